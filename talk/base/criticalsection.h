@@ -154,6 +154,22 @@ class AtomicOps {
   static int Decrement(int* i) {
     return ::InterlockedDecrement(reinterpret_cast<LONG*>(i));
   }
+  // Reads a value that other threads change with Increment and Decrement.
+  static int Load(const int* i) {
+    return ::InterlockedCompareExchange(
+        reinterpret_cast<LONG*>(const_cast<int*>(i)), 0, 0);
+  }
+#elif defined(__GNUC__)
+  // GCC and Clang builtins, which are full barriers.
+  static int Increment(int* i) {
+    return __sync_add_and_fetch(i, 1);
+  }
+  static int Decrement(int* i) {
+    return __sync_sub_and_fetch(i, 1);
+  }
+  static int Load(const int* i) {
+    return __sync_fetch_and_add(const_cast<int*>(i), 0);
+  }
 #else
   static int Increment(int* i) {
     // Could be faster, and less readable:
@@ -171,6 +187,11 @@ class AtomicOps {
     return --(*i);
   }
 
+  static int Load(const int* i) {
+    CritScope scope(StaticCrit());
+    return *i;
+  }
+
  private:
   static CriticalSection* StaticCrit() {
     static CriticalSection* crit = new CriticalSection();
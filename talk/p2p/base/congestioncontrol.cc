@@ -0,0 +1,139 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/p2p/base/congestioncontrol.h"
+
+#include <cmath>
+
+#include "talk/base/common.h"
+#include "talk/base/timeutils.h"
+
+namespace cricket {
+
+// CUBIC scaling constant, in segments per second cubed (RFC 8312, 5.1).
+const double CUBIC_C = 0.4;
+// CUBIC multiplicative decrease factor (RFC 8312, 4.5).
+const double CUBIC_BETA = 0.7;
+// Additive increase factor that makes CUBIC's AIMD estimate match Reno's
+// average throughput with the larger |CUBIC_BETA| (RFC 8312, 4.2).
+const double CUBIC_ALPHA = 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA);
+
+CongestionControl* CongestionControl::Create(Algorithm algorithm) {
+  switch (algorithm) {
+    case RENO:
+      return new RenoCongestionControl();
+    case CUBIC:
+      return new CubicCongestionControl();
+  }
+  return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////
+// RenoCongestionControl
+//////////////////////////////////////////////////////////////////////
+
+uint32 RenoCongestionControl::OnAck(uint32 cwnd, uint32 ssthresh, uint32 mss,
+                                    uint32 srtt, uint32 now) {
+  // Slow start, congestion avoidance
+  if (cwnd < ssthresh) {
+    return cwnd + mss;
+  }
+  return cwnd + talk_base::_max<uint32>(1, mss * mss / cwnd);
+}
+
+uint32 RenoCongestionControl::OnLoss(uint32 cwnd, uint32 in_flight,
+                                     uint32 mss, uint32 now) {
+  return talk_base::_max(in_flight / 2, 2 * mss);
+}
+
+//////////////////////////////////////////////////////////////////////
+// CubicCongestionControl
+//////////////////////////////////////////////////////////////////////
+
+CubicCongestionControl::CubicCongestionControl()
+    : w_max_(0), w_est_(0), k_(0), epoch_start_(0) {
+}
+
+uint32 CubicCongestionControl::OnAck(uint32 cwnd, uint32 ssthresh,
+                                     uint32 mss, uint32 srtt, uint32 now) {
+  if (cwnd < ssthresh) {
+    return cwnd + mss;
+  }
+
+  if (epoch_start_ == 0) {
+    // First ack of a new congestion avoidance epoch: find how long the
+    // cubic function needs to climb back to the window we last lost at.
+    epoch_start_ = now ? now : 1;
+    w_est_ = cwnd;
+    if (cwnd < w_max_) {
+      k_ = cbrt((w_max_ - cwnd) / mss / CUBIC_C);
+    } else {
+      k_ = 0;
+      w_max_ = cwnd;
+    }
+  }
+
+  // Evaluate the window one RTT ahead, as recommended by the RFC.
+  double t = (talk_base::TimeDiff(now, epoch_start_) + srtt) / 1000.0;
+  double target = w_max_ + CUBIC_C * (t - k_) * (t - k_) * (t - k_) * mss;
+  target = talk_base::_min<double>(target, 1.5 * cwnd);
+
+  w_est_ += CUBIC_ALPHA * mss * mss / cwnd;
+
+  uint32 increase;
+  if (target > cwnd) {
+    increase = static_cast<uint32>(mss * (target - cwnd) / cwnd);
+  } else {
+    // Plateau around |w_max_|: probe very slowly.
+    increase = mss * mss / (100 * cwnd);
+  }
+  double next = cwnd + talk_base::_max<uint32>(1, increase);
+  if (w_est_ > next) {
+    next = w_est_;
+  }
+  return static_cast<uint32>(next);
+}
+
+uint32 CubicCongestionControl::OnLoss(uint32 cwnd, uint32 in_flight,
+                                      uint32 mss, uint32 now) {
+  // Fast convergence: if we lost before reaching the previous maximum,
+  // another flow is probably competing, so release bandwidth faster.
+  double flight = in_flight;
+  if (flight < w_max_) {
+    w_max_ = flight * (1 + CUBIC_BETA) / 2;
+  } else {
+    w_max_ = flight;
+  }
+  epoch_start_ = 0;
+  return talk_base::_max(static_cast<uint32>(flight * CUBIC_BETA), 2 * mss);
+}
+
+void CubicCongestionControl::OnRestart() {
+  epoch_start_ = 0;
+}
+
+}  // namespace cricket
@@ -0,0 +1,105 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_P2P_BASE_CONGESTIONCONTROL_H_
+#define TALK_P2P_BASE_CONGESTIONCONTROL_H_
+
+#include "talk/base/basictypes.h"
+
+namespace cricket {
+
+// CongestionControl decides how PseudoTcp grows its congestion window on
+// new acknowledgements and how far it backs off when loss is detected.
+// PseudoTcp owns the window itself (including fast recovery inflation);
+// an algorithm only supplies the growth and decrease functions, so it can
+// be swapped without touching the rest of the sender state machine.
+// All sizes are in bytes and all times are in milliseconds.
+class CongestionControl {
+ public:
+  enum Algorithm {
+    RENO,   // Classic AIMD (RFC 5681), the historical PseudoTcp behaviour.
+    CUBIC,  // RFC 8312, better suited for long fat and lossy paths.
+  };
+
+  // Creates an instance of |algorithm|. Returns NULL on unknown values.
+  static CongestionControl* Create(Algorithm algorithm);
+
+  virtual ~CongestionControl() {}
+
+  virtual Algorithm algorithm() const = 0;
+
+  // Returns the new congestion window after new data was cumulatively
+  // acknowledged outside of loss recovery. |srtt| is the smoothed RTT, or 0
+  // if no sample has been taken yet.
+  virtual uint32 OnAck(uint32 cwnd, uint32 ssthresh, uint32 mss,
+                       uint32 srtt, uint32 now) = 0;
+
+  // Returns the new slow start threshold after loss was detected, either
+  // through duplicate acks or a retransmission timeout.
+  virtual uint32 OnLoss(uint32 cwnd, uint32 in_flight, uint32 mss,
+                        uint32 now) = 0;
+
+  // Called when the sender restarts after being idle for longer than an
+  // RTO, so any history tied to the previous transmission epoch is stale.
+  virtual void OnRestart() {}
+};
+
+class RenoCongestionControl : public CongestionControl {
+ public:
+  virtual Algorithm algorithm() const { return RENO; }
+  virtual uint32 OnAck(uint32 cwnd, uint32 ssthresh, uint32 mss,
+                       uint32 srtt, uint32 now);
+  virtual uint32 OnLoss(uint32 cwnd, uint32 in_flight, uint32 mss,
+                        uint32 now);
+};
+
+class CubicCongestionControl : public CongestionControl {
+ public:
+  CubicCongestionControl();
+
+  virtual Algorithm algorithm() const { return CUBIC; }
+  virtual uint32 OnAck(uint32 cwnd, uint32 ssthresh, uint32 mss,
+                       uint32 srtt, uint32 now);
+  virtual uint32 OnLoss(uint32 cwnd, uint32 in_flight, uint32 mss,
+                        uint32 now);
+  virtual void OnRestart();
+
+ private:
+  // Window size (bytes) just before the last reduction.
+  double w_max_;
+  // Window (bytes) that standard AIMD would have reached in this epoch;
+  // CUBIC never grows slower than this ("TCP-friendly region").
+  double w_est_;
+  // Time (seconds) the cubic function takes to grow back to |w_max_|.
+  double k_;
+  // Start of the current congestion avoidance epoch, 0 if none.
+  uint32 epoch_start_;
+};
+
+}  // namespace cricket
+
+#endif  // TALK_P2P_BASE_CONGESTIONCONTROL_H_
@@ -184,6 +184,12 @@ class FakeSession : public BaseSession {
                     NULL, "", "", true),
         fail_create_channel_(false) {
   }
+  explicit FakeSession(talk_base::Thread* worker_thread)
+      : BaseSession(talk_base::Thread::Current(),
+                    worker_thread,
+                    NULL, "", "", true),
+        fail_create_channel_(false) {
+  }
 
   FakeTransport* GetTransport(const std::string& content_name) {
     return static_cast<FakeTransport*>(
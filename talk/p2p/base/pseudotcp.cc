@@ -89,6 +89,10 @@ const uint32 JINGLE_HEADER_SIZE = 64; // when relay framing is in use
 const uint32 DEFAULT_RCV_BUF_SIZE = 60 * 1024;
 const uint32 DEFAULT_SND_BUF_SIZE = 90 * 1024;
 
+// RFC 1323 caps the window scale shift at 14, i.e. a 1 GB window. This is
+// the protocol limit, not a tuned value.
+const uint8 MAX_WND_SCALE = 14;
+
 //////////////////////////////////////////////////////////////////////
 // Global Constants and Functions
 //////////////////////////////////////////////////////////////////////
@@ -102,17 +106,24 @@ const uint32 DEFAULT_SND_BUF_SIZE = 90 * 1024;
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //  8 |                     Acknowledgment Number                     |
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-//    |               |   |U|A|P|R|S|F|                               |
-// 12 |    Control    |   |R|C|S|S|Y|I|            Window             |
-//    |               |   |G|K|H|T|N|N|                               |
+//    |     SACK      |   |U|A|P|R|S|F|                               |
+// 12 |    Blocks     |   |R|C|S|S|Y|I|            Window             |
+//    |    (n = 0)    |   |G|K|H|T|N|N|                               |
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 // 16 |                       Timestamp sending                       |
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 // 20 |                      Timestamp receiving                      |
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// 24 |           n x (SACK left edge, SACK right edge)               |
+//    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 // 24 |                             data                              |
+//  +8n                                                               |
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //
+// SACK blocks are only sent once both sides have offered
+// TCP_OPT_SACK_PERMITTED in their connect messages, so peers that predate
+// them always see n = 0 there.
+//
 //////////////////////////////////////////////////////////////////////
 
 #define PSEUDO_KEEPALIVE 0
@@ -125,6 +136,21 @@ const uint32 MIN_RTO   =   250; // 250 ms (RFC1122, Sec 4.2.3.1 "fractions of a
 const uint32 DEF_RTO   =  3000; // 3 seconds (RFC1122, Sec 4.2.3.1)
 const uint32 MAX_RTO   = 60000; // 60 seconds
 const uint32 DEF_ACK_DELAY = 100; // 100 milliseconds
+const uint32 DEF_ACK_FREQUENCY = 2; // ACK every second segment (RFC1122)
+
+// Pacing.  New data is released at cwnd/srtt, scaled up by these factors
+// (in percent) so that the pacer never holds the window back.  Slow start
+// needs more headroom since cwnd doubles every round trip.
+const uint32 PACING_GAIN_SS = 200;
+const uint32 PACING_GAIN_CA = 120;
+// Bytes that may go out back to back, in segments and in milliseconds of the
+// pacing rate, whichever is larger.  Timers only have millisecond resolution,
+// so anything less would cap the rate at one segment per tick.
+const uint32 PACING_BURST_SEGMENTS = 2;
+const uint32 PACING_BURST_MS = 2;
+
+// Runs of this many segments are counted as bursts.
+const uint32 BURST_SEGMENTS = 4;
 
 const uint8 FLAG_CTL = 0x02;
 const uint8 FLAG_RST = 0x04;
@@ -138,6 +164,11 @@ const uint8 TCP_OPT_EOL = 0;  // End of list.
 const uint8 TCP_OPT_NOOP = 1;  // No-op.
 const uint8 TCP_OPT_MSS = 2;  // Maximum segment size.
 const uint8 TCP_OPT_WND_SCALE = 3;  // Window scale factor.
+const uint8 TCP_OPT_SACK_PERMITTED = 4;  // Selective acks supported.
+
+// Selective acknowledgements (RFC 2018).
+const uint32 MAX_SACK_BLOCKS = 4;
+const uint32 SACK_BLOCK_SIZE = 8;
 
 /*
 const uint8 FLAG_FIN = 0x01;
@@ -176,6 +207,12 @@ inline uint16 bytes_to_short(const void* buf) {
   return talk_base::NetworkToHost16(*static_cast<const uint16*>(buf));
 }
 
+// Sizes the segment ring for a send buffer of |sbuf_len| bytes. Segments are
+// usually a full MSS, but start small until the path MTU is known.
+inline uint32 segments_for_buffer(uint32 sbuf_len) {
+  return sbuf_len / (MIN_PACKET - PACKET_OVERHEAD) + 1;
+}
+
 uint32 bound(uint32 lower, uint32 middle, uint32 upper) {
   return talk_base::_min(talk_base::_max(lower, middle), upper);
 }
@@ -237,7 +274,8 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32 conv)
       m_rbuf_len(DEFAULT_RCV_BUF_SIZE),
       m_rbuf(m_rbuf_len),
       m_sbuf_len(DEFAULT_SND_BUF_SIZE),
-      m_sbuf(m_sbuf_len) {
+      m_sbuf(m_sbuf_len),
+      m_cc(CongestionControl::Create(CongestionControl::RENO)) {
 
   // Sanity check on buffer sizes (needed for OnTcpWriteable notification logic)
   ASSERT(m_rbuf_len + MIN_PACKET < m_sbuf_len);
@@ -275,9 +313,26 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32 conv)
 
   m_rx_rto = DEF_RTO;
   m_rx_srtt = m_rx_rttvar = 0;
+  m_rto_backoff = 0;
+
+  m_slist.reserve(segments_for_buffer(m_sbuf_len));
+
+  m_support_sack = true;
+  m_sack_enabled = false;
+  m_sack_high = m_rtx_next = 0;
+
+  m_use_pacing = false;
+  m_pace_tokens = 0;
+  m_pace_last = now;
+  m_t_pace = 0;
+
+  m_unacked_segs = 0;
+
+  m_segments_sent = m_retransmits = m_bursts = m_drops = 0;
 
   m_use_nagling = true;
   m_ack_delay = DEF_ACK_DELAY;
+  m_ack_frequency = DEF_ACK_FREQUENCY;
   m_support_wnd_scale = true;
 }
 
@@ -311,39 +366,44 @@ void PseudoTcp::NotifyClock(uint32 now) {
     return;
 
     // Check if it's time to retransmit a segment
-  if (m_rto_base && (talk_base::TimeDiff(m_rto_base + m_rx_rto, now) <= 0)) {
+  if (m_rto_base && (talk_base::TimeDiff(m_rto_base + currentRto(), now) <= 0)) {
     if (m_slist.empty()) {
       ASSERT(false);
     } else {
       // Note: (m_slist.front().xmit == 0)) {
       // retransmit segments
 #if _DEBUGMSG >= _DBG_NORMAL
-      LOG(LS_INFO) << "timeout retransmit (rto: " << m_rx_rto
+      LOG(LS_INFO) << "timeout retransmit (rto: " << currentRto()
                    << ") (rto_base: " << m_rto_base
                    << ") (now: " << now
                    << ") (dup_acks: " << static_cast<unsigned>(m_dup_acks)
                    << ")";
 #endif // _DEBUGMSG
-      if (!transmit(m_slist.begin(), now)) {
+      if (!transmit(0, now)) {
         closedown(ECONNABORTED);
         return;
       }
 
       uint32 nInFlight = m_snd_nxt - m_snd_una;
-      m_ssthresh = talk_base::_max(nInFlight / 2, 2 * m_mss);
+      m_ssthresh = m_cc->OnLoss(m_cwnd, nInFlight, m_mss, now);
       //LOG(LS_INFO) << "m_ssthresh: " << m_ssthresh << "  nInFlight: " << nInFlight << "  m_mss: " << m_mss;
       m_cwnd = m_mss;
+      // A timeout ends any fast recovery in progress.
+      m_dup_acks = 0;
 
-      // Back off retransmit timer.  Note: the limit is lower when connecting.
-      uint32 rto_limit = (m_state < TCP_ESTABLISHED) ? DEF_RTO : MAX_RTO;
-      m_rx_rto = talk_base::_min(rto_limit, m_rx_rto * 2);
+      // Back off retransmit timer (see currentRto).  The smoothed estimate
+      // in |m_rx_rto| is left alone so the backoff can be dropped as soon as
+      // new data is acknowledged.
+      if (currentRto() < MAX_RTO) {
+        ++m_rto_backoff;
+      }
       m_rto_base = now;
     }
   }
 
   // Check if it's time to probe closed windows
   if ((m_snd_wnd == 0)
-        && (talk_base::TimeDiff(m_lastsend + m_rx_rto, now) <= 0)) {
+        && (talk_base::TimeDiff(m_lastsend + currentRto(), now) <= 0)) {
     if (talk_base::TimeDiff(now, m_lastrecv) >= 15000) {
       closedown(ECONNABORTED);
       return;
@@ -354,7 +414,9 @@ void PseudoTcp::NotifyClock(uint32 now) {
     m_lastsend = now;
 
     // back off retransmit timer
-    m_rx_rto = talk_base::_min(MAX_RTO, m_rx_rto * 2);
+    if (currentRto() < MAX_RTO) {
+      ++m_rto_backoff;
+    }
   }
 
   // Check if it's time to send delayed acks
@@ -362,6 +424,11 @@ void PseudoTcp::NotifyClock(uint32 now) {
     packet(m_snd_nxt, 0, 0, 0);
   }
 
+  // Check if the pacer is ready to release more data
+  if (m_t_pace && (talk_base::TimeDiff(m_t_pace, now) <= 0)) {
+    attemptSend();
+  }
+
 #if PSEUDO_KEEPALIVE
   // Check for idle timeout
   if ((m_state == TCP_ESTABLISHED) && (TimeDiff(m_lastrecv + IDLE_TIMEOUT, now) <= 0)) {
@@ -397,6 +464,14 @@ void PseudoTcp::GetOption(Option opt, int* value) {
     *value = m_sbuf_len;
   } else if (opt == OPT_RCVBUF) {
     *value = m_rbuf_len;
+  } else if (opt == OPT_SACK) {
+    *value = m_support_sack ? 1 : 0;
+  } else if (opt == OPT_CONGESTION_CONTROL) {
+    *value = m_cc->algorithm();
+  } else if (opt == OPT_PACING) {
+    *value = m_use_pacing ? 1 : 0;
+  } else if (opt == OPT_ACKFREQUENCY) {
+    *value = m_ack_frequency;
   } else {
     ASSERT(false);
   }
@@ -412,6 +487,36 @@ void PseudoTcp::SetOption(Option opt, int value) {
   } else if (opt == OPT_RCVBUF) {
     ASSERT(m_state == TCP_LISTEN);
     resizeReceiveBuffer(value);
+  } else if (opt == OPT_SACK) {
+    ASSERT(m_state == TCP_LISTEN);
+    m_support_sack = value != 0;
+  } else if (opt == OPT_CONGESTION_CONTROL) {
+    CongestionControl* cc = CongestionControl::Create(
+        static_cast<CongestionControl::Algorithm>(value));
+    ASSERT(cc != NULL);
+    if (cc) {
+      m_cc.reset(cc);
+    }
+  } else if (opt == OPT_PACING) {
+    m_use_pacing = value != 0;
+    m_t_pace = 0;
+  } else if (opt == OPT_ACKFREQUENCY) {
+    ASSERT(value > 0);
+    m_ack_frequency = talk_base::_max(value, 1);
+  } else {
+    ASSERT(false);
+  }
+}
+
+void PseudoTcp::GetCounter(Counter counter, uint32* value) const {
+  if (counter == COUNTER_SEGMENTS_SENT) {
+    *value = m_segments_sent;
+  } else if (counter == COUNTER_RETRANSMITS) {
+    *value = m_retransmits;
+  } else if (counter == COUNTER_BURSTS) {
+    *value = m_bursts;
+  } else if (counter == COUNTER_DROPS) {
+    *value = m_drops;
   } else {
     ASSERT(false);
   }
@@ -524,6 +629,15 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32 seq, uint8 flags,
   long_to_bytes(m_rcv_nxt, buffer + 8);
   buffer[12] = 0;
   buffer[13] = flags;
+
+  // Report out-of-order data, as long as the blocks fit in the segment.
+  uint32 sack_len = 0;
+  if (m_sack_enabled && !m_rlist.empty() && (len + SACK_BLOCK_SIZE <= m_mss)) {
+    uint32 max_blocks = talk_base::_min(MAX_SACK_BLOCKS,
+                                        (m_mss - len) / SACK_BLOCK_SIZE);
+    buffer[12] = writeSackBlocks(buffer + HEADER_SIZE, max_blocks);
+    sack_len = buffer[12] * SACK_BLOCK_SIZE;
+  }
   short_to_bytes(static_cast<uint16>(m_rcv_wnd >> m_rwnd_scale), buffer + 14);
 
   // Timestamp computations
@@ -533,7 +647,8 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32 seq, uint8 flags,
 
   if (len) {
     size_t bytes_read = 0;
-    talk_base::StreamResult result = m_sbuf.ReadOffset(buffer + HEADER_SIZE,
+    talk_base::StreamResult result = m_sbuf.ReadOffset(buffer + HEADER_SIZE +
+                                                       sack_len,
                                                        len,
                                                        offset,
                                                        &bytes_read);
@@ -553,14 +668,18 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32 seq, uint8 flags,
                << "><LEN=" << len << ">";
 #endif // _DEBUGMSG
 
-  IPseudoTcpNotify::WriteResult wres = m_notify->TcpWritePacket(this, reinterpret_cast<char *>(buffer), len + HEADER_SIZE);
+  IPseudoTcpNotify::WriteResult wres = m_notify->TcpWritePacket(this, reinterpret_cast<char *>(buffer), len + sack_len + HEADER_SIZE);
   // Note: When len is 0, this is an ACK packet.  We don't read the return value for those,
   // and thus we won't retry.  So go ahead and treat the packet as a success (basically simulate
   // as if it were dropped), which will prevent our timers from being messed up.
+  if (wres == IPseudoTcpNotify::WR_FAIL) {
+    ++m_drops;
+  }
   if ((wres != IPseudoTcpNotify::WR_SUCCESS) && (0 != len))
     return wres;
 
   m_t_ack = 0;
+  m_unacked_segs = 0;
   if (len > 0) {
     m_lastsend = now;
   }
@@ -571,7 +690,7 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32 seq, uint8 flags,
 }
 
 bool PseudoTcp::parse(const uint8* buffer, uint32 size) {
-  if (size < 12)
+  if (size < HEADER_SIZE)
     return false;
 
   Segment seg;
@@ -584,8 +703,16 @@ bool PseudoTcp::parse(const uint8* buffer, uint32 size) {
   seg.tsval = bytes_to_long(buffer + 16);
   seg.tsecr = bytes_to_long(buffer + 20);
 
-  seg.data = reinterpret_cast<const char *>(buffer) + HEADER_SIZE;
-  seg.len = size - HEADER_SIZE;
+  seg.sack_count = buffer[12];
+  uint32 sack_len = seg.sack_count * SACK_BLOCK_SIZE;
+  if (HEADER_SIZE + sack_len > size) {
+    LOG_F(LS_WARNING) << "invalid sack block count";
+    return false;
+  }
+  seg.sack = reinterpret_cast<const char *>(buffer) + HEADER_SIZE;
+
+  seg.data = reinterpret_cast<const char *>(buffer) + HEADER_SIZE + sack_len;
+  seg.len = size - HEADER_SIZE - sack_len;
 
 #if _DEBUGMSG >= _DBG_VERBOSE
   LOG(LS_INFO) << "--> <CONV=" << seg.conv
@@ -626,10 +753,14 @@ bool PseudoTcp::clock_check(uint32 now, long& nTimeout) {
   }
   if (m_rto_base) {
     nTimeout = talk_base::_min<int32>(nTimeout,
-      talk_base::TimeDiff(m_rto_base + m_rx_rto, now));
+      talk_base::TimeDiff(m_rto_base + currentRto(), now));
+  }
+  if (m_t_pace) {
+    nTimeout = talk_base::_min<int32>(nTimeout,
+      talk_base::TimeDiff(m_t_pace, now));
   }
   if (m_snd_wnd == 0) {
-    nTimeout = talk_base::_min<int32>(nTimeout, talk_base::TimeDiff(m_lastsend + m_rx_rto, now));
+    nTimeout = talk_base::_min<int32>(nTimeout, talk_base::TimeDiff(m_lastsend + currentRto(), now));
   }
 #if PSEUDO_KEEPALIVE
   if (m_state == TCP_ESTABLISHED) {
@@ -703,6 +834,12 @@ bool PseudoTcp::process(Segment& seg) {
     m_ts_recent = seg.tsval;
   }
 
+  // Update the SACK scoreboard before acting on the acknowledgement, so that
+  // any retransmission it triggers can skip data the peer already has.
+  if (m_sack_enabled && seg.sack_count) {
+    applySack(seg);
+  }
+
   // Check if this is a valuable ack
   if ((seg.ack > m_snd_una) && (seg.ack <= m_snd_nxt)) {
     // Calculate round-trip time
@@ -734,6 +871,7 @@ bool PseudoTcp::process(Segment& seg) {
     m_snd_una = seg.ack;
 
     m_rto_base = (m_snd_una == m_snd_nxt) ? 0 : now;
+    m_rto_backoff = 0;
 
     m_sbuf.ConsumeReadData(nAcked);
 
@@ -763,7 +901,13 @@ bool PseudoTcp::process(Segment& seg) {
 #if _DEBUGMSG >= _DBG_NORMAL
         LOG(LS_INFO) << "recovery retransmit";
 #endif // _DEBUGMSG
-        if (!transmit(m_slist.begin(), now)) {
+        // With SACK the next hole is known precisely, otherwise fall back
+        // to NewReno and resend the segment at the new left edge. The same
+        // applies when nothing above the new left edge has been sacked.
+        bool retransmitted =
+            (m_sack_enabled && (m_sack_high > m_snd_una)) ?
+                retransmitHole(now) : transmit(0, now);
+        if (!retransmitted) {
           closedown(ECONNABORTED);
           return false;
         }
@@ -771,12 +915,7 @@ bool PseudoTcp::process(Segment& seg) {
       }
     } else {
       m_dup_acks = 0;
-      // Slow start, congestion avoidance
-      if (m_cwnd < m_ssthresh) {
-        m_cwnd += m_mss;
-      } else {
-        m_cwnd += talk_base::_max<uint32>(1, m_mss * m_mss / m_cwnd);
-      }
+      m_cwnd = m_cc->OnAck(m_cwnd, m_ssthresh, m_mss, m_rx_srtt, now);
     }
   } else if (seg.ack == m_snd_una) {
     // !?! Note, tcp says don't do this... but otherwise how does a closed window become open?
@@ -792,17 +931,24 @@ bool PseudoTcp::process(Segment& seg) {
         LOG(LS_INFO) << "enter recovery";
         LOG(LS_INFO) << "recovery retransmit";
 #endif // _DEBUGMSG
-        if (!transmit(m_slist.begin(), now)) {
+        if (!transmit(0, now)) {
           closedown(ECONNABORTED);
           return false;
         }
         m_recover = m_snd_nxt;
+        m_rtx_next = m_slist.front().seq + m_slist.front().len;
         uint32 nInFlight = m_snd_nxt - m_snd_una;
-        m_ssthresh = talk_base::_max(nInFlight / 2, 2 * m_mss);
+        m_ssthresh = m_cc->OnLoss(m_cwnd, nInFlight, m_mss, now);
         //LOG(LS_INFO) << "m_ssthresh: " << m_ssthresh << "  nInFlight: " << nInFlight << "  m_mss: " << m_mss;
         m_cwnd = m_ssthresh + 3 * m_mss;
       } else if (m_dup_acks > 3) {
         m_cwnd += m_mss;
+        // Each further duplicate ack means another segment left the
+        // network; use it to fill the next known hole.
+        if (m_sack_enabled && !retransmitHole(now)) {
+          closedown(ECONNABORTED);
+          return false;
+        }
       }
     } else {
       m_dup_acks = 0;
@@ -906,8 +1052,10 @@ bool PseudoTcp::process(Segment& seg) {
         m_rcv_wnd -= seg.len;
         bNewData = true;
 
+        // Ranges are sorted, so everything that became contiguous sits at
+        // the front of |m_rlist|.
         RList::iterator it = m_rlist.begin();
-        while ((it != m_rlist.end()) && (it->seq <= m_rcv_nxt)) {
+        for (; (it != m_rlist.end()) && (it->seq <= m_rcv_nxt); ++it) {
           if (it->seq + it->len > m_rcv_nxt) {
             sflags = sfImmediateAck; // (Fast Recovery)
             uint32 nAdjust = (it->seq + it->len) - m_rcv_nxt;
@@ -918,20 +1066,13 @@ bool PseudoTcp::process(Segment& seg) {
             m_rcv_nxt += nAdjust;
             m_rcv_wnd -= nAdjust;
           }
-          it = m_rlist.erase(it);
         }
+        m_rlist.erase(m_rlist.begin(), it);
       } else {
 #if _DEBUGMSG >= _DBG_NORMAL
         LOG(LS_INFO) << "Saving " << seg.len << " bytes (" << seg.seq << " -> " << seg.seq + seg.len << ")";
 #endif // _DEBUGMSG
-        RSegment rseg;
-        rseg.seq = seg.seq;
-        rseg.len = seg.len;
-        RList::iterator it = m_rlist.begin();
-        while ((it != m_rlist.end()) && (it->seq < rseg.seq)) {
-          ++it;
-        }
-        m_rlist.insert(it, rseg);
+        addOutOfOrder(seg.seq, seg.len);
       }
     }
   }
@@ -950,7 +1091,8 @@ bool PseudoTcp::process(Segment& seg) {
   return true;
 }
 
-bool PseudoTcp::transmit(const SList::iterator& seg, uint32 now) {
+bool PseudoTcp::transmit(uint32 index, uint32 now) {
+  SSegment* seg = &m_slist[index];
   if (seg->xmit >= ((m_state == TCP_ESTABLISHED) ? 15 : 30)) {
     LOG_F(LS_VERBOSE) << "too many retransmits";
     return false;
@@ -1001,16 +1143,21 @@ bool PseudoTcp::transmit(const SList::iterator& seg, uint32 now) {
     SSegment subseg(seg->seq + nTransmit, seg->len - nTransmit, seg->bCtrl);
     //subseg.tstamp = seg->tstamp;
     subseg.xmit = seg->xmit;
+    subseg.bSacked = seg->bSacked;
     seg->len = nTransmit;
 
-    SList::iterator next = seg;
-    m_slist.insert(++next, subseg);
+    m_slist.insert(index + 1, subseg);
+    // The insertion may have reallocated the ring.
+    seg = &m_slist[index];
   }
 
   if (seg->xmit == 0) {
     m_snd_nxt += seg->len;
+  } else {
+    ++m_retransmits;
   }
   seg->xmit += 1;
+  ++m_segments_sent;
   //seg->tstamp = now;
   if (m_rto_base == 0) {
     m_rto_base = now;
@@ -1024,6 +1171,7 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
 
   if (talk_base::TimeDiff(now, m_lastsend) > static_cast<long>(m_rx_rto)) {
     m_cwnd = m_mss;
+    m_cc->OnRestart();
   }
 
 #if _DEBUGMSG
@@ -1031,6 +1179,9 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
   UNUSED(bFirst);
 #endif // _DEBUGMSG
 
+  m_t_pace = 0;
+  uint32 nBurst = 0;
+
   while (true) {
     uint32 cwnd = m_cwnd;
     if ((m_dup_acks == 1) || (m_dup_acks == 2)) { // Limited Transmit
@@ -1070,14 +1221,19 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
     }
 #endif // _DEBUGMSG
 
+    // Spread new data over the round trip instead of sending it all at once.
+    if ((nAvailable > 0) && !checkPacing(nAvailable, now)) {
+      nAvailable = 0;
+    }
+
     if (nAvailable == 0) {
       if (sflags == sfNone)
         return;
 
-      // If this is an immediate ack, or the second delayed ack
-      if ((sflags == sfImmediateAck) || m_t_ack) {
+      // If this is an immediate ack, or enough segments have been delayed
+      if ((sflags == sfImmediateAck) || (++m_unacked_segs >= m_ack_frequency)) {
         packet(m_snd_nxt, 0, 0, 0);
-      } else {
+      } else if (m_t_ack == 0) {
         m_t_ack = Now();
       }
       return;
@@ -1091,19 +1247,20 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
       return;
     }
 
-    // Find the next segment to transmit
-    SList::iterator it = m_slist.begin();
-    while (it->xmit > 0) {
-      ++it;
-      ASSERT(it != m_slist.end());
+    // Find the next segment to transmit. Unsent data is always at the tail,
+    // so search backwards.
+    uint32 seg = m_slist.size() - 1;
+    while ((seg > 0) && (m_slist[seg - 1].xmit == 0)) {
+      --seg;
     }
-    SList::iterator seg = it;
+    ASSERT(m_slist[seg].xmit == 0);
 
     // If the segment is too large, break it into two
-    if (seg->len > nAvailable) {
-      SSegment subseg(seg->seq + nAvailable, seg->len - nAvailable, seg->bCtrl);
-      seg->len = nAvailable;
-      m_slist.insert(++it, subseg);
+    if (m_slist[seg].len > nAvailable) {
+      SSegment subseg(m_slist[seg].seq + nAvailable,
+                      m_slist[seg].len - nAvailable, m_slist[seg].bCtrl);
+      m_slist[seg].len = nAvailable;
+      m_slist.insert(seg + 1, subseg);
     }
 
     if (!transmit(seg, now)) {
@@ -1112,10 +1269,51 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
       return;
     }
 
+    m_pace_tokens -= talk_base::_min(m_pace_tokens, m_slist[seg].len);
+    if (++nBurst == BURST_SEGMENTS) {
+      ++m_bursts;
+    }
+
     sflags = sfNone;
   }
 }
 
+uint32
+PseudoTcp::pacingRate() const {
+  if (!m_use_pacing || (m_rx_srtt == 0)) {
+    return 0;
+  }
+  uint32 gain = (m_cwnd < m_ssthresh) ? PACING_GAIN_SS : PACING_GAIN_CA;
+  uint64 rate = static_cast<uint64>(m_cwnd) * gain / (100 * m_rx_srtt);
+  return static_cast<uint32>(talk_base::_max<uint64>(rate, 1));
+}
+
+bool
+PseudoTcp::checkPacing(uint32 len, uint32 now) {
+  uint32 rate = pacingRate();
+  if (rate == 0) {
+    return true;
+  }
+
+  // Refill the bucket for the time since it was last checked.
+  uint32 burst = talk_base::_max(PACING_BURST_SEGMENTS * m_mss,
+                                 PACING_BURST_MS * rate);
+  uint64 tokens = m_pace_tokens +
+      static_cast<uint64>(rate) *
+      talk_base::_max<int32>(talk_base::TimeDiff(now, m_pace_last), 0);
+  m_pace_tokens = static_cast<uint32>(talk_base::_min<uint64>(tokens, burst));
+  m_pace_last = now;
+
+  // Never wait for more than the bucket can hold.
+  len = talk_base::_min(len, burst);
+  if (m_pace_tokens >= len) {
+    return true;
+  }
+  m_t_pace = now + talk_base::_max<uint32>(
+      (len - m_pace_tokens + rate - 1) / rate, 1);
+  return false;
+}
+
 void
 PseudoTcp::closedown(uint32 err) {
   LOG(LS_INFO) << "State: TCP_CLOSED";
@@ -1144,6 +1342,144 @@ PseudoTcp::adjustMTU() {
   m_cwnd = talk_base::_max(m_cwnd, m_mss);
 }
 
+void
+PseudoTcp::applySack(const Segment& seg) {
+  for (uint8 i = 0; i < seg.sack_count; ++i) {
+    uint32 left = bytes_to_long(seg.sack + i * SACK_BLOCK_SIZE);
+    uint32 right = bytes_to_long(seg.sack + i * SACK_BLOCK_SIZE + 4);
+    if ((left >= right) || (right <= m_snd_una) || (right > m_snd_nxt)) {
+      LOG_F(LS_VERBOSE) << "ignoring invalid sack block";
+      continue;
+    }
+    for (uint32 j = 0; (j < m_slist.size()) && (m_slist[j].xmit > 0) &&
+         (m_slist[j].seq < right); ++j) {
+      SSegment& sseg = m_slist[j];
+      if ((sseg.seq >= left) && (sseg.seq + sseg.len <= right)) {
+        sseg.bSacked = true;
+      }
+    }
+    m_sack_high = talk_base::_max(m_sack_high, right);
+  }
+}
+
+bool
+PseudoTcp::retransmitHole(uint32 now) {
+  for (uint32 i = 0; (i < m_slist.size()) && (m_slist[i].xmit > 0) &&
+       (m_slist[i].seq < m_sack_high); ++i) {
+    if (m_slist[i].bSacked || (m_slist[i].seq < m_rtx_next))
+      continue;
+#if _DEBUGMSG >= _DBG_NORMAL
+    LOG(LS_INFO) << "sack retransmit " << m_slist[i].seq;
+#endif // _DEBUGMSG
+    if (!transmit(i, now))
+      return false;
+    m_rtx_next = m_slist[i].seq + m_slist[i].len;
+    break;
+  }
+  return true;
+}
+
+void
+PseudoTcp::addOutOfOrder(uint32 seq, uint32 len) {
+  uint32 end = seq + len;
+
+  // Binary search for the first range that ends at or after |seq|; that is
+  // the first one the new data can touch.
+  size_t lo = 0, hi = m_rlist.size();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (m_rlist[mid].seq + m_rlist[mid].len < seq) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  RList::iterator first = m_rlist.begin() + lo;
+  RList::iterator last = first;
+  for (; (last != m_rlist.end()) && (last->seq <= end); ++last) {
+    seq = talk_base::_min(seq, last->seq);
+    end = talk_base::_max(end, last->seq + last->len);
+  }
+
+  if (first == last) {
+    RSegment rseg;
+    rseg.seq = seq;
+    rseg.len = end - seq;
+    m_rlist.insert(first, rseg);
+  } else {
+    first->seq = seq;
+    first->len = end - seq;
+    m_rlist.erase(first + 1, last);
+  }
+}
+
+uint8
+PseudoTcp::writeSackBlocks(uint8* buf, uint32 max_blocks) const {
+  uint8 count = 0;
+  for (RList::const_iterator it = m_rlist.begin();
+       (it != m_rlist.end()) && (count < max_blocks); ++it, ++count) {
+    long_to_bytes(it->seq, buf + count * SACK_BLOCK_SIZE);
+    long_to_bytes(it->seq + it->len, buf + count * SACK_BLOCK_SIZE + 4);
+  }
+  return count;
+}
+
+uint32
+PseudoTcp::currentRto() const {
+  // Note: the limit is lower when connecting.
+  uint32 rto_limit = (m_state < TCP_ESTABLISHED) ? DEF_RTO : MAX_RTO;
+  uint32 rto = m_rx_rto;
+  for (uint8 i = 0; (i < m_rto_backoff) && (rto < rto_limit); ++i) {
+    rto *= 2;
+  }
+  return talk_base::_min(rto, rto_limit);
+}
+
+PseudoTcp::SList::SList() : m_ring(1, SSegment(0, 0, false)), m_head(0),
+                             m_size(0) {
+}
+
+void
+PseudoTcp::SList::reserve(uint32 capacity) {
+  if (capacity <= m_ring.size())
+    return;
+
+  uint32 new_capacity = static_cast<uint32>(m_ring.size());
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+
+  std::vector<SSegment> ring;
+  ring.reserve(new_capacity);
+  for (uint32 i = 0; i < m_size; ++i) {
+    ring.push_back((*this)[i]);
+  }
+  ring.resize(new_capacity, SSegment(0, 0, false));
+  m_ring.swap(ring);
+  m_head = 0;
+}
+
+void
+PseudoTcp::SList::pop_front() {
+  ASSERT(m_size > 0);
+  m_head = (m_head + 1) & (m_ring.size() - 1);
+  --m_size;
+}
+
+void
+PseudoTcp::SList::insert(uint32 i, const SSegment& seg) {
+  ASSERT(i <= m_size);
+  if (m_size == m_ring.size()) {
+    reserve(m_size * 2);
+  }
+  for (uint32 j = m_size; j > i; --j) {
+    (*this)[j] = (*this)[j - 1];
+  }
+  (*this)[i] = seg;
+  ++m_size;
+}
+
 bool
 PseudoTcp::isReceiveBufferFull() const {
   size_t available_space = 0;
@@ -1166,6 +1502,10 @@ PseudoTcp::queueConnectMessage() {
     buf.WriteUInt8(1);
     buf.WriteUInt8(m_rwnd_scale);
   }
+  if (m_support_sack) {
+    buf.WriteUInt8(TCP_OPT_SACK_PERMITTED);
+    buf.WriteUInt8(0);
+  }
   m_snd_wnd = buf.Length();
   queue(buf.Data(), buf.Length(), true);
 }
@@ -1231,6 +1571,10 @@ PseudoTcp::applyOption(char kind, const char* data, uint32 len) {
       return;
     }
     applyWindowScaleOption(data[0]);
+  } else if (kind == TCP_OPT_SACK_PERMITTED) {
+    // Selective acknowledgements are used only if both sides offer them.
+    // http://www.ietf.org/rfc/rfc2018.txt
+    m_sack_enabled = m_support_sack;
   }
 }
 
@@ -1243,6 +1587,7 @@ void
 PseudoTcp::resizeSendBuffer(uint32 new_size) {
   m_sbuf_len = new_size;
   m_sbuf.SetCapacity(new_size);
+  m_slist.reserve(segments_for_buffer(new_size));
 }
 
 void
@@ -1251,10 +1596,14 @@ PseudoTcp::resizeReceiveBuffer(uint32 new_size) {
 
   // Determine the scale factor such that the scaled window size can fit
   // in a 16-bit unsigned integer.
-  while (new_size > 0xFFFF) {
+  while ((new_size > 0xFFFF) && (scale_factor < MAX_WND_SCALE)) {
     ++scale_factor;
     new_size >>= 1;
   }
+  if (new_size > 0xFFFF) {
+    LOG(LS_WARNING) << "Receive buffer limited by maximum window scale";
+    new_size = 0xFFFF;
+  }
 
   // Determine the proper size of the buffer.
   new_size <<= scale_factor;
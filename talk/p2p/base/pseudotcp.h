@@ -28,10 +28,12 @@
 #ifndef TALK_P2P_BASE_PSEUDOTCP_H_
 #define TALK_P2P_BASE_PSEUDOTCP_H_
 
-#include <list>
+#include <vector>
 
 #include "talk/base/basictypes.h"
+#include "talk/base/scoped_ptr.h"
 #include "talk/base/stream.h"
+#include "talk/p2p/base/congestioncontrol.h"
 
 namespace cricket {
 
@@ -97,17 +99,34 @@ class PseudoTcp {
   // instance's behaviour for the kind of data it will carry.
   // If an unrecognized option is set or got, an assertion will fire.
   //
-  // Setting options for OPT_RCVBUF or OPT_SNDBUF after Connect() is called
-  // will result in an assertion.
+  // Setting options for OPT_RCVBUF, OPT_SNDBUF or OPT_SACK after Connect() is
+  // called will result in an assertion.
   enum Option {
     OPT_NODELAY,      // Whether to enable Nagle's algorithm (0 == off)
     OPT_ACKDELAY,     // The Delayed ACK timeout (0 == off).
     OPT_RCVBUF,       // Set the receive buffer size, in bytes.
     OPT_SNDBUF,       // Set the send buffer size, in bytes.
+    OPT_SACK,         // Whether to offer selective acks (0 == off). They are
+                      // only used if the peer offers them too.
+    OPT_CONGESTION_CONTROL,  // A CongestionControl::Algorithm value.
+    OPT_PACING,       // Whether to pace new data over the RTT (0 == off).
+    OPT_ACKFREQUENCY, // Send an ACK at least every N data segments, without
+                      // waiting for OPT_ACKDELAY to expire.
   };
   void GetOption(Option opt, int* value);
   void SetOption(Option opt, int value);
 
+  // Call this to read the running counters of this PseudoTcp instance.
+  enum Counter {
+    COUNTER_SEGMENTS_SENT,  // Data segments put on the wire, including
+                            // retransmissions.
+    COUNTER_RETRANSMITS,    // Data segments sent more than once.
+    COUNTER_BURSTS,         // Runs of 4 or more data segments sent back to
+                            // back by a single call into the sender.
+    COUNTER_DROPS,          // Packets that TcpWritePacket failed to send.
+  };
+  void GetCounter(Counter counter, uint32* value) const;
+
  protected:
   enum SendFlags { sfNone, sfDelayedAck, sfImmediateAck };
 
@@ -118,19 +137,50 @@ class PseudoTcp {
     const char * data;
     uint32 len;
     uint32 tsval, tsecr;
+    const char * sack;  // |sack_count| (left, right) edge pairs.
+    uint8 sack_count;
   };
 
   struct SSegment {
     SSegment(uint32 s, uint32 l, bool c)
-        : seq(s), len(l), /*tstamp(0),*/ xmit(0), bCtrl(c) {
+        : seq(s), len(l), /*tstamp(0),*/ xmit(0), bCtrl(c), bSacked(false) {
     }
     uint32 seq, len;
     //uint32 tstamp;
     uint8 xmit;
     bool bCtrl;
+    bool bSacked;  // The peer has selectively acknowledged this segment.
+  };
+
+  // Ring of outgoing segments in sequence order. The storage is sized from
+  // the send buffer up front and only grows (by doubling) when a run of tiny
+  // writes needs more segments, so steady-state sending doesn't allocate.
+  class SList {
+   public:
+    SList();
+
+    bool empty() const { return m_size == 0; }
+    uint32 size() const { return m_size; }
+    SSegment& operator[](uint32 i) {
+      return m_ring[(m_head + i) & (m_ring.size() - 1)];
+    }
+    SSegment& front() { return (*this)[0]; }
+    SSegment& back() { return (*this)[m_size - 1]; }
+
+    // Makes room for at least |capacity| segments.
+    void reserve(uint32 capacity);
+    void push_back(const SSegment& seg) { insert(m_size, seg); }
+    void pop_front();
+    // Inserts |seg| in front of the |i|th segment. Segments are only ever
+    // split near the tail, so this rarely moves more than a few entries.
+    void insert(uint32 i, const SSegment& seg);
+
+   private:
+    std::vector<SSegment> m_ring;  // Size is always a power of two.
+    uint32 m_head, m_size;
   };
-  typedef std::list<SSegment> SList;
 
+  // A range of out-of-order data held in the receive buffer.
   struct RSegment {
     uint32 seq, len;
   };
@@ -156,7 +206,35 @@ class PseudoTcp {
   bool clock_check(uint32 now, long& nTimeout);
 
   bool process(Segment& seg);
-  bool transmit(const SList::iterator& seg, uint32 now);
+  // Transmits the |index|th segment of |m_slist|.
+  bool transmit(uint32 index, uint32 now);
+
+  // Marks the outstanding segments covered by the SACK blocks in |seg|.
+  void applySack(const Segment& seg);
+
+  // Retransmits the first segment below the highest selectively acked
+  // sequence number that is neither sacked nor already retransmitted during
+  // the current recovery. Returns false if the retransmission failed.
+  bool retransmitHole(uint32 now);
+
+  // Records [seq, seq + len) as received out of order, merging it with the
+  // ranges it overlaps or touches.
+  void addOutOfOrder(uint32 seq, uint32 len);
+
+  // Writes the out-of-order ranges held in |m_rlist| into |buf| as SACK
+  // blocks, at most |max_blocks| of them. Returns the number written.
+  uint8 writeSackBlocks(uint8* buf, uint32 max_blocks) const;
+
+  // Returns the retransmission timeout with exponential backoff applied.
+  uint32 currentRto() const;
+
+  // Returns the rate new data is paced at, in bytes per millisecond, or 0 if
+  // it shouldn't be paced.
+  uint32 pacingRate() const;
+
+  // Returns true if pacing allows |len| more bytes to be sent at |now|.
+  // Otherwise sets |m_t_pace| to the time when it will.
+  bool checkPacing(uint32 len, uint32 now);
 
   void adjustMTU();
 
@@ -199,7 +277,10 @@ class PseudoTcp {
   uint32 m_lasttraffic;
 
   // Incoming data
-  typedef std::list<RSegment> RList;
+  // Disjoint, non-adjacent out-of-order ranges sorted by sequence number.
+  // Each range covers any number of segments, so there is one entry per
+  // hole rather than per segment.
+  typedef std::vector<RSegment> RList;
   RList m_rlist;
   uint32 m_rbuf_len, m_rcv_nxt, m_rcv_wnd, m_lastrecv;
   uint8 m_rwnd_scale;  // Window scale factor.
@@ -221,16 +302,39 @@ class PseudoTcp {
 
   // Round-trip calculation
   uint32 m_rx_rttvar, m_rx_srtt, m_rx_rto;
+  // Number of consecutive timeouts, doubling |m_rx_rto| each time.
+  uint8 m_rto_backoff;
 
   // Congestion avoidance, Fast retransmit/recovery, Delayed ACKs
   uint32 m_ssthresh, m_cwnd;
   uint8 m_dup_acks;
   uint32 m_recover;
   uint32 m_t_ack;
+  talk_base::scoped_ptr<CongestionControl> m_cc;
+
+  // Selective acknowledgements
+  bool m_support_sack, m_sack_enabled;
+  // Highest sequence number selectively acked by the peer.
+  uint32 m_sack_high;
+  // Holes below this sequence number were retransmitted in this recovery.
+  uint32 m_rtx_next;
+
+  // Pacing, as a token bucket refilled at pacingRate().
+  bool m_use_pacing;
+  uint32 m_pace_tokens, m_pace_last;
+  // When new data may be sent again, or 0 if pacing isn't holding it back.
+  uint32 m_t_pace;
+
+  // Data segments received since the last ACK was sent.
+  uint32 m_unacked_segs;
+
+  // Counters
+  uint32 m_segments_sent, m_retransmits, m_bursts, m_drops;
 
   // Configuration options
   bool m_use_nagling;
   uint32 m_ack_delay;
+  uint32 m_ack_frequency;
 
   // This is used by unit tests to test backward compatibility of
   // PseudoTcp implementations that don't support window scaling.
@@ -27,6 +27,7 @@
 
 #include <vector>
 
+#include "talk/base/byteorder.h"
 #include "talk/base/gunit.h"
 #include "talk/base/helpers.h"
 #include "talk/base/messagehandler.h"
@@ -34,12 +35,18 @@
 #include "talk/base/thread.h"
 #include "talk/base/timeutils.h"
 #include "talk/p2p/base/pseudotcp.h"
+#include "talk/p2p/base/pseudotcptransfer.h"
 
 using cricket::PseudoTcp;
 
 static const int kConnectTimeoutMs = 10000;  // ~3 * default RTO of 3000ms
 static const int kTransferTimeoutMs = 15000;
 static const int kBlockSize = 4096;
+// Layout of the PseudoTcp header fields inspected by the tests.
+static const size_t kHeaderSize = 24;
+static const size_t kSeqOffset = 4;
+static const size_t kSackCountOffset = 12;
+static const size_t kFlagsOffset = 13;
 
 class PseudoTcpForTest : public cricket::PseudoTcp {
  public:
@@ -68,7 +75,12 @@ class PseudoTcpTestBase : public testing::Test,
         local_mtu_(65535),
         remote_mtu_(65535),
         delay_(0),
-        loss_(0) {
+        loss_(0),
+        drop_data_segment_(-1),
+        data_segments_(0),
+        dropped_end_(0),
+        sack_packets_(0),
+        first_sack_left_(0) {
     // Set use of the test RNG to get predictable loss patterns.
     talk_base::SetRandomTestMode(true);
   }
@@ -90,6 +102,10 @@ class PseudoTcpTestBase : public testing::Test,
   void SetLoss(int percent) {
     loss_ = percent;
   }
+  // Drops the |index|th data segment the local side sends, counting from 0.
+  void DropLocalDataSegment(int index) {
+    drop_data_segment_ = index;
+  }
   void SetOptNagling(bool enable_nagles) {
     local_.SetOption(PseudoTcp::OPT_NODELAY, !enable_nagles);
     remote_.SetOption(PseudoTcp::OPT_NODELAY, !enable_nagles);
@@ -108,6 +124,29 @@ class PseudoTcpTestBase : public testing::Test,
   void SetLocalOptRcvBuf(int size) {
     local_.SetOption(PseudoTcp::OPT_RCVBUF, size);
   }
+  void SetRemoteOptSack(bool enable) {
+    remote_.SetOption(PseudoTcp::OPT_SACK, enable);
+  }
+  void SetLocalOptSack(bool enable) {
+    local_.SetOption(PseudoTcp::OPT_SACK, enable);
+  }
+  void SetOptCongestionControl(cricket::CongestionControl::Algorithm cc) {
+    local_.SetOption(PseudoTcp::OPT_CONGESTION_CONTROL, cc);
+    remote_.SetOption(PseudoTcp::OPT_CONGESTION_CONTROL, cc);
+  }
+  void SetOptPacing(bool enable) {
+    local_.SetOption(PseudoTcp::OPT_PACING, enable);
+    remote_.SetOption(PseudoTcp::OPT_PACING, enable);
+  }
+  void SetOptAckFrequency(int segments) {
+    local_.SetOption(PseudoTcp::OPT_ACKFREQUENCY, segments);
+    remote_.SetOption(PseudoTcp::OPT_ACKFREQUENCY, segments);
+  }
+  uint32 GetLocalCounter(PseudoTcp::Counter counter) {
+    uint32 value = 0;
+    local_.GetCounter(counter, &value);
+    return value;
+  }
   void DisableRemoteWindowScale() {
     remote_.disableWindowScale();
   }
@@ -155,6 +194,19 @@ class PseudoTcpTestBase : public testing::Test,
   }
   virtual WriteResult TcpWritePacket(PseudoTcp* tcp,
                                      const char* buffer, size_t len) {
+    if (tcp == &local_ && len > kHeaderSize && buffer[kFlagsOffset] == 0 &&
+        data_segments_++ == drop_data_segment_) {
+      // The sender never has SACK blocks to report, so the rest is payload.
+      dropped_end_ = talk_base::GetBE32(buffer + kSeqOffset) +
+          static_cast<uint32>(len - kHeaderSize);
+      LOG(LS_VERBOSE) << "Dropping data segment, size=" << len;
+      return WR_SUCCESS;
+    }
+    if (tcp == &remote_ && len >= kHeaderSize && buffer[kSackCountOffset]) {
+      if (sack_packets_++ == 0) {
+        first_sack_left_ = talk_base::GetBE32(buffer + kHeaderSize);
+      }
+    }
     // Randomly drop the desired percentage of packets.
     // Also drop packets that are larger than the configured MTU.
     if (talk_base::CreateRandomId() % 100 < static_cast<uint32>(loss_)) {
@@ -221,6 +273,11 @@ class PseudoTcpTestBase : public testing::Test,
   int remote_mtu_;
   int delay_;
   int loss_;
+  int drop_data_segment_;
+  int data_segments_;
+  uint32 dropped_end_;
+  int sack_packets_;
+  uint32 first_sack_left_;
 };
 
 class PseudoTcpTest : public PseudoTcpTestBase {
@@ -590,6 +647,39 @@ class PseudoTcpTestReceiveWindow : public PseudoTcpTestBase {
   std::vector<size_t> recv_position_;
 };
 
+// Bulk transfer through VirtualSocketServer, so that packets cross a
+// simulated link with finite bandwidth, queueing and delay instead of being
+// handed over directly.
+class PseudoTcpBulkTransferTest : public testing::Test {
+ public:
+  PseudoTcpBulkTransferTest() {
+    transfer_.NotifyMTU(1500);
+  }
+
+  void SetLink(uint32 bandwidth, uint32 delay) {
+    transfer_.SetLink(bandwidth, delay, 0, 0);
+  }
+  void SetOptBuffers(int size) {
+    transfer_.SetOption(PseudoTcp::OPT_SNDBUF, size);
+    transfer_.SetOption(PseudoTcp::OPT_RCVBUF, size);
+  }
+
+  void TestBulkTransfer(uint32 size) {
+    EXPECT_TRUE(transfer_.Run(size, kTransferTimeoutMs * 4));
+    EXPECT_EQ(size, transfer_.received());
+    EXPECT_EQ(0U, transfer_.corrupted());
+    EXPECT_EQ(0U, transfer_.error());
+    uint32 elapsed = talk_base::_max<uint32>(1, transfer_.elapsed());
+    LOG(LS_INFO) << "Transferred " << transfer_.received() << " bytes in "
+                 << elapsed << " ms ("
+                 << static_cast<uint64>(transfer_.received()) * 8 / elapsed
+                 << " Kbps)";
+  }
+
+ private:
+  cricket::PseudoTcpTransfer transfer_;
+};
+
 // Basic end-to-end data transfer tests
 
 // Test the normal case of sending data from one side to the other.
@@ -665,6 +755,119 @@ TEST_F(PseudoTcpTest, TestSendWithDelayAndOptAckDelayOff) {
   TestTransfer(100000);  // less data so test runs faster
 }
 
+// Test sending data with 10% packet loss when the receiver doesn't support
+// selective acks. The sender should fall back to NewReno recovery.
+TEST_F(PseudoTcpTest, TestSendWithLossRemoteNoSack) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  SetRemoteOptSack(false);
+  TestTransfer(100000);
+}
+
+// Test sending data with 10% packet loss when the sender doesn't support
+// selective acks. The receiver must not send any SACK blocks.
+TEST_F(PseudoTcpTest, TestSendWithLossLocalNoSack) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  SetLocalOptSack(false);
+  TestTransfer(100000);
+}
+
+// Test sending data using CUBIC congestion control.
+TEST_F(PseudoTcpTest, TestSendCubic) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetOptCongestionControl(cricket::CongestionControl::CUBIC);
+  TestTransfer(1000000);
+}
+
+// Test sending data with a 50 ms RTT and 10% packet loss using CUBIC.
+TEST_F(PseudoTcpTest, TestSendCubicWithDelayAndLoss) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetDelay(50);
+  SetLoss(10);
+  SetOptCongestionControl(cricket::CongestionControl::CUBIC);
+  TestTransfer(100000);  // less data so test runs faster
+}
+
+// Test sending data with a 50 ms RTT and an ACK every eight segments, which
+// makes every ACK release a burst of segments.
+TEST_F(PseudoTcpTest, TestSendWithDelayUnpacedBursts) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetDelay(50);
+  SetOptAckFrequency(8);
+  TestTransfer(1000000);
+  EXPECT_GT(GetLocalCounter(PseudoTcp::COUNTER_BURSTS), 0U);
+}
+
+// Test the same with the sender paced. Segments should be spread over the
+// round trip rather than sent in bursts.
+TEST_F(PseudoTcpTest, TestSendWithDelayPaced) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetDelay(50);
+  SetOptAckFrequency(8);
+  SetOptPacing(true);
+  TestTransfer(1000000);
+  EXPECT_EQ(0U, GetLocalCounter(PseudoTcp::COUNTER_BURSTS));
+}
+
+// Test sending data with packet loss while paced.
+TEST_F(PseudoTcpTest, TestSendWithLossPaced) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetDelay(50);
+  SetLoss(10);
+  SetOptPacing(true);
+  TestTransfer(100000);  // less data so test runs faster
+}
+
+// Test that the retransmit counter picks up losses and nothing else.
+TEST_F(PseudoTcpTest, TestRetransmitCounter) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  TestTransfer(100000);
+  EXPECT_GT(GetLocalCounter(PseudoTcp::COUNTER_RETRANSMITS), 0U);
+  EXPECT_GT(GetLocalCounter(PseudoTcp::COUNTER_SEGMENTS_SENT),
+            GetLocalCounter(PseudoTcp::COUNTER_RETRANSMITS));
+}
+// Test that a single lost segment is reported in the receiver's SACK blocks
+// and resent exactly once.
+TEST_F(PseudoTcpTest, TestSackSingleLoss) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  DropLocalDataSegment(5);
+  TestTransfer(100000);
+  EXPECT_GT(sack_packets_, 0);
+  // The first block starts right after the hole the dropped segment left.
+  EXPECT_EQ(dropped_end_, first_sack_left_);
+  EXPECT_EQ(1U, GetLocalCounter(PseudoTcp::COUNTER_RETRANSMITS));
+}
+
+TEST_F(PseudoTcpTest, TestNoRetransmitsWithoutLoss) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  TestTransfer(100000);
+  EXPECT_EQ(0U, GetLocalCounter(PseudoTcp::COUNTER_RETRANSMITS));
+  EXPECT_EQ(0U, GetLocalCounter(PseudoTcp::COUNTER_DROPS));
+  // At least one segment per MSS worth of data.
+  EXPECT_GE(GetLocalCounter(PseudoTcp::COUNTER_SEGMENTS_SENT),
+            100000U / 1500);
+}
+
+// Test sending data with an ACK for every segment.
+TEST_F(PseudoTcpTest, TestSendAckEverySegment) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetOptAckFrequency(1);
+  TestTransfer(1000000);
+}
+
 // Test a large receive buffer with a sender that doesn't support scaling.
 TEST_F(PseudoTcpTest, TestSendRemoteNoWindowScale) {
   SetLocalMtu(1500);
@@ -711,6 +914,16 @@ TEST_F(PseudoTcpTest, TestSendBothUseLargeWindowScale) {
   TestTransfer(10000000);
 }
 
+// Test using multi-megabyte buffers on both sides.
+TEST_F(PseudoTcpTest, TestSendBothUseMultiMegabyteWindowScale) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetRemoteOptRcvBuf(4 * 1024 * 1024);
+  SetLocalOptRcvBuf(4 * 1024 * 1024);
+  SetOptSndBuf(6 * 1024 * 1024);
+  TestTransfer(20000000);
+}
+
 // Test using a small receive buffer.
 TEST_F(PseudoTcpTest, TestSendSmallReceiveBuffer) {
   SetLocalMtu(1500);
@@ -843,3 +1056,29 @@ TEST_F(PseudoTcpTest, TestSendWithMismatchedMtus) {
   TestTransfer(1000000);
 }
 */
+
+// Bulk transfers over a simulated link
+
+// Test that a transfer over a 10 MB/s link with 50 ms RTT negotiates a
+// multi-megabyte window and arrives intact.
+TEST_F(PseudoTcpBulkTransferTest, TestBulkTransferLargeWindow) {
+  SetLink(10 * 1024 * 1024, 25);
+  SetOptBuffers(4 * 1024 * 1024);
+  TestBulkTransfer(1024 * 1024);
+}
+
+// The transfers below move 16 MB each and are meant as benchmarks, so they
+// are disabled by default. Run them with --gtest_also_run_disabled_tests.
+
+// Benchmark a bulk transfer over an unconstrained link.
+TEST_F(PseudoTcpBulkTransferTest, DISABLED_BenchmarkBulkTransfer) {
+  TestBulkTransfer(16 * 1024 * 1024);
+}
+
+// Benchmark a bulk transfer over a 10 MB/s link with 50 ms RTT, which needs
+// multi-megabyte windows to be filled.
+TEST_F(PseudoTcpBulkTransferTest, DISABLED_BenchmarkBulkTransferLargeWindow) {
+  SetLink(10 * 1024 * 1024, 25);
+  SetOptBuffers(4 * 1024 * 1024);
+  TestBulkTransfer(16 * 1024 * 1024);
+}
@@ -0,0 +1,161 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Runs bulk transfers through PseudoTcp over a simulated link and prints one
+// line of JSON per run, so that transport changes can be compared and
+// throughput regressions caught by scripts.
+//
+//   pseudotcpbenchmark --bandwidth 1000 --rtt 100 --loss 1 --runs 5
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "talk/base/flags.h"
+#include "talk/base/logging.h"
+#include "talk/p2p/base/pseudotcp.h"
+#include "talk/p2p/base/pseudotcptransfer.h"
+
+using cricket::PseudoTcp;
+
+DEFINE_int(size, 8 * 1024 * 1024, "Bytes to transfer per run.");
+DEFINE_int(runs, 1, "Number of transfers to run.");
+DEFINE_int(bandwidth, 0, "Link bandwidth in KB/s (0 == unlimited).");
+DEFINE_int(queue, 0, "Link queue in KB (0 == one bandwidth-delay product, "
+           "at least 64 KB).");
+DEFINE_int(rtt, 0, "Round trip time in ms.");
+DEFINE_int(jitter, 0, "Standard deviation of the one-way delay in ms.");
+DEFINE_float(loss, 0, "Percentage of packets dropped, in both directions.");
+DEFINE_float(reorder, 0, "Percentage of packets held back by --reorderdelay.");
+DEFINE_int(reorderdelay, 10, "Extra delay for reordered packets in ms.");
+DEFINE_int(mtu, 1500, "Path MTU.");
+DEFINE_int(buffer, 0, "Send and receive buffer size (0 == default).");
+DEFINE_string(cc, "reno", "Congestion control: reno or cubic.");
+DEFINE_bool(pacing, false, "Pace the sender.");
+DEFINE_bool(sack, true, "Offer selective acknowledgements.");
+DEFINE_int(ackdelay, -1, "Delayed ACK timeout in ms (-1 == default).");
+DEFINE_int(ackfrequency, 0, "ACK every N segments (0 == default).");
+DEFINE_int(timeout, 120, "Give up on a run after this many seconds.");
+DEFINE_int(seed, 1, "Random seed for loss, jitter and reordering.");
+DEFINE_bool(help, false, "Prints this message.");
+
+// Percentile |p| of the sorted |samples|.
+static uint32 Percentile(const std::vector<uint32>& samples, int p) {
+  if (samples.empty()) {
+    return 0;
+  }
+  size_t index = (samples.size() - 1) * p / 100;
+  return samples[index];
+}
+
+static void Configure(cricket::PseudoTcpTransfer* transfer) {
+  transfer->SetLink(FLAG_bandwidth * 1024, FLAG_rtt / 2, FLAG_jitter,
+                    FLAG_queue * 1024);
+  transfer->SetLoss(FLAG_loss);
+  transfer->SetReorder(FLAG_reorder, FLAG_reorderdelay);
+  transfer->NotifyMTU(FLAG_mtu);
+  if (FLAG_buffer > 0) {
+    transfer->SetOption(PseudoTcp::OPT_SNDBUF, FLAG_buffer);
+    transfer->SetOption(PseudoTcp::OPT_RCVBUF, FLAG_buffer);
+  }
+  int cc = (strcmp(FLAG_cc, "cubic") == 0) ?
+      cricket::CongestionControl::CUBIC : cricket::CongestionControl::RENO;
+  transfer->SetOption(PseudoTcp::OPT_CONGESTION_CONTROL, cc);
+  transfer->SetOption(PseudoTcp::OPT_PACING, FLAG_pacing);
+  transfer->SetOption(PseudoTcp::OPT_SACK, FLAG_sack);
+  if (FLAG_ackdelay >= 0) {
+    transfer->SetOption(PseudoTcp::OPT_ACKDELAY, FLAG_ackdelay);
+  }
+  if (FLAG_ackfrequency > 0) {
+    transfer->SetOption(PseudoTcp::OPT_ACKFREQUENCY, FLAG_ackfrequency);
+  }
+}
+
+static void Print(int run, bool completed,
+                  cricket::PseudoTcpTransfer* transfer) {
+  uint32 elapsed = talk_base::_max<uint32>(1, transfer->elapsed());
+  uint32 received = transfer->received();
+  uint32 segments = 0, retransmits = 0, bursts = 0, drops = 0;
+  PseudoTcp* local = transfer->local();
+  local->GetCounter(PseudoTcp::COUNTER_SEGMENTS_SENT, &segments);
+  local->GetCounter(PseudoTcp::COUNTER_RETRANSMITS, &retransmits);
+  local->GetCounter(PseudoTcp::COUNTER_BURSTS, &bursts);
+  local->GetCounter(PseudoTcp::COUNTER_DROPS, &drops);
+  std::vector<uint32> latencies(transfer->latencies());
+  std::sort(latencies.begin(), latencies.end());
+
+  printf("{\"run\": %d, \"completed\": %s, \"corrupted\": %u, "
+         "\"bandwidth_kBps\": %d, \"rtt_ms\": %d, \"jitter_ms\": %d, "
+         "\"loss_pct\": %.2f, \"reorder_pct\": %.2f, \"cc\": \"%s\", "
+         "\"pacing\": %s, \"sack\": %s, "
+         "\"bytes\": %u, \"elapsed_ms\": %u, \"goodput_kbps\": %.1f, "
+         "\"segments_sent\": %u, \"retransmits\": %u, "
+         "\"retransmit_ratio\": %.4f, \"bursts\": %u, \"drops\": %u, "
+         "\"latency_p50_ms\": %u, \"latency_p90_ms\": %u, "
+         "\"latency_p99_ms\": %u, \"latency_max_ms\": %u}\n",
+         run, completed ? "true" : "false", transfer->corrupted(),
+         FLAG_bandwidth, FLAG_rtt, FLAG_jitter,
+         FLAG_loss, FLAG_reorder, FLAG_cc,
+         FLAG_pacing ? "true" : "false", FLAG_sack ? "true" : "false",
+         received, elapsed, received * 8.0 / elapsed,
+         segments, retransmits,
+         segments ? static_cast<double>(retransmits) / segments : 0.0,
+         bursts, drops,
+         Percentile(latencies, 50), Percentile(latencies, 90),
+         Percentile(latencies, 99), Percentile(latencies, 100));
+  fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+  FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help) {
+    FlagList::Print(NULL, false);
+    return 0;
+  }
+  if (FLAG_size <= 0 || FLAG_runs <= 0) {
+    fprintf(stderr, "--size and --runs must be positive\n");
+    return 1;
+  }
+  talk_base::LogMessage::LogToDebug(talk_base::LS_ERROR);
+  srand(FLAG_seed);
+
+  int failures = 0;
+  for (int run = 0; run < FLAG_runs; ++run) {
+    cricket::PseudoTcpTransfer transfer;
+    Configure(&transfer);
+    bool completed = transfer.Run(FLAG_size, FLAG_timeout * 1000);
+    Print(run, completed, &transfer);
+    if (!completed) {
+      ++failures;
+    }
+  }
+  return failures ? 1 : 0;
+}
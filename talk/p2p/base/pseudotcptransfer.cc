@@ -0,0 +1,247 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/p2p/base/pseudotcptransfer.h"
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "talk/base/asyncudpsocket.h"
+#include "talk/base/logging.h"
+#include "talk/base/timeutils.h"
+#include "talk/base/virtualsocketserver.h"
+
+namespace cricket {
+
+static const uint32 kTransferBlockSize = 16 * 1024;
+static const uint32 kMinQueue = 64 * 1024;
+
+// A packet held back to be delivered out of order.
+struct PseudoTcpTransfer::DelayedPacket {
+  talk_base::AsyncPacketSocket* from;
+  talk_base::AsyncPacketSocket* to;
+  std::string data;
+};
+
+PseudoTcpTransfer::PseudoTcpTransfer()
+    : vss_(new talk_base::VirtualSocketServer(NULL)),
+      ss_scope_(vss_.get()),
+      local_(this, 1),
+      remote_(this, 1),
+      local_socket_(CreateSocket()),
+      remote_socket_(CreateSocket()),
+      reorder_(0),
+      reorder_delay_(0),
+      size_(0),
+      sent_(0),
+      received_(0),
+      corrupted_(0),
+      error_(0),
+      start_(0),
+      finish_(0) {
+}
+
+PseudoTcpTransfer::~PseudoTcpTransfer() {
+  talk_base::Thread::Current()->Clear(this);
+}
+
+void PseudoTcpTransfer::SetLink(uint32 bandwidth, uint32 delay,
+                                uint32 jitter, uint32 queue) {
+  vss_->set_bandwidth(bandwidth);
+  vss_->set_delay_mean(delay);
+  vss_->set_delay_stddev(jitter);
+  vss_->UpdateDelayDistribution();
+  if (queue > 0) {
+    vss_->set_network_capacity(queue);
+  } else if (bandwidth > 0) {
+    vss_->set_network_capacity(talk_base::_max(
+        kMinQueue, bandwidth / 1000 * talk_base::_max<uint32>(2 * delay, 1)));
+  }
+}
+
+void PseudoTcpTransfer::SetLoss(double percent) {
+  vss_->set_drop_probability(percent / 100.0);
+}
+
+void PseudoTcpTransfer::SetReorder(double percent, int delay) {
+  reorder_ = percent;
+  reorder_delay_ = delay;
+}
+
+void PseudoTcpTransfer::SetOption(PseudoTcp::Option opt, int value) {
+  local_.SetOption(opt, value);
+  remote_.SetOption(opt, value);
+}
+
+void PseudoTcpTransfer::NotifyMTU(uint16 mtu) {
+  local_.NotifyMTU(mtu);
+  remote_.NotifyMTU(mtu);
+}
+
+bool PseudoTcpTransfer::Run(uint32 size, int timeout) {
+  size_ = size;
+  start_ = talk_base::Time();
+  local_.Connect();
+  UpdateClock(&local_, MSG_LCLOCK);
+
+  talk_base::Thread* thread = talk_base::Thread::Current();
+  while ((received_ < size_) && (error_ == 0) &&
+         (talk_base::TimeSince(start_) < timeout)) {
+    thread->ProcessMessages(10);
+  }
+  finish_ = talk_base::Time();
+  return received_ == size_;
+}
+
+talk_base::AsyncPacketSocket* PseudoTcpTransfer::CreateSocket() {
+  talk_base::AsyncPacketSocket* socket = talk_base::AsyncUDPSocket::Create(
+      vss_.get(), talk_base::SocketAddress("127.0.0.1", 0));
+  socket->SignalReadPacket.connect(this, &PseudoTcpTransfer::OnReadPacket);
+  return socket;
+}
+
+void PseudoTcpTransfer::OnTcpOpen(PseudoTcp* tcp) {
+  if (tcp == &local_) {
+    WriteData();
+  }
+}
+
+void PseudoTcpTransfer::OnTcpReadable(PseudoTcp* tcp) {
+  if (tcp == &remote_) {
+    ReadData();
+  }
+}
+
+void PseudoTcpTransfer::OnTcpWriteable(PseudoTcp* tcp) {
+  if (tcp == &local_) {
+    WriteData();
+  }
+}
+
+void PseudoTcpTransfer::OnTcpClosed(PseudoTcp* tcp, uint32 error) {
+  LOG(LS_ERROR) << "Connection closed, error " << error;
+  error_ = error;
+}
+
+IPseudoTcpNotify::WriteResult PseudoTcpTransfer::TcpWritePacket(
+    PseudoTcp* tcp, const char* buffer, size_t len) {
+  talk_base::AsyncPacketSocket* from =
+      (tcp == &local_) ? local_socket_.get() : remote_socket_.get();
+  talk_base::AsyncPacketSocket* to =
+      (tcp == &local_) ? remote_socket_.get() : local_socket_.get();
+  if (reorder_ > 0 && rand() < reorder_ / 100.0 * RAND_MAX) {
+    DelayedPacket* packet = new DelayedPacket;
+    packet->from = from;
+    packet->to = to;
+    packet->data.assign(buffer, len);
+    talk_base::Thread::Current()->PostDelayed(
+        reorder_delay_, this, MSG_REORDERED,
+        new talk_base::ScopedMessageData<DelayedPacket>(packet));
+    return WR_SUCCESS;
+  }
+  if (from->SendTo(buffer, len, to->GetLocalAddress()) < 0) {
+    return WR_FAIL;
+  }
+  return WR_SUCCESS;
+}
+
+void PseudoTcpTransfer::OnReadPacket(talk_base::AsyncPacketSocket* socket,
+                                     const char* data, size_t size,
+                                     const talk_base::SocketAddress& addr) {
+  if (socket == local_socket_.get()) {
+    local_.NotifyPacket(data, size);
+    UpdateClock(&local_, MSG_LCLOCK);
+  } else {
+    remote_.NotifyPacket(data, size);
+    UpdateClock(&remote_, MSG_RCLOCK);
+  }
+}
+
+void PseudoTcpTransfer::UpdateClock(PseudoTcp* tcp, uint32 message) {
+  long interval = 0;  // NOLINT
+  tcp->GetNextClock(PseudoTcp::Now(), interval);
+  interval = talk_base::_max<long>(interval, 0L);  // NOLINT
+  talk_base::Thread::Current()->Clear(this, message);
+  talk_base::Thread::Current()->PostDelayed(interval, this, message);
+}
+
+void PseudoTcpTransfer::OnMessage(talk_base::Message* message) {
+  if (message->message_id == MSG_REORDERED) {
+    talk_base::ScopedMessageData<DelayedPacket>* data =
+        static_cast<talk_base::ScopedMessageData<DelayedPacket>*>(
+            message->pdata);
+    const DelayedPacket* packet = data->data().get();
+    packet->from->SendTo(packet->data.data(), packet->data.size(),
+                         packet->to->GetLocalAddress());
+    delete data;
+    return;
+  }
+  PseudoTcp* tcp = (message->message_id == MSG_LCLOCK) ? &local_ : &remote_;
+  tcp->NotifyClock(PseudoTcp::Now());
+  UpdateClock(tcp, message->message_id);
+}
+
+// The time each block is handed to PseudoTcp is kept to measure how long it
+// takes to arrive.
+void PseudoTcpTransfer::WriteData() {
+  char block[kTransferBlockSize];
+  while (sent_ < size_) {
+    uint32 tosend = talk_base::_min<uint32>(kTransferBlockSize, size_ - sent_);
+    for (uint32 i = 0; i < tosend; ++i) {
+      block[i] = static_cast<char>(sent_ + i);
+    }
+    int sent = local_.Send(block, tosend);
+    UpdateClock(&local_, MSG_LCLOCK);
+    if (sent <= 0) {
+      break;
+    }
+    sent_ += sent;
+    pending_.push_back(std::make_pair(sent_, talk_base::Time()));
+  }
+}
+
+void PseudoTcpTransfer::ReadData() {
+  char block[kTransferBlockSize];
+  int rcvd;
+  while ((rcvd = remote_.Recv(block, sizeof(block))) > 0) {
+    for (int i = 0; i < rcvd; ++i) {
+      if (block[i] != static_cast<char>(received_ + i)) {
+        ++corrupted_;
+      }
+    }
+    received_ += rcvd;
+  }
+  uint32 now = talk_base::Time();
+  while (!pending_.empty() && pending_.front().first <= received_) {
+    latencies_.push_back(now - pending_.front().second);
+    pending_.pop_front();
+  }
+  UpdateClock(&remote_, MSG_RCLOCK);
+}
+
+}  // namespace cricket
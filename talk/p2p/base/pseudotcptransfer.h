@@ -0,0 +1,143 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_P2P_BASE_PSEUDOTCPTRANSFER_H_
+#define TALK_P2P_BASE_PSEUDOTCPTRANSFER_H_
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "talk/base/constructormagic.h"
+#include "talk/base/messagehandler.h"
+#include "talk/base/scoped_ptr.h"
+#include "talk/base/sigslot.h"
+#include "talk/base/thread.h"
+#include "talk/p2p/base/pseudotcp.h"
+
+namespace talk_base {
+class AsyncPacketSocket;
+class SocketAddress;
+class VirtualSocketServer;
+}
+
+namespace cricket {
+
+// Runs a one-way bulk transfer between two PseudoTcp endpoints connected
+// through a VirtualSocketServer, so that packets cross a simulated link with
+// finite bandwidth, queueing, delay and loss. The payload is a running byte
+// counter that the receiver checks on the fly, so transfers can be much
+// larger than the data a test would want to keep around.
+//
+// The VirtualSocketServer is installed on the current thread for the
+// lifetime of the object. Used by the PseudoTcp unittests and by
+// pseudotcpbenchmark.
+class PseudoTcpTransfer : public talk_base::MessageHandler,
+                          public sigslot::has_slots<>,
+                          public IPseudoTcpNotify {
+ public:
+  PseudoTcpTransfer();
+  virtual ~PseudoTcpTransfer();
+
+  // Configures the link in both directions. |bandwidth| is in bytes per
+  // second, 0 meaning unlimited. |delay| and |jitter| are the mean and
+  // standard deviation of the one-way delay in ms. |queue| is the link
+  // queue in bytes; 0 means one bandwidth-delay product, at least 64 KB.
+  void SetLink(uint32 bandwidth, uint32 delay, uint32 jitter, uint32 queue);
+  // Drops |percent| of the packets in both directions.
+  void SetLoss(double percent);
+  // Holds back |percent| of the packets by an extra |delay| ms, so that
+  // they arrive out of order.
+  void SetReorder(double percent, int delay);
+  // Sets |opt| on both endpoints.
+  void SetOption(PseudoTcp::Option opt, int value);
+  void NotifyMTU(uint16 mtu);
+
+  // Transfers |size| bytes from the local to the remote endpoint. Returns
+  // false if the transfer didn't complete within |timeout| ms.
+  bool Run(uint32 size, int timeout);
+
+  PseudoTcp* local() { return &local_; }
+  PseudoTcp* remote() { return &remote_; }
+  uint32 received() const { return received_; }
+  // Bytes that didn't match the running counter.
+  uint32 corrupted() const { return corrupted_; }
+  // Error the connection was closed with, or 0.
+  uint32 error() const { return error_; }
+  // Duration of the last run in ms.
+  uint32 elapsed() const { return finish_ - start_; }
+  // Time each written block took to arrive, in ms, in write order.
+  const std::vector<uint32>& latencies() const { return latencies_; }
+
+ private:
+  enum { MSG_LCLOCK, MSG_RCLOCK, MSG_REORDERED };
+
+  struct DelayedPacket;
+
+  talk_base::AsyncPacketSocket* CreateSocket();
+
+  // IPseudoTcpNotify implementation.
+  virtual void OnTcpOpen(PseudoTcp* tcp);
+  virtual void OnTcpReadable(PseudoTcp* tcp);
+  virtual void OnTcpWriteable(PseudoTcp* tcp);
+  virtual void OnTcpClosed(PseudoTcp* tcp, uint32 error);
+  virtual WriteResult TcpWritePacket(PseudoTcp* tcp,
+                                     const char* buffer, size_t len);
+
+  void OnReadPacket(talk_base::AsyncPacketSocket* socket, const char* data,
+                    size_t size, const talk_base::SocketAddress& addr);
+  void UpdateClock(PseudoTcp* tcp, uint32 message);
+  virtual void OnMessage(talk_base::Message* message);
+
+  void WriteData();
+  void ReadData();
+
+  talk_base::scoped_ptr<talk_base::VirtualSocketServer> vss_;
+  talk_base::SocketServerScope ss_scope_;
+  PseudoTcp local_;
+  PseudoTcp remote_;
+  talk_base::scoped_ptr<talk_base::AsyncPacketSocket> local_socket_;
+  talk_base::scoped_ptr<talk_base::AsyncPacketSocket> remote_socket_;
+  double reorder_;
+  int reorder_delay_;
+  uint32 size_;
+  uint32 sent_;
+  uint32 received_;
+  uint32 corrupted_;
+  uint32 error_;
+  uint32 start_;
+  uint32 finish_;
+  // (end offset, time written) of blocks not yet fully received.
+  std::deque<std::pair<uint32, uint32> > pending_;
+  std::vector<uint32> latencies_;
+
+  DISALLOW_COPY_AND_ASSIGN(PseudoTcpTransfer);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_P2P_BASE_PSEUDOTCPTRANSFER_H_
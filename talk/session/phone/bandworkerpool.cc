@@ -0,0 +1,136 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/session/phone/bandworkerpool.h"
+
+#include "talk/base/common.h"
+#include "talk/base/event.h"
+#include "talk/base/thread.h"
+
+namespace cricket {
+
+// The state of one Run, shared by the threads doing its bands.
+struct BandRun {
+  BandRun(BandTask* task, int pending)
+      : task(task), pending(pending), done(false, false) {
+  }
+
+  BandTask* task;
+  int pending;  // Bands given to the workers and not yet done.
+  talk_base::Event done;
+};
+
+struct BandParams {
+  BandRun* run;
+  int first_row;
+  int last_row;
+};
+
+BandWorkerPool::BandWorkerPool() : num_threads_(1) {
+}
+
+BandWorkerPool::~BandWorkerPool() {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->Stop();
+    delete workers_[i];
+  }
+}
+
+BandWorkerPool* BandWorkerPool::Default() {
+  static BandWorkerPool* pool = new BandWorkerPool();
+  return pool;
+}
+
+void BandWorkerPool::set_num_threads(int num_threads) {
+  talk_base::CritScope cs(&crit_);
+  num_threads_ = talk_base::_max(num_threads, 1);
+  while (static_cast<int>(workers_.size()) < num_threads_ - 1) {
+    talk_base::Thread* worker = new talk_base::Thread();
+    worker->Start();
+    workers_.push_back(worker);
+  }
+}
+
+int BandWorkerPool::num_threads() {
+  talk_base::CritScope cs(&crit_);
+  return num_threads_;
+}
+
+void BandWorkerPool::Run(BandTask* task, int num_rows, int alignment) {
+  alignment = talk_base::_max(alignment, 1);
+  int num_bands;
+  std::vector<talk_base::Thread*> workers;
+  {
+    talk_base::CritScope cs(&crit_);
+    num_bands = talk_base::_min(num_threads_, num_rows / kMinBandRows);
+    workers.assign(workers_.begin(),
+                   workers_.begin() + talk_base::_max(num_bands - 1, 0));
+  }
+  if (num_bands <= 1) {
+    task->ProcessBand(0, num_rows);
+    return;
+  }
+
+  // Make bands of nearly equal size on |alignment| boundaries. The calling
+  // thread takes the last, which may be shorter.
+  int units = (num_rows + alignment - 1) / alignment;
+  std::vector<int> boundaries;
+  boundaries.push_back(0);
+  for (int i = 1; i < num_bands; ++i) {
+    int row = units * i / num_bands * alignment;
+    if (row > boundaries.back() && row < num_rows) {
+      boundaries.push_back(row);
+    }
+  }
+  boundaries.push_back(num_rows);
+
+  int posted = static_cast<int>(boundaries.size()) - 2;
+  BandRun run(task, posted);
+  for (int i = 0; i < posted; ++i) {
+    BandParams band = { &run, boundaries[i], boundaries[i + 1] };
+    workers[i]->Post(this, 0,
+                     new talk_base::TypedMessageData<BandParams>(band));
+  }
+  task->ProcessBand(boundaries[posted], num_rows);
+  if (posted > 0) {
+    run.done.Wait(talk_base::kForever);
+  }
+}
+
+void BandWorkerPool::OnMessage(talk_base::Message* msg) {
+  talk_base::TypedMessageData<BandParams>* data =
+      static_cast<talk_base::TypedMessageData<BandParams>*>(msg->pdata);
+  BandRun* run = data->data().run;
+  run->task->ProcessBand(data->data().first_row, data->data().last_row);
+  delete data;
+  // |run| is gone as soon as the caller sees the last band done.
+  if (talk_base::AtomicOps::Decrement(&run->pending) == 0) {
+    run->done.Set();
+  }
+}
+
+}  // namespace cricket
@@ -0,0 +1,91 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_SESSION_PHONE_BANDWORKERPOOL_H_
+#define TALK_SESSION_PHONE_BANDWORKERPOOL_H_
+
+#include <vector>
+
+#include "talk/base/basictypes.h"
+#include "talk/base/constructormagic.h"
+#include "talk/base/criticalsection.h"
+#include "talk/base/messagehandler.h"
+
+namespace talk_base {
+class Thread;
+}
+
+namespace cricket {
+
+// A piece of per-frame work that can be done a horizontal band of rows at a
+// time. ProcessBand is called concurrently for disjoint bands.
+class BandTask {
+ public:
+  virtual ~BandTask() {}
+  // Processes the output rows [first_row, last_row).
+  virtual void ProcessBand(int first_row, int last_row) = 0;
+};
+
+// BandWorkerPool splits a frame into horizontal bands and processes them on
+// a few worker threads and the calling thread, returning when the whole frame
+// is done. With one thread, which is the default, the work is done on the
+// calling thread alone. BandWorkerPool is thread safe.
+class BandWorkerPool : public talk_base::MessageHandler {
+ public:
+  // Bands are not made smaller than this, so that small frames are not worth
+  // the cost of waking the workers.
+  static const int kMinBandRows = 32;
+
+  BandWorkerPool();
+  virtual ~BandWorkerPool();
+
+  // The pool used by VideoFrame scaling and color conversion.
+  static BandWorkerPool* Default();
+
+  // Sets the number of threads, the calling one included, that a frame is
+  // split across. Worker threads are started as needed and kept.
+  void set_num_threads(int num_threads);
+  int num_threads();
+
+  // Runs |task| over the rows [0, num_rows). Band boundaries are multiples of
+  // |alignment| rows.
+  void Run(BandTask* task, int num_rows, int alignment);
+
+  // Implements talk_base::MessageHandler. Context: worker thread.
+  virtual void OnMessage(talk_base::Message* msg);
+
+ private:
+  talk_base::CriticalSection crit_;
+  int num_threads_;
+  std::vector<talk_base::Thread*> workers_;
+
+  DISALLOW_COPY_AND_ASSIGN(BandWorkerPool);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_SESSION_PHONE_BANDWORKERPOOL_H_
@@ -0,0 +1,104 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <vector>
+
+#include "talk/base/gunit.h"
+#include "talk/base/scoped_ptr.h"
+#include "talk/session/phone/bandworkerpool.h"
+
+namespace cricket {
+
+// Records which rows were processed, and by how many bands.
+class RecordingTask : public BandTask {
+ public:
+  explicit RecordingTask(int num_rows) : rows_(num_rows, 0), bands_(0) {}
+
+  virtual void ProcessBand(int first_row, int last_row) {
+    for (int i = first_row; i < last_row; ++i) {
+      ++rows_[i];
+    }
+    talk_base::CritScope cs(&crit_);
+    ++bands_;
+    first_rows_.push_back(first_row);
+  }
+
+  bool AllRowsOnce() const {
+    for (size_t i = 0; i < rows_.size(); ++i) {
+      if (rows_[i] != 1) {
+        return false;
+      }
+    }
+    return true;
+  }
+  int bands() const { return bands_; }
+  const std::vector<int>& first_rows() const { return first_rows_; }
+
+ private:
+  std::vector<int> rows_;
+  talk_base::CriticalSection crit_;
+  int bands_;
+  std::vector<int> first_rows_;
+};
+
+// Test that with one thread the whole frame is one band.
+TEST(BandWorkerPoolTest, SingleThread) {
+  BandWorkerPool pool;
+  EXPECT_EQ(1, pool.num_threads());
+  RecordingTask task(720);
+  pool.Run(&task, 720, 2);
+  EXPECT_TRUE(task.AllRowsOnce());
+  EXPECT_EQ(1, task.bands());
+}
+
+// Test that every row is processed exactly once, in aligned bands.
+TEST(BandWorkerPoolTest, Bands) {
+  BandWorkerPool pool;
+  pool.set_num_threads(4);
+  EXPECT_EQ(4, pool.num_threads());
+  for (int i = 0; i < 100; ++i) {
+    RecordingTask task(719);
+    pool.Run(&task, 719, 6);
+    EXPECT_TRUE(task.AllRowsOnce());
+    EXPECT_EQ(4, task.bands());
+    for (size_t j = 0; j < task.first_rows().size(); ++j) {
+      EXPECT_EQ(0, task.first_rows()[j] % 6);
+    }
+  }
+}
+
+// Test that small frames are not split.
+TEST(BandWorkerPoolTest, SmallFrame) {
+  BandWorkerPool pool;
+  pool.set_num_threads(4);
+  RecordingTask task(BandWorkerPool::kMinBandRows + 1);
+  pool.Run(&task, BandWorkerPool::kMinBandRows + 1, 2);
+  EXPECT_TRUE(task.AllRowsOnce());
+  EXPECT_EQ(1, task.bands());
+}
+
+}  // namespace cricket
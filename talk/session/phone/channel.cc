@@ -61,8 +61,8 @@ enum {
   MSG_SENDINTRAFRAME = 19,
   MSG_REQUESTINTRAFRAME = 20,
   MSG_SCREENCASTWINDOWEVENT = 21,
-  MSG_RTPPACKET = 22,
-  MSG_RTCPPACKET = 23,
+  MSG_SENDQUEUEDPACKETS = 22,
+  // Removed MSG_RTCPPACKET = 23. Queued packets are sent in batches now.
   MSG_CHANNEL_ERROR = 24,
   MSG_SETCHANNELOPTIONS = 25,
   MSG_SCALEVOLUME = 26,
@@ -132,10 +132,6 @@ struct ScaleVolumeMessageData : public talk_base::MessageData {
   bool result;
 };
 
-struct PacketMessageData : public talk_base::MessageData {
-  talk_base::Buffer packet;
-};
-
 struct RenderMessageData : public talk_base::MessageData {
   RenderMessageData(uint32 s, VideoRenderer* r) : ssrc(s), renderer(r) {}
   uint32 ssrc;
@@ -209,15 +205,22 @@ struct ChannelOptionsMessageData : public talk_base::MessageData {
   int options;
 };
 
+// The largest batch of packets queued from another thread that is handed to
+// the worker at once.
+static const size_t kMaxSendBatchPackets = 64;
+
 static const char* PacketType(bool rtcp) {
   return (!rtcp) ? "RTP" : "RTCP";
 }
 
-static bool ValidPacket(bool rtcp, const talk_base::Buffer* packet) {
+static bool ValidPacket(bool rtcp, size_t length) {
   // Check the packet size. We could check the header too if needed.
-  return (packet &&
-      packet->length() >= (!rtcp ? kMinRtpPacketLen : kMinRtcpPacketLen) &&
-      packet->length() <= kMaxRtpPacketLen);
+  return (length >= (!rtcp ? kMinRtpPacketLen : kMinRtcpPacketLen) &&
+      length <= kMaxRtpPacketLen);
+}
+
+static bool ValidPacket(bool rtcp, const talk_base::Buffer* packet) {
+  return (packet && ValidPacket(rtcp, packet->length()));
 }
 
 BaseChannel::BaseChannel(talk_base::Thread* thread,
@@ -230,6 +233,11 @@ BaseChannel::BaseChannel(talk_base::Thread* thread,
       media_channel_(media_channel),
       content_name_(content_name),
       rtcp_(rtcp),
+      send_queue_posted_(false),
+      send_batch_delay_(0),
+      send_batches_(0),
+      queued_packets_(0),
+      recv_packet_(NULL, 0, kMaxRtpPacketLen),
       transport_channel_(NULL),
       rtcp_transport_channel_(NULL),
       enabled_(false),
@@ -390,8 +398,7 @@ void BaseChannel::OnChannelRead(TransportChannel* channel,
   // When using RTCP multiplexing we might get RTCP packets on the RTP
   // transport. We feed RTP traffic into the demuxer to determine if it is RTCP.
   bool rtcp = PacketIsRtcp(channel, data, len);
-  talk_base::Buffer packet(data, len);
-  HandlePacket(rtcp, &packet);
+  HandlePacket(rtcp, data, len);
 }
 
 bool BaseChannel::PacketIsRtcp(const TransportChannel* channel,
@@ -413,12 +420,10 @@ bool BaseChannel::SendPacket(bool rtcp, talk_base::Buffer* packet) {
   // SRTP and the inner workings of the transport channels.
   // The only downside is that we can't return a proper failure code if
   // needed. Since UDP is unreliable anyway, this should be a non-issue.
+  // Packets are queued so that a video frame split into many packets wakes
+  // the worker once, not once per packet.
   if (talk_base::Thread::Current() != worker_thread_) {
-    // Avoid a copy by transferring the ownership of the packet data.
-    int message_id = (!rtcp) ? MSG_RTPPACKET : MSG_RTCPPACKET;
-    PacketMessageData* data = new PacketMessageData;
-    packet->TransferTo(&data->packet);
-    worker_thread_->Post(this, message_id, data);
+    QueuePacket(rtcp, packet);
     return true;
   }
 
@@ -484,59 +489,115 @@ bool BaseChannel::SendPacket(bool rtcp, talk_base::Buffer* packet) {
       == static_cast<int>(packet->length()));
 }
 
-void BaseChannel::HandlePacket(bool rtcp, talk_base::Buffer* packet) {
+void BaseChannel::QueuePacket(bool rtcp, talk_base::Buffer* packet) {
+  // Avoid a copy by transferring the ownership of the packet data.
+  QueuedPacket queued;
+  queued.rtcp = rtcp;
+  queued.packet = new talk_base::Buffer;
+  packet->TransferTo(queued.packet);
+
+  talk_base::CritScope cs(&send_queue_cs_);
+  send_queue_.push_back(queued);
+  if (!send_queue_posted_) {
+    // The first packet of a batch bounds how long the batch may wait.
+    send_queue_posted_ = true;
+    if (send_batch_delay_ > 0) {
+      PostDelayed(send_batch_delay_, MSG_SENDQUEUEDPACKETS);
+    } else {
+      Post(MSG_SENDQUEUEDPACKETS);
+    }
+  } else if (send_queue_.size() == kMaxSendBatchPackets) {
+    // Don't let a full batch wait for the delay to run out.
+    Post(MSG_SENDQUEUEDPACKETS);
+  }
+}
+
+void BaseChannel::SendQueuedPackets_w() {
+  ASSERT(worker_thread_ == talk_base::Thread::Current());
+  std::vector<QueuedPacket> batch;
+  {
+    talk_base::CritScope cs(&send_queue_cs_);
+    send_queue_posted_ = false;
+    batch.swap(send_queue_);
+  }
+  if (batch.empty()) {
+    return;
+  }
+  ++send_batches_;
+  queued_packets_ += batch.size();
+  for (size_t i = 0; i < batch.size(); ++i) {
+    SendPacket(batch[i].rtcp, batch[i].packet);
+    delete batch[i].packet;
+  }
+}
+
+void BaseChannel::HandlePacket(bool rtcp, const char* data, size_t len) {
   // Protect ourselvs against crazy data.
-  if (!ValidPacket(rtcp, packet)) {
+  if (!ValidPacket(rtcp, len)) {
     LOG(LS_ERROR) << "Dropping incoming " << content_name_ << " "
-                  << PacketType(rtcp) << " packet: wrong size="
-                  << packet->length();
+                  << PacketType(rtcp) << " packet: wrong size=" << len;
     return;
   }
 
+  // Read the header once; the stages below all work from the descriptor.
+  // The header isn't encrypted by SRTP, so it stays valid after unprotecting.
+  // A packet that fails to parse is marked as such in |desc|.
+  RtpPacketDescriptor desc;
+  if (rtcp) {
+    ParseRtcpPacket(data, len, &desc);
+  } else {
+    ParseRtpPacket(data, len, &desc);
+  }
+
   // If this channel is suppose to handle RTP data, that is determined by
   // checking against ssrc filter. This is necessary to do it here to avoid
   // double decryption.
   if (ssrc_filter_.IsActive() &&
-      !ssrc_filter_.DemuxPacket(packet->data(), packet->length(), rtcp)) {
+      !ssrc_filter_.DemuxPacket(data, len, desc)) {
     return;
   }
 
-  // Signal to the media sink before unprotecting the packet. TODO:
+  // Signal to the media sink before unprotecting the packet. The sink gets
+  // the transport's data, so recording doesn't cost a copy. TODO:
   // Separate APIs to record unprotected media and protected header.
   {
     talk_base::CritScope cs(&signal_recv_packet_cs_);
-    SignalRecvPacket(packet->data(), packet->length(), rtcp);
+    SignalRecvPacket(data, len, rtcp);
   }
 
+  // Only packets we keep are copied, into a buffer that is reused so that
+  // receiving doesn't allocate. SRTP is then unprotected in place there.
+  // The copy itself can't go: the transport's data is const and shared with
+  // the other slots of SignalReadPacket, and MediaChannel::OnPacketReceived
+  // takes a talk_base::Buffer, which always owns its storage.
+  talk_base::Buffer* packet = &recv_packet_;
+  packet->SetData(data, len);
+
   // Unprotect the packet, if needed.
   if (srtp_filter_.IsActive()) {
-    char* data = packet->data();
-    int len = packet->length();
+    char* buf = packet->data();
+    int buf_len = packet->length();
     bool res;
     if (!rtcp) {
-      res = srtp_filter_.UnprotectRtp(data, len, &len);
+      res = srtp_filter_.UnprotectRtp(buf, buf_len, &buf_len);
       if (!res) {
-        int seq_num = -1;
-        uint32 ssrc = 0;
-        GetRtpSeqNum(data, len, &seq_num);
-        GetRtpSsrc(data, len, &ssrc);
         LOG(LS_ERROR) << "Failed to unprotect " << content_name_
-                      << " RTP packet: size=" << len
-                      << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
+                      << " RTP packet: size=" << buf_len
+                      << ", seqnum=" << (desc.parsed ? desc.seq_num : -1)
+                      << ", SSRC=" << desc.ssrc;
         return;
       }
     } else {
-      res = srtp_filter_.UnprotectRtcp(data, len, &len);
+      res = srtp_filter_.UnprotectRtcp(buf, buf_len, &buf_len);
       if (!res) {
-        int type = -1;
-        GetRtcpType(data, len, &type);
         LOG(LS_ERROR) << "Failed to unprotect " << content_name_
-                      << " RTCP packet: size=" << len << ", type=" << type;
+                      << " RTCP packet: size=" << buf_len << ", type="
+                      << (desc.parsed ? desc.payload_type : -1);
         return;
       }
     }
 
-    packet->SetLength(len);
+    packet->SetLength(buf_len);
   }
 
   // Push it down to the media channel.
@@ -911,13 +972,9 @@ void BaseChannel::OnMessage(talk_base::Message *pmsg) {
       break;
     }
 
-    case MSG_RTPPACKET:
-    case MSG_RTCPPACKET: {
-      PacketMessageData* data = static_cast<PacketMessageData*>(pmsg->pdata);
-      SendPacket(pmsg->message_id == MSG_RTCPPACKET, &data->packet);
-      delete data;  // because it is Posted
+    case MSG_SENDQUEUEDPACKETS:
+      SendQueuedPackets_w();
       break;
-    }
   }
 }
 
@@ -942,11 +999,16 @@ void BaseChannel::FlushRtcpMessages() {
   // Flush all remaining RTCP messages. This should only be called in
   // destructor.
   ASSERT(talk_base::Thread::Current() == worker_thread_);
-  talk_base::MessageList rtcp_messages;
-  Clear(MSG_RTCPPACKET, &rtcp_messages);
-  for (talk_base::MessageList::iterator it = rtcp_messages.begin();
-       it != rtcp_messages.end(); ++it) {
-    Send(MSG_RTCPPACKET, it->pdata);
+  std::vector<QueuedPacket> queued;
+  {
+    talk_base::CritScope cs(&send_queue_cs_);
+    queued.swap(send_queue_);
+  }
+  for (size_t i = 0; i < queued.size(); ++i) {
+    if (queued[i].rtcp) {
+      SendPacket(true, queued[i].packet);
+    }
+    delete queued[i].packet;
   }
 }
 
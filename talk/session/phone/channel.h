@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "talk/base/asyncudpsocket.h"
+#include "talk/base/buffer.h"
 #include "talk/base/criticalsection.h"
 #include "talk/base/network.h"
 #include "talk/base/sigslot.h"
@@ -105,6 +106,20 @@ class BaseChannel
     srtp_filter_.set_signal_silent_time(silent_time);
   }
 
+  // Packets sent from a thread other than the worker thread are queued and
+  // handed to the worker in batches. By default a batch is posted to the
+  // worker with its first packet, and takes whatever is queued by the time
+  // the worker runs it. With a |delay_ms| above 0, a batch is sent at most
+  // |delay_ms| after its first packet, or as soon as it is full; that trades
+  // latency for fewer thread hops, which suits video more than audio.
+  void set_send_batch_delay(int delay_ms) {
+    talk_base::CritScope cs(&send_queue_cs_);
+    send_batch_delay_ = delay_ms;
+  }
+  // Number of batches and packets handed over from other threads.
+  uint32 send_batches() const { return send_batches_; }
+  uint32 queued_packets() const { return queued_packets_; }
+
   template <class T>
   void RegisterSendSink(T* sink,
                         void (T::*OnPacket)(const void*, size_t, bool)) {
@@ -186,7 +201,9 @@ class BaseChannel
   bool PacketIsRtcp(const TransportChannel* channel, const char* data,
                     size_t len);
   bool SendPacket(bool rtcp, talk_base::Buffer* packet);
-  void HandlePacket(bool rtcp, talk_base::Buffer* packet);
+  void QueuePacket(bool rtcp, talk_base::Buffer* packet);
+  void SendQueuedPackets_w();
+  void HandlePacket(bool rtcp, const char* data, size_t len);
 
   // Setting the send codec based on the remote description.
   void OnSessionState(BaseSession* session, BaseSession::State state);
@@ -249,6 +266,21 @@ class BaseChannel
 
   std::string content_name_;
   bool rtcp_;
+  // Packets waiting to be sent on the worker thread, in sending order.
+  struct QueuedPacket {
+    bool rtcp;
+    talk_base::Buffer* packet;
+  };
+  talk_base::CriticalSection send_queue_cs_;
+  std::vector<QueuedPacket> send_queue_;
+  bool send_queue_posted_;
+  int send_batch_delay_;
+  uint32 send_batches_;
+  uint32 queued_packets_;
+  // Received packets are copied here and unprotected in place. Only used on
+  // the worker thread.
+  talk_base::Buffer recv_packet_;
+
   TransportChannel *transport_channel_;
   TransportChannel *rtcp_transport_channel_;
   SrtpFilter srtp_filter_;
@@ -52,6 +52,7 @@ static const uint32 kSsrc1 = 0x1111;
 static const uint32 kSsrc2 = 0x2222;
 static const uint32 kSsrc3 = 0x3333;
 static const char kCName[] = "a@b.com";
+static const uint32 kBatchPackets = 20;
 
 class VoiceTraits {
  public:
@@ -258,6 +259,14 @@ class ChannelTest : public testing::Test, public sigslot::has_slots<> {
     std::string data(CreateRtcpData(ssrc));
     return media_channel2_->SendRtcp(data.c_str(), data.size());
   }
+  bool SendRtpBatch1() {
+    for (uint32 ssrc = 1; ssrc <= kBatchPackets; ++ssrc) {
+      if (!SendCustomRtp1(ssrc)) {
+        return false;
+      }
+    }
+    return true;
+  }
   bool CheckRtp1() {
     return media_channel1_->CheckRtp(rtp_packet_.c_str(), rtp_packet_.size());
   }
@@ -1030,6 +1039,24 @@ class ChannelTest : public testing::Test, public sigslot::has_slots<> {
     EXPECT_TRUE(CheckNoRtcp2());
   }
 
+  // Test that packets sent from a thread reach the worker in a few batches,
+  // in the order they were sent.
+  void SendRtpBatchOnThread() {
+    bool sent_rtp1;
+    CreateChannels(0, 0);
+    EXPECT_TRUE(SendInitiate());
+    EXPECT_TRUE(SendAccept());
+    channel1_->set_send_batch_delay(10);
+    CallOnThread(&ChannelTest<T>::SendRtpBatch1, &sent_rtp1);
+    EXPECT_TRUE_WAIT(sent_rtp1, 1000);
+    EXPECT_EQ_WAIT(kBatchPackets, channel1_->queued_packets(), 1000);
+    EXPECT_LT(channel1_->send_batches(), kBatchPackets);
+    for (uint32 ssrc = 1; ssrc <= kBatchPackets; ++ssrc) {
+      EXPECT_TRUE(CheckCustomRtp2(ssrc));
+    }
+    EXPECT_TRUE(CheckNoRtp2());
+  }
+
   // Test that the mediachannel retains its sending state after the transport
   // becomes non-writable.
   void SendWithWritabilityLoss() {
@@ -1563,6 +1590,10 @@ TEST_F(VoiceChannelTest, SendRtpToRtpOnThread) {
   Base::SendRtpToRtpOnThread();
 }
 
+TEST_F(VoiceChannelTest, SendRtpBatchOnThread) {
+  Base::SendRtpBatchOnThread();
+}
+
 TEST_F(VoiceChannelTest, SendSrtpToSrtpOnThread) {
   Base::SendSrtpToSrtpOnThread();
 }
@@ -1868,6 +1899,10 @@ TEST_F(VideoChannelTest, SendRtpToRtpOnThread) {
   Base::SendRtpToRtpOnThread();
 }
 
+TEST_F(VideoChannelTest, SendRtpBatchOnThread) {
+  Base::SendRtpBatchOnThread();
+}
+
 TEST_F(VideoChannelTest, SendSrtpToSrtpOnThread) {
   Base::SendSrtpToSrtpOnThread();
 }
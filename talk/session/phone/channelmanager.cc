@@ -68,6 +68,10 @@ enum {
 };
 
 static const int kNotSetOutputVolume = -1;
+// Load of a channel when spreading channels over the worker threads. Video
+// encoding and decoding costs several times what an audio stream does.
+static const int kVoiceChannelLoad = 1;
+static const int kVideoChannelLoad = 4;
 
 struct CreationParams : public talk_base::MessageData {
   CreationParams(BaseSession* session, const std::string& content_name,
@@ -170,6 +174,9 @@ ChannelManager::ChannelManager(talk_base::Thread* worker_thread)
       initialized_(false),
       main_thread_(talk_base::Thread::Current()),
       worker_thread_(worker_thread),
+      worker_placement_(PLACEMENT_ROUND_ROBIN),
+      worker_loads_(1, 0),
+      next_worker_(0),
       audio_in_device_(DeviceManagerInterface::kDefaultDeviceName),
       audio_out_device_(DeviceManagerInterface::kDefaultDeviceName),
       audio_options_(MediaEngineInterface::DEFAULT_AUDIO_OPTIONS),
@@ -188,6 +195,9 @@ ChannelManager::ChannelManager(MediaEngineInterface* me,
       initialized_(false),
       main_thread_(talk_base::Thread::Current()),
       worker_thread_(worker_thread),
+      worker_placement_(PLACEMENT_ROUND_ROBIN),
+      worker_loads_(1, 0),
+      next_worker_(0),
       audio_in_device_(DeviceManagerInterface::kDefaultDeviceName),
       audio_out_device_(DeviceManagerInterface::kDefaultDeviceName),
       audio_options_(MediaEngineInterface::DEFAULT_AUDIO_OPTIONS),
@@ -212,6 +222,80 @@ void ChannelManager::Construct() {
 ChannelManager::~ChannelManager() {
   if (initialized_)
     Terminate();
+  for (size_t i = 0; i < extra_worker_threads_.size(); ++i) {
+    delete extra_worker_threads_[i];
+  }
+}
+
+bool ChannelManager::set_worker_thread_count(int count) {
+  if (initialized_ || count < 1) return false;
+  while (worker_thread_count() > count) {
+    delete extra_worker_threads_.back();
+    extra_worker_threads_.pop_back();
+  }
+  while (worker_thread_count() < count) {
+    talk_base::Thread* thread = new talk_base::Thread();
+    thread->SetName("ChannelManager worker", this);
+    extra_worker_threads_.push_back(thread);
+  }
+  worker_loads_.assign(count, 0);
+  next_worker_ = 0;
+  return true;
+}
+
+talk_base::Thread* ChannelManager::GetWorkerThread(int index) const {
+  return (index == 0) ? worker_thread_ : extra_worker_threads_[index - 1];
+}
+
+int ChannelManager::GetWorkerIndex(talk_base::Thread* thread) const {
+  if (thread == NULL) return -1;
+  if (thread == worker_thread_) return 0;
+  for (size_t i = 0; i < extra_worker_threads_.size(); ++i) {
+    if (extra_worker_threads_[i] == thread) {
+      return static_cast<int>(i) + 1;
+    }
+  }
+  return -1;
+}
+
+talk_base::Thread* ChannelManager::SelectWorkerThread() {
+  talk_base::CritScope cs(&channels_crit_);
+  int index = 0;
+  if (worker_placement_ == PLACEMENT_LEAST_LOADED) {
+    for (int i = 1; i < worker_thread_count(); ++i) {
+      if (worker_loads_[i] < worker_loads_[index]) {
+        index = i;
+      }
+    }
+  } else {
+    index = next_worker_;
+    next_worker_ = (next_worker_ + 1) % worker_thread_count();
+  }
+  return GetWorkerThread(index);
+}
+
+int ChannelManager::GetWorkerLoad(talk_base::Thread* thread) {
+  talk_base::CritScope cs(&channels_crit_);
+  int index = GetWorkerIndex(thread);
+  return (index < 0) ? -1 : worker_loads_[index];
+}
+
+void ChannelManager::AddWorkerLoad(talk_base::Thread* thread, int load) {
+  talk_base::CritScope cs(&channels_crit_);
+  int index = GetWorkerIndex(thread);
+  if (index >= 0) {
+    worker_loads_[index] += load;
+  }
+}
+
+talk_base::Thread* ChannelManager::PlaceChannel(BaseSession* session) {
+  // The transport channels signal packets on the session's worker thread, so
+  // the media channel has to run there too. Sessions on threads we don't own
+  // get the default worker, as before.
+  if (session && GetWorkerIndex(session->worker_thread()) >= 0) {
+    return session->worker_thread();
+  }
+  return worker_thread_;
 }
 
 int ChannelManager::GetCapabilities() {
@@ -247,6 +331,13 @@ bool ChannelManager::Init() {
   }
 
   ASSERT(worker_thread_ != NULL);
+  for (size_t i = 0; i < extra_worker_threads_.size(); ++i) {
+    if (!extra_worker_threads_[i]->started() &&
+        !extra_worker_threads_[i]->Start()) {
+      LOG(LS_ERROR) << "Failed to start worker thread " << i + 1;
+      return false;
+    }
+  }
   if (worker_thread_ && worker_thread_->started()) {
     if (media_engine_->Init()) {
       initialized_ = true;
@@ -320,20 +411,35 @@ void ChannelManager::Terminate() {
   if (!initialized_) {
     return;
   }
+  // Each channel has to be destroyed on its own worker thread.
+  while (true) {
+    VideoChannel* video_channel = NULL;
+    {
+      talk_base::CritScope cs(&channels_crit_);
+      if (video_channels_.empty()) break;
+      video_channel = video_channels_.back();
+    }
+    DestroyVideoChannel(video_channel);
+  }
+  while (true) {
+    VoiceChannel* voice_channel = NULL;
+    {
+      talk_base::CritScope cs(&channels_crit_);
+      if (voice_channels_.empty()) break;
+      voice_channel = voice_channels_.back();
+    }
+    DestroyVoiceChannel(voice_channel);
+  }
   Send(MSG_TERMINATE, NULL);
   media_engine_->Terminate();
   initialized_ = false;
+  for (size_t i = 0; i < extra_worker_threads_.size(); ++i) {
+    extra_worker_threads_[i]->Stop();
+  }
 }
 
 void ChannelManager::Terminate_w() {
   ASSERT(worker_thread_ == talk_base::Thread::Current());
-    // Need to destroy the voice/video channels
-  while (!video_channels_.empty()) {
-    DestroyVideoChannel_w(video_channels_.back());
-  }
-  while (!voice_channels_.empty()) {
-    DestroyVoiceChannel_w(voice_channels_.back());
-  }
   while (!soundclips_.empty()) {
     DestroySoundclip_w(soundclips_.back());
   }
@@ -342,7 +448,8 @@ void ChannelManager::Terminate_w() {
 VoiceChannel* ChannelManager::CreateVoiceChannel(
     BaseSession* session, const std::string& content_name, bool rtcp) {
   CreationParams params(session, content_name, rtcp, NULL);
-  return (Send(MSG_CREATEVOICECHANNEL, &params)) ? params.voice_channel : NULL;
+  return (Send(PlaceChannel(session), MSG_CREATEVOICECHANNEL, &params)) ?
+      params.voice_channel : NULL;
 }
 
 VoiceChannel* ChannelManager::CreateVoiceChannel_w(
@@ -354,33 +461,43 @@ VoiceChannel* ChannelManager::CreateVoiceChannel_w(
     return NULL;
 
   VoiceChannel* voice_channel = new VoiceChannel(
-      worker_thread_, media_engine_.get(), media_channel,
+      talk_base::Thread::Current(), media_engine_.get(), media_channel,
       session, content_name, rtcp);
   if (!voice_channel->Init()) {
     delete voice_channel;
     return NULL;
   }
+  talk_base::CritScope cs(&channels_crit_);
   voice_channels_.push_back(voice_channel);
+  int index = GetWorkerIndex(talk_base::Thread::Current());
+  if (index >= 0) {
+    worker_loads_[index] += kVoiceChannelLoad;
+  }
   return voice_channel;
 }
 
 void ChannelManager::DestroyVoiceChannel(VoiceChannel* voice_channel) {
   if (voice_channel) {
     talk_base::TypedMessageData<VoiceChannel *> data(voice_channel);
-    Send(MSG_DESTROYVOICECHANNEL, &data);
+    Send(voice_channel->worker_thread(), MSG_DESTROYVOICECHANNEL, &data);
   }
 }
 
 void ChannelManager::DestroyVoiceChannel_w(VoiceChannel* voice_channel) {
   // Destroy voice channel.
   ASSERT(initialized_);
-  VoiceChannels::iterator it = std::find(voice_channels_.begin(),
-      voice_channels_.end(), voice_channel);
-  ASSERT(it != voice_channels_.end());
-  if (it == voice_channels_.end())
-    return;
-
-  voice_channels_.erase(it);
+  ASSERT(voice_channel->worker_thread() == talk_base::Thread::Current());
+  {
+    talk_base::CritScope cs(&channels_crit_);
+    VoiceChannels::iterator it = std::find(voice_channels_.begin(),
+        voice_channels_.end(), voice_channel);
+    ASSERT(it != voice_channels_.end());
+    if (it == voice_channels_.end())
+      return;
+
+    voice_channels_.erase(it);
+  }
+  AddWorkerLoad(voice_channel->worker_thread(), -kVoiceChannelLoad);
   delete voice_channel;
 }
 
@@ -388,7 +505,11 @@ VideoChannel* ChannelManager::CreateVideoChannel(
     BaseSession* session, const std::string& content_name, bool rtcp,
     VoiceChannel* voice_channel) {
   CreationParams params(session, content_name, rtcp, voice_channel);
-  return (Send(MSG_CREATEVIDEOCHANNEL, &params)) ? params.video_channel : NULL;
+  // Keep the video channel with its voice channel, which it syncs with.
+  talk_base::Thread* thread = voice_channel ?
+      voice_channel->worker_thread() : PlaceChannel(session);
+  return (Send(thread, MSG_CREATEVIDEOCHANNEL, &params)) ?
+      params.video_channel : NULL;
 }
 
 VideoChannel* ChannelManager::CreateVideoChannel_w(
@@ -404,33 +525,43 @@ VideoChannel* ChannelManager::CreateVideoChannel_w(
     return NULL;
 
   VideoChannel* video_channel = new VideoChannel(
-      worker_thread_, media_engine_.get(), media_channel,
+      talk_base::Thread::Current(), media_engine_.get(), media_channel,
       session, content_name, rtcp, voice_channel);
   if (!video_channel->Init()) {
     delete video_channel;
     return NULL;
   }
+  talk_base::CritScope cs(&channels_crit_);
   video_channels_.push_back(video_channel);
+  int index = GetWorkerIndex(talk_base::Thread::Current());
+  if (index >= 0) {
+    worker_loads_[index] += kVideoChannelLoad;
+  }
   return video_channel;
 }
 
 void ChannelManager::DestroyVideoChannel(VideoChannel* video_channel) {
   if (video_channel) {
     talk_base::TypedMessageData<VideoChannel *> data(video_channel);
-    Send(MSG_DESTROYVIDEOCHANNEL, &data);
+    Send(video_channel->worker_thread(), MSG_DESTROYVIDEOCHANNEL, &data);
   }
 }
 
 void ChannelManager::DestroyVideoChannel_w(VideoChannel *video_channel) {
   // Destroy voice channel.
   ASSERT(initialized_);
-  VideoChannels::iterator it = std::find(video_channels_.begin(),
-      video_channels_.end(), video_channel);
-  ASSERT(it != video_channels_.end());
-  if (it == video_channels_.end())
-    return;
-
-  video_channels_.erase(it);
+  ASSERT(video_channel->worker_thread() == talk_base::Thread::Current());
+  {
+    talk_base::CritScope cs(&channels_crit_);
+    VideoChannels::iterator it = std::find(video_channels_.begin(),
+        video_channels_.end(), video_channel);
+    ASSERT(it != video_channels_.end());
+    if (it == video_channels_.end())
+      return;
+
+    video_channels_.erase(it);
+  }
+  AddWorkerLoad(video_channel->worker_thread(), -kVideoChannelLoad);
   delete video_channel;
 }
 
@@ -793,8 +924,13 @@ bool ChannelManager::UnregisterVoiceProcessor_w(
 }
 
 bool ChannelManager::Send(uint32 id, talk_base::MessageData* data) {
-  if (!worker_thread_ || !initialized_) return false;
-  worker_thread_->Send(this, id, data);
+  return Send(worker_thread_, id, data);
+}
+
+bool ChannelManager::Send(talk_base::Thread* thread, uint32 id,
+                          talk_base::MessageData* data) {
+  if (!thread || !initialized_) return false;
+  thread->Send(this, id, data);
   return true;
 }
 
@@ -53,6 +53,17 @@ class VoiceProcessor;
 // voice or just video channels.
 // ChannelManager also allows the application to discover what devices it has
 // using device manager.
+//
+// Channels can be spread over several worker threads, so that calls don't all
+// share one core for SRTP and media processing. ChannelManager does not pick a
+// thread for each channel itself: a channel's transport channels deliver
+// packets on the worker thread of its session, so every channel is created on
+// its session's worker thread when that is one of ours, and on worker_thread()
+// otherwise. Calls are only spread if the application gives each
+// SessionManager a thread from SelectWorkerThread(). The load that
+// SelectWorkerThread balances is a static weight per channel, not measured
+// CPU time; CpuMonitor only reports process and system load, which can't
+// tell the workers apart.
 class ChannelManager : public talk_base::MessageHandler,
                        public sigslot::has_slots<> {
  public:
@@ -73,6 +84,33 @@ class ChannelManager : public talk_base::MessageHandler,
     return true;
   }
 
+  // Sets the number of worker threads channels are placed on, including
+  // worker_thread(). The additional threads are owned by the ChannelManager
+  // and started by Init. Returns false if called after Init.
+  bool set_worker_thread_count(int count);
+  int worker_thread_count() const {
+    return static_cast<int>(extra_worker_threads_.size()) + 1;
+  }
+
+  // How SelectWorkerThread spreads sessions over the workers.
+  enum WorkerPlacement {
+    PLACEMENT_ROUND_ROBIN,   // Each worker in turn.
+    PLACEMENT_LEAST_LOADED   // The worker with the least channel load, where
+                             // a video channel counts as several voice
+                             // channels. The weights are fixed estimates.
+  };
+  WorkerPlacement worker_placement() const { return worker_placement_; }
+  void set_worker_placement(WorkerPlacement placement) {
+    worker_placement_ = placement;
+  }
+
+  // Picks a worker thread for a new SessionManager, according to
+  // worker_placement(). Channels of its sessions will run on that thread.
+  talk_base::Thread* SelectWorkerThread();
+  // Returns the weighted channel count placed on |thread|, or -1 if it isn't
+  // one of our worker threads.
+  int GetWorkerLoad(talk_base::Thread* thread);
+
   // Gets capabilities. Can be called prior to starting the media engine.
   int GetCapabilities();
 
@@ -171,6 +209,14 @@ class ChannelManager : public talk_base::MessageHandler,
 
   void Construct();
   bool Send(uint32 id, talk_base::MessageData* pdata);
+  bool Send(talk_base::Thread* thread, uint32 id,
+            talk_base::MessageData* pdata);
+  // Index of |thread| among the worker threads, or -1.
+  int GetWorkerIndex(talk_base::Thread* thread) const;
+  talk_base::Thread* GetWorkerThread(int index) const;
+  // Picks the worker thread for a new channel of |session|.
+  talk_base::Thread* PlaceChannel(BaseSession* session);
+  void AddWorkerLoad(talk_base::Thread* thread, int load);
   void Terminate_w();
   VoiceChannel* CreateVoiceChannel_w(
       BaseSession* session, const std::string& content_name, bool rtcp);
@@ -213,6 +259,14 @@ class ChannelManager : public talk_base::MessageHandler,
   bool initialized_;
   talk_base::Thread* main_thread_;
   talk_base::Thread* worker_thread_;
+  std::vector<talk_base::Thread*> extra_worker_threads_;
+  WorkerPlacement worker_placement_;
+  // Channel load per worker thread, indexed like GetWorkerThread.
+  std::vector<int> worker_loads_;
+  int next_worker_;
+  // Guards the channel lists and worker loads, which are changed on the
+  // worker threads of the channels.
+  talk_base::CriticalSection channels_crit_;
 
   VoiceChannels voice_channels_;
   VideoChannels video_channels_;
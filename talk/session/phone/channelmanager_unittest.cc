@@ -135,6 +135,111 @@ TEST_F(ChannelManagerTest, CreateDestroyChannelsOnThread) {
   cm_->Terminate();
 }
 
+// Test that sessions are spread over several worker threads in turn, that
+// their channels run on the session's thread, and that a video channel stays
+// on the thread of its voice channel.
+TEST_F(ChannelManagerTest, CreateDestroyChannelsOnWorkerThreads) {
+  worker_.Start();
+  EXPECT_TRUE(cm_->set_worker_thread(&worker_));
+  EXPECT_TRUE(cm_->set_worker_thread_count(3));
+  EXPECT_EQ(3, cm_->worker_thread_count());
+  EXPECT_TRUE(cm_->Init());
+  // Changing the number of threads while initialized should fail.
+  EXPECT_FALSE(cm_->set_worker_thread_count(1));
+
+  cricket::FakeSession* sessions[3];
+  cricket::VoiceChannel* voice_channels[3];
+  for (int i = 0; i < 3; ++i) {
+    sessions[i] = new cricket::FakeSession(cm_->SelectWorkerThread());
+    voice_channels[i] = cm_->CreateVoiceChannel(
+        sessions[i], cricket::CN_AUDIO, false);
+    ASSERT_TRUE(voice_channels[i] != NULL);
+    EXPECT_EQ(sessions[i]->worker_thread(), voice_channels[i]->worker_thread());
+  }
+  EXPECT_EQ(&worker_, voice_channels[0]->worker_thread());
+  EXPECT_NE(&worker_, voice_channels[1]->worker_thread());
+  EXPECT_NE(&worker_, voice_channels[2]->worker_thread());
+  EXPECT_NE(voice_channels[1]->worker_thread(),
+            voice_channels[2]->worker_thread());
+  EXPECT_TRUE(voice_channels[1]->worker_thread()->started());
+  EXPECT_EQ(1, cm_->GetWorkerLoad(voice_channels[1]->worker_thread()));
+  EXPECT_EQ(-1, cm_->GetWorkerLoad(talk_base::Thread::Current()));
+
+  // A second channel of the same session joins it rather than moving on to
+  // the next worker.
+  cricket::VoiceChannel* second_channel = cm_->CreateVoiceChannel(
+      sessions[1], cricket::CN_AUDIO, false);
+  ASSERT_TRUE(second_channel != NULL);
+  EXPECT_EQ(sessions[1]->worker_thread(), second_channel->worker_thread());
+  cm_->DestroyVoiceChannel(second_channel);
+
+  // A session on a thread we don't own gets the default worker.
+  cricket::VoiceChannel* default_channel = cm_->CreateVoiceChannel(
+      session_, cricket::CN_AUDIO, false);
+  ASSERT_TRUE(default_channel != NULL);
+  EXPECT_EQ(&worker_, default_channel->worker_thread());
+
+  cricket::VideoChannel* video_channel =
+      cm_->CreateVideoChannel(sessions[1], cricket::CN_VIDEO,
+                              false, voice_channels[1]);
+  ASSERT_TRUE(video_channel != NULL);
+  EXPECT_EQ(voice_channels[1]->worker_thread(),
+            video_channel->worker_thread());
+  EXPECT_LT(1, cm_->GetWorkerLoad(video_channel->worker_thread()));
+
+  talk_base::Thread* thread = video_channel->worker_thread();
+  cm_->DestroyVideoChannel(video_channel);
+  EXPECT_EQ(1, cm_->GetWorkerLoad(thread));
+  cm_->DestroyVoiceChannel(voice_channels[1]);
+  EXPECT_EQ(0, cm_->GetWorkerLoad(thread));
+  // The remaining channels are destroyed on their own threads by Terminate.
+  cm_->Terminate();
+  EXPECT_FALSE(cm_->initialized());
+  for (int i = 0; i < 3; ++i) {
+    delete sessions[i];
+  }
+}
+
+// Test that the least loaded placement avoids a worker running video.
+TEST_F(ChannelManagerTest, CreateChannelsOnLeastLoadedWorker) {
+  worker_.Start();
+  EXPECT_TRUE(cm_->set_worker_thread(&worker_));
+  EXPECT_TRUE(cm_->set_worker_thread_count(2));
+  cm_->set_worker_placement(cricket::ChannelManager::PLACEMENT_LEAST_LOADED);
+  EXPECT_TRUE(cm_->Init());
+
+  std::vector<cricket::FakeSession*> sessions;
+  sessions.push_back(new cricket::FakeSession(cm_->SelectWorkerThread()));
+  cricket::VoiceChannel* voice_channel = cm_->CreateVoiceChannel(
+      sessions.back(), cricket::CN_AUDIO, false);
+  ASSERT_TRUE(voice_channel != NULL);
+  EXPECT_EQ(&worker_, voice_channel->worker_thread());
+  cricket::VideoChannel* video_channel =
+      cm_->CreateVideoChannel(sessions.back(), cricket::CN_VIDEO,
+                              false, voice_channel);
+  ASSERT_TRUE(video_channel != NULL);
+
+  // The other worker takes the next audio-only calls until it carries as
+  // much load as the one with video.
+  talk_base::Thread* other = cm_->SelectWorkerThread();
+  EXPECT_NE(&worker_, other);
+  int load = cm_->GetWorkerLoad(&worker_);
+  for (int i = 0; i < load; ++i) {
+    sessions.push_back(new cricket::FakeSession(cm_->SelectWorkerThread()));
+    cricket::VoiceChannel* channel = cm_->CreateVoiceChannel(
+        sessions.back(), cricket::CN_AUDIO, false);
+    ASSERT_TRUE(channel != NULL);
+    EXPECT_EQ(other, channel->worker_thread());
+  }
+  EXPECT_EQ(load, cm_->GetWorkerLoad(other));
+  cm_->Terminate();
+  EXPECT_EQ(0, cm_->GetWorkerLoad(&worker_));
+  EXPECT_EQ(0, cm_->GetWorkerLoad(other));
+  for (size_t i = 0; i < sessions.size(); ++i) {
+    delete sessions[i];
+  }
+}
+
 // Test that we fail to create a voice/video channel if the session is unable
 // to create a cricket::TransportChannel
 TEST_F(ChannelManagerTest, NoTransportChannelTest) {
@@ -28,6 +28,7 @@
 #include <climits>
 
 #include "talk/base/buffer.h"
+#include "talk/base/bytebuffer.h"
 #include "talk/base/event.h"
 #include "talk/base/logging.h"
 #include "talk/base/pathutils.h"
@@ -41,15 +42,21 @@ namespace cricket {
 ///////////////////////////////////////////////////////////////////////////
 // Implementation of FileMediaEngine.
 ///////////////////////////////////////////////////////////////////////////
+FileMediaEngine::FileMediaEngine() {}
+
+FileMediaEngine::~FileMediaEngine() {}
+
 int FileMediaEngine::GetCapabilities() {
   int capabilities = 0;
-  if (!voice_input_filename_.empty()) {
+  if (!voice_input_filename_.empty() ||
+      !voice_load_capture_filename_.empty()) {
     capabilities |= AUDIO_SEND;
   }
   if (!voice_output_filename_.empty()) {
     capabilities |= AUDIO_RECV;
   }
-  if (!video_input_filename_.empty()) {
+  if (!video_input_filename_.empty() ||
+      !video_load_capture_filename_.empty()) {
     capabilities |= VIDEO_SEND;
   }
   if (!video_output_filename_.empty()) {
@@ -58,10 +65,47 @@ int FileMediaEngine::GetCapabilities() {
   return capabilities;
 }
 
+// Returns |generator|, replaying |capture_filename|, creating it if needed.
+static RtpLoadGenerator* GetLoadGenerator(
+    const std::string& capture_filename,
+    talk_base::scoped_ptr<RtpLoadGenerator>* generator) {
+  if (!generator->get()) {
+    talk_base::scoped_ptr<RtpLoadGenerator> new_generator(
+        new RtpLoadGenerator);
+    if (!new_generator->Init(capture_filename)) {
+      LOG(LS_ERROR) << "Not able to load the capture " << capture_filename;
+      return NULL;
+    }
+    generator->reset(new_generator.release());
+  }
+  return generator->get();
+}
+
+static talk_base::FileStream* OpenOutputStream(const std::string& filename) {
+  if (filename.empty()) {
+    return NULL;
+  }
+  return talk_base::Filesystem::OpenFile(talk_base::Pathname(filename), "wb");
+}
+
 VoiceMediaChannel* FileMediaEngine::CreateChannel() {
   talk_base::FileStream* input_file_stream = NULL;
   talk_base::FileStream* output_file_stream = NULL;
 
+  if (!voice_load_capture_filename_.empty()) {
+    RtpLoadGenerator* generator = GetLoadGenerator(
+        voice_load_capture_filename_, &voice_load_generator_);
+    if (!generator) {
+      return NULL;
+    }
+    output_file_stream = OpenOutputStream(voice_output_filename_);
+    if (!voice_output_filename_.empty() && !output_file_stream) {
+      LOG(LS_ERROR) << "Not able to open the output audio stream file.";
+      return NULL;
+    }
+    return new FileVoiceChannel(generator, output_file_stream);
+  }
+
   if (voice_input_filename_.empty() && voice_output_filename_.empty())
     return NULL;
   if (!voice_input_filename_.empty()) {
@@ -91,6 +135,20 @@ VideoMediaChannel* FileMediaEngine::CreateVideoChannel(
   talk_base::FileStream* input_file_stream = NULL;
   talk_base::FileStream* output_file_stream = NULL;
 
+  if (!video_load_capture_filename_.empty()) {
+    RtpLoadGenerator* generator = GetLoadGenerator(
+        video_load_capture_filename_, &video_load_generator_);
+    if (!generator) {
+      return NULL;
+    }
+    output_file_stream = OpenOutputStream(video_output_filename_);
+    if (!video_output_filename_.empty() && !output_file_stream) {
+      LOG(LS_ERROR) << "Not able to open the output video stream file.";
+      return NULL;
+    }
+    return new FileVideoChannel(generator, output_file_stream);
+  }
+
   if (video_input_filename_.empty() && video_output_filename_.empty())
       return NULL;
 
@@ -116,6 +174,300 @@ VideoMediaChannel* FileMediaEngine::CreateVideoChannel(
   return new FileVideoChannel(input_file_stream, output_file_stream);
 }
 
+///////////////////////////////////////////////////////////////////////////
+// Implementation of RtpLoadGenerator.
+///////////////////////////////////////////////////////////////////////////
+enum {
+  MSG_LOAD_START = 1,
+  MSG_LOAD_STOP,
+  MSG_LOAD_TICK,
+};
+
+// Used when the capture has a single packet or frame, as RtpDumpLoopReader.
+static const uint32 kDefaultLoadTimeIncrease = 30;
+
+struct RtpLoadGenerator::ChannelState {
+  MediaChannel* channel;
+  uint32 ssrc;
+  // Added to the sequence numbers and timestamps of the capture so that the
+  // channels don't all send the same values.
+  uint16 seq_num_offset;
+  uint32 timestamp_offset;
+  uint64 start_time;  // Now_w() time the first packet is due, in ms.
+  uint32 loop_count;
+  size_t next_packet;  // Index in RtpLoadGenerator::packets_.
+  Schedule::iterator scheduled;
+  // Reused for every packet, unless the network interface takes its data.
+  talk_base::Buffer packet;
+};
+
+struct LoadChannelParams {
+  MediaChannel* channel;
+  uint32 ssrc;
+};
+
+RtpLoadGenerator::RtpLoadGenerator()
+    : loop_elapsed_time_(0),
+      loop_seq_num_(0),
+      loop_timestamp_(0),
+      start_spread_ms_(0),
+      last_time_(0),
+      clock_(0),
+      start_time_(0),
+      packets_sent_(0),
+      bytes_sent_(0),
+      send_failures_(0),
+      total_lateness_ms_(0),
+      max_lateness_ms_(0) {
+}
+
+RtpLoadGenerator::~RtpLoadGenerator() {
+  thread_.Stop();
+  for (std::map<MediaChannel*, ChannelState*>::iterator it = channels_.begin();
+       it != channels_.end(); ++it) {
+    delete it->second;
+  }
+}
+
+bool RtpLoadGenerator::Init(const std::string& capture_filename) {
+  if (!capture_.Open(capture_filename, "")) {
+    return false;
+  }
+
+  // Replay the RTP packets of the first SSRC, as RtpSenderReceiver does.
+  RtpDumpPacketView view;
+  uint32 first_ssrc = 0;
+  for (size_t i = 0; i < capture_.packet_count(); ++i) {
+    if (capture_.GetPacket(i, &view) && !view.is_rtcp &&
+        GetRtpSsrc(view.data, view.size, &first_ssrc)) {
+      break;
+    }
+  }
+  const std::vector<uint32>* packets = capture_.GetPacketsBySsrc(first_ssrc);
+  if (!packets || packets->empty()) {
+    LOG(LS_ERROR) << "No RTP packets in " << capture_filename;
+    return false;
+  }
+  packets_ = *packets;
+
+  // Work out how far each loop advances, as RtpDumpLoopReader does.
+  int first_seq_num = 0, last_seq_num = 0;
+  uint32 first_timestamp = 0, prev_timestamp = 0;
+  uint32 frame_count = 0;
+  elapsed_times_.reserve(packets_.size());
+  for (size_t i = 0; i < packets_.size(); ++i) {
+    capture_.GetPacket(packets_[i], &view);
+    uint32 timestamp = 0;
+    GetRtpSeqNum(view.data, view.size, &last_seq_num);
+    GetRtpTimestamp(view.data, view.size, &timestamp);
+    if (i == 0) {
+      first_seq_num = last_seq_num;
+      first_timestamp = timestamp;
+      ++frame_count;
+    } else if (timestamp != prev_timestamp) {
+      ++frame_count;
+    }
+    prev_timestamp = timestamp;
+    elapsed_times_.push_back(view.elapsed_time);
+  }
+  uint32 packet_count = static_cast<uint32>(packets_.size());
+  loop_seq_num_ = static_cast<uint16>(last_seq_num - first_seq_num + 1);
+  loop_elapsed_time_ = packet_count <= 1 ? kDefaultLoadTimeIncrease :
+      (elapsed_times_.back() - elapsed_times_.front()) * packet_count /
+      (packet_count - 1);
+  loop_timestamp_ = frame_count <= 1 ? kDefaultLoadTimeIncrease :
+      (prev_timestamp - first_timestamp) * frame_count / (frame_count - 1);
+
+  last_time_ = talk_base::Time();
+  return thread_.Start();
+}
+
+void RtpLoadGenerator::StartChannel(MediaChannel* channel, uint32 ssrc) {
+  LoadChannelParams params = { channel, ssrc };
+  talk_base::TypedMessageData<LoadChannelParams> data(params);
+  thread_.Send(this, MSG_LOAD_START, &data);
+}
+
+void RtpLoadGenerator::StopChannel(MediaChannel* channel) {
+  LoadChannelParams params = { channel, 0 };
+  talk_base::TypedMessageData<LoadChannelParams> data(params);
+  thread_.Send(this, MSG_LOAD_STOP, &data);
+}
+
+void RtpLoadGenerator::GetStats(RtpLoadGeneratorStats* stats) {
+  talk_base::CritScope cs(&stats_crit_);
+  stats->channels = static_cast<int>(schedule_.size());
+  stats->elapsed_ms = packets_sent_ + send_failures_ > 0 ?
+      talk_base::TimeSince(start_time_) : 0;
+  stats->packets_sent = packets_sent_;
+  stats->bytes_sent = bytes_sent_;
+  stats->send_failures = send_failures_;
+  if (stats->elapsed_ms > 0) {
+    stats->packets_per_second =
+        packets_sent_ * 1000.0 / stats->elapsed_ms;
+    stats->bits_per_second = bytes_sent_ * 8000.0 / stats->elapsed_ms;
+  }
+  uint64 attempts = packets_sent_ + send_failures_;
+  stats->mean_lateness_ms = attempts > 0 ?
+      static_cast<double>(total_lateness_ms_) / attempts : 0;
+  stats->max_lateness_ms = max_lateness_ms_;
+}
+
+void RtpLoadGenerator::OnMessage(talk_base::Message* msg) {
+  switch (msg->message_id) {
+    case MSG_LOAD_START: {
+      const LoadChannelParams& params = static_cast<
+          talk_base::TypedMessageData<LoadChannelParams>*>(msg->pdata)->data();
+      StartChannel_w(params.channel, params.ssrc);
+      break;
+    }
+    case MSG_LOAD_STOP: {
+      const LoadChannelParams& params = static_cast<
+          talk_base::TypedMessageData<LoadChannelParams>*>(msg->pdata)->data();
+      StopChannel_w(params.channel);
+      break;
+    }
+    case MSG_LOAD_TICK:
+      SendDuePackets_w();
+      break;
+  }
+}
+
+void RtpLoadGenerator::StartChannel_w(MediaChannel* channel, uint32 ssrc) {
+  ChannelState* state = NULL;
+  std::map<MediaChannel*, ChannelState*>::iterator it =
+      channels_.find(channel);
+  if (it != channels_.end()) {
+    state = it->second;
+    if (state->scheduled != schedule_.end()) {
+      // Already sending; the new SSRC applies from the next packet.
+      SetChannelSsrc_w(state, ssrc);
+      return;
+    }
+  } else {
+    state = new ChannelState;
+    state->channel = channel;
+    state->packet.SetCapacity(kMaxRtpPacketLen);
+    channels_[channel] = state;
+  }
+
+  SetChannelSsrc_w(state, ssrc);
+  state->start_time = Now_w();
+  if (start_spread_ms_ > 0) {
+    state->start_time += (ssrc * 2654435761U >> 8) % start_spread_ms_;
+  }
+  state->loop_count = 0;
+  state->next_packet = 0;
+  {
+    talk_base::CritScope cs(&stats_crit_);
+    if (schedule_.empty() && packets_sent_ + send_failures_ == 0) {
+      start_time_ = talk_base::Time();
+    }
+    ScheduleNextPacket_w(state);
+  }
+  ScheduleWakeUp_w();
+}
+
+void RtpLoadGenerator::SetChannelSsrc_w(ChannelState* state, uint32 ssrc) {
+  // Derive the offsets from the SSRC so that they are stable for a stream.
+  uint32 hash = ssrc * 2654435761U;
+  state->ssrc = ssrc;
+  state->seq_num_offset = static_cast<uint16>(hash >> 16);
+  state->timestamp_offset = hash;
+}
+
+void RtpLoadGenerator::StopChannel_w(MediaChannel* channel) {
+  std::map<MediaChannel*, ChannelState*>::iterator it =
+      channels_.find(channel);
+  if (it == channels_.end()) {
+    return;
+  }
+  {
+    talk_base::CritScope cs(&stats_crit_);
+    if (it->second->scheduled != schedule_.end()) {
+      schedule_.erase(it->second->scheduled);
+    }
+  }
+  delete it->second;
+  channels_.erase(it);
+  ScheduleWakeUp_w();
+}
+
+void RtpLoadGenerator::SendDuePackets_w() {
+  uint64 now = Now_w();
+  while (!schedule_.empty() && schedule_.begin()->first <= now) {
+    ChannelState* state = schedule_.begin()->second;
+    int lateness = static_cast<int>(now - schedule_.begin()->first);
+    SendPacket_w(state);
+    talk_base::CritScope cs(&stats_crit_);
+    total_lateness_ms_ += lateness;
+    max_lateness_ms_ = talk_base::_max(max_lateness_ms_, lateness);
+    schedule_.erase(schedule_.begin());
+    ScheduleNextPacket_w(state);
+  }
+  ScheduleWakeUp_w();
+}
+
+void RtpLoadGenerator::SendPacket_w(ChannelState* state) {
+  RtpDumpPacketView view;
+  capture_.GetPacket(packets_[state->next_packet], &view);
+  talk_base::Buffer& packet = state->packet;
+  packet.SetData(view.data, view.size);
+
+  // Renumber the packet as the channel's own stream.
+  int seq_num = 0;
+  uint32 timestamp = 0;
+  GetRtpSeqNum(packet.data(), packet.length(), &seq_num);
+  GetRtpTimestamp(packet.data(), packet.length(), &timestamp);
+  seq_num += state->loop_count * loop_seq_num_ + state->seq_num_offset;
+  timestamp += state->loop_count * loop_timestamp_ + state->timestamp_offset;
+  SetRtpSeqNum(packet.data(), packet.length(), seq_num & 0xFFFF);
+  SetRtpTimestamp(packet.data(), packet.length(), timestamp);
+  SetRtpSsrc(packet.data(), packet.length(), state->ssrc);
+
+  size_t length = packet.length();
+  bool sent = state->channel->network_interface() &&
+      state->channel->network_interface()->SendPacket(&packet);
+  talk_base::CritScope cs(&stats_crit_);
+  if (sent) {
+    ++packets_sent_;
+    bytes_sent_ += length;
+  } else {
+    ++send_failures_;
+  }
+
+  if (++state->next_packet == packets_.size()) {
+    state->next_packet = 0;
+    ++state->loop_count;
+  }
+}
+
+void RtpLoadGenerator::ScheduleNextPacket_w(ChannelState* state) {
+  uint64 due = state->start_time +
+      static_cast<uint64>(state->loop_count) * loop_elapsed_time_ +
+      (elapsed_times_[state->next_packet] - elapsed_times_[0]);
+  state->scheduled = schedule_.insert(std::make_pair(due, state));
+}
+
+void RtpLoadGenerator::ScheduleWakeUp_w() {
+  thread_.Clear(this, MSG_LOAD_TICK);
+  if (!schedule_.empty()) {
+    uint64 now = Now_w();
+    uint64 due = schedule_.begin()->first;
+    int wait = due > now ? static_cast<int>(due - now) : 0;
+    thread_.PostDelayed(wait, this, MSG_LOAD_TICK);
+  }
+}
+
+uint64 RtpLoadGenerator::Now_w() {
+  // The clock only moves forward, so the unsigned difference is the time
+  // passed even across a wrap of talk_base::Time().
+  uint32 now = talk_base::Time();
+  clock_ += static_cast<uint32>(now - last_time_);
+  last_time_ = now;
+  return clock_;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Definition of RtpSenderReceiver.
 ///////////////////////////////////////////////////////////////////////////
@@ -261,9 +613,24 @@ FileVoiceChannel::FileVoiceChannel(
     talk_base::StreamInterface* output_file_stream)
     : send_ssrc_(0),
       rtp_sender_receiver_(new RtpSenderReceiver(this, input_file_stream,
-                                                 output_file_stream)) {}
+                                                 output_file_stream)),
+      load_generator_(NULL),
+      sending_(false) {}
 
-FileVoiceChannel::~FileVoiceChannel() {}
+FileVoiceChannel::FileVoiceChannel(
+    RtpLoadGenerator* load_generator,
+    talk_base::StreamInterface* output_file_stream)
+    : send_ssrc_(0),
+      rtp_sender_receiver_(new RtpSenderReceiver(this, NULL,
+                                                 output_file_stream)),
+      load_generator_(load_generator),
+      sending_(false) {}
+
+FileVoiceChannel::~FileVoiceChannel() {
+  if (load_generator_) {
+    load_generator_->StopChannel(this);
+  }
+}
 
 bool FileVoiceChannel::SetSendCodecs(const std::vector<AudioCodec>& codecs) {
   // TODO: Check the format of RTP dump input.
@@ -271,7 +638,18 @@ bool FileVoiceChannel::SetSendCodecs(const std::vector<AudioCodec>& codecs) {
 }
 
 bool FileVoiceChannel::SetSend(SendFlags flag) {
-  return rtp_sender_receiver_->SetSend(flag != SEND_NOTHING);
+  sending_ = flag != SEND_NOTHING;
+  if (load_generator_) {
+    // Without a send stream there is no SSRC to send with yet;
+    // AddSendStream starts the channel once there is one.
+    if (sending_ && send_ssrc_ != 0) {
+      load_generator_->StartChannel(this, send_ssrc_);
+    } else if (!sending_) {
+      load_generator_->StopChannel(this);
+    }
+    return true;
+  }
+  return rtp_sender_receiver_->SetSend(sending_);
 }
 
 bool FileVoiceChannel::AddSendStream(const StreamParams& sp) {
@@ -281,6 +659,9 @@ bool FileVoiceChannel::AddSendStream(const StreamParams& sp) {
   }
   send_ssrc_ = sp.ssrcs[0];
   rtp_sender_receiver_->SetSendSsrc(send_ssrc_);
+  if (load_generator_ && sending_) {
+    load_generator_->StartChannel(this, send_ssrc_);
+  }
   return true;
 }
 
@@ -289,6 +670,9 @@ bool FileVoiceChannel::RemoveSendStream(uint32 ssrc) {
     return false;
   send_ssrc_ = 0;
   rtp_sender_receiver_->SetSendSsrc(send_ssrc_);
+  if (load_generator_) {
+    load_generator_->StopChannel(this);
+  }
   return true;
 }
 
@@ -304,9 +688,24 @@ FileVideoChannel::FileVideoChannel(
     talk_base::StreamInterface* output_file_stream)
     : send_ssrc_(0),
       rtp_sender_receiver_(new RtpSenderReceiver(this, input_file_stream,
-                                                 output_file_stream)) {}
+                                                 output_file_stream)),
+      load_generator_(NULL),
+      sending_(false) {}
 
-FileVideoChannel::~FileVideoChannel() {}
+FileVideoChannel::FileVideoChannel(
+    RtpLoadGenerator* load_generator,
+    talk_base::StreamInterface* output_file_stream)
+    : send_ssrc_(0),
+      rtp_sender_receiver_(new RtpSenderReceiver(this, NULL,
+                                                 output_file_stream)),
+      load_generator_(load_generator),
+      sending_(false) {}
+
+FileVideoChannel::~FileVideoChannel() {
+  if (load_generator_) {
+    load_generator_->StopChannel(this);
+  }
+}
 
 bool FileVideoChannel::SetSendCodecs(const std::vector<VideoCodec>& codecs) {
   // TODO: Check the format of RTP dump input.
@@ -314,7 +713,18 @@ bool FileVideoChannel::SetSendCodecs(const std::vector<VideoCodec>& codecs) {
 }
 
 bool FileVideoChannel::SetSend(bool send) {
-  return rtp_sender_receiver_->SetSend(send);
+  sending_ = send;
+  if (load_generator_) {
+    // Without a send stream there is no SSRC to send with yet;
+    // AddSendStream starts the channel once there is one.
+    if (sending_ && send_ssrc_ != 0) {
+      load_generator_->StartChannel(this, send_ssrc_);
+    } else if (!sending_) {
+      load_generator_->StopChannel(this);
+    }
+    return true;
+  }
+  return rtp_sender_receiver_->SetSend(sending_);
 }
 
 bool FileVideoChannel::AddSendStream(const StreamParams& sp) {
@@ -324,6 +734,9 @@ bool FileVideoChannel::AddSendStream(const StreamParams& sp) {
   }
   send_ssrc_ = sp.ssrcs[0];
   rtp_sender_receiver_->SetSendSsrc(send_ssrc_);
+  if (load_generator_ && sending_) {
+    load_generator_->StartChannel(this, send_ssrc_);
+  }
   return true;
 }
 
@@ -332,6 +745,9 @@ bool FileVideoChannel::RemoveSendStream(uint32 ssrc) {
     return false;
   send_ssrc_ = 0;
   rtp_sender_receiver_->SetSendSsrc(send_ssrc_);
+  if (load_generator_) {
+    load_generator_->StopChannel(this);
+  }
   return true;
 }
 
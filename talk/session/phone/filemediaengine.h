@@ -26,14 +26,19 @@
 #ifndef TALK_SESSION_PHONE_FILEMEDIAENGINE_H_
 #define TALK_SESSION_PHONE_FILEMEDIAENGINE_H_
 
+#include <map>
 #include <string>
 #include <vector>
 
+#include "talk/base/criticalsection.h"
+#include "talk/base/messagehandler.h"
 #include "talk/base/scoped_ptr.h"
 #include "talk/base/stream.h"
+#include "talk/base/thread.h"
 #include "talk/session/phone/codec.h"
 #include "talk/session/phone/mediachannel.h"
 #include "talk/session/phone/mediaengine.h"
+#include "talk/session/phone/rtpdump.h"
 
 namespace talk_base {
 class StreamInterface;
@@ -41,6 +46,8 @@ class StreamInterface;
 
 namespace cricket {
 
+class RtpLoadGenerator;
+
 // A media engine contains a capturer, an encoder, and a sender in the sender
 // side and a receiver, a decoder, and a renderer in the receiver side.
 // FileMediaEngine simulates the capturer and the encoder via an input RTP dump
@@ -48,10 +55,16 @@ namespace cricket {
 // stream. Depending on the parameters of the constructor, FileMediaEngine can
 // act as file voice engine, file video engine, or both. Currently, we use
 // only the RTP dump packets. TODO: Enable RTCP packets.
+//
+// In load-generator mode, set with set_voice_load_capture_filename or
+// set_video_load_capture_filename, every channel of that media type replays
+// the same capture, memory-mapped once and paced by one shared
+// RtpLoadGenerator thread, so that hundreds of calls can be simulated on one
+// machine.
 class FileMediaEngine : public MediaEngineInterface {
  public:
-  FileMediaEngine() {}
-  virtual ~FileMediaEngine() {}
+  FileMediaEngine();
+  virtual ~FileMediaEngine();
 
   // Set the file name of the input or output RTP dump for voice or video.
   // Should be called before the channel is created.
@@ -67,6 +80,22 @@ class FileMediaEngine : public MediaEngineInterface {
   void set_video_output_filename(const std::string& filename) {
     video_output_filename_ = filename;
   }
+  // Set the RTP dump that all voice or video channels replay in load-generator
+  // mode. Overrides the input filename. Should be called before the channel is
+  // created.
+  void set_voice_load_capture_filename(const std::string& filename) {
+    voice_load_capture_filename_ = filename;
+  }
+  void set_video_load_capture_filename(const std::string& filename) {
+    video_load_capture_filename_ = filename;
+  }
+  // The shared load generators, or NULL until the first channel is created.
+  RtpLoadGenerator* voice_load_generator() {
+    return voice_load_generator_.get();
+  }
+  RtpLoadGenerator* video_load_generator() {
+    return video_load_generator_.get();
+  }
 
   // Should be called before codecs() and video_codecs() are called. We need to
   // set the voice and video codecs; otherwise, Jingle initiation will fail.
@@ -139,18 +168,113 @@ class FileMediaEngine : public MediaEngineInterface {
   std::string voice_output_filename_;
   std::string video_input_filename_;
   std::string video_output_filename_;
+  std::string voice_load_capture_filename_;
+  std::string video_load_capture_filename_;
   std::vector<AudioCodec> voice_codecs_;
   std::vector<VideoCodec> video_codecs_;
+  talk_base::scoped_ptr<RtpLoadGenerator> voice_load_generator_;
+  talk_base::scoped_ptr<RtpLoadGenerator> video_load_generator_;
 
   DISALLOW_COPY_AND_ASSIGN(FileMediaEngine);
 };
 
+struct RtpLoadGeneratorStats {
+  RtpLoadGeneratorStats()
+      : channels(0), elapsed_ms(0), packets_sent(0), bytes_sent(0),
+        send_failures(0), packets_per_second(0), bits_per_second(0),
+        mean_lateness_ms(0), max_lateness_ms(0) {
+  }
+
+  int channels;         // Channels currently sending.
+  uint32 elapsed_ms;    // Since the first channel started sending.
+  uint64 packets_sent;
+  uint64 bytes_sent;
+  uint64 send_failures;
+  double packets_per_second;  // Achieved over elapsed_ms.
+  double bits_per_second;
+  // How late packets went out compared with the capture's timing. This is
+  // not RTP jitter, which compares the spacing of successive packets.
+  double mean_lateness_ms;
+  int max_lateness_ms;
+};
+
+// RtpLoadGenerator replays the RTP packets of the first SSRC in a capture
+// into any number of media channels from a single thread. The capture is
+// memory-mapped once. All channels wait in one queue ordered by the time
+// their next packet is due. Each channel's packets get its send SSRC and a
+// sequence number and timestamp base of its own, and are renumbered
+// seamlessly each time the capture loops.
+class RtpLoadGenerator : public talk_base::MessageHandler {
+ public:
+  RtpLoadGenerator();
+  virtual ~RtpLoadGenerator();
+
+  // Maps and indexes |capture_filename| and starts the pacing thread.
+  bool Init(const std::string& capture_filename);
+  // Spreads the first packets of the channels over |spread_ms|, so that
+  // channels started together don't send in lock step.
+  void set_start_spread_ms(int spread_ms) { start_spread_ms_ = spread_ms; }
+
+  // Start or stop replaying into |channel|. Context: any thread; they
+  // return once the pacing thread has taken the change.
+  void StartChannel(MediaChannel* channel, uint32 ssrc);
+  void StopChannel(MediaChannel* channel);
+  void GetStats(RtpLoadGeneratorStats* stats);
+
+  // Implements talk_base::MessageHandler. Context: pacing thread.
+  virtual void OnMessage(talk_base::Message* msg);
+
+ private:
+  struct ChannelState;
+  // Keyed on Now_w() time, which doesn't wrap like talk_base::Time().
+  typedef std::multimap<uint64, ChannelState*> Schedule;
+
+  void StartChannel_w(MediaChannel* channel, uint32 ssrc);
+  void SetChannelSsrc_w(ChannelState* state, uint32 ssrc);
+  void StopChannel_w(MediaChannel* channel);
+  void SendDuePackets_w();
+  void SendPacket_w(ChannelState* state);
+  void ScheduleNextPacket_w(ChannelState* state);
+  void ScheduleWakeUp_w();
+  // Returns talk_base::Time() unwrapped to 64 bits.
+  uint64 Now_w();
+
+  talk_base::Thread thread_;
+  RtpDumpMappedReader capture_;
+  // Indices in |capture_| of the replayed packets, with their RTP fields.
+  std::vector<uint32> packets_;
+  std::vector<uint32> elapsed_times_;
+  // How much the elapsed time, sequence number and timestamp advance each
+  // time the capture loops.
+  uint32 loop_elapsed_time_;
+  uint16 loop_seq_num_;
+  uint32 loop_timestamp_;
+  int start_spread_ms_;
+  std::map<MediaChannel*, ChannelState*> channels_;
+  Schedule schedule_;
+  uint32 last_time_;
+  uint64 clock_;
+
+  talk_base::CriticalSection stats_crit_;
+  uint32 start_time_;
+  uint64 packets_sent_;
+  uint64 bytes_sent_;
+  uint64 send_failures_;
+  uint64 total_lateness_ms_;
+  int max_lateness_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(RtpLoadGenerator);
+};
+
 class RtpSenderReceiver;  // Forward declaration. Defined in the .cc file.
 
 class FileVoiceChannel : public VoiceMediaChannel {
  public:
   FileVoiceChannel(talk_base::StreamInterface* input_file_stream,
       talk_base::StreamInterface* output_file_stream);
+  // Sends packets from |load_generator| rather than from an input stream.
+  FileVoiceChannel(RtpLoadGenerator* load_generator,
+      talk_base::StreamInterface* output_file_stream);
   virtual ~FileVoiceChannel();
 
   // Implement pure virtual methods of VoiceMediaChannel.
@@ -201,6 +325,8 @@ class FileVoiceChannel : public VoiceMediaChannel {
  private:
   uint32 send_ssrc_;
   talk_base::scoped_ptr<RtpSenderReceiver> rtp_sender_receiver_;
+  RtpLoadGenerator* load_generator_;
+  bool sending_;
   int options_;
 
   DISALLOW_COPY_AND_ASSIGN(FileVoiceChannel);
@@ -210,6 +336,9 @@ class FileVideoChannel : public VideoMediaChannel {
  public:
   FileVideoChannel(talk_base::StreamInterface* input_file_stream,
       talk_base::StreamInterface* output_file_stream);
+  // Sends packets from |load_generator| rather than from an input stream.
+  FileVideoChannel(RtpLoadGenerator* load_generator,
+      talk_base::StreamInterface* output_file_stream);
   virtual ~FileVideoChannel();
 
   // Implement pure virtual methods of VideoMediaChannel.
@@ -259,6 +388,8 @@ class FileVideoChannel : public VideoMediaChannel {
  private:
   uint32 send_ssrc_;
   talk_base::scoped_ptr<RtpSenderReceiver> rtp_sender_receiver_;
+  RtpLoadGenerator* load_generator_;
+  bool sending_;
   int options_;
 
   DISALLOW_COPY_AND_ASSIGN(FileVideoChannel);
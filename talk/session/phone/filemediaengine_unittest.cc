@@ -451,6 +451,84 @@ TEST_F(FileMediaEngineTest, TestVoiceChannelSenderThreadTwoSsrcs) {
   EXPECT_GE(packet_count, 2 * RtpTestUtility::GetTestPacketCount());
 }
 
+// Test that in load-generator mode many channels replay one capture, each as
+// its own stream.
+TEST_F(FileMediaEngineTest, TestVoiceChannelLoadGenerator) {
+  EXPECT_TRUE(WriteTestPacketsToFile(voice_input_filename_, 1));
+  engine_.reset(new FileMediaEngine);
+  engine_->set_voice_load_capture_filename(voice_input_filename_);
+  EXPECT_TRUE(engine_->GetCapabilities() & AUDIO_SEND);
+
+  const size_t kNumChannels = 8;
+  std::vector<VoiceMediaChannel*> channels;
+  std::vector<talk_base::MemoryStream*> dumps;
+  std::vector<FileNetworkInterface*> interfaces;
+  for (size_t i = 0; i < kNumChannels; ++i) {
+    VoiceMediaChannel* channel = engine_->CreateChannel();
+    ASSERT_TRUE(NULL != channel);
+    channels.push_back(channel);
+    dumps.push_back(new talk_base::MemoryStream);
+    interfaces.push_back(new FileNetworkInterface(dumps[i], NULL));
+    channel->SetInterface(interfaces[i]);
+    // Half of the channels start sending before they have a send stream,
+    // which must not send anything until the SSRC is known.
+    if (i % 2) {
+      EXPECT_TRUE(channel->SetSend(SEND_MICROPHONE));
+      talk_base::Thread::Current()->ProcessMessages(kWaitTimeMs);
+      EXPECT_EQ(0U, interfaces[i]->num_sent_packets());
+    }
+    EXPECT_TRUE(channel->AddSendStream(StreamParams::CreateLegacy(
+        RtpTestUtility::kDefaultSsrc + 100 + i)));
+    if (!(i % 2)) {
+      EXPECT_TRUE(channel->SetSend(SEND_MICROPHONE));
+    }
+  }
+  ASSERT_TRUE(NULL != engine_->voice_load_generator());
+
+  for (size_t i = 0; i < kNumChannels; ++i) {
+    EXPECT_TRUE_WAIT(interfaces[i]->num_sent_packets() >=
+                     2 * RtpTestUtility::GetTestPacketCount(), kWaitTimeout);
+  }
+  RtpLoadGeneratorStats stats;
+  engine_->voice_load_generator()->GetStats(&stats);
+  EXPECT_EQ(static_cast<int>(kNumChannels), stats.channels);
+  EXPECT_GE(stats.packets_sent,
+            kNumChannels * 2 * RtpTestUtility::GetTestPacketCount());
+  EXPECT_EQ(0U, stats.send_failures);
+  EXPECT_GT(stats.bytes_sent, 0U);
+
+  // Removing the send stream stops the channel.
+  EXPECT_TRUE(channels[0]->RemoveSendStream(
+      RtpTestUtility::kDefaultSsrc + 100));
+  engine_->voice_load_generator()->GetStats(&stats);
+  EXPECT_EQ(static_cast<int>(kNumChannels) - 1, stats.channels);
+
+  // Stop sending and check that each channel sent only its own SSRC.
+  for (size_t i = 0; i < kNumChannels; ++i) {
+    EXPECT_TRUE(channels[i]->SetSend(SEND_NOTHING));
+  }
+  engine_->voice_load_generator()->GetStats(&stats);
+  EXPECT_EQ(0, stats.channels);
+  for (size_t i = 0; i < kNumChannels; ++i) {
+    size_t ssrc_count = 0;
+    dumps[i]->Rewind();
+    RtpDumpReader reader(dumps[i]);
+    RtpDumpPacket packet;
+    std::set<uint32> ssrcs;
+    while (talk_base::SR_SUCCESS == reader.ReadPacket(&packet)) {
+      uint32 ssrc = 0;
+      EXPECT_TRUE(packet.GetRtpSsrc(&ssrc));
+      ssrcs.insert(ssrc);
+    }
+    ssrc_count = ssrcs.size();
+    EXPECT_EQ(1U, ssrc_count);
+    EXPECT_EQ(RtpTestUtility::kDefaultSsrc + 100 + i, *ssrcs.begin());
+    delete channels[i];
+    delete interfaces[i];
+    delete dumps[i];
+  }
+}
+
 // Test SendIntraFrame() and RequestIntraFrame() of video channel.
 TEST_F(FileMediaEngineTest, TestVideoChannelIntraFrame) {
   EXPECT_TRUE(CreateEngineAndChannels("", "", video_input_filename_,
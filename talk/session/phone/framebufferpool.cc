@@ -0,0 +1,179 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/session/phone/framebufferpool.h"
+
+#include "talk/base/common.h"
+
+namespace cricket {
+
+///////////////////////////////////////////////////////////////////////////
+// Implementation of FrameBuffer.
+///////////////////////////////////////////////////////////////////////////
+FrameBuffer::FrameBuffer(FrameBufferPool* pool, uint8* data, size_t size)
+    : pool_(pool), data_(data), size_(size), ref_count_(0) {
+}
+
+FrameBuffer::~FrameBuffer() {
+}
+
+int FrameBuffer::AddRef() {
+  return talk_base::AtomicOps::Increment(&ref_count_);
+}
+
+int FrameBuffer::Release() {
+  int count = talk_base::AtomicOps::Decrement(&ref_count_);
+  if (!count) {
+    if (data_) {
+      pool_->Recycle(data_, size_);
+    }
+    delete this;
+  }
+  return count;
+}
+
+bool FrameBuffer::HasOneRef() const {
+  return talk_base::AtomicOps::Load(&ref_count_) == 1;
+}
+
+uint8* FrameBuffer::ReleaseData() {
+  ASSERT(HasOneRef());
+  uint8* data = data_;
+  if (data) {
+    pool_->Forget(size_);
+  }
+  data_ = NULL;
+  size_ = 0;
+  return data;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Implementation of FrameBufferPool.
+///////////////////////////////////////////////////////////////////////////
+FrameBufferPool::FrameBufferPool()
+    : max_free_bytes_(kDefaultMaxFreeBytes) {
+}
+
+FrameBufferPool::~FrameBufferPool() {
+  Trim();
+}
+
+static FrameBufferPool* CreateDefaultPool() {
+  FrameBufferPool* pool = new talk_base::RefCountedObject<FrameBufferPool>();
+  pool->AddRef();  // Never released.
+  return pool;
+}
+
+FrameBufferPool* FrameBufferPool::Default() {
+  static FrameBufferPool* pool = CreateDefaultPool();
+  return pool;
+}
+
+talk_base::scoped_refptr<FrameBuffer> FrameBufferPool::Acquire(size_t size) {
+  uint8* data = NULL;
+  {
+    talk_base::CritScope cs(&crit_);
+    ++stats_.allocations;
+    FreeBuffers::iterator it = free_buffers_.find(size);
+    if (it != free_buffers_.end() && !it->second.empty()) {
+      data = it->second.back();
+      it->second.pop_back();
+      stats_.bytes_free -= size;
+      ++stats_.hits;
+    }
+    ++stats_.buffers_in_use;
+    stats_.bytes_in_use += size;
+    stats_.peak_bytes = talk_base::_max(stats_.peak_bytes,
+                                        stats_.bytes_in_use + stats_.bytes_free);
+  }
+  if (!data) {
+    data = new uint8[size];
+  }
+  return new FrameBuffer(this, data, size);
+}
+
+void FrameBufferPool::set_max_free_bytes(size_t max_free_bytes) {
+  talk_base::CritScope cs(&crit_);
+  max_free_bytes_ = max_free_bytes;
+  if (stats_.bytes_free > max_free_bytes_) {
+    MakeRoom(0, 0);
+  }
+}
+
+void FrameBufferPool::Trim() {
+  talk_base::CritScope cs(&crit_);
+  for (FreeBuffers::iterator it = free_buffers_.begin();
+       it != free_buffers_.end(); ++it) {
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      delete[] it->second[i];
+    }
+  }
+  free_buffers_.clear();
+  stats_.bytes_free = 0;
+}
+
+void FrameBufferPool::GetStats(FrameBufferPoolStats* stats) {
+  talk_base::CritScope cs(&crit_);
+  *stats = stats_;
+}
+
+void FrameBufferPool::Recycle(uint8* data, size_t size) {
+  talk_base::CritScope cs(&crit_);
+  --stats_.buffers_in_use;
+  stats_.bytes_in_use -= size;
+  MakeRoom(size, size);
+  if (stats_.bytes_free + size > max_free_bytes_) {
+    delete[] data;
+    return;
+  }
+  free_buffers_[size].push_back(data);
+  stats_.bytes_free += size;
+}
+
+void FrameBufferPool::Forget(size_t size) {
+  talk_base::CritScope cs(&crit_);
+  --stats_.buffers_in_use;
+  stats_.bytes_in_use -= size;
+}
+
+void FrameBufferPool::MakeRoom(size_t bytes, size_t keep_size) {
+  // Frame sizes only change when the resolution does, so the memory of other
+  // sizes is the least likely to be reused.
+  FreeBuffers::iterator it = free_buffers_.begin();
+  while (stats_.bytes_free + bytes > max_free_bytes_ &&
+         it != free_buffers_.end()) {
+    if (it->first == keep_size || it->second.empty()) {
+      ++it;
+      continue;
+    }
+    delete[] it->second.back();
+    it->second.pop_back();
+    stats_.bytes_free -= it->first;
+  }
+}
+
+}  // namespace cricket
@@ -0,0 +1,136 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_SESSION_PHONE_FRAMEBUFFERPOOL_H_
+#define TALK_SESSION_PHONE_FRAMEBUFFERPOOL_H_
+
+#include <map>
+#include <vector>
+
+#include "talk/base/basictypes.h"
+#include "talk/base/constructormagic.h"
+#include "talk/base/criticalsection.h"
+#include "talk/base/refcount.h"
+#include "talk/base/scoped_ref_ptr.h"
+
+namespace cricket {
+
+class FrameBufferPool;
+
+// A reference-counted block of frame memory from a FrameBufferPool. When the
+// last reference is released, the memory goes back to the pool rather than to
+// the heap, so that frames of the same size can reuse it.
+class FrameBuffer : public talk_base::RefCountInterface {
+ public:
+  uint8* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  virtual int AddRef();
+  virtual int Release();
+  // True if the caller holds the only reference, so the buffer may be
+  // written without affecting anybody else.
+  bool HasOneRef() const;
+
+  // Takes the memory out of the pool. The caller then owns it and must free it
+  // with delete[]. The buffer must have one reference, and is empty afterward.
+  uint8* ReleaseData();
+
+ private:
+  friend class FrameBufferPool;
+  FrameBuffer(FrameBufferPool* pool, uint8* data, size_t size);
+  // Virtual since Release deletes through this class, which has virtual
+  // functions of its own.
+  virtual ~FrameBuffer();
+
+  talk_base::scoped_refptr<FrameBufferPool> pool_;
+  uint8* data_;
+  size_t size_;
+  int ref_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrameBuffer);
+};
+
+struct FrameBufferPoolStats {
+  FrameBufferPoolStats()
+      : allocations(0), hits(0), buffers_in_use(0), bytes_in_use(0),
+        bytes_free(0), peak_bytes(0) {
+  }
+
+  int64 allocations;    // Calls to Acquire.
+  int64 hits;           // Acquires served from a free buffer.
+  int buffers_in_use;
+  size_t bytes_in_use;
+  size_t bytes_free;    // Held by the pool for reuse.
+  size_t peak_bytes;    // Largest bytes_in_use + bytes_free seen.
+};
+
+// FrameBufferPool keeps the memory of released frame buffers, keyed by size,
+// and hands it out again to the next Acquire of the same size. A video stream
+// thus stops allocating once it has as many buffers as it has frames in
+// flight. FrameBufferPool is thread safe, and is reference counted so that
+// outstanding buffers keep it alive; create it with
+// new talk_base::RefCountedObject<FrameBufferPool>().
+class FrameBufferPool : public talk_base::RefCountInterface {
+ public:
+  // Free memory above this is returned to the heap.
+  static const size_t kDefaultMaxFreeBytes = 32 * 1024 * 1024;
+
+  FrameBufferPool();
+  virtual ~FrameBufferPool();
+
+  // The pool shared by the video frames of the process.
+  static FrameBufferPool* Default();
+
+  // Returns a buffer of |size| bytes, whose content is undefined.
+  talk_base::scoped_refptr<FrameBuffer> Acquire(size_t size);
+
+  void set_max_free_bytes(size_t max_free_bytes);
+  // Returns all the free memory to the heap.
+  void Trim();
+  void GetStats(FrameBufferPoolStats* stats);
+
+ private:
+  friend class FrameBuffer;
+  typedef std::map<size_t, std::vector<uint8*> > FreeBuffers;
+
+  // Called with the memory of the last reference to a buffer.
+  void Recycle(uint8* data, size_t size);
+  void Forget(size_t size);
+  // Frees memory of sizes other than |keep_size| until |bytes| more fit.
+  void MakeRoom(size_t bytes, size_t keep_size);
+
+  talk_base::CriticalSection crit_;
+  FreeBuffers free_buffers_;
+  size_t max_free_bytes_;
+  FrameBufferPoolStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrameBufferPool);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_SESSION_PHONE_FRAMEBUFFERPOOL_H_
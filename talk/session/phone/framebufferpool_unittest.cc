@@ -0,0 +1,162 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/base/gunit.h"
+#include "talk/base/scoped_ref_ptr.h"
+#include "talk/base/thread.h"
+#include "talk/session/phone/framebufferpool.h"
+
+namespace cricket {
+
+class FrameBufferPoolTest : public testing::Test {
+ public:
+  FrameBufferPoolTest()
+      : pool_(new talk_base::RefCountedObject<FrameBufferPool>()) {
+  }
+
+ protected:
+  FrameBufferPoolStats GetStats() {
+    FrameBufferPoolStats stats;
+    pool_->GetStats(&stats);
+    return stats;
+  }
+
+  talk_base::scoped_refptr<FrameBufferPool> pool_;
+};
+
+// Test that a released buffer is reused by the next Acquire of its size.
+TEST_F(FrameBufferPoolTest, ReuseSameSize) {
+  talk_base::scoped_refptr<FrameBuffer> buffer = pool_->Acquire(1000);
+  ASSERT_TRUE(buffer.get() != NULL);
+  EXPECT_EQ(1000U, buffer->size());
+  EXPECT_TRUE(buffer->HasOneRef());
+  uint8* data = buffer->data();
+  EXPECT_EQ(1, GetStats().buffers_in_use);
+  EXPECT_EQ(1000U, GetStats().bytes_in_use);
+  buffer = NULL;
+  EXPECT_EQ(0, GetStats().buffers_in_use);
+  EXPECT_EQ(1000U, GetStats().bytes_free);
+
+  buffer = pool_->Acquire(1000);
+  EXPECT_EQ(data, buffer->data());
+  buffer = pool_->Acquire(2000);
+  EXPECT_EQ(2000U, buffer->size());
+
+  FrameBufferPoolStats stats = GetStats();
+  EXPECT_EQ(3, stats.allocations);
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.buffers_in_use);
+  EXPECT_EQ(2000U, stats.bytes_in_use);
+  EXPECT_EQ(1000U, stats.bytes_free);
+  EXPECT_EQ(3000U, stats.peak_bytes);
+}
+
+// Test that the memory goes back to the pool only with the last reference.
+TEST_F(FrameBufferPoolTest, SharedBuffer) {
+  talk_base::scoped_refptr<FrameBuffer> buffer1 = pool_->Acquire(100);
+  talk_base::scoped_refptr<FrameBuffer> buffer2 = buffer1;
+  EXPECT_FALSE(buffer1->HasOneRef());
+  buffer1 = NULL;
+  EXPECT_TRUE(buffer2->HasOneRef());
+  EXPECT_EQ(1, GetStats().buffers_in_use);
+  buffer2 = NULL;
+  EXPECT_EQ(0, GetStats().buffers_in_use);
+  EXPECT_EQ(100U, GetStats().bytes_free);
+}
+
+// Test that ReleaseData hands the memory out of the pool.
+TEST_F(FrameBufferPoolTest, ReleaseData) {
+  talk_base::scoped_refptr<FrameBuffer> buffer = pool_->Acquire(100);
+  uint8* data = buffer->ReleaseData();
+  EXPECT_TRUE(data != NULL);
+  EXPECT_TRUE(buffer->data() == NULL);
+  EXPECT_EQ(0, GetStats().buffers_in_use);
+  buffer = NULL;
+  EXPECT_EQ(0U, GetStats().bytes_free);
+  delete[] data;
+}
+
+// Test that the free memory is capped, dropping other sizes first.
+TEST_F(FrameBufferPoolTest, MaxFreeBytes) {
+  pool_->set_max_free_bytes(2500);
+  talk_base::scoped_refptr<FrameBuffer> small = pool_->Acquire(500);
+  talk_base::scoped_refptr<FrameBuffer> large1 = pool_->Acquire(1000);
+  talk_base::scoped_refptr<FrameBuffer> large2 = pool_->Acquire(1000);
+  talk_base::scoped_refptr<FrameBuffer> large3 = pool_->Acquire(1000);
+  small = NULL;
+  large1 = NULL;
+  large2 = NULL;
+  EXPECT_EQ(2500U, GetStats().bytes_free);
+  // The 500 byte buffer makes way, then there is no more room.
+  large3 = NULL;
+  EXPECT_EQ(2000U, GetStats().bytes_free);
+  pool_->Trim();
+  EXPECT_EQ(0U, GetStats().bytes_free);
+}
+
+// Test that buffers keep the pool alive.
+TEST_F(FrameBufferPoolTest, BufferOutlivesPool) {
+  talk_base::scoped_refptr<FrameBuffer> buffer = pool_->Acquire(100);
+  pool_ = NULL;
+  memset(buffer->data(), 0, buffer->size());
+  buffer = NULL;
+}
+
+class FrameBufferUser : public talk_base::MessageHandler {
+ public:
+  explicit FrameBufferUser(FrameBufferPool* pool) : pool_(pool) {}
+  virtual void OnMessage(talk_base::Message* msg) {
+    for (int i = 0; i < 1000; ++i) {
+      talk_base::scoped_refptr<FrameBuffer> buffer =
+          pool_->Acquire(100 + i % 3);
+      buffer->data()[0] = i;
+    }
+  }
+
+ private:
+  FrameBufferPool* pool_;
+};
+
+// Test that the pool can be used from several threads at once.
+TEST_F(FrameBufferPoolTest, ManyThreads) {
+  const int kNumThreads = 4;
+  FrameBufferUser user(pool_.get());
+  talk_base::Thread threads[kNumThreads];
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i].Start();
+    threads[i].Post(&user);
+  }
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads[i].Stop();
+  }
+  FrameBufferPoolStats stats = GetStats();
+  EXPECT_EQ(kNumThreads * 1000, stats.allocations);
+  EXPECT_EQ(0, stats.buffers_in_use);
+  EXPECT_GT(stats.hits, 0);
+}
+
+}  // namespace cricket
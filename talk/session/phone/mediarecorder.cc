@@ -31,26 +31,67 @@
 
 #include <string>
 
+#include "talk/base/byteorder.h"
 #include "talk/base/fileutils.h"
 #include "talk/base/logging.h"
 #include "talk/base/pathutils.h"
+#include "talk/base/stringencode.h"
+#include "talk/base/thread.h"
+#include "talk/base/timeutils.h"
 #include "talk/session/phone/channel.h"
 #include "talk/session/phone/rtpdump.h"
 
-
 namespace cricket {
 
 ///////////////////////////////////////////////////////////////////////////
 // Implementation of RtpDumpSink.
 ///////////////////////////////////////////////////////////////////////////
+enum {
+  MSG_OPEN = 1,
+  MSG_WRITE,
+  MSG_FLUSH,
+  MSG_CLOSE,
+};
+
+// Each buffered packet is a record of its kind, its length, the number of
+// bytes kept by the filter and its elapsed time, followed by the kept bytes.
+enum RecordKind {
+  RECORD_RTP = 0,
+  RECORD_RTCP = 1,
+  RECORD_NEW_FILE = 2,  // No packet; the following ones go to the next file.
+};
+static const size_t kRecordHeaderLength = 9;
+static const size_t kDefaultBufferSize = 512 * 1024;
+// How long a packet may sit in the buffer before it is written.
+static const int kWriteDelayMs = 100;
+
 RtpDumpSink::RtpDumpSink(const std::string& filename)
     : max_size_(INT_MAX),
       recording_(false),
       packet_filter_(PF_NONE),
-      filename_(filename) {
+      filename_(filename),
+      buffer_size_(kDefaultBufferSize),
+      buffer_capacity_(0),
+      opened_(false),
+      write_posted_(false),
+      write_file_index_(0),
+      total_size_(0),
+      file_size_(0),
+      file_start_ms_(0),
+      file_count_(0),
+      max_file_size_(0),
+      max_file_ms_(0),
+      dropped_packets_(0),
+      dropped_bytes_(0) {
 }
 
-RtpDumpSink::~RtpDumpSink() {}
+RtpDumpSink::~RtpDumpSink() {
+  if (writer_thread_.get()) {
+    writer_thread_->Send(this, MSG_CLOSE);
+    writer_thread_->Clear(this);
+    writer_thread_->Stop();
+  }
+}
 
 void RtpDumpSink::SetMaxSize(size_t size) {
   talk_base::CritScope cs(&critical_section_);
@@ -58,54 +99,237 @@ void RtpDumpSink::SetMaxSize(size_t size) {
 }
 
 bool RtpDumpSink::Enable(bool enable) {
-  talk_base::CritScope cs(&critical_section_);
-
-  recording_ = enable;
+  bool open;
+  {
+    talk_base::CritScope cs(&critical_section_);
+    recording_ = enable;
+    open = recording_ && !opened_;
+    if (open) {
+      file_start_ms_ = talk_base::Time();
+    }
+  }
 
-  // Create a file and the RTP writer if we have not done yet.
-  if (recording_ && !writer_.get()) {
-    stream_.reset(talk_base::Filesystem::OpenFile(
-        talk_base::Pathname(filename_), "wb"));
-    if (!stream_.get()) {
+  // Create a file and the RTP writer if we have not done yet. The writer
+  // thread is called without holding the lock, which it takes to swap the
+  // buffers.
+  if (open) {
+    if (!writer_thread_.get()) {
+      writer_thread_.reset(new talk_base::Thread);
+      writer_thread_->SetName("RtpDumpSink", this);
+      writer_thread_->Start();
+    }
+    writer_thread_->Send(this, MSG_OPEN);
+    talk_base::CritScope cs(&critical_section_);
+    opened_ = (writer_.get() != NULL);
+    if (!opened_) {
       return false;
     }
-    writer_.reset(new RtpDumpWriter(stream_.get()));
-    writer_->set_packet_filter(packet_filter_);
-  } else if (!recording_ && stream_.get()) {
-    stream_->Flush();
+    buffer_capacity_ = buffer_size_;
+    front_buffer_.SetCapacity(buffer_capacity_);
+    back_buffer_.SetCapacity(buffer_capacity_);
+    file_count_ = 1;
+  } else if (!enable && writer_thread_.get()) {
+    writer_thread_->Send(this, MSG_FLUSH);
   }
   return true;
 }
 
 void RtpDumpSink::OnPacket(const void* data, size_t size, bool rtcp) {
   talk_base::CritScope cs(&critical_section_);
+  if (!recording_ || !opened_) {
+    return;
+  }
+  if (rtcp) {
+    // TODO: Enable recording RTCP.
+    return;
+  }
+  size_t write_len = RtpDumpWriter::FilterPacket(packet_filter_, data, size,
+                                                 rtcp);
+  if (write_len == 0) {
+    return;
+  }
 
-  if (recording_ && writer_.get()) {
-    size_t current_size;
-    if (writer_->GetDumpSize(&current_size) &&
-        current_size + RtpDumpPacket::kHeaderLength + size <= max_size_) {
-      if (!rtcp) {
-        writer_->WriteRtpPacket(data, size);
-      } else {
-        // TODO: Enable recording RTCP.
-      }
-    }
+  // Check whether this packet starts a new file.
+  uint32 now = talk_base::Time();
+  size_t dump_len = RtpDumpPacket::kHeaderLength + write_len;
+  bool new_file = file_size_ > 0 &&
+      ((max_file_size_ > 0 && file_size_ + dump_len > max_file_size_) ||
+       (max_file_ms_ > 0 &&
+        talk_base::TimeDiff(now, file_start_ms_) >=
+            static_cast<int>(max_file_ms_)));
+  // The file header goes out with the first packet of each file.
+  size_t file_header_len = (new_file || file_size_ == 0) ?
+      strlen(RtpDumpFileHeader::kFirstLine) + RtpDumpFileHeader::kHeaderLength :
+      0;
+  if (total_size_ + file_header_len + dump_len > max_size_) {
+    return;
+  }
+  size_t record_len = (new_file ? kRecordHeaderLength : 0) +
+      kRecordHeaderLength + write_len;
+  if (front_buffer_.length() + record_len > buffer_capacity_) {
+    // The writer thread has fallen behind; drop rather than wait for it.
+    ++dropped_packets_;
+    dropped_bytes_ += size;
+    return;
+  }
+
+  if (new_file) {
+    // The new file's start time goes where a packet's elapsed time would.
+    char record[kRecordHeaderLength] = { RECORD_NEW_FILE };
+    talk_base::SetBE32(record + 5, now);
+    front_buffer_.AppendData(record, sizeof(record));
+    file_size_ = 0;
+    file_start_ms_ = now;
+    ++file_count_;
+  }
+  char record[kRecordHeaderLength];
+  record[0] = rtcp ? RECORD_RTCP : RECORD_RTP;
+  talk_base::SetBE16(record + 1, static_cast<uint16>(size));
+  talk_base::SetBE16(record + 3, static_cast<uint16>(write_len));
+  talk_base::SetBE32(record + 5, talk_base::TimeDiff(now, file_start_ms_));
+  front_buffer_.AppendData(record, sizeof(record));
+  front_buffer_.AppendData(data, write_len);
+  file_size_ += file_header_len + dump_len;
+  total_size_ += file_header_len + dump_len;
+  RequestWrite();
+}
+
+void RtpDumpSink::RequestWrite() {
+  // Write a buffer that is half full at once; otherwise, wait a little so
+  // that one write covers many packets.
+  if (front_buffer_.length() >= buffer_capacity_ / 2) {
+    write_posted_ = true;
+    writer_thread_->Post(this, MSG_WRITE);
+  } else if (!write_posted_) {
+    write_posted_ = true;
+    writer_thread_->PostDelayed(kWriteDelayMs, this, MSG_WRITE);
   }
 }
 
 void RtpDumpSink::set_packet_filter(int filter) {
   talk_base::CritScope cs(&critical_section_);
   packet_filter_ = filter;
-  if (writer_.get()) {
-    writer_->set_packet_filter(packet_filter_);
-  }
 }
 
 void RtpDumpSink::Flush() {
+  if (writer_thread_.get()) {
+    writer_thread_->Send(this, MSG_FLUSH);
+  }
+}
+
+void RtpDumpSink::set_buffer_size(size_t size) {
   talk_base::CritScope cs(&critical_section_);
-  if (stream_.get()) {
-    stream_->Flush();
+  buffer_size_ = size;
+}
+
+void RtpDumpSink::SetRotation(size_t max_file_size, uint32 max_file_ms) {
+  talk_base::CritScope cs(&critical_section_);
+  max_file_size_ = max_file_size;
+  max_file_ms_ = max_file_ms;
+}
+
+size_t RtpDumpSink::dropped_packets() const {
+  talk_base::CritScope cs(&critical_section_);
+  return dropped_packets_;
+}
+
+size_t RtpDumpSink::dropped_bytes() const {
+  talk_base::CritScope cs(&critical_section_);
+  return dropped_bytes_;
+}
+
+int RtpDumpSink::file_count() const {
+  talk_base::CritScope cs(&critical_section_);
+  return file_count_;
+}
+
+void RtpDumpSink::OnMessage(talk_base::Message* msg) {
+  switch (msg->message_id) {
+    case MSG_OPEN: {
+      uint32 start_ms;
+      {
+        talk_base::CritScope cs(&critical_section_);
+        start_ms = file_start_ms_;
+      }
+      OpenFile_w(0, start_ms);
+      break;
+    }
+    case MSG_WRITE:
+      WriteBuffer_w();
+      break;
+    case MSG_FLUSH:
+      WriteBuffer_w();
+      if (stream_.get()) {
+        stream_->Flush();
+      }
+      break;
+    case MSG_CLOSE:
+      WriteBuffer_w();
+      CloseFile_w();
+      break;
+  }
+}
+
+void RtpDumpSink::WriteBuffer_w() {
+  // |back_buffer_| is empty here; swap in the packets buffered so far.
+  {
+    talk_base::CritScope cs(&critical_section_);
+    write_posted_ = false;
+    if (front_buffer_.length() == 0) {
+      return;
+    }
+    talk_base::Buffer packets;
+    front_buffer_.TransferTo(&packets);
+    back_buffer_.TransferTo(&front_buffer_);
+    packets.TransferTo(&back_buffer_);
+  }
+
+  const char* record = back_buffer_.data();
+  const char* end = record + back_buffer_.length();
+  while (record < end) {
+    int kind = record[0];
+    size_t data_len = talk_base::GetBE16(record + 1);
+    size_t write_len = talk_base::GetBE16(record + 3);
+    uint32 elapsed = talk_base::GetBE32(record + 5);
+    const char* data = record + kRecordHeaderLength;
+    if (kind == RECORD_NEW_FILE) {
+      CloseFile_w();
+      OpenFile_w(write_file_index_ + 1, elapsed);
+    } else if (writer_.get()) {
+      writer_->WriteFilteredPacket(data, write_len, data_len, elapsed,
+                                   kind == RECORD_RTCP);
+    }
+    record = data + write_len;
+  }
+  back_buffer_.SetLength(0);
+}
+
+bool RtpDumpSink::OpenFile_w(int index, uint32 start_ms) {
+  write_file_index_ = index;
+  std::string filename = GetFilename(index);
+  stream_.reset(talk_base::Filesystem::OpenFile(
+      talk_base::Pathname(filename), "wb"));
+  if (!stream_.get()) {
+    LOG(LS_ERROR) << "Failed to open RTP dump " << filename;
+    return false;
+  }
+  writer_.reset(new RtpDumpWriter(stream_.get()));
+  writer_->set_start_time(start_ms);
+  return true;
+}
+
+void RtpDumpSink::CloseFile_w() {
+  writer_.reset();
+  stream_.reset();
+}
+
+std::string RtpDumpSink::GetFilename(int index) const {
+  if (index == 0) {
+    return filename_;
   }
+  talk_base::Pathname path(filename_);
+  path.SetBasename(path.basename() + "-" + talk_base::ToString(index));
+  return path.pathname();
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -31,7 +31,9 @@
 #include <map>
 #include <string>
 
+#include "talk/base/buffer.h"
 #include "talk/base/criticalsection.h"
+#include "talk/base/messagehandler.h"
 #include "talk/base/scoped_ptr.h"
 #include "talk/base/sigslot.h"
 #include "talk/session/phone/mediasink.h"
@@ -39,6 +41,7 @@
 namespace talk_base {
 class Pathname;
 class FileStream;
+class Thread;
 }
 
 namespace cricket {
@@ -49,28 +52,84 @@ class VoiceChannel;
 class RtpDumpWriter;
 
 // RtpDumpSink implements MediaSinkInterface by dumping the RTP/RTCP packets to
-// a file.
-class RtpDumpSink : public MediaSinkInterface, public sigslot::has_slots<> {
+// a file. OnPacket is called on the channel's worker thread, so it only
+// copies the packet into an in-memory buffer; a writer thread of the sink's
+// own swaps that buffer with a second one and writes it to the file. Disk
+// stalls thus never block media. If the buffer being filled is full because
+// the writer thread has not swapped it out yet, packets are dropped and
+// counted. The dump can be split into several files by size
+// or by time: the first file is |filename|, the next ones get "-1", "-2", and
+// so on, inserted before the extension.
+class RtpDumpSink : public MediaSinkInterface, public sigslot::has_slots<>,
+                    public talk_base::MessageHandler {
  public:
   explicit RtpDumpSink(const std::string& filename);
   virtual ~RtpDumpSink();
 
+  // Limits the total size of the dump files.
   virtual void SetMaxSize(size_t size);
   virtual bool Enable(bool enable);
   virtual bool IsEnabled() const { return recording_; }
   virtual void OnPacket(const void* data, size_t size, bool rtcp);
   virtual void set_packet_filter(int filter);
   int packet_filter() const { return packet_filter_; }
+  // Writes the buffered packets to the file and flushes it.
   void Flush();
 
+  // Sets the size of each of the two buffers. Takes effect when the file is
+  // next opened.
+  void set_buffer_size(size_t size);
+  // Starts a new file once the current one would exceed |max_file_size| bytes
+  // or is |max_file_ms| old. 0 means no limit.
+  void SetRotation(size_t max_file_size, uint32 max_file_ms);
+  // Packets and bytes dropped because the buffers were full.
+  size_t dropped_packets() const;
+  size_t dropped_bytes() const;
+  // Number of files opened, including the current one.
+  int file_count() const;
+
+  // Implements talk_base::MessageHandler.
+  virtual void OnMessage(talk_base::Message* msg);
+
  private:
+  // Writes the back buffer, swapping in the front one first if the back one
+  // is empty. Runs on the writer thread.
+  void WriteBuffer_w();
+  bool OpenFile_w(int index, uint32 start_ms);
+  void CloseFile_w();
+  void RequestWrite();
+  std::string GetFilename(int index) const;
+
   size_t max_size_;
   bool recording_;
   int packet_filter_;
   std::string filename_;
+  talk_base::scoped_ptr<talk_base::Thread> writer_thread_;
+  // Used only on the writer thread.
   talk_base::scoped_ptr<talk_base::FileStream> stream_;
   talk_base::scoped_ptr<RtpDumpWriter> writer_;
-  talk_base::CriticalSection critical_section_;
+  // Packets are appended to |front_buffer_|, which the writer thread swaps
+  // with the empty |back_buffer_| and then writes out.
+  talk_base::Buffer front_buffer_;
+  talk_base::Buffer back_buffer_;
+  size_t buffer_size_;
+  // The size of each buffer while the file is open, from |buffer_size_|.
+  size_t buffer_capacity_;
+  bool opened_;
+  bool write_posted_;
+  int write_file_index_;  // Used only on the writer thread.
+  // What has been accepted so far, for the size limit and rotation.
+  size_t total_size_;
+  size_t file_size_;
+  // Start of the current file. The packets' elapsed times are taken from it,
+  // and it is passed to the writer thread for the file header.
+  uint32 file_start_ms_;
+  int file_count_;
+  size_t max_file_size_;
+  uint32 max_file_ms_;
+  size_t dropped_packets_;
+  size_t dropped_bytes_;
+  mutable talk_base::CriticalSection critical_section_;
 
   DISALLOW_COPY_AND_ASSIGN(RtpDumpSink);
 };
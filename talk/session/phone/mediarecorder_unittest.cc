@@ -162,6 +162,76 @@ TEST_F(RtpDumpSinkTest, TestRtpDumpSinkFilter) {
   EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
 }
 
+TEST_F(RtpDumpSinkTest, TestRtpDumpSinkDrop) {
+  // Buffers too small for any packet: everything is dropped and counted.
+  sink_->set_buffer_size(RtpTestUtility::kTestRawRtpPackets[0].size());
+  sink_->set_packet_filter(PF_ALL);
+  EXPECT_TRUE(sink_->Enable(true));
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[0]);
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[1]);
+  EXPECT_EQ(2U, sink_->dropped_packets());
+  size_t dropped_bytes = RtpTestUtility::kTestRawRtpPackets[0].size() +
+      RtpTestUtility::kTestRawRtpPackets[1].size();
+  EXPECT_EQ(dropped_bytes, sink_->dropped_bytes());
+
+  RtpDumpPacket packet;
+  EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
+}
+
+TEST_F(RtpDumpSinkTest, TestRtpDumpSinkBufferSizeWhenOpened) {
+  // A new buffer size doesn't apply to the file that is already open.
+  sink_->set_packet_filter(PF_ALL);
+  EXPECT_TRUE(sink_->Enable(true));
+  sink_->set_buffer_size(RtpTestUtility::kTestRawRtpPackets[0].size());
+  OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[0]);
+  EXPECT_EQ(0U, sink_->dropped_packets());
+
+  RtpDumpPacket packet;
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[0], false));
+  EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
+}
+
+TEST_F(RtpDumpSinkTest, TestRtpDumpSinkRotation) {
+  // Room for two packets per file.
+  sink_->SetRotation(strlen(RtpDumpFileHeader::kFirstLine) +
+                     RtpDumpFileHeader::kHeaderLength +
+                     2 * (RtpDumpPacket::kHeaderLength +
+                          RtpTestUtility::kTestRawRtpPackets[0].size()), 0);
+  sink_->set_packet_filter(PF_ALL);
+  EXPECT_TRUE(sink_->Enable(true));
+  for (int i = 0; i < 3; ++i) {
+    OnRtpPacket(RtpTestUtility::kTestRawRtpPackets[i]);
+  }
+  EXPECT_EQ(2, sink_->file_count());
+  EXPECT_EQ(0U, sink_->dropped_packets());
+
+  // The first file has the first two packets.
+  RtpDumpPacket packet;
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[0], false));
+  EXPECT_EQ(talk_base::SR_SUCCESS, ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[1], false));
+  EXPECT_EQ(talk_base::SR_EOS, ReadPacket(&packet));
+
+  // The second file has the third packet.
+  talk_base::Pathname path2(path_);
+  path2.SetBasename(path_.basename() + "-1");
+  talk_base::scoped_ptr<talk_base::StreamInterface> stream2(
+      talk_base::Filesystem::OpenFile(path2, "rb"));
+  ASSERT_TRUE(stream2.get() != NULL);
+  RtpDumpReader reader2(stream2.get());
+  EXPECT_EQ(talk_base::SR_SUCCESS, reader2.ReadPacket(&packet));
+  EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+      &packet, &RtpTestUtility::kTestRawRtpPackets[2], false));
+  EXPECT_EQ(talk_base::SR_EOS, reader2.ReadPacket(&packet));
+  stream2.reset();
+  EXPECT_TRUE(talk_base::Filesystem::DeleteFile(path2));
+}
+
 /////////////////////////////////////////////////////////////////////////
 // Test MediaRecorder
 /////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,329 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#undef HAVE_CONFIG_H
+
+#include "talk/session/phone/opensslsrtpcrypto.h"
+
+#include "talk/base/logging.h"
+
+#ifdef HAVE_SRTP
+#ifdef SRTP_RELATIVE_PATH
+#include "srtp.h"  // NOLINT
+#else
+#include "third_party/libsrtp/include/srtp.h"
+#endif  // SRTP_RELATIVE_PATH
+
+extern "C" cipher_type_t aes_icm;
+extern "C" auth_type_t hmac;
+#endif  // HAVE_SRTP
+
+#if defined(HAVE_SRTP) && HAVE_OPENSSL_SSL_H
+
+#include <string.h>
+
+#include <openssl/evp.h>
+
+namespace cricket {
+
+// libsrtp keys AES counter mode with the AES key followed by a 14 byte salt.
+static const int kIcmSaltLen = 14;
+static const int kIcmBlockLen = 16;
+static const int kSha1BlockLen = 64;
+static const int kSha1DigestLen = 20;
+
+///////////////////////////////////////////////////////////////////////////////
+// AES counter mode, as libsrtp's aes_icm
+
+struct OpenSslIcmState {
+  EVP_CIPHER_CTX* ctx;
+  // The salt, which is XORed with each IV to form the initial counter.
+  uint8_t offset[kIcmBlockLen];
+};
+
+static cipher_type_t openssl_aes_icm;
+
+static const EVP_CIPHER* IcmCipher(int key_len) {
+  switch (key_len - kIcmSaltLen) {
+    case 16: return EVP_aes_128_ctr();
+    case 24: return EVP_aes_192_ctr();
+    case 32: return EVP_aes_256_ctr();
+  }
+  return NULL;
+}
+
+static err_status_t OpenSslIcmAlloc(cipher_t** c, int key_len) {
+  if (!IcmCipher(key_len)) {
+    return err_status_bad_param;
+  }
+  uint8_t* pointer = static_cast<uint8_t*>(
+      crypto_alloc(sizeof(cipher_t) + sizeof(OpenSslIcmState)));
+  if (!pointer) {
+    return err_status_alloc_fail;
+  }
+  OpenSslIcmState* state =
+      reinterpret_cast<OpenSslIcmState*>(pointer + sizeof(cipher_t));
+  state->ctx = EVP_CIPHER_CTX_new();
+  if (!state->ctx) {
+    crypto_free(pointer);
+    return err_status_alloc_fail;
+  }
+  *c = reinterpret_cast<cipher_t*>(pointer);
+  (*c)->type = &openssl_aes_icm;
+  (*c)->state = state;
+  (*c)->key_len = key_len;
+  openssl_aes_icm.ref_count++;
+  return err_status_ok;
+}
+
+static err_status_t OpenSslIcmDealloc(cipher_t* c) {
+  OpenSslIcmState* state = static_cast<OpenSslIcmState*>(c->state);
+  EVP_CIPHER_CTX_free(state->ctx);
+  octet_string_set_to_zero(reinterpret_cast<uint8_t*>(c),
+                           sizeof(cipher_t) + sizeof(OpenSslIcmState));
+  crypto_free(c);
+  openssl_aes_icm.ref_count--;
+  return err_status_ok;
+}
+
+static err_status_t OpenSslIcmInit(void* cs, const uint8_t* key, int key_len,
+                                   cipher_direction_t dir) {
+  OpenSslIcmState* state = static_cast<OpenSslIcmState*>(cs);
+  const EVP_CIPHER* cipher = IcmCipher(key_len);
+  if (!cipher) {
+    return err_status_bad_param;
+  }
+  // Like libsrtp, the last two octets of the offset hold the block counter.
+  memcpy(state->offset, key + key_len - kIcmSaltLen, kIcmSaltLen);
+  state->offset[14] = state->offset[15] = 0;
+  // The key schedule is expanded once here; set_iv only resets the counter.
+  if (!EVP_EncryptInit_ex(state->ctx, cipher, NULL, key, NULL)) {
+    return err_status_init_fail;
+  }
+  return err_status_ok;
+}
+
+static err_status_t OpenSslIcmSetIv(cipher_pointer_t cs, void* iv) {
+  OpenSslIcmState* state = reinterpret_cast<OpenSslIcmState*>(cs);
+  const uint8_t* nonce = static_cast<const uint8_t*>(iv);
+  uint8_t counter[kIcmBlockLen];
+  for (int i = 0; i < kIcmBlockLen; ++i) {
+    counter[i] = state->offset[i] ^ nonce[i];
+  }
+  if (!EVP_EncryptInit_ex(state->ctx, NULL, NULL, NULL, counter)) {
+    return err_status_cipher_fail;
+  }
+  return err_status_ok;
+}
+
+static err_status_t OpenSslIcmEncrypt(void* cs, uint8_t* buf,
+                                      unsigned int* len) {
+  OpenSslIcmState* state = static_cast<OpenSslIcmState*>(cs);
+  // SRTP counters start with the low 16 bits clear, so OpenSSL's 128 bit
+  // counter and libsrtp's 16 bit one agree for anything below 1 MB.
+  int out_len = 0;
+  if (!EVP_EncryptUpdate(state->ctx, buf, &out_len, buf, *len)) {
+    return err_status_cipher_fail;
+  }
+  return err_status_ok;
+}
+
+static char openssl_aes_icm_description[] =
+    "aes integer counter mode (openssl)";
+
+///////////////////////////////////////////////////////////////////////////////
+// HMAC-SHA1, as libsrtp's hmac
+
+struct OpenSslHmacState {
+  // Digests of the inner and outer pads, copied at the start of each message
+  // so that the key isn't hashed again for every packet.
+  EVP_MD_CTX* inner;
+  EVP_MD_CTX* outer;
+  EVP_MD_CTX* ctx;
+};
+
+static auth_type_t openssl_hmac;
+
+static err_status_t OpenSslHmacAlloc(auth_t** a, int key_len, int out_len) {
+  if (key_len > kSha1DigestLen || out_len > kSha1DigestLen) {
+    return err_status_bad_param;
+  }
+  uint8_t* pointer = static_cast<uint8_t*>(
+      crypto_alloc(sizeof(auth_t) + sizeof(OpenSslHmacState)));
+  if (!pointer) {
+    return err_status_alloc_fail;
+  }
+  OpenSslHmacState* state =
+      reinterpret_cast<OpenSslHmacState*>(pointer + sizeof(auth_t));
+  state->inner = EVP_MD_CTX_create();
+  state->outer = EVP_MD_CTX_create();
+  state->ctx = EVP_MD_CTX_create();
+  if (!state->inner || !state->outer || !state->ctx) {
+    EVP_MD_CTX_destroy(state->inner);
+    EVP_MD_CTX_destroy(state->outer);
+    EVP_MD_CTX_destroy(state->ctx);
+    crypto_free(pointer);
+    return err_status_alloc_fail;
+  }
+  *a = reinterpret_cast<auth_t*>(pointer);
+  (*a)->type = &openssl_hmac;
+  (*a)->state = state;
+  (*a)->out_len = out_len;
+  (*a)->key_len = key_len;
+  (*a)->prefix_len = 0;
+  openssl_hmac.ref_count++;
+  return err_status_ok;
+}
+
+static err_status_t OpenSslHmacDealloc(auth_t* a) {
+  OpenSslHmacState* state = static_cast<OpenSslHmacState*>(a->state);
+  EVP_MD_CTX_destroy(state->inner);
+  EVP_MD_CTX_destroy(state->outer);
+  EVP_MD_CTX_destroy(state->ctx);
+  octet_string_set_to_zero(reinterpret_cast<uint8_t*>(a),
+                           sizeof(auth_t) + sizeof(OpenSslHmacState));
+  crypto_free(a);
+  openssl_hmac.ref_count--;
+  return err_status_ok;
+}
+
+static err_status_t OpenSslHmacInit(void* as, const uint8_t* key,
+                                    int key_len) {
+  OpenSslHmacState* state = static_cast<OpenSslHmacState*>(as);
+  if (key_len > kSha1DigestLen) {
+    return err_status_bad_param;
+  }
+  uint8_t ipad[kSha1BlockLen];
+  uint8_t opad[kSha1BlockLen];
+  for (int i = 0; i < kSha1BlockLen; ++i) {
+    uint8_t k = (i < key_len) ? key[i] : 0;
+    ipad[i] = k ^ 0x36;
+    opad[i] = k ^ 0x5c;
+  }
+  bool ok = EVP_DigestInit_ex(state->inner, EVP_sha1(), NULL) &&
+      EVP_DigestUpdate(state->inner, ipad, sizeof(ipad)) &&
+      EVP_DigestInit_ex(state->outer, EVP_sha1(), NULL) &&
+      EVP_DigestUpdate(state->outer, opad, sizeof(opad)) &&
+      EVP_MD_CTX_copy_ex(state->ctx, state->inner);
+  octet_string_set_to_zero(ipad, sizeof(ipad));
+  octet_string_set_to_zero(opad, sizeof(opad));
+  return ok ? err_status_ok : err_status_auth_fail;
+}
+
+static err_status_t OpenSslHmacStart(void* as) {
+  OpenSslHmacState* state = static_cast<OpenSslHmacState*>(as);
+  if (!EVP_MD_CTX_copy_ex(state->ctx, state->inner)) {
+    return err_status_auth_fail;
+  }
+  return err_status_ok;
+}
+
+static err_status_t OpenSslHmacUpdate(void* as, uint8_t* message,
+                                      int msg_octets) {
+  OpenSslHmacState* state = static_cast<OpenSslHmacState*>(as);
+  if (!EVP_DigestUpdate(state->ctx, message, msg_octets)) {
+    return err_status_auth_fail;
+  }
+  return err_status_ok;
+}
+
+static err_status_t OpenSslHmacCompute(void* as, uint8_t* message,
+                                       int msg_octets, int tag_len,
+                                       uint8_t* result) {
+  OpenSslHmacState* state = static_cast<OpenSslHmacState*>(as);
+  if (tag_len > kSha1DigestLen) {
+    return err_status_bad_param;
+  }
+  uint8_t hash[EVP_MAX_MD_SIZE];
+  bool ok = EVP_DigestUpdate(state->ctx, message, msg_octets) &&
+      EVP_DigestFinal_ex(state->ctx, hash, NULL) &&
+      EVP_MD_CTX_copy_ex(state->ctx, state->outer) &&
+      EVP_DigestUpdate(state->ctx, hash, kSha1DigestLen) &&
+      EVP_DigestFinal_ex(state->ctx, hash, NULL);
+  if (!ok) {
+    return err_status_auth_fail;
+  }
+  memcpy(result, hash, tag_len);
+  return err_status_ok;
+}
+
+static char openssl_hmac_description[] =
+    "hmac sha-1 authentication function (openssl)";
+
+bool LoadOpenSslSrtpCrypto() {
+  // The known answers are libsrtp's own.
+  openssl_aes_icm.alloc = OpenSslIcmAlloc;
+  openssl_aes_icm.dealloc = OpenSslIcmDealloc;
+  openssl_aes_icm.init = OpenSslIcmInit;
+  openssl_aes_icm.encrypt = OpenSslIcmEncrypt;
+  openssl_aes_icm.decrypt = OpenSslIcmEncrypt;
+  openssl_aes_icm.set_iv = OpenSslIcmSetIv;
+  openssl_aes_icm.description = openssl_aes_icm_description;
+  openssl_aes_icm.test_data = aes_icm.test_data;
+  openssl_aes_icm.id = AES_ICM;
+
+  openssl_hmac.alloc = OpenSslHmacAlloc;
+  openssl_hmac.dealloc = OpenSslHmacDealloc;
+  openssl_hmac.init = OpenSslHmacInit;
+  openssl_hmac.compute = OpenSslHmacCompute;
+  openssl_hmac.update = OpenSslHmacUpdate;
+  openssl_hmac.start = OpenSslHmacStart;
+  openssl_hmac.description = openssl_hmac_description;
+  openssl_hmac.test_data = hmac.test_data;
+  openssl_hmac.id = HMAC_SHA1;
+
+  err_status_t err = crypto_kernel_replace_cipher_type(&openssl_aes_icm,
+                                                       AES_ICM);
+  if (err != err_status_ok) {
+    LOG(LS_WARNING) << "Failed to load OpenSSL AES-ICM for SRTP, err=" << err;
+    return false;
+  }
+  err = crypto_kernel_replace_auth_type(&openssl_hmac, HMAC_SHA1);
+  if (err != err_status_ok) {
+    LOG(LS_WARNING) << "Failed to load OpenSSL HMAC-SHA1 for SRTP, err="
+                    << err;
+    crypto_kernel_replace_cipher_type(&aes_icm, AES_ICM);
+    return false;
+  }
+  LOG(LS_INFO) << "Using OpenSSL crypto for SRTP";
+  return true;
+}
+
+}  // namespace cricket
+
+#else  // !HAVE_SRTP || !HAVE_OPENSSL_SSL_H
+
+namespace cricket {
+
+bool LoadOpenSslSrtpCrypto() {
+  LOG(LS_WARNING) << "OpenSSL crypto for SRTP is not available.";
+  return false;
+}
+
+}  // namespace cricket
+
+#endif  // !HAVE_SRTP || !HAVE_OPENSSL_SSL_H
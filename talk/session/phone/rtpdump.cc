@@ -28,7 +28,17 @@
 #include "talk/session/phone/rtpdump.h"
 
 #include <ctype.h>
-
+#include <errno.h>
+#if defined(POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(WIN32)
+#include "talk/base/win32.h"
+#endif
+
+#include <algorithm>
 #include <string>
 
 #include "talk/base/byteorder.h"
@@ -98,6 +108,21 @@ bool RtpDumpPacket::GetRtcpType(int* type) const {
       cricket::GetRtcpType(&data[0], data.size(), type);
 }
 
+static bool IsRtpDumpFirstLine(const std::string& first_line) {
+  // The first line is like "#!rtpplay1.0 address/port"
+  bool matched = (0 == first_line.find("#!rtpplay1.0 "));
+
+  // The address could be IP or hostname. We do not check it here. Instead, we
+  // check the port at the end.
+  size_t pos = first_line.find('/');
+  matched &= (pos != std::string::npos && pos < first_line.size() - 1);
+  for (++pos; pos < first_line.size() && matched; ++pos) {
+    matched &= (0 != isdigit(first_line[pos]));
+  }
+
+  return matched;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Implementation of RtpDumpReader.
 ///////////////////////////////////////////////////////////////////////////
@@ -177,18 +202,7 @@ talk_base::StreamResult RtpDumpReader::ReadFileHeader() {
 }
 
 bool RtpDumpReader::CheckFirstLine(const std::string& first_line) {
-  // The first line is like "#!rtpplay1.0 address/port"
-  bool matched = (0 == first_line.find("#!rtpplay1.0 "));
-
-  // The address could be IP or hostname. We do not check it here. Instead, we
-  // check the port at the end.
-  size_t pos = first_line.find('/');
-  matched &= (pos != std::string::npos && pos < first_line.size() - 1);
-  for (++pos; pos < first_line.size() && matched; ++pos) {
-    matched &= (0 != isdigit(first_line[pos]));
-  }
-
-  return matched;
+  return IsRtpDumpFirstLine(first_line);
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -304,6 +318,309 @@ void RtpDumpLoopReader::UpdateDumpPacket(RtpDumpPacket* packet) {
   }
 }
 
+///////////////////////////////////////////////////////////////////////////
+// Implementation of RtpDumpMappedReader.
+///////////////////////////////////////////////////////////////////////////
+// The index file holds a header of the magic, the dump file size and
+// modification time and the packet count, then per packet its offset, elapsed
+// time, SSRC and flags.
+static const uint32 kIndexMagic = 0x52445832;  // "RDX2"
+static const size_t kIndexHeaderLength = 24;
+static const size_t kIndexEntryLength = 17;
+static const size_t kMaxFirstLineLength = 256;
+
+RtpDumpMappedReader::RtpDumpMappedReader()
+    : data_(NULL),
+      size_(0),
+      mtime_(0),
+      first_packet_offset_(0),
+      start_time_ms_(0),
+      position_(0) {
+}
+
+RtpDumpMappedReader::~RtpDumpMappedReader() {
+  Close();
+}
+
+bool RtpDumpMappedReader::Open(const std::string& filename,
+                               const std::string& index_filename) {
+  Close();
+  if (!MapFile(filename)) {
+    return false;
+  }
+  if (!ReadFileHeader()) {
+    LOG(LS_ERROR) << "Not an RTP dump: " << filename;
+    Close();
+    return false;
+  }
+  if (index_filename.empty() || !LoadIndex(index_filename)) {
+    BuildIndex();
+    if (!index_filename.empty() && !SaveIndex(index_filename)) {
+      LOG(LS_WARNING) << "Failed to save the RTP dump index to "
+                      << index_filename;
+    }
+  }
+  FinishIndex();
+  return true;
+}
+
+void RtpDumpMappedReader::Close() {
+  UnmapFile();
+  first_packet_offset_ = 0;
+  start_time_ms_ = 0;
+  position_ = 0;
+  index_.clear();
+  max_elapsed_times_.clear();
+  ssrc_index_.clear();
+}
+
+talk_base::StreamResult RtpDumpMappedReader::ReadPacket(
+    RtpDumpPacketView* packet) {
+  if (!packet || !IsOpen()) return talk_base::SR_ERROR;
+  if (position_ >= index_.size()) return talk_base::SR_EOS;
+  GetPacket(position_++, packet);
+  return talk_base::SR_SUCCESS;
+}
+
+bool RtpDumpMappedReader::GetPacket(size_t index,
+                                    RtpDumpPacketView* packet) const {
+  if (!packet || index >= index_.size()) return false;
+  const IndexEntry& entry = index_[index];
+  const uint8* header = data_ + entry.offset;
+  packet->elapsed_time = entry.elapsed_time;
+  packet->is_rtcp = entry.is_rtcp;
+  packet->data = header + RtpDumpPacket::kHeaderLength;
+  packet->size = talk_base::GetBE16(header) - RtpDumpPacket::kHeaderLength;
+  return true;
+}
+
+bool RtpDumpMappedReader::SeekToPacket(size_t index) {
+  if (index > index_.size()) return false;
+  position_ = index;
+  return true;
+}
+
+bool RtpDumpMappedReader::SeekToTime(uint32 elapsed_ms) {
+  position_ = FindFirstAtTime(max_elapsed_times_, elapsed_ms);
+  return position_ < index_.size();
+}
+
+size_t RtpDumpMappedReader::FindPacket(uint32 ssrc, uint32 elapsed_ms) const {
+  std::map<uint32, SsrcPackets>::const_iterator it = ssrc_index_.find(ssrc);
+  if (it == ssrc_index_.end()) return index_.size();
+  const SsrcPackets& ssrc_packets = it->second;
+  size_t pos = FindFirstAtTime(ssrc_packets.max_elapsed_times, elapsed_ms);
+  return (pos < ssrc_packets.packets.size()) ?
+      ssrc_packets.packets[pos] : index_.size();
+}
+
+const std::vector<uint32>* RtpDumpMappedReader::GetPacketsBySsrc(
+    uint32 ssrc) const {
+  std::map<uint32, SsrcPackets>::const_iterator it = ssrc_index_.find(ssrc);
+  return (it != ssrc_index_.end()) ? &it->second.packets : NULL;
+}
+
+size_t RtpDumpMappedReader::FindFirstAtTime(
+    const std::vector<uint32>& max_elapsed_times, uint32 elapsed_ms) {
+  return std::lower_bound(max_elapsed_times.begin(), max_elapsed_times.end(),
+                          elapsed_ms) - max_elapsed_times.begin();
+}
+
+bool RtpDumpMappedReader::MapFile(const std::string& filename) {
+#if defined(POSIX)
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_ERR(LS_ERROR) << "Failed to open " << filename;
+    return false;
+  }
+  struct stat st;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping keeps the file open.
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_ERR(LS_ERROR) << "Failed to map " << filename;
+    return false;
+  }
+  // Replay reads the file front to back.
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  data_ = static_cast<const uint8*>(data);
+  size_ = st.st_size;
+  mtime_ = st.st_mtime;
+  return true;
+#elif defined(WIN32)
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    LOG_ERR(LS_ERROR) << "Failed to open " << filename;
+    return false;
+  }
+  LARGE_INTEGER size;
+  FILETIME mtime;
+  HANDLE mapping = NULL;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0 &&
+      GetFileTime(file, NULL, NULL, &mtime)) {
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  }
+  void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+  // The view keeps the file and the mapping open.
+  if (mapping) CloseHandle(mapping);
+  CloseHandle(file);
+  if (!data) {
+    LOG_ERR(LS_ERROR) << "Failed to map " << filename;
+    return false;
+  }
+  data_ = static_cast<const uint8*>(data);
+  size_ = static_cast<size_t>(size.QuadPart);
+  mtime_ = (static_cast<uint64>(mtime.dwHighDateTime) << 32) |
+      mtime.dwLowDateTime;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RtpDumpMappedReader::UnmapFile() {
+  if (!data_) return;
+#if defined(POSIX)
+  munmap(const_cast<uint8*>(data_), size_);
+#elif defined(WIN32)
+  UnmapViewOfFile(data_);
+#endif
+  data_ = NULL;
+  size_ = 0;
+  mtime_ = 0;
+}
+
+bool RtpDumpMappedReader::ReadFileHeader() {
+  const uint8* end = static_cast<const uint8*>(
+      memchr(data_, '\n', talk_base::_min(size_, kMaxFirstLineLength)));
+  if (!end) return false;
+  std::string first_line(reinterpret_cast<const char*>(data_), end - data_);
+  if (!IsRtpDumpFirstLine(first_line)) return false;
+  size_t header_offset = first_line.size() + 1;
+  if (size_ < header_offset + RtpDumpFileHeader::kHeaderLength) return false;
+  uint32 start_sec = talk_base::GetBE32(data_ + header_offset);
+  uint32 start_usec = talk_base::GetBE32(data_ + header_offset + 4);
+  start_time_ms_ = static_cast<uint64>(start_sec) * 1000 + start_usec / 1000;
+  first_packet_offset_ = header_offset + RtpDumpFileHeader::kHeaderLength;
+  return true;
+}
+
+void RtpDumpMappedReader::BuildIndex() {
+  index_.clear();
+  size_t offset = first_packet_offset_;
+  while (size_ - offset >= RtpDumpPacket::kHeaderLength) {
+    const uint8* header = data_ + offset;
+    size_t dump_packet_len = talk_base::GetBE16(header);
+    if (dump_packet_len < RtpDumpPacket::kHeaderLength ||
+        dump_packet_len > size_ - offset) {
+      LOG(LS_WARNING) << "RTP dump is truncated at offset " << offset;
+      break;
+    }
+    IndexEntry entry;
+    entry.offset = offset;
+    entry.is_rtcp = (0 == talk_base::GetBE16(header + 2));
+    entry.elapsed_time = talk_base::GetBE32(header + 4);
+    entry.ssrc = 0;
+    if (!entry.is_rtcp) {
+      GetRtpSsrc(header + RtpDumpPacket::kHeaderLength,
+                 dump_packet_len - RtpDumpPacket::kHeaderLength, &entry.ssrc);
+    }
+    index_.push_back(entry);
+    offset += dump_packet_len;
+  }
+}
+
+bool RtpDumpMappedReader::LoadIndex(const std::string& index_filename) {
+  talk_base::FileStream file;
+  if (!file.Open(index_filename, "rb", NULL)) {
+    return false;
+  }
+  char header[kIndexHeaderLength];
+  if (file.ReadAll(header, sizeof(header), NULL, NULL) !=
+      talk_base::SR_SUCCESS ||
+      talk_base::GetBE32(header) != kIndexMagic ||
+      talk_base::GetBE64(header + 4) != static_cast<uint64>(size_) ||
+      talk_base::GetBE64(header + 12) != mtime_) {
+    LOG(LS_INFO) << "Rebuilding stale RTP dump index " << index_filename;
+    return false;
+  }
+  size_t count = talk_base::GetBE32(header + 20);
+  if (count > size_ / RtpDumpPacket::kHeaderLength) {
+    return false;
+  }
+  std::vector<char> entries(count * kIndexEntryLength);
+  if (count > 0 && file.ReadAll(&entries[0], entries.size(), NULL, NULL) !=
+      talk_base::SR_SUCCESS) {
+    return false;
+  }
+  index_.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const char* p = &entries[i * kIndexEntryLength];
+    IndexEntry& entry = index_[i];
+    entry.offset = talk_base::GetBE64(p);
+    entry.elapsed_time = talk_base::GetBE32(p + 8);
+    entry.ssrc = talk_base::GetBE32(p + 12);
+    entry.is_rtcp = (p[16] != 0);
+    // Don't trust an index that points outside the dump or at a packet
+    // header that BuildIndex would have rejected.
+    if (entry.offset < first_packet_offset_ ||
+        entry.offset + RtpDumpPacket::kHeaderLength > size_) {
+      index_.clear();
+      return false;
+    }
+    size_t dump_packet_len = talk_base::GetBE16(data_ + entry.offset);
+    if (dump_packet_len < RtpDumpPacket::kHeaderLength ||
+        dump_packet_len > size_ - static_cast<size_t>(entry.offset)) {
+      LOG(LS_INFO) << "Rebuilding corrupt RTP dump index " << index_filename;
+      index_.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RtpDumpMappedReader::SaveIndex(const std::string& index_filename) const {
+  std::vector<char> buf(kIndexHeaderLength +
+                        index_.size() * kIndexEntryLength);
+  talk_base::SetBE32(&buf[0], kIndexMagic);
+  talk_base::SetBE64(&buf[4], size_);
+  talk_base::SetBE64(&buf[12], mtime_);
+  talk_base::SetBE32(&buf[20], static_cast<uint32>(index_.size()));
+  for (size_t i = 0; i < index_.size(); ++i) {
+    char* p = &buf[kIndexHeaderLength + i * kIndexEntryLength];
+    talk_base::SetBE64(p, index_[i].offset);
+    talk_base::SetBE32(p + 8, index_[i].elapsed_time);
+    talk_base::SetBE32(p + 12, index_[i].ssrc);
+    p[16] = index_[i].is_rtcp ? 1 : 0;
+  }
+  talk_base::FileStream file;
+  return file.Open(index_filename, "wb", NULL) &&
+      file.WriteAll(&buf[0], buf.size(), NULL, NULL) == talk_base::SR_SUCCESS;
+}
+
+void RtpDumpMappedReader::FinishIndex() {
+  max_elapsed_times_.resize(index_.size());
+  uint32 max_elapsed_time = 0;
+  for (size_t i = 0; i < index_.size(); ++i) {
+    const IndexEntry& entry = index_[i];
+    max_elapsed_time = talk_base::_max(max_elapsed_time, entry.elapsed_time);
+    max_elapsed_times_[i] = max_elapsed_time;
+    if (!entry.is_rtcp) {
+      SsrcPackets& ssrc_packets = ssrc_index_[entry.ssrc];
+      ssrc_packets.max_elapsed_times.push_back(talk_base::_max(
+          ssrc_packets.max_elapsed_times.empty() ?
+              0 : ssrc_packets.max_elapsed_times.back(),
+          entry.elapsed_time));
+      ssrc_packets.packets.push_back(static_cast<uint32>(i));
+    }
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Implementation of RtpDumpWriter.
 ///////////////////////////////////////////////////////////////////////////
@@ -333,7 +650,7 @@ talk_base::StreamResult RtpDumpWriter::WriteFileHeader() {
   }
 
   talk_base::ByteBuffer buf;
-  RtpDumpFileHeader file_header(talk_base::Time(), 0, 0);
+  RtpDumpFileHeader file_header(start_time_ms_, 0, 0);
   file_header.WriteToByteBuffer(&buf);
   return stream_->WriteAll(buf.Data(), buf.Length(), NULL, NULL);
 }
@@ -342,6 +659,16 @@ talk_base::StreamResult RtpDumpWriter::WritePacket(
     const void* data, size_t data_len, uint32 elapsed, bool rtcp) {
   if (!stream_ || !data || 0 == data_len) return talk_base::SR_ERROR;
 
+  // Figure out what to write.
+  size_t write_len = FilterPacket(packet_filter_, data, data_len, rtcp);
+  return WriteFilteredPacket(data, write_len, data_len, elapsed, rtcp);
+}
+
+talk_base::StreamResult RtpDumpWriter::WriteFilteredPacket(
+    const void* data, size_t write_len, size_t data_len, uint32 elapsed,
+    bool rtcp) {
+  if (!stream_ || !data || 0 == data_len) return talk_base::SR_ERROR;
+
   talk_base::StreamResult res = talk_base::SR_SUCCESS;
   // Write the file header if it has not been written yet.
   if (!file_header_written_) {
@@ -352,8 +679,6 @@ talk_base::StreamResult RtpDumpWriter::WritePacket(
     file_header_written_ = true;
   }
 
-  // Figure out what to write.
-  size_t write_len = FilterPacket(data, data_len, rtcp);
   if (write_len == 0) {
     return talk_base::SR_SUCCESS;
   }
@@ -373,14 +698,14 @@ talk_base::StreamResult RtpDumpWriter::WritePacket(
   return stream_->WriteAll(data, write_len, NULL, NULL);
 }
 
-size_t RtpDumpWriter::FilterPacket(const void* data, size_t data_len,
-                                   bool rtcp) {
+size_t RtpDumpWriter::FilterPacket(int filter, const void* data,
+                                   size_t data_len, bool rtcp) {
   size_t filtered_len = 0;
   if (!rtcp) {
-    if ((packet_filter_ & PF_RTPPACKET) == PF_RTPPACKET) {
+    if ((filter & PF_RTPPACKET) == PF_RTPPACKET) {
       // RTP header + payload
       filtered_len = data_len;
-    } else if ((packet_filter_ & PF_RTPHEADER) == PF_RTPHEADER) {
+    } else if ((filter & PF_RTPHEADER) == PF_RTPHEADER) {
       // RTP header only
       size_t header_len;
       if (GetRtpHeaderLen(data, data_len, &header_len)) {
@@ -388,7 +713,7 @@ size_t RtpDumpWriter::FilterPacket(const void* data, size_t data_len,
       }
     }
   } else {
-    if ((packet_filter_ & PF_RTCPPACKET) == PF_RTCPPACKET) {
+    if ((filter & PF_RTCPPACKET) == PF_RTCPPACKET) {
       // RTCP header + payload
       filtered_len = data_len;
     }
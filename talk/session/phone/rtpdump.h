@@ -29,6 +29,7 @@
 #define TALK_SESSION_PHONE_RTPDUMP_H_
 
 #include <cstring>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -177,12 +178,105 @@ class RtpDumpLoopReader : public RtpDumpReader {
   DISALLOW_COPY_AND_ASSIGN(RtpDumpLoopReader);
 };
 
+// A dump packet that points into the memory-mapped file of an
+// RtpDumpMappedReader rather than owning a copy of the packet. It is valid
+// until the reader is closed.
+struct RtpDumpPacketView {
+  uint32 elapsed_time;  // Milliseconds since the start of recording.
+  bool is_rtcp;         // True if data is a RTCP packet.
+  const uint8* data;    // The actual RTP or RTCP packet.
+  size_t size;
+};
+
+// RtpDumpMappedReader memory-maps a whole RTP dump file, so that replaying a
+// large capture does not cost a read and a copy per packet. The packets are
+// indexed by elapsed time and RTP SSRC when the file is opened, which lets the
+// reader seek by time in O(log n). The index can be saved to a file and is
+// reused as long as the dump's size and modification time have not changed.
+// Unlike RtpDumpReader, the packets cannot be rewritten (no SetSsrc) since
+// they are views of the file.
+class RtpDumpMappedReader {
+ public:
+  RtpDumpMappedReader();
+  ~RtpDumpMappedReader();
+
+  // Maps the dump |filename| and indexes it. If |index_filename| is not empty,
+  // the index is loaded from it when it matches the dump, or else is built
+  // and saved there.
+  bool Open(const std::string& filename, const std::string& index_filename);
+  void Close();
+  bool IsOpen() const { return data_ != NULL; }
+
+  size_t packet_count() const { return index_.size(); }
+  uint64 start_time_ms() const { return start_time_ms_; }
+  // Index of the packet that the next ReadPacket returns.
+  size_t position() const { return position_; }
+
+  // Returns the packet at position() and advances, or SR_EOS after the last.
+  talk_base::StreamResult ReadPacket(RtpDumpPacketView* packet);
+  bool GetPacket(size_t index, RtpDumpPacketView* packet) const;
+  bool SeekToPacket(size_t index);
+  // Moves to the first packet whose elapsed time is at least |elapsed_ms|.
+  // Returns false, leaving the reader at the end, if there is none.
+  bool SeekToTime(uint32 elapsed_ms);
+  // Returns the index of the first RTP packet with |ssrc| whose elapsed time
+  // is at least |elapsed_ms|, or packet_count() if there is none.
+  size_t FindPacket(uint32 ssrc, uint32 elapsed_ms) const;
+  // Returns the indices of the RTP packets with |ssrc| in file order, or NULL
+  // if there are none.
+  const std::vector<uint32>* GetPacketsBySsrc(uint32 ssrc) const;
+
+ private:
+  struct IndexEntry {
+    uint64 offset;  // Of the dump packet header in the file.
+    uint32 elapsed_time;
+    uint32 ssrc;    // 0 for RTCP packets.
+    bool is_rtcp;
+  };
+  // The RTP packets of one SSRC, with the largest elapsed time up to each.
+  struct SsrcPackets {
+    std::vector<uint32> packets;
+    std::vector<uint32> max_elapsed_times;
+  };
+
+  bool MapFile(const std::string& filename);
+  void UnmapFile();
+  bool ReadFileHeader();
+  void BuildIndex();
+  bool LoadIndex(const std::string& index_filename);
+  bool SaveIndex(const std::string& index_filename) const;
+  // Fills in max_elapsed_times_ and ssrc_index_ from index_.
+  void FinishIndex();
+  // Returns the position of the first element of |max_elapsed_times| that is
+  // at least |elapsed_ms|.
+  static size_t FindFirstAtTime(const std::vector<uint32>& max_elapsed_times,
+                                uint32 elapsed_ms);
+
+  const uint8* data_;
+  size_t size_;
+  uint64 mtime_;  // Of the dump file, in the platform's file time units.
+  size_t first_packet_offset_;
+  uint64 start_time_ms_;
+  size_t position_;
+  std::vector<IndexEntry> index_;
+  // The largest elapsed time of each packet and all earlier ones. Searching on
+  // it finds the first packet at a time even if the dump's clock stepped
+  // backwards.
+  std::vector<uint32> max_elapsed_times_;
+  std::map<uint32, SsrcPackets> ssrc_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(RtpDumpMappedReader);
+};
+
 class RtpDumpWriter {
  public:
   explicit RtpDumpWriter(talk_base::StreamInterface* stream);
 
   // Filter to control what packets we actually record.
   void set_packet_filter(int filter);
+  // Sets the start of the recording, which goes in the file header and which
+  // GetElapsedTime counts from. It is the writer's creation by default.
+  void set_start_time(uint32 start_ms) { start_time_ms_ = start_ms; }
   // Write a RTP or RTCP packet. The parameters data points to the packet and
   // data_len is its length.
   talk_base::StreamResult WriteRtpPacket(const void* data, size_t data_len) {
@@ -196,6 +290,15 @@ class RtpDumpWriter {
                        packet.is_rtcp);
   }
   uint32 GetElapsedTime() const;
+  // Returns how many bytes of the packet |filter| keeps; 0 to drop it.
+  static size_t FilterPacket(int filter, const void* data, size_t data_len,
+                             bool rtcp);
+  // Writes the first |write_len| bytes, as returned by FilterPacket, of a
+  // packet of |data_len| bytes.
+  talk_base::StreamResult WriteFilteredPacket(const void* data,
+                                              size_t write_len,
+                                              size_t data_len,
+                                              uint32 elapsed, bool rtcp);
 
   bool GetDumpSize(size_t* size) {
     // Note that we use GetPosition(), rather than GetSize(), to avoid flush the
@@ -209,7 +312,6 @@ class RtpDumpWriter {
  private:
   talk_base::StreamResult WritePacket(const void* data, size_t data_len,
                                       uint32 elapsed, bool rtcp);
-  size_t FilterPacket(const void* data, size_t data_len, bool rtcp);
 
   talk_base::StreamInterface* stream_;
   int packet_filter_;
@@ -26,9 +26,13 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "talk/base/bytebuffer.h"
+#include "talk/base/byteorder.h"
+#include "talk/base/fileutils.h"
 #include "talk/base/gunit.h"
+#include "talk/base/pathutils.h"
 #include "talk/base/thread.h"
 #include "talk/session/phone/rtpdump.h"
 #include "talk/session/phone/rtputils.h"
@@ -286,4 +290,109 @@ TEST(RtpDumpTest, LoopReadSingleRtcp) {
   EXPECT_EQ(talk_base::SR_SUCCESS, loop_reader.ReadPacket(&packet));
 }
 
+// Writes the test RTP packets twice, with kTestSsrc and then kTestSsrc + 1,
+// and RTCP packets to a dump file and checks the mapped reader's index.
+// The elapsed times restart for each batch, so they step backwards.
+TEST(RtpDumpTest, MappedReader) {
+  talk_base::Pathname path;
+  ASSERT_TRUE(talk_base::Filesystem::GetTemporaryFolder(path, true, NULL));
+  path.SetPathname(talk_base::Filesystem::TempFilename(path, "rtpdump-"));
+  std::string filename = path.pathname();
+  std::string index_filename = filename + ".idx";
+  const size_t count = RtpTestUtility::GetTestPacketCount();
+  const uint32 interval = RtpTestUtility::kElapsedTimeInterval;
+  {
+    talk_base::FileStream stream;
+    ASSERT_TRUE(stream.Open(filename, "wb", NULL));
+    RtpDumpWriter writer(&stream);
+    ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+        count, false, kTestSsrc, &writer));
+    ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+        count, false, kTestSsrc + 1, &writer));
+    ASSERT_TRUE(RtpTestUtility::WriteTestPackets(
+        count, true, kTestSsrc, &writer));
+  }
+
+  // Build and save the index, then load it back.
+  for (int pass = 0; pass < 2; ++pass) {
+    RtpDumpMappedReader reader;
+    ASSERT_TRUE(reader.Open(filename, index_filename));
+    ASSERT_EQ(3 * count, reader.packet_count());
+    EXPECT_TRUE(talk_base::Filesystem::IsFile(index_filename));
+
+    RtpDumpPacketView view;
+    for (size_t i = 0; i < 3 * count; ++i) {
+      ASSERT_EQ(talk_base::SR_SUCCESS, reader.ReadPacket(&view));
+      EXPECT_EQ((i % count) * interval,
+                view.elapsed_time);
+      EXPECT_EQ(i >= 2 * count, view.is_rtcp);
+      if (i < count) {
+        RtpDumpPacket packet(view.data, view.size, view.elapsed_time, false);
+        EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+            &packet, &RtpTestUtility::kTestRawRtpPackets[i % count], false));
+      }
+    }
+    EXPECT_EQ(talk_base::SR_EOS, reader.ReadPacket(&view));
+
+    ASSERT_EQ(count, reader.GetPacketsBySsrc(kTestSsrc)->size());
+    ASSERT_EQ(count, reader.GetPacketsBySsrc(kTestSsrc + 1)->size());
+    EXPECT_TRUE(reader.GetPacketsBySsrc(kTestSsrc + 2) == NULL);
+
+    // Seek to the second packet's time, which first occurs in the first batch.
+    EXPECT_TRUE(reader.SeekToTime(interval));
+    EXPECT_EQ(1U, reader.position());
+    ASSERT_EQ(talk_base::SR_SUCCESS, reader.ReadPacket(&view));
+    EXPECT_EQ(interval, view.elapsed_time);
+    EXPECT_FALSE(reader.SeekToTime(count * interval));
+    EXPECT_EQ(reader.packet_count(), reader.position());
+    EXPECT_TRUE(reader.SeekToPacket(0));
+
+    EXPECT_EQ(count + 1, reader.FindPacket(
+        kTestSsrc + 1, interval));
+    EXPECT_EQ(reader.packet_count(), reader.FindPacket(kTestSsrc + 2, 0));
+  }
+
+  // An index whose entry points at a bad packet header is rebuilt. Moving
+  // the first entry onto the high half of the elapsed time gives it a length
+  // of 0.
+  {
+    talk_base::FileStream stream;
+    size_t size = 0;
+    ASSERT_TRUE(stream.Open(index_filename, "r+b", NULL));
+    ASSERT_TRUE(stream.GetSize(&size));
+    std::vector<char> index(size);
+    ASSERT_EQ(talk_base::SR_SUCCESS,
+              stream.ReadAll(&index[0], size, NULL, NULL));
+    const size_t kFirstEntryOffset = 24;
+    talk_base::SetBE64(&index[kFirstEntryOffset],
+                       talk_base::GetBE64(&index[kFirstEntryOffset]) + 4);
+    ASSERT_TRUE(stream.SetPosition(0));
+    ASSERT_EQ(talk_base::SR_SUCCESS,
+              stream.WriteAll(&index[0], size, NULL, NULL));
+  }
+  {
+    RtpDumpMappedReader reader;
+    ASSERT_TRUE(reader.Open(filename, index_filename));
+    ASSERT_EQ(3 * count, reader.packet_count());
+    RtpDumpPacketView view;
+    ASSERT_EQ(talk_base::SR_SUCCESS, reader.ReadPacket(&view));
+    RtpDumpPacket packet(view.data, view.size, view.elapsed_time, false);
+    EXPECT_TRUE(RtpTestUtility::VerifyPacket(
+        &packet, &RtpTestUtility::kTestRawRtpPackets[0], false));
+  }
+  {
+    talk_base::FileStream stream;
+    ASSERT_TRUE(stream.Open(filename, "wb", NULL));
+    RtpDumpWriter writer(&stream);
+    ASSERT_TRUE(RtpTestUtility::WriteTestPackets(1, true, kTestSsrc, &writer));
+  }
+  RtpDumpMappedReader reader;
+  ASSERT_TRUE(reader.Open(filename, index_filename));
+  EXPECT_EQ(1U, reader.packet_count());
+  reader.Close();
+
+  EXPECT_TRUE(talk_base::Filesystem::DeleteFile(filename));
+  EXPECT_TRUE(talk_base::Filesystem::DeleteFile(index_filename));
+}
+
 }  // namespace cricket
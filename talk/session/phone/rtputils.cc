@@ -149,6 +149,100 @@ bool GetRtpHeader(const void* data, size_t len, RtpHeader* header) {
           GetRtpSsrc(data, len, &(header->ssrc)));
 }
 
+static void ClearRtpPacketDescriptor(bool rtcp, RtpPacketDescriptor* desc) {
+  *desc = RtpPacketDescriptor();
+  desc->rtcp = rtcp;
+}
+
+bool ParseRtpPacket(const void* data, size_t len, RtpPacketDescriptor* desc) {
+  if (!desc) {
+    return false;
+  }
+  ClearRtpPacketDescriptor(false, desc);
+  if (!data || len < kMinRtpPacketLen) {
+    return false;
+  }
+  const uint8* header = static_cast<const uint8*>(data);
+  desc->version = header[0] >> 6;
+  desc->padding = (header[0] & 0x20) != 0;
+  desc->csrc_count = header[0] & 0x0F;
+  desc->marker = (header[1] & 0x80) != 0;
+  desc->payload_type = header[1] & 0x7F;
+  desc->seq_num = talk_base::GetBE16(header + kRtpSeqNumOffset);
+  desc->timestamp = talk_base::GetBE32(header + kRtpTimestampOffset);
+  desc->ssrc = talk_base::GetBE32(header + kRtpSsrcOffset);
+
+  size_t header_len = kMinRtpPacketLen + desc->csrc_count * sizeof(uint32);
+  if (len < header_len) {
+    return false;
+  }
+  if (header[0] & 0x10) {
+    if (len < header_len + sizeof(uint32)) {
+      return false;
+    }
+    desc->extension_offset = static_cast<uint16>(header_len);
+    desc->extension_profile = talk_base::GetBE16(header + header_len);
+    desc->extension_len = static_cast<uint16>(
+        talk_base::GetBE16(header + header_len + 2) * sizeof(uint32));
+    header_len += sizeof(uint32) + desc->extension_len;
+    if (len < header_len) {
+      return false;
+    }
+  }
+  desc->header_len = static_cast<uint16>(header_len);
+  desc->parsed = true;
+  return true;
+}
+
+bool ParseRtcpPacket(const void* data, size_t len, RtpPacketDescriptor* desc) {
+  if (!desc) {
+    return false;
+  }
+  ClearRtpPacketDescriptor(true, desc);
+  if (!data || len < kMinRtcpPacketLen) {
+    return false;
+  }
+  const uint8* packet = static_cast<const uint8*>(data);
+  desc->version = packet[0] >> 6;
+  desc->padding = (packet[0] & 0x20) != 0;
+  desc->payload_type = packet[kRtcpPayloadTypeOffset];
+  if (len >= kMinRtcpPacketLen + sizeof(uint32) &&
+      desc->payload_type != kRtcpTypeSDES) {
+    desc->ssrc = talk_base::GetBE32(packet + kMinRtcpPacketLen);
+  }
+
+  size_t offset = 0;
+  RtcpBlock block;
+  while (ParseRtcpBlock(data, len, offset, &block)) {
+    if (desc->rtcp_block_count == kMaxRtcpBlocks) {
+      desc->rtcp_more_blocks = true;
+      break;
+    }
+    desc->rtcp_blocks[desc->rtcp_block_count++] = block;
+    offset += block.len;
+  }
+  desc->parsed = desc->rtcp_block_count > 0;
+  return desc->parsed;
+}
+
+bool ParseRtcpBlock(const void* data, size_t len, size_t offset,
+                    RtcpBlock* block) {
+  if (offset >= len || len - offset < kMinRtcpPacketLen) {
+    return false;
+  }
+  const uint8* header = static_cast<const uint8*>(data) + offset;
+  if ((header[0] >> 6) != kRtpVersion) {
+    return false;
+  }
+  size_t block_len = (talk_base::GetBE16(header + 2) + 1) * sizeof(uint32);
+  block_len = talk_base::_min(block_len, len - offset);
+  block->type = header[kRtcpPayloadTypeOffset];
+  block->count = header[0] & 0x1F;
+  block->offset = static_cast<uint16>(offset);
+  block->len = static_cast<uint16>(block_len);
+  return true;
+}
+
 bool GetRtcpType(const void* data, size_t len, int* value) {
   if (len < kMinRtcpPacketLen) {
     return false;
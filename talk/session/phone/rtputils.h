@@ -53,6 +53,62 @@ enum RtcpTypes {
   kRtcpTypePSFB = 206,    // Payload-specific Feedback message payload type.
 };
 
+// Location of one sub-packet of a compound RTCP packet.
+struct RtcpBlock {
+  uint8 type;    // Payload type, e.g. kRtcpTypeSR.
+  uint8 count;   // Report count, source count or feedback message type.
+  uint16 offset;
+  uint16 len;    // Clamped to the data if the length field runs past it.
+};
+
+// At most this many sub-packets of a compound RTCP packet are recorded in
+// the descriptor. Any further ones are flagged by |rtcp_more_blocks| and can
+// be read with ParseRtcpBlock.
+const int kMaxRtcpBlocks = 8;
+
+// The fields of an RTP or RTCP header, filled in by one pass of
+// ParseRtpPacket or ParseRtcpPacket when a packet arrives, so that later
+// stages don't each re-read the header. It is filled in even when parsing
+// fails, with |parsed| false and whatever fields could be read; the rest are
+// zero.
+//
+// Only BaseChannel's SSRC demux uses it so far. RtcpMuxFilter looks at one
+// byte before the packet is parsed, libsrtp reads the header itself, and
+// the recording signals still pass raw data to their sinks.
+struct RtpPacketDescriptor {
+  bool parsed;
+  bool rtcp;
+  uint8 version;
+  bool padding;
+  bool marker;             // RTP only.
+  uint8 payload_type;      // For RTCP, the type of the first sub-packet.
+  uint16 seq_num;          // RTP only.
+  uint32 timestamp;        // RTP only.
+  // For RTCP, the sender SSRC of the first sub-packet, or 0 if it is SDES.
+  uint32 ssrc;
+  uint8 csrc_count;        // RTP only.
+  uint16 header_len;       // RTP fixed header, CSRCs and header extension.
+  // Offset of the header extension's profile field, or 0 if there is none.
+  uint16 extension_offset;
+  uint16 extension_profile;
+  uint16 extension_len;    // Extension data in bytes, after its profile word.
+  uint8 rtcp_block_count;
+  // Sub-packets follow the last one in |rtcp_blocks|.
+  bool rtcp_more_blocks;
+  RtcpBlock rtcp_blocks[kMaxRtcpBlocks];
+};
+
+// Returns false if |data| is too short for the header it claims to have.
+// The SSRC is still filled in if the fixed header is there.
+bool ParseRtpPacket(const void* data, size_t len, RtpPacketDescriptor* desc);
+// Walks each sub-packet of a compound packet. The walk stops at a sub-packet
+// with a bad version. Returns false if there is no sub-packet at all.
+bool ParseRtcpPacket(const void* data, size_t len, RtpPacketDescriptor* desc);
+// Reads the sub-packet of a compound RTCP packet that starts at |offset|.
+// Returns false if there is none there.
+bool ParseRtcpBlock(const void* data, size_t len, size_t offset,
+                    RtcpBlock* block);
+
 bool GetRtpPayloadType(const void* data, size_t len, int* value);
 bool GetRtpSeqNum(const void* data, size_t len, int* value);
 bool GetRtpTimestamp(const void* data, size_t len, uint32* value);
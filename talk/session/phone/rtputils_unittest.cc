@@ -187,4 +187,126 @@ TEST(RtpUtilsTest, GetRtcp) {
                            &ssrc));
 }
 
+// RR = PT = 201, count = 1, SSRC of sender = 0x1111, one report block,
+// followed by SDES = PT = 202, count = 1, SSRC = 0x1111, CNAME = "ab".
+static const unsigned char kCompoundRtcpRrSdesPacket[] = {
+    0x81, 0xC9, 0x00, 0x07, 0x00, 0x00, 0x11, 0x11,
+    0x00, 0x00, 0x22, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x81, 0xCA, 0x00, 0x03, 0x00, 0x00, 0x11, 0x11,
+    0x01, 0x02, 0x61, 0x62, 0x00, 0x00, 0x00, 0x00,
+};
+
+TEST(RtpUtilsTest, ParseRtpPacket) {
+  RtpPacketDescriptor desc;
+  EXPECT_TRUE(ParseRtpPacket(kPcmuFrame, sizeof(kPcmuFrame), &desc));
+  EXPECT_FALSE(desc.rtcp);
+  EXPECT_EQ(2, desc.version);
+  EXPECT_FALSE(desc.marker);
+  EXPECT_EQ(0, desc.payload_type);
+  EXPECT_EQ(1, desc.seq_num);
+  EXPECT_EQ(0U, desc.timestamp);
+  EXPECT_EQ(1U, desc.ssrc);
+  EXPECT_EQ(0, desc.csrc_count);
+  EXPECT_EQ(12, desc.header_len);
+  EXPECT_EQ(0, desc.extension_offset);
+
+  EXPECT_TRUE(ParseRtpPacket(kRtpPacketWithMarkerAndCsrcAndExtension,
+                             sizeof(kRtpPacketWithMarkerAndCsrcAndExtension),
+                             &desc));
+  EXPECT_TRUE(desc.marker);
+  EXPECT_EQ(3, desc.csrc_count);
+  EXPECT_EQ(24, desc.extension_offset);
+  EXPECT_EQ(0xBEDE, desc.extension_profile);
+  EXPECT_EQ(8, desc.extension_len);
+  EXPECT_EQ(sizeof(kRtpPacketWithMarkerAndCsrcAndExtension),
+            static_cast<size_t>(desc.header_len));
+
+  EXPECT_TRUE(desc.parsed);
+
+  // A failed parse is marked, and the SSRC is kept if it could be read.
+  EXPECT_FALSE(ParseRtpPacket(kInvalidPacket, sizeof(kInvalidPacket), &desc));
+  EXPECT_FALSE(desc.parsed);
+  EXPECT_EQ(0U, desc.ssrc);
+  EXPECT_FALSE(ParseRtpPacket(kInvalidPacketWithCsrc,
+                              sizeof(kInvalidPacketWithCsrc), &desc));
+  EXPECT_FALSE(desc.parsed);
+  EXPECT_EQ(1U, desc.ssrc);
+  EXPECT_EQ(0, desc.header_len);
+  EXPECT_FALSE(ParseRtpPacket(kInvalidPacketWithCsrcAndExtension1,
+                              sizeof(kInvalidPacketWithCsrcAndExtension1),
+                              &desc));
+  EXPECT_FALSE(ParseRtpPacket(kInvalidPacketWithCsrcAndExtension2,
+                              sizeof(kInvalidPacketWithCsrcAndExtension2),
+                              &desc));
+}
+
+TEST(RtpUtilsTest, ParseRtcpPacket) {
+  RtpPacketDescriptor desc;
+  EXPECT_TRUE(ParseRtcpPacket(kCompoundRtcpRrSdesPacket,
+                              sizeof(kCompoundRtcpRrSdesPacket), &desc));
+  EXPECT_TRUE(desc.rtcp);
+  EXPECT_EQ(kRtcpTypeRR, desc.payload_type);
+  EXPECT_EQ(0x1111U, desc.ssrc);
+  ASSERT_EQ(2, desc.rtcp_block_count);
+  EXPECT_EQ(kRtcpTypeRR, desc.rtcp_blocks[0].type);
+  EXPECT_EQ(1, desc.rtcp_blocks[0].count);
+  EXPECT_EQ(0, desc.rtcp_blocks[0].offset);
+  EXPECT_EQ(32, desc.rtcp_blocks[0].len);
+  EXPECT_EQ(kRtcpTypeSDES, desc.rtcp_blocks[1].type);
+  EXPECT_EQ(32, desc.rtcp_blocks[1].offset);
+  EXPECT_EQ(16, desc.rtcp_blocks[1].len);
+
+  // The length field claims more than the packet holds; the block is clamped.
+  EXPECT_TRUE(ParseRtcpPacket(kNonCompoundRtcpPliFeedbackPacket,
+                              sizeof(kNonCompoundRtcpPliFeedbackPacket),
+                              &desc));
+  EXPECT_EQ(kRtcpTypePSFB, desc.payload_type);
+  ASSERT_EQ(1, desc.rtcp_block_count);
+  EXPECT_EQ(sizeof(kNonCompoundRtcpPliFeedbackPacket),
+            static_cast<size_t>(desc.rtcp_blocks[0].len));
+
+  EXPECT_TRUE(ParseRtcpPacket(kNonCompoundRtcpSDESPacket,
+                              sizeof(kNonCompoundRtcpSDESPacket), &desc));
+  EXPECT_EQ(0U, desc.ssrc);
+  EXPECT_FALSE(ParseRtcpPacket(kInvalidPacket, sizeof(kInvalidPacket),
+                               &desc));
+  EXPECT_FALSE(desc.parsed);
+  EXPECT_EQ(0, desc.rtcp_block_count);
+}
+
+TEST(RtpUtilsTest, ParseRtcpPacketWithManyBlocks) {
+  // Empty receiver reports, one more than the descriptor has room for.
+  static const int kNumBlocks = kMaxRtcpBlocks + 1;
+  static const size_t kBlockLen = 8;
+  uint8 packet[kNumBlocks * kBlockLen];
+  for (int i = 0; i < kNumBlocks; ++i) {
+    uint8* block = packet + i * kBlockLen;
+    block[0] = 0x80;
+    block[1] = kRtcpTypeRR;
+    talk_base::SetBE16(block + 2, 1);
+    talk_base::SetBE32(block + 4, i + 1);
+  }
+
+  RtpPacketDescriptor desc;
+  EXPECT_TRUE(ParseRtcpPacket(packet, sizeof(packet), &desc));
+  EXPECT_TRUE(desc.parsed);
+  EXPECT_EQ(kMaxRtcpBlocks, desc.rtcp_block_count);
+  EXPECT_TRUE(desc.rtcp_more_blocks);
+
+  // The rest are read on from the end of the last one recorded.
+  const RtcpBlock& last = desc.rtcp_blocks[kMaxRtcpBlocks - 1];
+  RtcpBlock block;
+  ASSERT_TRUE(ParseRtcpBlock(packet, sizeof(packet),
+                             last.offset + last.len, &block));
+  EXPECT_EQ(kRtcpTypeRR, block.type);
+  EXPECT_EQ(kMaxRtcpBlocks * kBlockLen, static_cast<size_t>(block.offset));
+  EXPECT_FALSE(ParseRtcpBlock(packet, sizeof(packet),
+                              block.offset + block.len, &block));
+
+  EXPECT_TRUE(ParseRtcpPacket(packet, sizeof(packet) - kBlockLen, &desc));
+  EXPECT_EQ(kMaxRtcpBlocks, desc.rtcp_block_count);
+  EXPECT_FALSE(desc.rtcp_more_blocks);
+}
+
 }  // namespace cricket
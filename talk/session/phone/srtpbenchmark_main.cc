@@ -0,0 +1,190 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Measures how many RTP packets per second one core can protect and
+// unprotect with each SRTP cipher suite, printing one line of JSON per suite.
+// The crypto backend is fixed when libsrtp is initialized, so compare
+// backends by running once with each.
+//
+//   srtpbenchmark --size 1200 --packets 200000 --backend openssl
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "talk/base/buffer.h"
+#include "talk/base/byteorder.h"
+#include "talk/base/flags.h"
+#include "talk/base/logging.h"
+#include "talk/base/timing.h"
+#include "talk/session/phone/srtpfilter.h"
+
+using cricket::SrtpFilter;
+using cricket::SrtpSession;
+
+DEFINE_int(size, 1200, "RTP packet size in bytes, including the header.");
+DEFINE_int(packets, 200000, "Packets to protect and unprotect per run.");
+DEFINE_string(backend, "builtin", "Crypto backend: builtin or openssl.");
+DEFINE_string(suite, "all", "Cipher suite: AES_CM_128_HMAC_SHA1_80, "
+              "AES_CM_128_HMAC_SHA1_32 or all.");
+DEFINE_bool(help, false, "Prints this message.");
+
+static const uint8 kKey[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ1234";
+static const int kKeyLen = 30;
+static const int kRtpHeaderLen = 12;
+static const uint32 kSsrc = 0x12345678;
+// Packets protected, then unprotected, between two reads of the clock.
+static const int kChunk = 64;
+
+// Fills |packet| with an RTP packet of |size| bytes and sequence number
+// |seq_num|.
+static void MakeRtpPacket(int size, uint16 seq_num, talk_base::Buffer* packet) {
+  packet->SetLength(size);
+  char* data = packet->data();
+  memset(data, 0xAB, size);
+  data[0] = static_cast<char>(0x80);
+  data[1] = 0;  // PCMU
+  talk_base::SetBE16(data + 2, seq_num);
+  talk_base::SetBE32(data + 4, seq_num * 160);
+  talk_base::SetBE32(data + 8, kSsrc);
+}
+
+// Protects and unprotects FLAG_packets packets with |suite| and prints the
+// rates. Returns false if SRTP failed.
+static bool RunSuite(const std::string& suite) {
+  SrtpSession sender;
+  SrtpSession receiver;
+  if (!sender.SetSend(suite, kKey, kKeyLen) ||
+      !receiver.SetRecv(suite, kKey, kKeyLen)) {
+    fprintf(stderr, "Failed to set up %s\n", suite.c_str());
+    return false;
+  }
+  // Keying the first session initialized SRTP and fixed the backend.
+  const char* backend =
+      (SrtpFilter::crypto_backend() == SrtpFilter::CRYPTO_OPENSSL) ?
+      "openssl" : "builtin";
+
+  std::vector<talk_base::Buffer*> chunk;
+  for (int i = 0; i < kChunk; ++i) {
+    chunk.push_back(new talk_base::Buffer(NULL, 0, FLAG_size + 16));
+  }
+  Timing timing;
+  uint16 seq_num = 0;
+  int done = 0;
+  int failed = 0;
+  double protect_time = 0;
+  double unprotect_time = 0;
+  while (done < FLAG_packets) {
+    for (size_t i = 0; i < chunk.size(); ++i) {
+      MakeRtpPacket(FLAG_size, ++seq_num, chunk[i]);
+    }
+    double start = timing.TimerNow();
+    for (size_t i = 0; i < chunk.size(); ++i) {
+      talk_base::Buffer* packet = chunk[i];
+      int out_len = 0;
+      if (sender.ProtectRtp(packet->data(), static_cast<int>(packet->length()),
+                            static_cast<int>(packet->capacity()), &out_len)) {
+        packet->SetLength(out_len);
+      } else {
+        packet->SetLength(0);
+        ++failed;
+      }
+    }
+    double middle = timing.TimerNow();
+    for (size_t i = 0; i < chunk.size(); ++i) {
+      talk_base::Buffer* packet = chunk[i];
+      int out_len = 0;
+      if (!packet->length() ||
+          !receiver.UnprotectRtp(packet->data(),
+                                 static_cast<int>(packet->length()),
+                                 &out_len)) {
+        ++failed;
+      }
+    }
+    double end = timing.TimerNow();
+    protect_time += middle - start;
+    unprotect_time += end - middle;
+    done += static_cast<int>(chunk.size());
+  }
+  for (size_t i = 0; i < chunk.size(); ++i) {
+    delete chunk[i];
+  }
+
+  // TimerNow() has microsecond resolution or better.
+  double protect_pps = done / talk_base::_max(protect_time, 1e-6);
+  double unprotect_pps = done / talk_base::_max(unprotect_time, 1e-6);
+  printf("{\"backend\": \"%s\", \"suite\": \"%s\", \"size\": %d, "
+         "\"packets\": %d, \"failed\": %d, "
+         "\"protect_pps\": %.0f, \"unprotect_pps\": %.0f, "
+         "\"protect_mbps\": %.1f, \"unprotect_mbps\": %.1f}\n",
+         backend, suite.c_str(), FLAG_size, done, failed,
+         protect_pps, unprotect_pps,
+         protect_pps * FLAG_size * 8 / 1000000,
+         unprotect_pps * FLAG_size * 8 / 1000000);
+  fflush(stdout);
+  return failed == 0;
+}
+
+int main(int argc, char* argv[]) {
+  FlagList::SetFlagsFromCommandLine(&argc, argv, true);
+  if (FLAG_help) {
+    FlagList::Print(NULL, false);
+    return 0;
+  }
+  if (FLAG_size < kRtpHeaderLen || FLAG_size > 2048 || FLAG_packets <= 0) {
+    fprintf(stderr, "--size must be 12-2048, --packets positive\n");
+    return 1;
+  }
+  talk_base::LogMessage::LogToDebug(talk_base::LS_ERROR);
+
+  SrtpFilter::CryptoBackend backend = (strcmp(FLAG_backend, "openssl") == 0) ?
+      SrtpFilter::CRYPTO_OPENSSL : SrtpFilter::CRYPTO_BUILTIN;
+  SrtpFilter::SetCryptoBackend(backend);
+
+  std::vector<std::string> suites;
+  if (strcmp(FLAG_suite, "all") == 0) {
+    suites.push_back(cricket::CS_AES_CM_128_HMAC_SHA1_80);
+    suites.push_back(cricket::CS_AES_CM_128_HMAC_SHA1_32);
+  } else {
+    suites.push_back(FLAG_suite);
+  }
+
+  int failures = 0;
+  for (size_t i = 0; i < suites.size(); ++i) {
+    if (!RunSuite(suites[i])) {
+      ++failures;
+    }
+  }
+  // SRTP falls back to the builtin crypto if OpenSSL's isn't available.
+  if (SrtpFilter::crypto_backend() != backend) {
+    fprintf(stderr, "Crypto backend %s is not available\n", FLAG_backend);
+    ++failures;
+  }
+  return failures ? 1 : 0;
+}
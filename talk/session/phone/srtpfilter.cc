@@ -36,6 +36,7 @@
 #include "talk/base/logging.h"
 #include "talk/base/stringencode.h"
 #include "talk/base/timeutils.h"
+#include "talk/session/phone/opensslsrtpcrypto.h"
 #include "talk/session/phone/rtputils.h"
 
 // Enable this line to turn on SRTP debugging
@@ -236,6 +237,14 @@ bool SrtpFilter::UnprotectRtp(void* p, int in_len, int* out_len) {
   return recv_session_->UnprotectRtp(p, in_len, out_len);
 }
 
+bool SrtpFilter::SetCryptoBackend(CryptoBackend backend) {
+  return SrtpSession::SetCryptoBackend(backend);
+}
+
+SrtpFilter::CryptoBackend SrtpFilter::crypto_backend() {
+  return SrtpSession::crypto_backend();
+}
+
 bool SrtpFilter::UnprotectRtcp(void* p, int in_len, int* out_len) {
   if (!IsActive()) {
     LOG(LS_WARNING) << "Failed to UnprotectRtcp: SRTP not active";
@@ -369,6 +378,13 @@ bool SrtpFilter::ParseKeyParams(const std::string& key_params,
 #ifdef HAVE_SRTP
 
 bool SrtpSession::inited_ = false;
+#ifdef SRTP_USE_OPENSSL
+SrtpFilter::CryptoBackend SrtpSession::crypto_backend_ =
+    SrtpFilter::CRYPTO_OPENSSL;
+#else
+SrtpFilter::CryptoBackend SrtpSession::crypto_backend_ =
+    SrtpFilter::CRYPTO_BUILTIN;
+#endif
 
 SrtpSession::SrtpSession()
     : session_(NULL),
@@ -488,6 +504,14 @@ void SrtpSession::set_signal_silent_time(uint32 signal_silent_time_in_ms) {
   srtp_stat_->set_signal_silent_time(signal_silent_time_in_ms);
 }
 
+bool SrtpSession::SetCryptoBackend(SrtpFilter::CryptoBackend backend) {
+  if (inited_) {
+    return backend == crypto_backend_;
+  }
+  crypto_backend_ = backend;
+  return true;
+}
+
 bool SrtpSession::SetKey(int type, const std::string& cs,
                          const uint8* key, int len) {
   if (session_) {
@@ -554,6 +578,12 @@ bool SrtpSession::Init() {
       return false;
     }
 
+    // Falls back to libsrtp's own crypto if OpenSSL's doesn't check out.
+    if (crypto_backend_ == SrtpFilter::CRYPTO_OPENSSL &&
+        !LoadOpenSslSrtpCrypto()) {
+      crypto_backend_ = SrtpFilter::CRYPTO_BUILTIN;
+    }
+
     inited_ = true;
   }
 
@@ -599,6 +629,9 @@ std::list<SrtpSession*>* SrtpSession::sessions() {
 
 // On some systems, SRTP is not (yet) available.
 
+SrtpFilter::CryptoBackend SrtpSession::crypto_backend_ =
+    SrtpFilter::CRYPTO_BUILTIN;
+
 SrtpSession::SrtpSession() {
   LOG(WARNING) << "SRTP implementation is missing.";
 }
@@ -636,6 +669,10 @@ void SrtpSession::set_signal_silent_time(uint32 signal_silent_time) {
   // Do nothing.
 }
 
+bool SrtpSession::SetCryptoBackend(SrtpFilter::CryptoBackend backend) {
+  return SrtpNotAvailable(__FUNCTION__);
+}
+
 #endif  // HAVE_SRTP
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -83,10 +83,25 @@ class SrtpFilter {
     ERROR_AUTH,
     ERROR_REPLAY,
   };
+  enum CryptoBackend {
+    CRYPTO_BUILTIN,  // libsrtp's portable AES and SHA-1.
+    CRYPTO_OPENSSL   // OpenSSL, which uses AES-NI and the SHA extensions.
+  };
 
   SrtpFilter();
   ~SrtpFilter();
 
+  // Selects the AES and HMAC-SHA1 implementation libsrtp is initialized
+  // with. That happens once per process, when the first SRTP session is
+  // keyed, so this has to be called before. Builds with SRTP_USE_OPENSSL
+  // default to CRYPTO_OPENSSL, others to CRYPTO_BUILTIN. If OpenSSL's
+  // implementation isn't available or fails libsrtp's checks, SRTP falls
+  // back to the builtin one. Returns false once SRTP is initialized with a
+  // different backend.
+  static bool SetCryptoBackend(CryptoBackend backend);
+  // Returns the backend SRTP uses, or will be initialized with.
+  static CryptoBackend crypto_backend();
+
   // Whether the filter is active (i.e. crypto has been properly negotiated).
   bool IsActive() const;
 
@@ -186,6 +201,10 @@ class SrtpSession {
   // Update the silent threshold (in ms) for signaling errors.
   void set_signal_silent_time(uint32 signal_silent_time_in_ms);
 
+  // See SrtpFilter::SetCryptoBackend.
+  static bool SetCryptoBackend(SrtpFilter::CryptoBackend backend);
+  static SrtpFilter::CryptoBackend crypto_backend() { return crypto_backend_; }
+
   sigslot::repeater3<uint32, SrtpFilter::Mode, SrtpFilter::Error>
       SignalSrtpError;
 
@@ -201,6 +220,7 @@ class SrtpSession {
   int rtcp_auth_tag_len_;
   talk_base::scoped_ptr<SrtpStat> srtp_stat_;
   static bool inited_;
+  static SrtpFilter::CryptoBackend crypto_backend_;
   int last_send_seq_num_;
   DISALLOW_COPY_AND_ASSIGN(SrtpSession);
 };
@@ -507,6 +507,19 @@ TEST_F(SrtpSessionTest, TestProtect_AES_CM_128_HMAC_SHA1_32) {
   TestUnprotectRtcp(CS_AES_CM_128_HMAC_SHA1_32);
 }
 
+// Test that the crypto backend can't be changed once SRTP is initialized.
+TEST_F(SrtpSessionTest, TestCryptoBackendFixedAtInit) {
+  EXPECT_TRUE(s1_.SetSend(CS_AES_CM_128_HMAC_SHA1_80, kTestKey1, kTestKeyLen));
+  cricket::SrtpFilter::CryptoBackend backend =
+      cricket::SrtpFilter::crypto_backend();
+  cricket::SrtpFilter::CryptoBackend other =
+      (backend == cricket::SrtpFilter::CRYPTO_BUILTIN) ?
+      cricket::SrtpFilter::CRYPTO_OPENSSL : cricket::SrtpFilter::CRYPTO_BUILTIN;
+  EXPECT_TRUE(cricket::SrtpFilter::SetCryptoBackend(backend));
+  EXPECT_FALSE(cricket::SrtpFilter::SetCryptoBackend(other));
+  EXPECT_EQ(backend, cricket::SrtpFilter::crypto_backend());
+}
+
 // Test that we fail to unprotect if someone tampers with the RTP/RTCP paylaods.
 TEST_F(SrtpSessionTest, TestTamperReject) {
   int out_len;
@@ -29,14 +29,20 @@
 
 #include <algorithm>
 
+#include "talk/base/basictypes.h"
+#include "talk/base/byteorder.h"
 #include "talk/base/logging.h"
 #include "talk/session/phone/rtputils.h"
 
 namespace cricket {
 
 static const uint32 kSsrc01 = 0x01;
+static const size_t kRtcpSsrcOffset = 4;
+static const size_t kMinSsrcTableSize = 16;
 
-SsrcMuxFilter::SsrcMuxFilter() {
+SsrcMuxFilter::SsrcMuxFilter()
+    : ssrc_count_(0),
+      has_ssrc0_(false) {
 }
 
 SsrcMuxFilter::~SsrcMuxFilter() {
@@ -47,44 +53,211 @@ bool SsrcMuxFilter::IsActive() const {
 }
 
 bool SsrcMuxFilter::DemuxPacket(const char* data, size_t len, bool rtcp) {
-  uint32 ssrc = 0;
-  if (!rtcp) {
-    GetRtpSsrc(data, len, &ssrc);
+  RtpPacketDescriptor desc;
+  if (rtcp) {
+    ParseRtcpPacket(data, len, &desc);
   } else {
-    int pl_type = 0;
-    if (!GetRtcpType(data, len, &pl_type)) return false;
-    if (pl_type == kRtcpTypeSDES) {
-      // SDES packet parsing not supported.
-      LOG(LS_INFO) << "SDES packet received for demux.";
+    ParseRtpPacket(data, len, &desc);
+  }
+  return DemuxPacket(data, len, desc);
+}
+
+bool SsrcMuxFilter::DemuxPacket(const char* data, size_t len,
+                                const RtpPacketDescriptor& desc) {
+  if (desc.rtcp) {
+    return desc.parsed && DemuxRtcpPacket(data, len, desc);
+  }
+  // An RTP packet too short for its header is still demuxed on whatever
+  // SSRC could be read.
+  return HasSsrc(desc.ssrc);
+}
+
+// Checks each sub-packet of a compound RTCP packet (RFC 3550 section 6.1),
+// as located by ParseRtcpPacket, and then any sub-packets past the ones the
+// descriptor has room for.
+bool SsrcMuxFilter::DemuxRtcpPacket(const char* data, size_t len,
+                                    const RtpPacketDescriptor& desc) const {
+  bool has_sender_ssrc = false;
+  bool has_sdes = false;
+  for (int i = 0; i < desc.rtcp_block_count; ++i) {
+    if (DemuxRtcpBlock(data, desc.rtcp_blocks[i],
+                       &has_sender_ssrc, &has_sdes)) {
       return true;
-    } else {
-      if (!GetRtcpSsrc(data, len, &ssrc)) return false;
-      if (ssrc == kSsrc01) {
-        // SSRC 1 has a special meaning and indicates generic feedback on
-        // some systems and should never be dropped.  If it is forwarded
-        // incorrectly it will be ignored by lower layers anyway.
+    }
+  }
+  if (desc.rtcp_more_blocks) {
+    const RtcpBlock& last = desc.rtcp_blocks[desc.rtcp_block_count - 1];
+    RtcpBlock block;
+    for (size_t offset = last.offset + last.len;
+         ParseRtcpBlock(data, len, offset, &block); offset += block.len) {
+      if (DemuxRtcpBlock(data, block, &has_sender_ssrc, &has_sdes)) {
         return true;
       }
     }
   }
-  return FindStream(ssrc);
+  // A packet carrying nothing but SDES is not tied to a sender, so it is
+  // passed on rather than dropped.
+  return has_sdes && !has_sender_ssrc;
+}
+
+// A sub-packet whose length field runs past the data has been clamped, so
+// that reduced-size packets (RFC 5506) with a truncated length are still
+// demuxed on their sender SSRC.
+bool SsrcMuxFilter::DemuxRtcpBlock(const char* data, const RtcpBlock& block,
+                                   bool* has_sender_ssrc,
+                                   bool* has_sdes) const {
+  const uint8* header = reinterpret_cast<const uint8*>(data) + block.offset;
+  if (block.type == kRtcpTypeSDES) {
+    *has_sdes = true;
+    // Each chunk is an SSRC followed by items, terminated by a null item
+    // and padded to a 32-bit boundary.
+    int chunks = block.count;
+    size_t pos = kMinRtcpPacketLen;
+    while (chunks-- > 0 && pos + sizeof(uint32) <= block.len) {
+      if (HasSsrc(talk_base::GetBE32(header + pos))) {
+        return true;
+      }
+      pos += sizeof(uint32);
+      while (pos < block.len && header[pos] != 0) {
+        if (pos + 1 >= block.len) {
+          break;
+        }
+        pos += 2 + header[pos + 1];
+      }
+      pos = (pos + sizeof(uint32)) & ~(sizeof(uint32) - 1);
+    }
+  } else if (block.len >= kMinRtcpPacketLen + sizeof(uint32)) {
+    uint32 ssrc = talk_base::GetBE32(header + kRtcpSsrcOffset);
+    // SSRC 1 has a special meaning and indicates generic feedback on
+    // some systems and should never be dropped.  If it is forwarded
+    // incorrectly it will be ignored by lower layers anyway.
+    if (ssrc == kSsrc01 || HasSsrc(ssrc)) {
+      return true;
+    }
+    *has_sender_ssrc = true;
+  }
+  return false;
 }
 
 bool SsrcMuxFilter::AddStream(const StreamParams& stream) {
-  if (GetStreamBySsrc(streams_, stream.first_ssrc(), NULL)) {
+  for (size_t i = 0; i < stream.ssrcs.size(); ++i) {
+    if (HasSsrc(stream.ssrcs[i])) {
       LOG(LS_WARNING) << "Stream already added to filter";
       return false;
+    }
   }
   streams_.push_back(stream);
+  for (size_t i = 0; i < stream.ssrcs.size(); ++i) {
+    InsertSsrc(stream.ssrcs[i]);
+  }
   return true;
 }
 
 bool SsrcMuxFilter::RemoveStream(uint32 ssrc) {
+  if (!HasSsrc(ssrc)) {
+    return false;
+  }
+  StreamParams stream;
+  if (!GetStreamBySsrc(streams_, ssrc, &stream)) {
+    return false;
+  }
+  for (size_t i = 0; i < stream.ssrcs.size(); ++i) {
+    EraseSsrc(stream.ssrcs[i]);
+  }
   return RemoveStreamBySsrc(&streams_, ssrc);
 }
 
 bool SsrcMuxFilter::FindStream(uint32 ssrc) const {
-  return (GetStreamBySsrc(streams_, ssrc, NULL));
+  return HasSsrc(ssrc);
+}
+
+size_t SsrcMuxFilter::SsrcBucket(uint32 ssrc) const {
+  // SSRCs are random but may be assigned sequentially by some endpoints, so
+  // mix the bits before masking.
+  uint32 hash = ssrc * 2654435761U;
+  hash ^= hash >> 16;
+  return hash & (ssrc_table_.size() - 1);
+}
+
+bool SsrcMuxFilter::HasSsrc(uint32 ssrc) const {
+  if (ssrc == 0) {
+    return has_ssrc0_;
+  }
+  if (ssrc_table_.empty()) {
+    return false;
+  }
+  size_t mask = ssrc_table_.size() - 1;
+  for (size_t i = SsrcBucket(ssrc); ssrc_table_[i] != 0; i = (i + 1) & mask) {
+    if (ssrc_table_[i] == ssrc) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SsrcMuxFilter::InsertSsrc(uint32 ssrc) {
+  if (ssrc == 0) {
+    has_ssrc0_ = true;
+    return;
+  }
+  // Keep the load factor at or below one half so probe runs stay short.
+  if ((ssrc_count_ + 1) * 2 > ssrc_table_.size()) {
+    ResizeSsrcTable(talk_base::_max(kMinSsrcTableSize, ssrc_table_.size() * 2));
+  }
+  size_t mask = ssrc_table_.size() - 1;
+  size_t i = SsrcBucket(ssrc);
+  while (ssrc_table_[i] != 0) {
+    if (ssrc_table_[i] == ssrc) {
+      return;
+    }
+    i = (i + 1) & mask;
+  }
+  ssrc_table_[i] = ssrc;
+  ++ssrc_count_;
+}
+
+void SsrcMuxFilter::EraseSsrc(uint32 ssrc) {
+  if (ssrc == 0) {
+    has_ssrc0_ = false;
+    return;
+  }
+  if (ssrc_table_.empty()) {
+    return;
+  }
+  size_t mask = ssrc_table_.size() - 1;
+  size_t i = SsrcBucket(ssrc);
+  while (ssrc_table_[i] != ssrc) {
+    if (ssrc_table_[i] == 0) {
+      return;
+    }
+    i = (i + 1) & mask;
+  }
+  ssrc_table_[i] = 0;
+  --ssrc_count_;
+  // Shift later entries of the probe run back into the hole so that lookups
+  // never stop early on it.
+  for (size_t j = (i + 1) & mask; ssrc_table_[j] != 0; j = (j + 1) & mask) {
+    size_t home = SsrcBucket(ssrc_table_[j]);
+    bool in_place = (i <= j) ? (i < home && home <= j)
+                             : (i < home || home <= j);
+    if (!in_place) {
+      ssrc_table_[i] = ssrc_table_[j];
+      ssrc_table_[j] = 0;
+      i = j;
+    }
+  }
+}
+
+void SsrcMuxFilter::ResizeSsrcTable(size_t buckets) {
+  std::vector<uint32> old_table;
+  old_table.swap(ssrc_table_);
+  ssrc_table_.resize(buckets, 0);
+  ssrc_count_ = 0;
+  for (size_t i = 0; i < old_table.size(); ++i) {
+    if (old_table[i] != 0) {
+      InsertSsrc(old_table[i]);
+    }
+  }
 }
 
 }  // namespace cricket
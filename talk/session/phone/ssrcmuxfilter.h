@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "talk/base/basictypes.h"
+#include "talk/session/phone/rtputils.h"
 #include "talk/session/phone/streamparams.h"
 
 namespace cricket {
@@ -50,7 +51,13 @@ class SsrcMuxFilter {
   // Returns true if the filter contains a stream.
   bool IsActive() const;
   // Determines packet belongs to valid cricket::BaseChannel.
+  // RTP packets are matched on their SSRC. RTCP packets are walked as a
+  // compound packet and accepted if any sub-packet carries a known SSRC.
   bool DemuxPacket(const char* data, size_t len, bool rtcp);
+  // As above, for a packet whose header has already been parsed into |desc|.
+  // RTCP that failed to parse is dropped; RTP is matched on its SSRC alone.
+  bool DemuxPacket(const char* data, size_t len,
+                   const RtpPacketDescriptor& desc);
   // Adding a valid source to the filter.
   bool AddStream(const StreamParams& stream);
   // Removes source from the filter.
@@ -59,7 +66,25 @@ class SsrcMuxFilter {
   bool FindStream(uint32 ssrc) const;
 
  private:
+  bool DemuxRtcpPacket(const char* data, size_t len,
+                       const RtpPacketDescriptor& desc) const;
+  // Returns true if |block| carries a known SSRC.
+  bool DemuxRtcpBlock(const char* data, const RtcpBlock& block,
+                      bool* has_sender_ssrc, bool* has_sdes) const;
+
+  // Open-addressed hash set of every SSRC of every stream in |streams_|, so
+  // that demuxing does not scan the streams on each packet.
+  bool HasSsrc(uint32 ssrc) const;
+  void InsertSsrc(uint32 ssrc);
+  void EraseSsrc(uint32 ssrc);
+  void ResizeSsrcTable(size_t buckets);
+  size_t SsrcBucket(uint32 ssrc) const;
+
   std::vector<StreamParams> streams_;
+  // Slot value 0 marks an empty bucket; SSRC 0 is tracked by |has_ssrc0_|.
+  std::vector<uint32> ssrc_table_;
+  size_t ssrc_count_;
+  bool has_ssrc0_;
 };
 
 }  // namespace cricket
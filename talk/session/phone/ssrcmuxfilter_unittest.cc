@@ -182,3 +182,105 @@ TEST(SsrcMuxFilterTest, RtcpPacketTest) {
       reinterpret_cast<const char*>(kRtcpPacketNonCompoundRtcpPliFeedback),
       sizeof(kRtcpPacketNonCompoundRtcpPliFeedback), true));
 }
+
+// First packet - RR = PT = 201, count = 0, SSRC of sender = 0x4444
+// second packet - SDES = PT = 202, count = 2, chunk SSRCs = 0x5555, 0x2222,
+// each with a CNAME of "ab".
+static const unsigned char kRtcpPacketCompoundRrSdesSsrc2[] = {
+    0x80, 0xC9, 0x00, 0x01, 0x00, 0x00, 0x44, 0x44,
+    0x82, 0xCA, 0x00, 0x06,
+    0x00, 0x00, 0x55, 0x55, 0x01, 0x02, 0x61, 0x62, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x22, 0x22, 0x01, 0x02, 0x61, 0x62, 0x00, 0x00, 0x00, 0x00,
+};
+
+// First packet - RR = PT = 201, count = 0, SSRC of sender = 0x4444
+// second packet - PSFB = PT = 206, FMT = 1, Sender SSRC = 0x3333,
+// Media SSRC = 0x4444
+static const unsigned char kRtcpPacketCompoundRrPliSsrc3[] = {
+    0x80, 0xC9, 0x00, 0x01, 0x00, 0x00, 0x44, 0x44,
+    0x81, 0xCE, 0x00, 0x02, 0x00, 0x00, 0x33, 0x33, 0x00, 0x00, 0x44, 0x44,
+};
+
+TEST(SsrcMuxFilterTest, RtcpCompoundPacketTest) {
+  cricket::SsrcMuxFilter ssrc_filter;
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(kSsrc1)));
+  // Neither packet carries a known SSRC in any of its sub-packets.
+  EXPECT_FALSE(ssrc_filter.DemuxPacket(
+      reinterpret_cast<const char*>(kRtcpPacketCompoundRrSdesSsrc2),
+      sizeof(kRtcpPacketCompoundRrSdesSsrc2), true));
+  EXPECT_FALSE(ssrc_filter.DemuxPacket(
+      reinterpret_cast<const char*>(kRtcpPacketCompoundRrPliSsrc3),
+      sizeof(kRtcpPacketCompoundRrPliSsrc3), true));
+  // The second SDES chunk and the PLI behind the RR are found.
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(kSsrc2)));
+  EXPECT_TRUE(ssrc_filter.DemuxPacket(
+      reinterpret_cast<const char*>(kRtcpPacketCompoundRrSdesSsrc2),
+      sizeof(kRtcpPacketCompoundRrSdesSsrc2), true));
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(kSsrc3)));
+  EXPECT_TRUE(ssrc_filter.DemuxPacket(
+      reinterpret_cast<const char*>(kRtcpPacketCompoundRrPliSsrc3),
+      sizeof(kRtcpPacketCompoundRrPliSsrc3), true));
+}
+
+TEST(SsrcMuxFilterTest, RtcpCompoundPacketWithManyBlocksTest) {
+  // Empty receiver reports from 0x2222, with the last from 0x1111 and past
+  // the sub-packets that ParseRtcpPacket records.
+  static const int kNumBlocks = cricket::kMaxRtcpBlocks + 2;
+  static const size_t kBlockLen = 8;
+  uint8 packet[kNumBlocks * kBlockLen];
+  for (int i = 0; i < kNumBlocks; ++i) {
+    uint8* block = packet + i * kBlockLen;
+    block[0] = 0x80;
+    block[1] = cricket::kRtcpTypeRR;
+    talk_base::SetBE16(block + 2, 1);
+    talk_base::SetBE32(block + 4, (i == kNumBlocks - 1) ? kSsrc1 : kSsrc2);
+  }
+
+  cricket::SsrcMuxFilter ssrc_filter;
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(kSsrc3)));
+  EXPECT_FALSE(ssrc_filter.DemuxPacket(
+      reinterpret_cast<const char*>(packet), sizeof(packet), true));
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(kSsrc1)));
+  EXPECT_TRUE(ssrc_filter.DemuxPacket(
+      reinterpret_cast<const char*>(packet), sizeof(packet), true));
+}
+
+TEST(SsrcMuxFilterTest, ManyStreamsTest) {
+  static const uint32 kNumStreams = 500;
+  cricket::SsrcMuxFilter ssrc_filter;
+  for (uint32 i = 0; i < kNumStreams; ++i) {
+    StreamParams stream;
+    stream.ssrcs.push_back(i * 2 + 1);
+    stream.ssrcs.push_back(0x80000000 + i);
+    EXPECT_TRUE(ssrc_filter.AddStream(stream));
+  }
+  EXPECT_FALSE(ssrc_filter.AddStream(StreamParams::CreateLegacy(7)));
+  // Remove every other stream, alternating on the first and second SSRC.
+  for (uint32 i = 0; i < kNumStreams; i += 2) {
+    EXPECT_TRUE(ssrc_filter.RemoveStream(
+        (i % 4) ? i * 2 + 1 : 0x80000000 + i));
+  }
+  for (uint32 i = 0; i < kNumStreams; ++i) {
+    bool kept = (i % 2) != 0;
+    EXPECT_EQ(kept, ssrc_filter.FindStream(i * 2 + 1)) << i;
+    EXPECT_EQ(kept, ssrc_filter.FindStream(0x80000000 + i)) << i;
+    EXPECT_FALSE(ssrc_filter.FindStream(i * 2 + 2));
+  }
+  for (uint32 i = 1; i < kNumStreams; i += 2) {
+    EXPECT_TRUE(ssrc_filter.RemoveStream(i * 2 + 1));
+  }
+  EXPECT_FALSE(ssrc_filter.IsActive());
+  EXPECT_FALSE(ssrc_filter.FindStream(1));
+}
+
+TEST(SsrcMuxFilterTest, SsrcZeroTest) {
+  cricket::SsrcMuxFilter ssrc_filter;
+  EXPECT_FALSE(ssrc_filter.FindStream(0));
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(0)));
+  EXPECT_TRUE(ssrc_filter.AddStream(StreamParams::CreateLegacy(kSsrc1)));
+  EXPECT_FALSE(ssrc_filter.AddStream(StreamParams::CreateLegacy(0)));
+  EXPECT_TRUE(ssrc_filter.FindStream(0));
+  EXPECT_TRUE(ssrc_filter.RemoveStream(0));
+  EXPECT_FALSE(ssrc_filter.FindStream(0));
+  EXPECT_TRUE(ssrc_filter.FindStream(kSsrc1));
+}
@@ -367,4 +367,25 @@ bool VideoFrameEqual(const VideoFrame* frame0, const VideoFrame* frame1) {
   return true;
 }
 
+size_t TestVideoFrame::ConvertToRgbBuffer(uint32 to_fourcc, uint8* buffer,
+                                          size_t size,
+                                          int stride_rgb) const {
+  size_t needed = stride_rgb * height_;
+  if (stride_rgb < width_ * 4 || size < needed) {
+    return needed;
+  }
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      memset(buffer + y * stride_rgb + x * 4, buffer_[y * width_ + x], 4);
+    }
+  }
+  return needed;
+}
+
+void TestVideoFrame::Fill() {
+  for (size_t i = 0; i < buffer_.size(); ++i) {
+    buffer_[i] = static_cast<uint8>(i * 7 + i / width_ * 3);
+  }
+}
+
 }  // namespace cricket
@@ -37,6 +37,7 @@
 #include "talk/session/phone/mediachannel.h"
 #include "talk/session/phone/videocommon.h"
 #include "talk/session/phone/videocapturer.h"
+#include "talk/session/phone/videoframe.h"
 
 namespace talk_base {
 class ByteBuffer;
@@ -57,7 +58,6 @@ template <class T> inline std::vector<T> MakeVector(const T a[], size_t s) {
 
 struct RtpDumpPacket;
 class RtpDumpWriter;
-class VideoFrame;
 
 struct RawRtpPacket {
   void WriteToByteBuffer(uint32 in_ssrc, talk_base::ByteBuffer* buf) const;
@@ -204,6 +204,71 @@ void DumpPlanarArgbTestImage(const std::string& prefix, const uint8* img,
 // Compare two I420 frames.
 bool VideoFrameEqual(const VideoFrame* frame0, const VideoFrame* frame1);
 
+// An I420 frame in a plain buffer, to test code that uses VideoFrame.
+class TestVideoFrame : public VideoFrame {
+ public:
+  TestVideoFrame(int w, int h)
+      : width_(w), height_(h), buffer_(SizeOf(w, h)) {
+  }
+
+  virtual bool Reset(uint32 fourcc, int w, int h, int dw, int dh,
+                     uint8* sample, size_t sample_size,
+                     size_t pixel_width, size_t pixel_height,
+                     int64 elapsed_time, int64 time_stamp, int rotation) {
+    return false;
+  }
+  virtual size_t GetWidth() const { return width_; }
+  virtual size_t GetHeight() const { return height_; }
+  virtual const uint8* GetYPlane() const { return &buffer_[0]; }
+  virtual const uint8* GetUPlane() const {
+    return GetYPlane() + width_ * height_;
+  }
+  virtual const uint8* GetVPlane() const {
+    return GetUPlane() + GetChromaSize();
+  }
+  virtual uint8* GetYPlane() { return &buffer_[0]; }
+  virtual uint8* GetUPlane() { return GetYPlane() + width_ * height_; }
+  virtual uint8* GetVPlane() { return GetUPlane() + GetChromaSize(); }
+  virtual int32 GetYPitch() const { return width_; }
+  virtual int32 GetUPitch() const { return (width_ + 1) / 2; }
+  virtual int32 GetVPitch() const { return (width_ + 1) / 2; }
+  virtual size_t GetPixelWidth() const { return 1; }
+  virtual size_t GetPixelHeight() const { return 1; }
+  virtual int64 GetElapsedTime() const { return 0; }
+  virtual int64 GetTimeStamp() const { return 0; }
+  virtual void SetElapsedTime(int64 elapsed_time) {}
+  virtual void SetTimeStamp(int64 time_stamp) {}
+  virtual int GetRotation() const { return 0; }
+  virtual VideoFrame* Copy() const {
+    TestVideoFrame* copy = new TestVideoFrame(width_, height_);
+    copy->buffer_ = buffer_;
+    return copy;
+  }
+  virtual bool MakeExclusive() { return true; }
+  virtual size_t CopyToBuffer(uint8* buffer, size_t size) const { return 0; }
+  // Writes the Y plane to all four bytes of each pixel, whatever the fourcc.
+  virtual size_t ConvertToRgbBuffer(uint32 to_fourcc, uint8* buffer,
+                                    size_t size, int stride_rgb) const;
+
+  const std::vector<uint8>& buffer() const { return buffer_; }
+
+  // Fills the planes with a gradient.
+  void Fill();
+
+ protected:
+  virtual VideoFrame* CreateEmptyFrame(int w, int h,
+                                       size_t pixel_width, size_t pixel_height,
+                                       int64 elapsed_time,
+                                       int64 time_stamp) const {
+    return new TestVideoFrame(w, h);
+  }
+
+ private:
+  int width_;
+  int height_;
+  std::vector<uint8> buffer_;
+};
+
 }  // namespace cricket
 
 #endif  // TALK_SESSION_PHONE_TESTUTILS_H_
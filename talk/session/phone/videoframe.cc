@@ -34,18 +34,209 @@
 #include "libyuv/scale.h"
 #endif
 #include "talk/base/logging.h"
+#include "talk/base/scoped_ref_ptr.h"
+#include "talk/session/phone/bandworkerpool.h"
+#include "talk/session/phone/framebufferpool.h"
 
 namespace cricket {
 
 // Round to 2 pixels because Chroma channels are half size.
 #define ROUNDTO2(v) (v & ~1)
 
+static int GreatestCommonDivisor(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+#ifndef HAVE_YUV
+// Scales a plane with nearest or bilinear filtering.
+static void ScalePlane(const uint8* src, int32 src_pitch,
+                       int src_width, int src_height,
+                       uint8* dst, int32 dst_pitch,
+                       int dst_width, int dst_height, bool interpolate) {
+  if (src_width <= 0 || src_height <= 0 || dst_width <= 0 ||
+      dst_height <= 0) {
+    return;
+  }
+  // 16.16 fixed point steps, sampling at pixel centers.
+  int dx = (src_width << 16) / dst_width;
+  int dy = (src_height << 16) / dst_height;
+  int max_x = (src_width - 1) << 16;
+  int max_y = (src_height - 1) << 16;
+  for (int row = 0; row < dst_height; ++row) {
+    int y = talk_base::_min(talk_base::_max((row * dy) + (dy >> 1) - 32768, 0),
+                            max_y);
+    const uint8* src_row = src + (y >> 16) * src_pitch;
+    uint8* dst_row = dst + row * dst_pitch;
+    if (!interpolate) {
+      for (int col = 0, x = dx >> 1; col < dst_width; ++col, x += dx) {
+        dst_row[col] = src_row[talk_base::_min(x >> 16, src_width - 1)];
+      }
+      continue;
+    }
+    const uint8* next_row = (y >> 16) + 1 < src_height ?
+        src_row + src_pitch : src_row;
+    int fy = (y >> 8) & 0xFF;
+    for (int col = 0; col < dst_width; ++col) {
+      int x = talk_base::_min(talk_base::_max(col * dx + (dx >> 1) - 32768, 0),
+                              max_x);
+      int x0 = x >> 16;
+      int x1 = talk_base::_min(x0 + 1, src_width - 1);
+      int fx = (x >> 8) & 0xFF;
+      int top = src_row[x0] * (256 - fx) + src_row[x1] * fx;
+      int bottom = next_row[x0] * (256 - fx) + next_row[x1] * fx;
+      dst_row[col] = static_cast<uint8>(
+          (top * (256 - fy) + bottom * fy + 32768) >> 16);
+    }
+  }
+}
+#endif
+
+// Scales a whole I420 image.
+static void ScaleI420(const uint8* in_y, const uint8* in_u, const uint8* in_v,
+                      int32 in_pitch_y, int32 in_pitch_u, int32 in_pitch_v,
+                      int in_width, int in_height,
+                      uint8* y, uint8* u, uint8* v,
+                      int32 pitch_y, int32 pitch_u, int32 pitch_v,
+                      int width, int height, bool interpolate) {
+#ifdef HAVE_YUV
+  libyuv::Scale(in_y, in_u, in_v, in_pitch_y, in_pitch_u, in_pitch_v,
+                in_width, in_height, y, u, v, pitch_y, pitch_u, pitch_v,
+                width, height, interpolate);
+#else
+  ScalePlane(in_y, in_pitch_y, in_width, in_height,
+             y, pitch_y, width, height, interpolate);
+  ScalePlane(in_u, in_pitch_u, (in_width + 1) / 2, (in_height + 1) / 2,
+             u, pitch_u, (width + 1) / 2, (height + 1) / 2, interpolate);
+  ScalePlane(in_v, in_pitch_v, (in_width + 1) / 2, (in_height + 1) / 2,
+             v, pitch_v, (width + 1) / 2, (height + 1) / 2, interpolate);
+#endif
+}
+
+static void CopyRows(const uint8* src, int32 src_pitch,
+                     uint8* dst, int32 dst_pitch, int width, int rows) {
+  for (int row = 0; row < rows; ++row) {
+    memcpy(dst + row * dst_pitch, src + row * src_pitch, width);
+  }
+}
+
+// Scales a band of output rows of an I420 image. The scaler only sees the
+// input rows of the band, so near a band boundary its filter would read the
+// band's edge instead of the neighbouring rows, leaving a seam. Each band is
+// therefore scaled with a margin of extra rows on the sides it shares with
+// other bands, into a scratch image, and only its own rows are kept.
+class StretchTask : public BandTask {
+ public:
+  StretchTask(const uint8* in_y, const uint8* in_u, const uint8* in_v,
+              int32 in_pitch_y, int32 in_pitch_u, int32 in_pitch_v,
+              int in_width, int in_height,
+              uint8* y, uint8* u, uint8* v,
+              int32 pitch_y, int32 pitch_u, int32 pitch_v,
+              int width, int height, bool interpolate)
+      : in_y_(in_y), in_u_(in_u), in_v_(in_v),
+        in_pitch_y_(in_pitch_y), in_pitch_u_(in_pitch_u),
+        in_pitch_v_(in_pitch_v), in_width_(in_width), in_height_(in_height),
+        y_(y), u_(u), v_(v),
+        pitch_y_(pitch_y), pitch_u_(pitch_u), pitch_v_(pitch_v),
+        width_(width), height_(height), interpolate_(interpolate) {
+  }
+
+  // Band boundaries, and the margins around them, must be even, for the
+  // chroma rows. Ideally they also map to whole even input rows, so that a
+  // band is scaled with the same ratio as the whole frame. For ratios where
+  // that step would leave too few bands, boundaries only keep to even rows,
+  // and a band's ratio may differ from the frame's by part of an input row.
+  int alignment() const {
+    int exact = ExactAlignment();
+    return exact <= BandWorkerPool::kMinBandRows ? exact : 2;
+  }
+
+  virtual void ProcessBand(int first_row, int last_row) {
+    // The margin covers the filter: at least two input rows and at least
+    // two output rows. An exact alignment step already does.
+    int margin = ExactAlignment();
+    if (margin > BandWorkerPool::kMinBandRows) {
+      margin = (2 * height_ / in_height_ + 3) & ~1;
+    }
+    int scaled_first_row = talk_base::_max(first_row - margin, 0);
+    int scaled_last_row = talk_base::_min(last_row + margin, height_);
+    int in_first_row = InputRow(scaled_first_row);
+    int in_last_row = InputRow(scaled_last_row);
+    const uint8* in_y = in_y_ + in_first_row * in_pitch_y_;
+    const uint8* in_u = in_u_ + in_first_row / 2 * in_pitch_u_;
+    const uint8* in_v = in_v_ + in_first_row / 2 * in_pitch_v_;
+    if (first_row == 0 && last_row == height_) {
+      ScaleI420(in_y, in_u, in_v, in_pitch_y_, in_pitch_u_, in_pitch_v_,
+                in_width_, in_height_, y_, u_, v_,
+                pitch_y_, pitch_u_, pitch_v_, width_, height_, interpolate_);
+      return;
+    }
+
+    int rows = scaled_last_row - scaled_first_row;
+    int chroma_width = (width_ + 1) / 2;
+    int chroma_rows = (rows + 1) / 2;
+    // Pooled, since every band of every frame needs one.
+    talk_base::scoped_refptr<FrameBuffer> scratch =
+        FrameBufferPool::Default()->Acquire(
+            width_ * rows + 2 * chroma_width * chroma_rows);
+    uint8* y = scratch->data();
+    uint8* u = y + width_ * rows;
+    uint8* v = u + chroma_width * chroma_rows;
+    ScaleI420(in_y, in_u, in_v, in_pitch_y_, in_pitch_u_, in_pitch_v_,
+              in_width_, in_last_row - in_first_row, y, u, v,
+              width_, chroma_width, chroma_width, width_, rows, interpolate_);
+
+    int skip = first_row - scaled_first_row;
+    CopyRows(y + skip * width_, width_, y_ + first_row * pitch_y_, pitch_y_,
+             width_, last_row - first_row);
+    int chroma_first_row = first_row / 2;
+    int chroma_last_row = last_row == height_ ?
+        (height_ + 1) / 2 : last_row / 2;
+    CopyRows(u + skip / 2 * chroma_width, chroma_width,
+             u_ + chroma_first_row * pitch_u_, pitch_u_,
+             chroma_width, chroma_last_row - chroma_first_row);
+    CopyRows(v + skip / 2 * chroma_width, chroma_width,
+             v_ + chroma_first_row * pitch_v_, pitch_v_,
+             chroma_width, chroma_last_row - chroma_first_row);
+  }
+
+ private:
+  int ExactAlignment() const {
+    return 2 * (height_ / GreatestCommonDivisor(in_height_, height_));
+  }
+
+  int InputRow(int row) const {
+    return row == height_ ? in_height_ : row * in_height_ / height_;
+  }
+
+  const uint8* in_y_;
+  const uint8* in_u_;
+  const uint8* in_v_;
+  int32 in_pitch_y_;
+  int32 in_pitch_u_;
+  int32 in_pitch_v_;
+  int in_width_;
+  int in_height_;
+  uint8* y_;
+  uint8* u_;
+  uint8* v_;
+  int32 pitch_y_;
+  int32 pitch_u_;
+  int32 pitch_v_;
+  int width_;
+  int height_;
+  bool interpolate_;
+};
+
 // TODO: Handle odd width/height with rounding.
 void VideoFrame::StretchToPlanes(
     uint8* y, uint8* u, uint8* v,
     int32 dst_pitch_y, int32 dst_pitch_u, int32 dst_pitch_v,
     size_t width, size_t height, bool interpolate, bool vert_crop) const {
-#ifdef HAVE_YUV
   if (!GetYPlane() || !GetUPlane() || !GetVPlane())
     return;
 
@@ -76,14 +267,12 @@ void VideoFrame::StretchToPlanes(
   }
 
   // Scale to the output I420 frame.
-  libyuv::Scale(in_y, in_u, in_v,
-                GetYPitch(),
-                GetUPitch(),
-                GetVPitch(),
-                iwidth, iheight,
-                y, u, v, dst_pitch_y, dst_pitch_u, dst_pitch_v,
-                width, height, interpolate);
-#endif
+  StretchTask task(in_y, in_u, in_v,
+                   GetYPitch(), GetUPitch(), GetVPitch(),
+                   iwidth, iheight,
+                   y, u, v, dst_pitch_y, dst_pitch_u, dst_pitch_v,
+                   width, height, interpolate);
+  BandWorkerPool::Default()->Run(&task, height, task.alignment());
 }
 
 size_t VideoFrame::StretchToBuffer(size_t w, size_t h,
@@ -0,0 +1,172 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "talk/base/gunit.h"
+#include "talk/base/logging.h"
+#include "talk/base/scoped_ptr.h"
+#include "talk/base/timeutils.h"
+#include "talk/session/phone/bandworkerpool.h"
+#include "talk/session/phone/testutils.h"
+#include "talk/session/phone/videoframe.h"
+
+namespace cricket {
+
+class VideoFrameTest : public testing::Test {
+ public:
+  virtual void TearDown() {
+    BandWorkerPool::Default()->set_num_threads(1);
+  }
+
+ protected:
+  // Returns the average time to stretch a frame, in microseconds.
+  int TimeStretch(const TestVideoFrame& frame, TestVideoFrame* target,
+                  int num_threads) {
+    const int kNumFrames = 20;
+    BandWorkerPool::Default()->set_num_threads(num_threads);
+    uint32 start = talk_base::Time();
+    for (int i = 0; i < kNumFrames; ++i) {
+      frame.StretchToFrame(target, true, true);
+    }
+    return talk_base::TimeSince(start) * 1000 / kNumFrames;
+  }
+};
+
+// Test that stretching in bands gives the same frame as in one pass, with no
+// seams at the band boundaries. This runs the band code of the libyuv path
+// too; only the scaler under it differs. Each band is scaled with the same
+// fixed-point step as the whole frame, but from its own first row, so
+// interpolated pixels may differ by one from a single pass.
+TEST_F(VideoFrameTest, StretchInBands) {
+  static const struct {
+    int in_width, in_height, out_width, out_height;
+  } kSizes[] = {
+    { 1280, 720, 640, 360 },
+    { 1280, 720, 960, 540 },
+    { 640, 360, 1280, 720 },
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(kSizes); ++i) {
+    TestVideoFrame frame(kSizes[i].in_width, kSizes[i].in_height);
+    frame.Fill();
+    for (int interpolate = 0; interpolate < 2; ++interpolate) {
+      BandWorkerPool::Default()->set_num_threads(1);
+      talk_base::scoped_ptr<VideoFrame> serial(frame.Stretch(
+          kSizes[i].out_width, kSizes[i].out_height, interpolate != 0, true));
+      BandWorkerPool::Default()->set_num_threads(4);
+      talk_base::scoped_ptr<VideoFrame> parallel(frame.Stretch(
+          kSizes[i].out_width, kSizes[i].out_height, interpolate != 0, true));
+      const std::vector<uint8>& expected =
+          static_cast<TestVideoFrame*>(serial.get())->buffer();
+      const std::vector<uint8>& actual =
+          static_cast<TestVideoFrame*>(parallel.get())->buffer();
+      ASSERT_EQ(expected.size(), actual.size());
+      for (size_t j = 0; j < expected.size(); ++j) {
+        ASSERT_LE(abs(expected[j] - actual[j]), interpolate) << i << " " << j;
+      }
+    }
+  }
+}
+
+// Test that stretching in bands stays close to one pass for a ratio whose
+// exact band alignment would leave a single band. The bands then only keep
+// to even rows, so a band may sample up to about two input rows away from a
+// single pass; a shallow vertical gradient keeps that within a few levels.
+TEST_F(VideoFrameTest, StretchInBandsUnevenRatio) {
+  static const int kInWidth = 640;
+  static const int kInHeight = 480;
+  static const int kOutWidth = 352;
+  static const int kOutHeight = 262;
+  TestVideoFrame frame(kInWidth, kInHeight);
+  for (int row = 0; row < kInHeight; ++row) {
+    memset(frame.GetYPlane() + row * kInWidth, row / 2, kInWidth);
+  }
+  memset(frame.GetUPlane(), 50, frame.GetChromaSize());
+  memset(frame.GetVPlane(), 200, frame.GetChromaSize());
+  for (int interpolate = 0; interpolate < 2; ++interpolate) {
+    BandWorkerPool::Default()->set_num_threads(1);
+    talk_base::scoped_ptr<VideoFrame> serial(frame.Stretch(
+        kOutWidth, kOutHeight, interpolate != 0, false));
+    BandWorkerPool::Default()->set_num_threads(4);
+    talk_base::scoped_ptr<VideoFrame> parallel(frame.Stretch(
+        kOutWidth, kOutHeight, interpolate != 0, false));
+    const std::vector<uint8>& expected =
+        static_cast<TestVideoFrame*>(serial.get())->buffer();
+    const std::vector<uint8>& actual =
+        static_cast<TestVideoFrame*>(parallel.get())->buffer();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      ASSERT_LE(abs(expected[j] - actual[j]), 2) << j;
+    }
+  }
+}
+
+// Test that a stretched frame keeps a uniform color.
+TEST_F(VideoFrameTest, StretchSolidColor) {
+  TestVideoFrame frame(320, 240);
+  memset(frame.GetYPlane(), 100, 320 * 240);
+  memset(frame.GetUPlane(), 50, frame.GetChromaSize());
+  memset(frame.GetVPlane(), 200, frame.GetChromaSize());
+  TestVideoFrame target(176, 144);
+  frame.StretchToFrame(&target, true, false);
+  for (size_t i = 0; i < 176 * 144; ++i) {
+    ASSERT_EQ(100, target.GetYPlane()[i]);
+  }
+  for (size_t i = 0; i < target.GetChromaSize(); ++i) {
+    ASSERT_EQ(50, target.GetUPlane()[i]);
+    ASSERT_EQ(200, target.GetVPlane()[i]);
+  }
+}
+
+// Reports the time to stretch frames at common resolutions, in one pass and
+// in bands. Disabled by default since it only logs timings.
+TEST_F(VideoFrameTest, DISABLED_StretchPerf) {
+  static const struct {
+    int in_width, in_height, out_width, out_height;
+  } kSizes[] = {
+    { 1920, 1080, 1280, 720 },
+    { 1920, 1080, 640, 360 },
+    { 1280, 720, 640, 360 },
+    { 640, 480, 320, 240 },
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(kSizes); ++i) {
+    TestVideoFrame frame(kSizes[i].in_width, kSizes[i].in_height);
+    frame.Fill();
+    TestVideoFrame target(kSizes[i].out_width, kSizes[i].out_height);
+    int serial_us = TimeStretch(frame, &target, 1);
+    int parallel_us = TimeStretch(frame, &target, 4);
+    LOG(LS_INFO) << "Stretch " << kSizes[i].in_width << "x"
+                 << kSizes[i].in_height << " to " << kSizes[i].out_width
+                 << "x" << kSizes[i].out_height << ": "
+                 << serial_us / 1000.0 << " ms per frame, "
+                 << parallel_us / 1000.0 << " ms in 4 bands";
+  }
+}
+
+}  // namespace cricket
@@ -30,7 +30,9 @@
 #include "libyuv/convert.h"
 #include "libyuv/convert_from.h"
 #include "libyuv/planar_functions.h"
+#include "talk/base/criticalsection.h"
 #include "talk/base/logging.h"
+#include "talk/session/phone/bandworkerpool.h"
 #include "talk/session/phone/videocapturer.h"
 #include "talk/session/phone/videocommon.h"
 
@@ -46,6 +48,7 @@ WebRtcVideoFrame::WebRtcVideoFrame() {
 }
 
 WebRtcVideoFrame::~WebRtcVideoFrame() {
+  FreeBuffer();
 }
 
 bool WebRtcVideoFrame::Init(uint32 format, int w, int h, int dw, int dh,
@@ -75,7 +78,7 @@ void WebRtcVideoFrame::Attach(uint8* buffer, size_t buffer_size, int w, int h,
                               size_t pixel_width, size_t pixel_height,
                               int64 elapsed_time, int64 time_stamp,
                               int rotation) {
-  video_frame_.Free();
+  FreeBuffer();
   WebRtc_UWord8* new_memory = buffer;
   WebRtc_UWord32 new_length = buffer_size;
   WebRtc_UWord32 new_size = buffer_size;
@@ -94,10 +97,43 @@ void WebRtcVideoFrame::Detach(uint8** buffer, size_t* buffer_size) {
   WebRtc_UWord32 new_length = 0;
   WebRtc_UWord32 new_size = 0;
   video_frame_.Swap(new_memory, new_length, new_size);
+  if (pooled_buffer_.get()) {
+    if (pooled_buffer_->HasOneRef()) {
+      new_memory = pooled_buffer_->ReleaseData();
+    } else {
+      new_memory = new uint8[new_size];
+      memcpy(new_memory, pooled_buffer_->data(), new_size);
+    }
+    pooled_buffer_ = NULL;
+  }
   *buffer = new_memory;
   *buffer_size = new_size;
 }
 
+void WebRtcVideoFrame::AttachPooled(FrameBuffer* buffer, int w, int h,
+                                    size_t pixel_width, size_t pixel_height,
+                                    int64 elapsed_time, int64 time_stamp,
+                                    int rotation) {
+  // Hold the reference before Attach drops the current buffer, which may be
+  // the same one.
+  talk_base::scoped_refptr<FrameBuffer> pooled_buffer(buffer);
+  Attach(buffer->data(), buffer->size(), w, h, pixel_width, pixel_height,
+         elapsed_time, time_stamp, rotation);
+  pooled_buffer_ = pooled_buffer;
+}
+
+void WebRtcVideoFrame::FreeBuffer() {
+  if (pooled_buffer_.get()) {
+    WebRtc_UWord8* new_memory = NULL;
+    WebRtc_UWord32 new_length = 0;
+    WebRtc_UWord32 new_size = 0;
+    video_frame_.Swap(new_memory, new_length, new_size);
+    pooled_buffer_ = NULL;
+  } else {
+    video_frame_.Free();
+  }
+}
+
 size_t WebRtcVideoFrame::GetWidth() const {
   return video_frame_.Width();
 }
@@ -155,20 +191,42 @@ VideoFrame* WebRtcVideoFrame::Copy() const {
   if (!buffer)
     return NULL;
 
+  WebRtcVideoFrame* copy = new WebRtcVideoFrame();
   size_t new_buffer_size = video_frame_.Length();
-  uint8* new_buffer = new uint8[new_buffer_size];
-  memcpy(new_buffer, buffer, new_buffer_size);
+  talk_base::scoped_refptr<FrameBuffer> new_buffer =
+      FrameBufferPool::Default()->Acquire(new_buffer_size);
+  memcpy(new_buffer->data(), buffer, new_buffer_size);
+  copy->AttachPooled(new_buffer.get(),
+                     video_frame_.Width(), video_frame_.Height(),
+                     pixel_width_, pixel_height_,
+                     elapsed_time_, time_stamp_, rotation_);
+  return copy;
+}
+
+WebRtcVideoFrame* WebRtcVideoFrame::ShallowCopy() const {
+  if (!pooled_buffer_.get()) {
+    return static_cast<WebRtcVideoFrame*>(Copy());
+  }
   WebRtcVideoFrame* copy = new WebRtcVideoFrame();
-  copy->Attach(new_buffer, new_buffer_size,
-               video_frame_.Width(), video_frame_.Height(),
-               pixel_width_, pixel_height_,
-               elapsed_time_, time_stamp_, rotation_);
+  copy->AttachPooled(pooled_buffer_.get(),
+                     video_frame_.Width(), video_frame_.Height(),
+                     pixel_width_, pixel_height_,
+                     elapsed_time_, time_stamp_, rotation_);
   return copy;
 }
 
 bool WebRtcVideoFrame::MakeExclusive() {
-  // WebRtcVideoFrame::Copy makes a deep copy of the frame buffer.  No action
-  // is needed for MakeExclusive.
+  if (!pooled_buffer_.get() || pooled_buffer_->HasOneRef()) {
+    return true;
+  }
+  size_t buffer_size = video_frame_.Length();
+  talk_base::scoped_refptr<FrameBuffer> new_buffer =
+      FrameBufferPool::Default()->Acquire(buffer_size);
+  memcpy(new_buffer->data(), pooled_buffer_->data(), buffer_size);
+  AttachPooled(new_buffer.get(),
+               video_frame_.Width(), video_frame_.Height(),
+               pixel_width_, pixel_height_,
+               elapsed_time_, time_stamp_, rotation_);
   return true;
 }
 
@@ -184,6 +242,42 @@ size_t WebRtcVideoFrame::CopyToBuffer(uint8* buffer, size_t size) const {
   return needed;
 }
 
+// Converts a band of rows of an I420 frame to RGB.
+class ConvertToRgbTask : public BandTask {
+ public:
+  ConvertToRgbTask(const WebRtcVideoFrame* frame, uint32 to_fourcc,
+                   uint8* buffer, int stride_rgb)
+      : frame_(frame), to_fourcc_(to_fourcc), buffer_(buffer),
+        stride_rgb_(stride_rgb), failures_(0) {
+  }
+
+  bool failed() const { return talk_base::AtomicOps::Load(&failures_) > 0; }
+
+  virtual void ProcessBand(int first_row, int last_row) {
+    // |first_row| is even, so the chroma rows start on a boundary too.
+    if (libyuv::ConvertFromI420(
+            frame_->GetYPlane() + first_row * frame_->GetYPitch(),
+            frame_->GetYPitch(),
+            frame_->GetUPlane() + first_row / 2 * frame_->GetUPitch(),
+            frame_->GetUPitch(),
+            frame_->GetVPlane() + first_row / 2 * frame_->GetVPitch(),
+            frame_->GetVPitch(),
+            buffer_ + first_row * stride_rgb_, stride_rgb_,
+            frame_->GetWidth(), last_row - first_row,
+            to_fourcc_)) {
+      // Bands run on several threads at once.
+      talk_base::AtomicOps::Increment(&failures_);
+    }
+  }
+
+ private:
+  const WebRtcVideoFrame* frame_;
+  uint32 to_fourcc_;
+  uint8* buffer_;
+  int stride_rgb_;
+  int failures_;
+};
+
 // TODO: Refactor into base class and share with lmi
 size_t WebRtcVideoFrame::ConvertToRgbBuffer(uint32 to_fourcc,
                                             uint8* buffer,
@@ -192,7 +286,6 @@ size_t WebRtcVideoFrame::ConvertToRgbBuffer(uint32 to_fourcc,
   if (!video_frame_.Buffer()) {
     return 0;
   }
-  size_t width = video_frame_.Width();
   size_t height = video_frame_.Height();
   size_t needed = (stride_rgb >= 0 ? stride_rgb : -stride_rgb) * height;
   if (size < needed) {
@@ -200,12 +293,9 @@ size_t WebRtcVideoFrame::ConvertToRgbBuffer(uint32 to_fourcc,
     return needed;
   }
 
-  if (libyuv::ConvertFromI420(GetYPlane(), GetYPitch(),
-                              GetUPlane(), GetUPitch(),
-                              GetVPlane(), GetVPitch(),
-                              buffer, stride_rgb,
-                              width, height,
-                              to_fourcc)) {
+  ConvertToRgbTask task(this, to_fourcc, buffer, stride_rgb);
+  BandWorkerPool::Default()->Run(&task, height, 2);
+  if (task.failed()) {
     LOG(LS_WARNING) << "RGB type not supported: " << to_fourcc;
     return 0;  // 0 indicates error
   }
@@ -250,17 +340,19 @@ bool WebRtcVideoFrame::Reset(uint32 format, int w, int h, int dw, int dh,
     return false;
   }
 
-  // Discard the existing buffer.
-  uint8* old_buffer;
-  size_t old_buffer_size;
-  Detach(&old_buffer, &old_buffer_size);
-  delete[] old_buffer;
-
-  // Set up a new buffer.
+  // Set up a new buffer, reusing the existing one if nobody shares it.
   size_t desired_size = SizeOf(dw, dh);
-  uint8* buffer = new uint8[desired_size];
-  Attach(buffer, desired_size, dw, dh, pixel_width, pixel_height,
-         elapsed_time, time_stamp, rotation);
+  if (!pooled_buffer_.get() || !pooled_buffer_->HasOneRef() ||
+      pooled_buffer_->size() != desired_size) {
+    talk_base::scoped_refptr<FrameBuffer> new_buffer =
+        FrameBufferPool::Default()->Acquire(desired_size);
+    AttachPooled(new_buffer.get(), dw, dh, pixel_width, pixel_height,
+                 elapsed_time, time_stamp, rotation);
+  } else {
+    AttachPooled(pooled_buffer_.get(), dw, dh, pixel_width, pixel_height,
+                 elapsed_time, time_stamp, rotation);
+  }
+  uint8* buffer = pooled_buffer_->data();
 
   if (dh == h) {
     // Uncropped
@@ -304,9 +396,10 @@ void WebRtcVideoFrame::InitToEmptyBuffer(int w, int h,
                                          int64 elapsed_time,
                                          int64 time_stamp) {
   size_t buffer_size = VideoFrame::SizeOf(w, h);
-  uint8* buffer = new uint8[buffer_size];
-  Attach(buffer, buffer_size, w, h, pixel_width, pixel_height,
-         elapsed_time, time_stamp, 0);
+  talk_base::scoped_refptr<FrameBuffer> buffer =
+      FrameBufferPool::Default()->Acquire(buffer_size);
+  AttachPooled(buffer.get(), w, h, pixel_width, pixel_height,
+               elapsed_time, time_stamp, 0);
 }
 
 }  // namespace cricket
@@ -35,12 +35,17 @@
 #include "third_party/webrtc/files/include/common_types.h"
 #include "third_party/webrtc/files/include/module_common_types.h"
 #endif
+#include "talk/session/phone/framebufferpool.h"
 #include "talk/session/phone/videoframe.h"
 
 namespace cricket {
 
 struct CapturedFrame;
 
+// WebRtcVideoFrame takes the buffers it allocates from
+// FrameBufferPool::Default(). Copy() duplicates the buffer, while
+// ShallowCopy() shares it until either frame is made exclusive. A buffer
+// passed to Attach is owned by the frame as before.
 class WebRtcVideoFrame : public VideoFrame {
  public:
   WebRtcVideoFrame();
@@ -63,6 +68,8 @@ class WebRtcVideoFrame : public VideoFrame {
   void Attach(uint8* buffer, size_t buffer_size, int w, int h,
               size_t pixel_width, size_t pixel_height,
               int64 elapsed_time, int64 time_stamp, int rotation);
+  // Hands the buffer to the caller, who must free it with delete[]. A shared
+  // buffer is copied first.
   void Detach(uint8** buffer, size_t* buffer_size);
   bool AddWatermark();
   webrtc::VideoFrame* frame() { return &video_frame_; }
@@ -99,6 +106,10 @@ class WebRtcVideoFrame : public VideoFrame {
   virtual int GetRotation() const { return rotation_; }
 
   virtual VideoFrame* Copy() const;
+  // Returns a frame that shares this frame's pooled buffer. Call
+  // MakeExclusive on either frame before writing to it. A buffer passed to
+  // Attach can't be shared, so it is duplicated as by Copy().
+  WebRtcVideoFrame* ShallowCopy() const;
   virtual bool MakeExclusive();
   virtual size_t CopyToBuffer(uint8* buffer, size_t size) const;
   virtual size_t ConvertToRgbBuffer(uint32 to_fourcc, uint8* buffer,
@@ -112,8 +123,17 @@ class WebRtcVideoFrame : public VideoFrame {
   void InitToEmptyBuffer(int w, int h,
                          size_t pixel_width, size_t pixel_height,
                          int64 elapsed_time, int64 time_stamp);
+  // Like Attach, for a buffer of the pool.
+  void AttachPooled(FrameBuffer* buffer, int w, int h,
+                    size_t pixel_width, size_t pixel_height,
+                    int64 elapsed_time, int64 time_stamp, int rotation);
+  // Takes the buffer out of video_frame_ and drops it.
+  void FreeBuffer();
 
   webrtc::VideoFrame video_frame_;
+  // The buffer of video_frame_, if it came from the pool. video_frame_ only
+  // borrows it and must not free it.
+  talk_base::scoped_refptr<FrameBuffer> pooled_buffer_;
   size_t pixel_width_;
   size_t pixel_height_;
   int64 elapsed_time_;
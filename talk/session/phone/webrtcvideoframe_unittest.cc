@@ -201,6 +201,35 @@ TEST_F(WebRtcVideoFrameTest, AttachAndRelease) {
   EXPECT_TRUE(IsSize(frame1, kWidth, kHeight));
 }
 
+// Test that shallow copies share the pooled buffer until they are made
+// exclusive, that deep copies don't, and that a frame reuses its buffer
+// across Reset.
+TEST_F(WebRtcVideoFrameTest, PooledBuffer) {
+  cricket::WebRtcVideoFrame frame1;
+  ASSERT_TRUE(LoadFrameNoRepeat(&frame1));
+  const uint8* y_plane = frame1.GetYPlane();
+  talk_base::scoped_ptr<cricket::VideoFrame> copy(frame1.Copy());
+  EXPECT_NE(y_plane, copy->GetYPlane());
+  EXPECT_TRUE(IsEqual(frame1, *copy, 0));
+  copy.reset();
+
+  talk_base::scoped_ptr<cricket::VideoFrame> frame2(frame1.ShallowCopy());
+  EXPECT_EQ(y_plane, frame2->GetYPlane());
+  EXPECT_TRUE(frame2->MakeExclusive());
+  EXPECT_NE(y_plane, frame2->GetYPlane());
+  EXPECT_TRUE(IsEqual(frame1, *frame2, 0));
+  ASSERT_TRUE(LoadFrameNoRepeat(&frame1));
+  EXPECT_EQ(y_plane, frame1.GetYPlane());
+
+  // A detached buffer leaves the pool for the caller to delete.
+  uint8* buffer;
+  size_t size;
+  frame1.Detach(&buffer, &size);
+  EXPECT_EQ(y_plane, buffer);
+  EXPECT_TRUE(IsNull(frame1));
+  delete[] buffer;
+}
+
 TEST_F(WebRtcVideoFrameTest, Transfer) {
   cricket::WebRtcVideoFrame frame1, frame2;
   ASSERT_TRUE(LoadFrameNoRepeat(&frame1));
@@ -145,6 +145,13 @@ bool PseudoTcpChannel::Connect(const std::string& content_name,
 
   ASSERT(tcp_ == NULL);
   tcp_ = new PseudoTcp(this, 0);
+  // Tunnels mostly carry bulk transfers, which CUBIC handles much better
+  // than Reno on long and lossy paths. This only affects our sending side.
+  tcp_->SetOption(PseudoTcp::OPT_CONGESTION_CONTROL,
+                  CongestionControl::CUBIC);
+  // Pace the window out over the round trip, so the UDP transport below
+  // doesn't drop the tail of every burst.
+  tcp_->SetOption(PseudoTcp::OPT_PACING, 1);
   if (session_->initiator()) {
     // Since we may try several protocols and network adapters that won't work,
     // waiting until we get our first writable notification before initiating
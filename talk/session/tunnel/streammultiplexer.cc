@@ -0,0 +1,415 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/session/tunnel/streammultiplexer.h"
+
+#include "talk/base/byteorder.h"
+#include "talk/base/common.h"
+#include "talk/base/logging.h"
+#include "talk/base/socket.h"
+
+namespace cricket {
+
+// Every frame starts with a type byte, the stream id and the payload length.
+//
+//    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  0 |     Type      |                  Stream id                    |
+//    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  4 |               |                Payload length                 |
+//    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//  8 |               |                   payload                     |
+//    +-+-+-+-+-+-+-+-+                                               |
+
+const size_t kFrameHeaderSize = 9;
+// Largest payload of any frame. Larger writes are split, so that streams
+// take turns on the underlying stream.
+const size_t kMaxFramePayload = 16 * 1024;
+// Data writes are refused once this much is waiting for the underlying
+// stream. Control frames are always queued.
+const size_t kMaxQueuedBytes = 2 * (kFrameHeaderSize + kMaxFramePayload);
+const size_t kReadBlockSize = 4096;
+
+const size_t StreamMultiplexer::kDefaultStreamWindow = 64 * 1024;
+
+///////////////////////////////////////////////////////////////////////////////
+// StreamMultiplexer::MuxStream
+///////////////////////////////////////////////////////////////////////////////
+
+class StreamMultiplexer::MuxStream : public talk_base::StreamInterface {
+ public:
+  MuxStream(StreamMultiplexer* parent, uint32 id, size_t window)
+      : parent_(parent), id_(id), state_(talk_base::SS_OPENING),
+        window_(window), consumed_(0), send_credit_(0),
+        write_blocked_(false), close_pending_(false), close_error_(0) {
+  }
+  virtual ~MuxStream() {
+    Close();
+  }
+
+  virtual talk_base::StreamState GetState() const {
+    return state_;
+  }
+
+  virtual talk_base::StreamResult Read(void* buffer, size_t buffer_len,
+                                       size_t* read, int* error) {
+    if (recv_.Length() == 0) {
+      return (state_ == talk_base::SS_CLOSED) ?
+          talk_base::SR_EOS : talk_base::SR_BLOCK;
+    }
+    size_t len = talk_base::_min(buffer_len, recv_.Length());
+    recv_.ReadBytes(static_cast<char*>(buffer), len);
+    if (read)
+      *read = len;
+
+    if (recv_.Length() == 0) {
+      recv_.Shift(0);
+      if (close_pending_) {
+        close_pending_ = false;
+        PostEvent(talk_base::SE_CLOSE, close_error_);
+      }
+    }
+
+    // Open the window again once half of it has been read.
+    consumed_ += len;
+    if (parent_ && (consumed_ >= window_ / 2)) {
+      parent_->SendWindowUpdate(this, consumed_);
+      consumed_ = 0;
+    }
+    return talk_base::SR_SUCCESS;
+  }
+
+  virtual talk_base::StreamResult Write(const void* data, size_t data_len,
+                                        size_t* written, int* error) {
+    if (state_ == talk_base::SS_OPENING)
+      return talk_base::SR_BLOCK;
+    if (!parent_ || (state_ == talk_base::SS_CLOSED)) {
+      if (error)
+        *error = ENOTCONN;
+      return talk_base::SR_ERROR;
+    }
+    return parent_->WriteData(this, data, data_len, written);
+  }
+
+  virtual void Close() {
+    if (parent_) {
+      parent_->CloseStream(this);
+      parent_ = NULL;
+    }
+    state_ = talk_base::SS_CLOSED;
+    close_pending_ = false;
+  }
+
+ private:
+  friend class StreamMultiplexer;
+
+  // Called when the stream is closed from the other end, or the multiplexer
+  // goes away. Data that has already arrived can still be read, and
+  // SE_CLOSE is held back until it has been.
+  void Detach(int error) {
+    parent_ = NULL;
+    state_ = talk_base::SS_CLOSED;
+    if (recv_.Length() == 0) {
+      PostEvent(talk_base::SE_CLOSE, error);
+    } else {
+      close_pending_ = true;
+      close_error_ = error;
+    }
+  }
+
+  StreamMultiplexer* parent_;
+  uint32 id_;
+  talk_base::StreamState state_;
+  talk_base::ByteBuffer recv_;
+  // Our receive window, and how much of it has been read since the last
+  // window update.
+  size_t window_, consumed_;
+  // How much more the peer is willing to receive.
+  size_t send_credit_;
+  bool write_blocked_;
+  bool close_pending_;
+  int close_error_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// StreamMultiplexer
+///////////////////////////////////////////////////////////////////////////////
+
+StreamMultiplexer::StreamMultiplexer(talk_base::StreamInterface* stream,
+                                     bool initiator)
+    : stream_(stream), pending_(NULL), next_id_(initiator ? 1 : 2),
+      stream_window_(kDefaultStreamWindow), write_blocked_(false) {
+  stream_->SignalEvent.connect(this, &StreamMultiplexer::OnStreamEvent);
+}
+
+StreamMultiplexer::~StreamMultiplexer() {
+  for (StreamMap::iterator it = streams_.begin(); it != streams_.end(); ++it) {
+    it->second->parent_ = NULL;
+    it->second->state_ = talk_base::SS_CLOSED;
+  }
+  stream_->Close();
+}
+
+talk_base::StreamInterface* StreamMultiplexer::CreateStream(
+    const std::string& description) {
+  if (stream_->GetState() == talk_base::SS_CLOSED)
+    return NULL;
+
+  ASSERT(description.size() + 4 <= kMaxFramePayload);
+  MuxStream* stream = new MuxStream(this, next_id_, stream_window_);
+  next_id_ += 2;
+  streams_[stream->id_] = stream;
+  QueueFrame(FRAME_OPEN, stream->id_, stream_window_,
+             description.substr(0, kMaxFramePayload - 4));
+  Flush();
+  return stream;
+}
+
+talk_base::StreamInterface* StreamMultiplexer::AcceptStream(uint32 id) {
+  if (!pending_ || (pending_->id_ != id))
+    return NULL;
+
+  MuxStream* stream = pending_;
+  pending_ = NULL;
+  stream->state_ = talk_base::SS_OPEN;
+  streams_[id] = stream;
+  QueueFrame(FRAME_ACCEPT, id, stream->window_, std::string());
+  Flush();
+  // Posted, so that the caller can connect to SignalEvent first.
+  stream->PostEvent(talk_base::SE_OPEN | talk_base::SE_WRITE, 0);
+  return stream;
+}
+
+void StreamMultiplexer::RejectStream(uint32 id) {
+  if (!pending_ || (pending_->id_ != id))
+    return;
+
+  pending_->parent_ = NULL;
+  delete pending_;
+  pending_ = NULL;
+  QueueFrame(FRAME_RESET, id, NULL, 0);
+  Flush();
+}
+
+void StreamMultiplexer::set_stream_window(size_t window) {
+  ASSERT(window > 0);
+  stream_window_ = talk_base::_max<size_t>(window, 1);
+}
+
+talk_base::StreamResult StreamMultiplexer::WriteData(MuxStream* stream,
+                                                     const void* data,
+                                                     size_t data_len,
+                                                     size_t* written) {
+  if (out_.Length() >= kMaxQueuedBytes) {
+    stream->write_blocked_ = true;
+    write_blocked_ = true;
+    return talk_base::SR_BLOCK;
+  }
+  if (stream->send_credit_ == 0) {
+    stream->write_blocked_ = true;
+    return talk_base::SR_BLOCK;
+  }
+
+  size_t len = talk_base::_min(talk_base::_min(data_len, stream->send_credit_),
+                               kMaxFramePayload);
+  QueueFrame(FRAME_DATA, stream->id_, static_cast<const char*>(data), len);
+  stream->send_credit_ -= len;
+  if (written)
+    *written = len;
+  Flush();
+  return talk_base::SR_SUCCESS;
+}
+
+void StreamMultiplexer::SendWindowUpdate(MuxStream* stream, uint32 consumed) {
+  QueueFrame(FRAME_WINDOW, stream->id_, consumed, std::string());
+  Flush();
+}
+
+void StreamMultiplexer::CloseStream(MuxStream* stream) {
+  streams_.erase(stream->id_);
+  QueueFrame(FRAME_CLOSE, stream->id_, NULL, 0);
+  Flush();
+}
+
+void StreamMultiplexer::QueueFrame(FrameType type, uint32 id,
+                                   const char* payload, size_t payload_len) {
+  out_.WriteUInt8(type);
+  out_.WriteUInt32(id);
+  out_.WriteUInt32(static_cast<uint32>(payload_len));
+  if (payload_len)
+    out_.WriteBytes(payload, payload_len);
+}
+
+void StreamMultiplexer::QueueFrame(FrameType type, uint32 id, uint32 value,
+                                   const std::string& payload) {
+  out_.WriteUInt8(type);
+  out_.WriteUInt32(id);
+  out_.WriteUInt32(static_cast<uint32>(4 + payload.size()));
+  out_.WriteUInt32(value);
+  out_.WriteString(payload);
+}
+
+void StreamMultiplexer::Flush() {
+  while (out_.Length() > 0) {
+    size_t written = 0;
+    if (stream_->Write(out_.Data(), out_.Length(), &written, NULL) !=
+        talk_base::SR_SUCCESS)
+      break;
+    out_.Consume(written);
+  }
+  if (out_.Length() == 0)
+    out_.Shift(0);
+
+  // Let streams that were refused a write try again.
+  if (write_blocked_ && (out_.Length() < kMaxQueuedBytes)) {
+    write_blocked_ = false;
+    for (StreamMap::iterator it = streams_.begin(); it != streams_.end();
+         ++it) {
+      MuxStream* stream = it->second;
+      if (stream->write_blocked_ && (stream->send_credit_ > 0)) {
+        stream->write_blocked_ = false;
+        stream->PostEvent(talk_base::SE_WRITE, 0);
+      }
+    }
+  }
+}
+
+void StreamMultiplexer::ReadFrames() {
+  char block[kReadBlockSize];
+  size_t read = 0;
+  while (stream_->Read(block, sizeof(block), &read, NULL) ==
+         talk_base::SR_SUCCESS) {
+    in_.WriteBytes(block, read);
+
+    while (in_.Length() >= kFrameHeaderSize) {
+      const char* frame = in_.Data();
+      uint32 payload_len = talk_base::GetBE32(frame + 5);
+      if (payload_len > kMaxFramePayload) {
+        LOG(LS_ERROR) << "Invalid frame length " << payload_len;
+        stream_->Close();
+        CloseAll(ECONNABORTED);
+        SignalClosed(this, ECONNABORTED);
+        return;
+      }
+      if (in_.Length() < kFrameHeaderSize + payload_len)
+        break;
+      ProcessFrame(talk_base::Get8(frame, 0), talk_base::GetBE32(frame + 1),
+                   frame + kFrameHeaderSize, payload_len);
+      in_.Consume(kFrameHeaderSize + payload_len);
+    }
+    if (in_.Length() == 0)
+      in_.Shift(0);
+  }
+}
+
+void StreamMultiplexer::ProcessFrame(uint8 type, uint32 id,
+                                     const char* payload,
+                                     size_t payload_len) {
+  if (type == FRAME_OPEN) {
+    if ((payload_len < 4) || ((id & 1) == (next_id_ & 1)) ||
+        (streams_.find(id) != streams_.end())) {
+      LOG(LS_WARNING) << "Ignoring invalid open for stream " << id;
+      return;
+    }
+    ASSERT(pending_ == NULL);
+    pending_ = new MuxStream(this, id, stream_window_);
+    pending_->send_credit_ = talk_base::GetBE32(payload);
+    SignalIncomingStream(this, id, std::string(payload + 4, payload_len - 4));
+    RejectStream(id);  // Unless it has been accepted.
+    return;
+  }
+
+  StreamMap::iterator it = streams_.find(id);
+  if (it == streams_.end()) {
+    // Frames that were in flight when we closed the stream.
+    return;
+  }
+  MuxStream* stream = it->second;
+
+  if (type == FRAME_ACCEPT) {
+    if ((payload_len < 4) || (stream->state_ != talk_base::SS_OPENING))
+      return;
+    stream->state_ = talk_base::SS_OPEN;
+    stream->send_credit_ = talk_base::GetBE32(payload);
+    stream->PostEvent(talk_base::SE_OPEN | talk_base::SE_WRITE, 0);
+  } else if (type == FRAME_DATA) {
+    if (stream->state_ != talk_base::SS_OPEN)
+      return;
+    size_t space = stream->window_ - stream->consumed_ - stream->recv_.Length();
+    if (payload_len > space) {
+      LOG(LS_WARNING) << "Stream " << id << " overran its window by "
+                      << payload_len - space << " bytes";
+      payload_len = space;
+    }
+    bool was_empty = (stream->recv_.Length() == 0);
+    stream->recv_.WriteBytes(payload, payload_len);
+    if (was_empty && payload_len)
+      stream->PostEvent(talk_base::SE_READ, 0);
+  } else if (type == FRAME_WINDOW) {
+    if (payload_len < 4)
+      return;
+    stream->send_credit_ += talk_base::GetBE32(payload);
+    if (stream->write_blocked_ && (out_.Length() < kMaxQueuedBytes)) {
+      stream->write_blocked_ = false;
+      stream->PostEvent(talk_base::SE_WRITE, 0);
+    }
+  } else if (type == FRAME_CLOSE) {
+    streams_.erase(it);
+    stream->Detach(0);
+  } else if (type == FRAME_RESET) {
+    streams_.erase(it);
+    stream->Detach(ECONNREFUSED);
+  } else {
+    LOG(LS_WARNING) << "Ignoring unknown frame type "
+                    << static_cast<int>(type);
+  }
+}
+
+void StreamMultiplexer::OnStreamEvent(talk_base::StreamInterface* stream,
+                                      int events, int error) {
+  ASSERT(stream == stream_.get());
+  if (events & (talk_base::SE_OPEN | talk_base::SE_WRITE)) {
+    Flush();
+  }
+  if (events & talk_base::SE_READ) {
+    ReadFrames();
+  }
+  if (events & talk_base::SE_CLOSE) {
+    CloseAll(error);
+    SignalClosed(this, error);
+  }
+}
+
+void StreamMultiplexer::CloseAll(int error) {
+  StreamMap streams;
+  streams.swap(streams_);
+  for (StreamMap::iterator it = streams.begin(); it != streams.end(); ++it) {
+    it->second->Detach(error);
+  }
+}
+
+}  // namespace cricket
@@ -0,0 +1,142 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// StreamMultiplexer carries many logical streams over one established
+// tunnel stream, such as the one returned by TunnelSessionClient's
+// CreateTunnel or AcceptTunnel. Opening a logical stream costs one round
+// trip on the existing PseudoTcpChannel instead of a new session with its
+// own connectivity checks.
+//
+// Each logical stream has its own flow control window, so a stream whose
+// reader falls behind doesn't stall the others.
+
+#ifndef TALK_SESSION_TUNNEL_STREAMMULTIPLEXER_H_
+#define TALK_SESSION_TUNNEL_STREAMMULTIPLEXER_H_
+
+#include <map>
+#include <string>
+
+#include "talk/base/basictypes.h"
+#include "talk/base/bytebuffer.h"
+#include "talk/base/constructormagic.h"
+#include "talk/base/scoped_ptr.h"
+#include "talk/base/sigslot.h"
+#include "talk/base/stream.h"
+
+namespace cricket {
+
+// All methods, as well as those of the streams it hands out, must be called
+// on the thread that signals events for the underlying stream (the stream
+// thread of the PseudoTcpChannel).
+class StreamMultiplexer : public sigslot::has_slots<> {
+ public:
+  // Takes ownership of |stream|. The two ends must pass different values
+  // for |initiator|, so that the stream ids they pick never collide.
+  StreamMultiplexer(talk_base::StreamInterface* stream, bool initiator);
+  ~StreamMultiplexer();
+
+  // Opens a new logical stream. The returned stream is owned by the caller
+  // and stays in SS_OPENING until the peer accepts it, at which point it
+  // signals SE_OPEN. If the peer rejects it, it signals SE_CLOSE with
+  // ECONNREFUSED. Returns NULL if the underlying stream is closed.
+  talk_base::StreamInterface* CreateStream(const std::string& description);
+
+  // Signalled when the peer opens a stream, with the stream id and the
+  // description passed to CreateStream. Handlers must call AcceptStream or
+  // RejectStream for the id before returning; streams that are neither
+  // accepted nor rejected are rejected.
+  sigslot::signal3<StreamMultiplexer*, uint32, const std::string&>
+      SignalIncomingStream;
+
+  // Accepts the incoming stream |id|. The returned stream is owned by the
+  // caller. Returns NULL if there is no such pending stream.
+  talk_base::StreamInterface* AcceptStream(uint32 id);
+  void RejectStream(uint32 id);
+
+  // Signalled when the underlying stream closes. All logical streams are
+  // closed with it.
+  sigslot::signal2<StreamMultiplexer*, int> SignalClosed;
+
+  // The receive window for streams opened or accepted from now on, in
+  // bytes. Defaults to kDefaultStreamWindow.
+  size_t stream_window() const { return stream_window_; }
+  void set_stream_window(size_t window);
+
+  // Returns the number of logical streams that are open or opening.
+  size_t stream_count() const { return streams_.size(); }
+
+  static const size_t kDefaultStreamWindow;
+
+ private:
+  class MuxStream;
+  friend class MuxStream;
+  typedef std::map<uint32, MuxStream*> StreamMap;
+
+  enum FrameType {
+    FRAME_OPEN = 1,  // Payload: receive window, description.
+    FRAME_ACCEPT,    // Payload: receive window.
+    FRAME_DATA,      // Payload: stream data.
+    FRAME_WINDOW,    // Payload: bytes the receiver has consumed.
+    FRAME_CLOSE,     // No payload. No more frames will follow for the stream.
+    FRAME_RESET,     // No payload. The stream was rejected.
+  };
+
+  // Logical stream methods
+  talk_base::StreamResult WriteData(MuxStream* stream, const void* data,
+                                    size_t data_len, size_t* written);
+  void SendWindowUpdate(MuxStream* stream, uint32 consumed);
+  void CloseStream(MuxStream* stream);
+
+  void QueueFrame(FrameType type, uint32 id, const char* payload,
+                  size_t payload_len);
+  void QueueFrame(FrameType type, uint32 id, uint32 value,
+                  const std::string& payload);
+  void Flush();
+  void ReadFrames();
+  void ProcessFrame(uint8 type, uint32 id, const char* payload,
+                    size_t payload_len);
+  void OnStreamEvent(talk_base::StreamInterface* stream, int events,
+                     int error);
+  void CloseAll(int error);
+
+  talk_base::scoped_ptr<talk_base::StreamInterface> stream_;
+  StreamMap streams_;
+  // The incoming stream whose SignalIncomingStream is in progress.
+  MuxStream* pending_;
+  uint32 next_id_;
+  size_t stream_window_;
+  talk_base::ByteBuffer in_;
+  talk_base::ByteBuffer out_;
+  // Set when a logical stream was refused a write because |out_| was full.
+  bool write_blocked_;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamMultiplexer);
+};
+
+}  // namespace cricket
+
+#endif  // TALK_SESSION_TUNNEL_STREAMMULTIPLEXER_H_
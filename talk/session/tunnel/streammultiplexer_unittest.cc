@@ -0,0 +1,283 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include <vector>
+
+#include "talk/base/gunit.h"
+#include "talk/base/scoped_ptr.h"
+#include "talk/base/socket.h"
+#include "talk/base/stream.h"
+#include "talk/base/thread.h"
+#include "talk/session/tunnel/streammultiplexer.h"
+
+using cricket::StreamMultiplexer;
+using talk_base::StreamInterface;
+
+static const int kTimeoutMs = 10000;
+static const int kBlockSize = 4096;
+
+// One end of an in-memory, bidirectional stream. Events arrive
+// asynchronously, like they do from a PseudoTcpChannel.
+class PipeStream : public StreamInterface, public sigslot::has_slots<> {
+ public:
+  PipeStream(talk_base::FifoBuffer* in, talk_base::FifoBuffer* out)
+      : in_(in), out_(out) {
+    in_->SignalEvent.connect(this, &PipeStream::OnInEvent);
+    out_->SignalEvent.connect(this, &PipeStream::OnOutEvent);
+  }
+
+  virtual talk_base::StreamState GetState() const {
+    return talk_base::SS_OPEN;
+  }
+  virtual talk_base::StreamResult Read(void* buffer, size_t buffer_len,
+                                       size_t* read, int* error) {
+    return in_->Read(buffer, buffer_len, read, error);
+  }
+  virtual talk_base::StreamResult Write(const void* data, size_t data_len,
+                                        size_t* written, int* error) {
+    return out_->Write(data, data_len, written, error);
+  }
+  virtual void Close() {
+  }
+
+ private:
+  void OnInEvent(StreamInterface* stream, int events, int error) {
+    if (events & talk_base::SE_READ)
+      SignalEvent(this, talk_base::SE_READ, 0);
+  }
+  void OnOutEvent(StreamInterface* stream, int events, int error) {
+    if (events & talk_base::SE_WRITE)
+      SignalEvent(this, talk_base::SE_WRITE, 0);
+  }
+
+  talk_base::FifoBuffer* in_;
+  talk_base::FifoBuffer* out_;
+};
+
+// Sends a byte counter on one logical stream and checks it on the other.
+class StreamTransfer : public sigslot::has_slots<> {
+ public:
+  StreamTransfer(StreamInterface* sender, size_t size)
+      : sender_(sender), size_(size), sent_(0), received_(0),
+        corrupted_(0), opened_(false), closed_(false), close_error_(0),
+        read_enabled_(true) {
+    sender_->SignalEvent.connect(this, &StreamTransfer::OnSenderEvent);
+  }
+
+  void SetReceiver(StreamInterface* receiver) {
+    receiver_.reset(receiver);
+    receiver_->SignalEvent.connect(this, &StreamTransfer::OnReceiverEvent);
+  }
+  void EnableRead(bool enable) {
+    read_enabled_ = enable;
+    if (enable)
+      ReadData();
+  }
+
+  StreamInterface* sender() { return sender_.get(); }
+  size_t sent() const { return sent_; }
+  size_t received() const { return received_; }
+  size_t corrupted() const { return corrupted_; }
+  bool opened() const { return opened_; }
+  bool closed() const { return closed_; }
+  int close_error() const { return close_error_; }
+
+ private:
+  void OnSenderEvent(StreamInterface* stream, int events, int error) {
+    if (events & talk_base::SE_OPEN)
+      opened_ = true;
+    if (events & talk_base::SE_WRITE)
+      WriteData();
+    if (events & talk_base::SE_CLOSE) {
+      closed_ = true;
+      close_error_ = error;
+    }
+  }
+  void OnReceiverEvent(StreamInterface* stream, int events, int error) {
+    if (events & talk_base::SE_READ)
+      ReadData();
+    if (events & talk_base::SE_CLOSE) {
+      closed_ = true;
+      close_error_ = error;
+    }
+  }
+
+  void WriteData() {
+    char block[kBlockSize];
+    while (sent_ < size_) {
+      size_t tosend = std::min<size_t>(sizeof(block), size_ - sent_);
+      for (size_t i = 0; i < tosend; ++i)
+        block[i] = static_cast<char>(sent_ + i);
+      size_t written = 0;
+      if (sender_->Write(block, tosend, &written, NULL) !=
+          talk_base::SR_SUCCESS)
+        return;
+      sent_ += written;
+    }
+    sender_->Close();
+  }
+  void ReadData() {
+    char block[kBlockSize];
+    size_t read = 0;
+    while (read_enabled_ &&
+           receiver_->Read(block, sizeof(block), &read, NULL) ==
+           talk_base::SR_SUCCESS) {
+      for (size_t i = 0; i < read; ++i) {
+        if (block[i] != static_cast<char>(received_ + i))
+          ++corrupted_;
+      }
+      received_ += read;
+    }
+  }
+
+  talk_base::scoped_ptr<StreamInterface> sender_;
+  talk_base::scoped_ptr<StreamInterface> receiver_;
+  size_t size_, sent_, received_, corrupted_;
+  bool opened_, closed_;
+  int close_error_;
+  bool read_enabled_;
+};
+
+class StreamMultiplexerTest : public testing::Test,
+                              public sigslot::has_slots<> {
+ public:
+  StreamMultiplexerTest()
+      : local_to_remote_(64 * 1024),
+        remote_to_local_(64 * 1024),
+        local_pipe_(new PipeStream(&remote_to_local_, &local_to_remote_)),
+        local_(local_pipe_, true),
+        remote_(new PipeStream(&local_to_remote_, &remote_to_local_), false),
+        accept_(true),
+        incoming_(0) {
+    remote_.SignalIncomingStream.connect(this,
+        &StreamMultiplexerTest::OnIncomingStream);
+  }
+  ~StreamMultiplexerTest() {
+    for (size_t i = 0; i < transfers_.size(); ++i)
+      delete transfers_[i];
+  }
+
+  // Opens a stream from |local_| to |remote_| that sends |size| bytes.
+  StreamTransfer* StartTransfer(size_t size) {
+    StreamInterface* stream = local_.CreateStream("test");
+    EXPECT_TRUE(stream != NULL);
+    EXPECT_EQ(talk_base::SS_OPENING, stream->GetState());
+    transfers_.push_back(new StreamTransfer(stream, size));
+    return transfers_.back();
+  }
+
+  void OnIncomingStream(StreamMultiplexer* mux, uint32 id,
+                        const std::string& description) {
+    EXPECT_EQ(&remote_, mux);
+    EXPECT_EQ("test", description);
+    ++incoming_;
+    if (!accept_)
+      return;  // Leaving it alone rejects it.
+    // Streams arrive in the order they were opened.
+    ASSERT_LE(static_cast<size_t>(incoming_), transfers_.size());
+    transfers_[incoming_ - 1]->SetReceiver(remote_.AcceptStream(id));
+  }
+
+ protected:
+  talk_base::FifoBuffer local_to_remote_;
+  talk_base::FifoBuffer remote_to_local_;
+  PipeStream* local_pipe_;
+  StreamMultiplexer local_;
+  StreamMultiplexer remote_;
+  std::vector<StreamTransfer*> transfers_;
+  bool accept_;
+  int incoming_;
+};
+
+// Test a transfer on a single stream.
+TEST_F(StreamMultiplexerTest, TestTransfer) {
+  StreamTransfer* transfer = StartTransfer(1000000);
+  EXPECT_TRUE_WAIT(transfer->opened(), kTimeoutMs);
+  EXPECT_TRUE_WAIT(transfer->closed(), kTimeoutMs);
+  EXPECT_EQ(1000000U, transfer->received());
+  EXPECT_EQ(0U, transfer->corrupted());
+  EXPECT_EQ(0, transfer->close_error());
+  EXPECT_EQ(0U, local_.stream_count());
+  EXPECT_EQ(0U, remote_.stream_count());
+}
+
+// Test many concurrent transfers sharing the underlying stream.
+TEST_F(StreamMultiplexerTest, TestConcurrentTransfers) {
+  const int kStreams = 10;
+  for (int i = 0; i < kStreams; ++i)
+    StartTransfer(200000 + i * 1000);
+  for (int i = 0; i < kStreams; ++i) {
+    EXPECT_TRUE_WAIT(transfers_[i]->closed(), kTimeoutMs);
+    EXPECT_EQ(200000U + i * 1000, transfers_[i]->received());
+    EXPECT_EQ(0U, transfers_[i]->corrupted());
+  }
+  EXPECT_EQ(kStreams, incoming_);
+  EXPECT_EQ(0U, local_.stream_count());
+  EXPECT_EQ(0U, remote_.stream_count());
+}
+
+// Test that a rejected stream is closed with ECONNREFUSED.
+TEST_F(StreamMultiplexerTest, TestReject) {
+  accept_ = false;
+  StreamTransfer* transfer = StartTransfer(1000);
+  EXPECT_TRUE_WAIT(transfer->closed(), kTimeoutMs);
+  EXPECT_FALSE(transfer->opened());
+  EXPECT_EQ(ECONNREFUSED, transfer->close_error());
+  EXPECT_EQ(talk_base::SS_CLOSED, transfer->sender()->GetState());
+  EXPECT_EQ(0U, local_.stream_count());
+  EXPECT_EQ(0U, remote_.stream_count());
+}
+
+// Test that a stream whose reader stalls doesn't hold up the others, and
+// that its writer is held to the receive window.
+TEST_F(StreamMultiplexerTest, TestPerStreamFlowControl) {
+  remote_.set_stream_window(16 * 1024);
+  StreamTransfer* stalled = StartTransfer(1000000);
+  StreamTransfer* other = StartTransfer(1000000);
+  stalled->EnableRead(false);
+  EXPECT_TRUE_WAIT(other->closed(), kTimeoutMs);
+  EXPECT_EQ(1000000U, other->received());
+  EXPECT_FALSE(stalled->closed());
+  EXPECT_EQ(0U, stalled->received());
+  EXPECT_EQ(16U * 1024, stalled->sent());
+
+  stalled->EnableRead(true);
+  EXPECT_TRUE_WAIT(stalled->closed(), kTimeoutMs);
+  EXPECT_EQ(1000000U, stalled->received());
+  EXPECT_EQ(0U, stalled->corrupted());
+}
+
+// Test that closing the underlying stream closes the logical streams.
+TEST_F(StreamMultiplexerTest, TestUnderlyingClose) {
+  StreamTransfer* transfer = StartTransfer(100000000);
+  EXPECT_TRUE_WAIT(transfer->received() > 0, kTimeoutMs);
+  local_pipe_->SignalEvent(local_pipe_, talk_base::SE_CLOSE, ECONNRESET);
+  EXPECT_TRUE_WAIT(transfer->closed(), kTimeoutMs);
+  EXPECT_EQ(ECONNRESET, transfer->close_error());
+  EXPECT_EQ(0U, local_.stream_count());
+}
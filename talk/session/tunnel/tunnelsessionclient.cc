@@ -40,8 +40,8 @@
 namespace cricket {
 
 const char NS_TUNNEL[] = "http://www.google.com/talk/tunnel";
-const buzz::StaticQName QN_TUNNEL_DESCRIPTION = { NS_TUNNEL, "description" };
-const buzz::StaticQName QN_TUNNEL_TYPE = { NS_TUNNEL, "type" };
+const buzz::StaticQName QN_TUNNEL_DESCRIPTION(NS_TUNNEL, "description");
+const buzz::StaticQName QN_TUNNEL_TYPE(NS_TUNNEL, "type");
 const char CN_TUNNEL[] = "tunnel";
 
 enum {
@@ -27,69 +27,316 @@
 
 #include "talk/xmllite/qname.h"
 
+#include <string.h>
+#include <vector>
+
+#include "talk/base/basictypes.h"
+#include "talk/base/criticalsection.h"
+
 namespace buzz {
 
-QName::QName() {
+namespace {
+
+// Names read from one stream that a QNameCache keeps. Past this, new names
+// still work, they just get an entry of their own.
+const size_t kMaxCachedNames = 1024;
+const size_t kInitialBuckets = 64;
+
+size_t HashName(const char* ns, size_t ns_len,
+                const char* local, size_t local_len) {
+  // FNV-1a over the namespace, a separator and the local part.
+  size_t hash = 2166136261u;
+  for (size_t i = 0; i < ns_len; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(ns[i])) * 16777619u;
+  }
+  hash = (hash ^ ':') * 16777619u;
+  for (size_t i = 0; i < local_len; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(local[i])) * 16777619u;
+  }
+  return hash;
+}
+
+void AddRef(const QNameEntry* entry) {
+  if (!entry->interned)
+    talk_base::AtomicOps::Increment(&entry->ref_count);
+}
+
+void Release(const QNameEntry* entry) {
+  if (!entry->interned &&
+      talk_base::AtomicOps::Decrement(&entry->ref_count) == 0)
+    delete entry;
+}
+
+}  // namespace
+
+// A hash table of entries, which it neither owns nor references.
+class QNameTable {
+ public:
+  // A |max_count| of 0 means no limit.
+  explicit QNameTable(size_t max_count)
+      : buckets_(kInitialBuckets), count_(0), max_count_(max_count) {
+  }
+
+  ~QNameTable() {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      Node* node = buckets_[i];
+      while (node) {
+        Node* next = node->next;
+        delete node;
+        node = next;
+      }
+    }
+  }
+
+  const QNameEntry* Find(const char* ns, size_t ns_len,
+                         const char* local, size_t local_len,
+                         size_t hash) const {
+    for (Node* node = buckets_[hash & (buckets_.size() - 1)]; node;
+         node = node->next) {
+      const QNameEntry* entry = node->entry;
+      if (entry->hash == hash &&
+          entry->ns.length() == ns_len &&
+          entry->local.length() == local_len &&
+          memcmp(entry->ns.data(), ns, ns_len) == 0 &&
+          memcmp(entry->local.data(), local, local_len) == 0) {
+        return entry;
+      }
+    }
+    return NULL;
+  }
+
+  // Returns false if the table is full.
+  bool Add(const QNameEntry* entry) {
+    if (max_count_ && count_ >= max_count_) {
+      return false;
+    }
+    Node** bucket = &buckets_[entry->hash & (buckets_.size() - 1)];
+    Node* node = new Node;
+    node->entry = entry;
+    node->next = *bucket;
+    *bucket = node;
+    if (++count_ > buckets_.size()) {
+      Grow();
+    }
+    return true;
+  }
+
+  // Calls |f| with each entry.
+  template <class F> void ForEach(F f) const {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      for (Node* node = buckets_[i]; node; node = node->next) {
+        f(node->entry);
+      }
+    }
+  }
+
+  size_t count() const { return count_; }
+
+ private:
+  struct Node {
+    const QNameEntry* entry;
+    Node* next;
+  };
+
+  // Doubles the buckets.
+  void Grow() {
+    std::vector<Node*> buckets(buckets_.size() * 2);
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      Node* node = buckets_[i];
+      while (node) {
+        Node* next = node->next;
+        Node** bucket = &buckets[node->entry->hash & (buckets.size() - 1)];
+        node->next = *bucket;
+        *bucket = node;
+        node = next;
+      }
+    }
+    buckets_.swap(buckets);
+  }
+
+  std::vector<Node*> buckets_;
+  size_t count_;
+  size_t max_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(QNameTable);
+};
+
+namespace {
+
+// The interned entries of all the StaticQNames. They are added as the
+// StaticQNames are constructed, and looked up by QNameCaches when they first
+// see a name, so the lock is taken once per distinct name per stream.
+class StaticQNameTable {
+ public:
+  StaticQNameTable() : table_(0) {
+    empty_ = Intern("", "");
+  }
+
+  const QNameEntry* Intern(const char* ns, const char* local) {
+    size_t ns_len = strlen(ns);
+    size_t local_len = strlen(local);
+    size_t hash = HashName(ns, ns_len, local, local_len);
+    talk_base::CritScope cs(&crit_);
+    const QNameEntry* entry = table_.Find(ns, ns_len, local, local_len, hash);
+    if (!entry) {
+      entry = new QNameEntry(ns, ns_len, local, local_len, hash, true);
+      table_.Add(entry);
+    }
+    return entry;
+  }
+
+  const QNameEntry* Find(const char* ns, size_t ns_len,
+                         const char* local, size_t local_len, size_t hash) {
+    talk_base::CritScope cs(&crit_);
+    return table_.Find(ns, ns_len, local, local_len, hash);
+  }
+
+  const QNameEntry* empty() const { return empty_; }
+
+  size_t count() {
+    talk_base::CritScope cs(&crit_);
+    return table_.count();
+  }
+
+ private:
+  talk_base::CriticalSection crit_;
+  QNameTable table_;
+  const QNameEntry* empty_;
+};
+
+StaticQNameTable& StaticTable() {
+  // Interned entries are never freed, so neither is the table.
+  LIBJINGLE_DEFINE_STATIC_LOCAL(StaticQNameTable, table, ());
+  return table;
+}
+
+}  // namespace
+
+StaticQName::StaticQName(const char* ns, const char* local)
+    : ns(ns), local(local), entry(StaticTable().Intern(ns, local)) {
+}
+
+QName::QName() : entry_(StaticTable().empty()) {
+}
+
+QName::QName(const QName& qname) : entry_(qname.entry_) {
+  AddRef(entry_);
 }
 
-QName::QName(const QName& qname)
-    : namespace_(qname.namespace_),
-      local_part_(qname.local_part_) {
+QName::QName(const StaticQName& const_value) : entry_(const_value.entry) {
 }
 
-QName::QName(const StaticQName& const_value)
-    : namespace_(const_value.ns),
-      local_part_(const_value.local) {
+QName::QName(const std::string& ns, const std::string& local) {
+  Init(ns.data(), ns.length(), local.data(), local.length());
 }
 
-QName::QName(const std::string& ns, const std::string& local)
-    : namespace_(ns),
-      local_part_(local) {
+QName::QName(const std::string& ns, const char* local) {
+  Init(ns.data(), ns.length(), local, strlen(local));
 }
 
 QName::QName(const std::string& merged_or_local) {
   size_t i = merged_or_local.rfind(':');
   if (i == std::string::npos) {
-    local_part_ = merged_or_local;
+    Init("", 0, merged_or_local.data(), merged_or_local.length());
   } else {
-    namespace_ = merged_or_local.substr(0, i);
-    local_part_ = merged_or_local.substr(i + 1);
+    Init(merged_or_local.data(), i,
+         merged_or_local.data() + i + 1, merged_or_local.length() - i - 1);
   }
 }
 
+QName::QName(const QNameEntry* entry) : entry_(entry) {
+  AddRef(entry_);
+}
+
 QName::~QName() {
+  Release(entry_);
+}
+
+QName& QName::operator=(const QName& qname) {
+  if (entry_ != qname.entry_) {
+    AddRef(qname.entry_);
+    Release(entry_);
+    entry_ = qname.entry_;
+  }
+  return *this;
+}
+
+void QName::Init(const char* ns, size_t ns_len,
+                 const char* local, size_t local_len) {
+  entry_ = new QNameEntry(ns, ns_len, local, local_len, 0, false);
+}
+
+size_t QName::InternedCount() {
+  return StaticTable().count();
 }
 
 std::string QName::Merged() const {
-  if (namespace_[0] == '\0')
-    return local_part_;
+  if (entry_->ns.empty())
+    return entry_->local;
 
   std::string result;
-  result.reserve(namespace_.length() + 1 + local_part_.length());
-  result += namespace_;
+  result.reserve(entry_->ns.length() + 1 + entry_->local.length());
+  result += entry_->ns;
   result += ':';
-  result += local_part_;
+  result += entry_->local;
   return result;
 }
 
 bool QName::IsEmpty() const {
-  return namespace_.empty() && local_part_.empty();
+  return entry_->ns.empty() && entry_->local.empty();
 }
 
 int QName::Compare(const StaticQName& other) const {
-  int result = local_part_.compare(other.local);
-  if (result != 0)
-    return result;
-
-  return namespace_.compare(other.ns);
+  return Compare(other.entry);
 }
 
 int QName::Compare(const QName& other) const {
-  int result = local_part_.compare(other.local_part_);
+  return Compare(other.entry_);
+}
+
+int QName::Compare(const QNameEntry* other) const {
+  if (entry_ == other)
+    return 0;
+
+  int result = entry_->local.compare(other->local);
   if (result != 0)
     return result;
 
-  return namespace_.compare(other.namespace_);
+  return entry_->ns.compare(other->ns);
+}
+
+QNameCache::QNameCache() : table_(new QNameTable(kMaxCachedNames)) {
+}
+
+QNameCache::~QNameCache() {
+  table_->ForEach(Release);
+}
+
+QName QNameCache::Resolve(const std::string& ns, const char* local) {
+  size_t local_len = strlen(local);
+  size_t hash = HashName(ns.data(), ns.length(), local, local_len);
+  const QNameEntry* entry =
+      table_->Find(ns.data(), ns.length(), local, local_len, hash);
+  if (entry) {
+    return QName(entry);
+  }
+
+  entry = StaticTable().Find(ns.data(), ns.length(), local, local_len, hash);
+  if (!entry) {
+    entry = new QNameEntry(ns.data(), ns.length(), local, local_len, hash,
+                           false);
+  }
+  // The cache keeps the new entry's reference, unless it is full.
+  if (!table_->Add(entry)) {
+    QName name(entry);
+    Release(entry);
+    return name;
+  }
+  return QName(entry);
+}
+
+size_t QNameCache::count() const {
+  return table_->count();
 }
 
 }  // namespace buzz
@@ -28,73 +28,153 @@
 #ifndef TALK_XMLLITE_QNAME_H_
 #define TALK_XMLLITE_QNAME_H_
 
+#include <stddef.h>
 #include <string>
 
+#include "talk/base/constructormagic.h"
+#include "talk/base/scoped_ptr.h"
+
 namespace buzz {
 
 class QName;
+class QNameTable;
+
+// The strings of a QName, shared by copies of the name. Interned entries
+// belong to StaticQNames and live for the rest of the process; each distinct
+// static name has exactly one. Other entries are reference counted.
+struct QNameEntry {
+  QNameEntry(const char* ns, size_t ns_len,
+             const char* local, size_t local_len,
+             size_t hash, bool interned)
+      : ns(ns, ns_len), local(local, local_len),
+        hash(hash), interned(interned), ref_count(1) {
+  }
 
-// StaticQName is used to represend constant quailified names. They
-// can be initialized statically and don't need intializers code, e.g.
-//   const StaticQName QN_FOO = { "foo_namespace", "foo" };
+  std::string ns;
+  std::string local;
+  size_t hash;
+  bool interned;
+  mutable int ref_count;  // Unused for interned entries.
+};
+
+// StaticQName is used to represent constant qualified names, defined at
+// namespace scope, e.g.
+//   const StaticQName QN_FOO("foo_namespace", "foo");
 //
-// Beside this use case, QName should be used everywhere
-// else. StaticQName instances are implicitly converted to QName
+// Each is interned when it is constructed, so it must not be used by static
+// initializers in other files. Beside this use case, QName should be used
+// everywhere else. StaticQName instances are implicitly converted to QName
 // objects.
 struct StaticQName {
+  StaticQName(const char* ns, const char* local);
+
   const char* const ns;
   const char* const local;
+  const QNameEntry* const entry;
 
   bool operator==(const QName& other) const;
   bool operator!=(const QName& other) const;
 };
 
+// QName is a namespace qualified name. Copies share one entry. A name built
+// from a StaticQName, or resolved by a QNameCache to the same strings, shares
+// the static name's interned entry, so comparing it with a constant is a
+// pointer compare. Other names compare by string.
 class QName {
  public:
   QName();
   QName(const QName& qname);
   QName(const StaticQName& const_value);
   QName(const std::string& ns, const std::string& local);
+  QName(const std::string& ns, const char* local);
   explicit QName(const std::string& merged_or_local);
   ~QName();
 
-  const std::string& Namespace() const { return namespace_; }
-  const std::string& LocalPart() const { return local_part_; }
+  QName& operator=(const QName& qname);
+
+  const std::string& Namespace() const { return entry_->ns; }
+  const std::string& LocalPart() const { return entry_->local; }
   std::string Merged() const;
   bool IsEmpty() const;
+  bool IsInterned() const { return entry_->interned; }
 
   int Compare(const StaticQName& other) const;
   int Compare(const QName& other) const;
+  bool Equals(const StaticQName& other) const {
+    return Equals(other.entry);
+  }
+  bool Equals(const QName& other) const {
+    return Equals(other.entry_);
+  }
 
   bool operator==(const StaticQName& other) const {
-    return Compare(other) == 0;
+    return Equals(other);
   }
   bool operator==(const QName& other) const {
-    return Compare(other) == 0;
+    return Equals(other);
   }
   bool operator!=(const StaticQName& other) const {
-    return Compare(other) != 0;
+    return !Equals(other);
   }
   bool operator!=(const QName& other) const {
-    return Compare(other) != 0;
+    return !Equals(other);
   }
   bool operator<(const QName& other) const {
     return Compare(other) < 0;
   }
 
+  // Number of distinct static names.
+  static size_t InternedCount();
+
  private:
-  std::string namespace_;
-  std::string local_part_;
+  friend class QNameCache;
+
+  // Takes a reference to |entry|.
+  explicit QName(const QNameEntry* entry);
+
+  void Init(const char* ns, size_t ns_len,
+            const char* local, size_t local_len);
+  bool Equals(const QNameEntry* other) const {
+    if (entry_ == other)
+      return true;
+    if (entry_->interned && other->interned)
+      return false;
+    return Compare(other) == 0;
+  }
+  int Compare(const QNameEntry* other) const;
+
+  const QNameEntry* entry_;
 };
 
 inline bool StaticQName::operator==(const QName& other) const {
-  return other.Compare(*this) == 0;
+  return other.Equals(*this);
 }
 
 inline bool StaticQName::operator!=(const QName& other) const {
-  return other.Compare(*this) != 0;
+  return !other.Equals(*this);
 }
 
+// QNameCache resolves the names read from one stream, such as by a parser.
+// A name equal to a StaticQName gets the static name's entry. Other names
+// are cached, up to a limit, so that repeats share one entry; they are kept
+// here rather than in a global table, so a peer cannot make the process hold
+// them after the stream is gone. A QNameCache is not thread safe.
+class QNameCache {
+ public:
+  QNameCache();
+  ~QNameCache();
+
+  QName Resolve(const std::string& ns, const char* local);
+
+  // Number of names cached.
+  size_t count() const;
+
+ private:
+  talk_base::scoped_ptr<QNameTable> table_;
+
+  DISALLOW_COPY_AND_ASSIGN(QNameCache);
+};
+
 }  // namespace buzz
 
 #endif  // TALK_XMLLITE_QNAME_H_
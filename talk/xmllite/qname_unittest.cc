@@ -25,6 +25,7 @@
  * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sstream>
 #include <string>
 #include "talk/base/gunit.h"
 #include "talk/xmllite/qname.h"
@@ -71,7 +72,7 @@ TEST(QNameTest, TestAssignment) {
 }
 
 TEST(QNameTest, TestConstAssignment) {
-  StaticQName name = { "a", "test" };
+  StaticQName name("a", "test");
   QName namecopy(name);
   EXPECT_EQ(namecopy.LocalPart(), "test");
   EXPECT_EQ(namecopy.Namespace(), "a");
@@ -108,8 +109,8 @@ TEST(QNameTest, TestCompare) {
 }
 
 TEST(QNameTest, TestStaticQName) {
-  const StaticQName const_name1 = { "namespace", "local-name1" };
-  const StaticQName const_name2 = { "namespace", "local-name2" };
+  const StaticQName const_name1("namespace", "local-name1");
+  const StaticQName const_name2("namespace", "local-name2");
   const QName name("namespace", "local-name1");
   const QName name1 = const_name1;
   const QName name2 = const_name2;
@@ -129,3 +130,81 @@ TEST(QNameTest, TestStaticQName) {
   EXPECT_TRUE(name != name2);
   EXPECT_TRUE(name2 != name);
 }
+
+TEST(QNameTest, TestInterned) {
+  size_t count = QName::InternedCount();
+  static const StaticQName kStaticName("a-very:long:namespace", "test");
+  static const StaticQName kStaticName2("a-very:long:namespace", "test");
+  EXPECT_EQ(count + 1, QName::InternedCount());
+  EXPECT_EQ(kStaticName.entry, kStaticName2.entry);
+
+  // Names built from static names share their entry.
+  QName name(kStaticName);
+  QName name2;
+  name2 = kStaticName2;
+  EXPECT_TRUE(name.IsInterned());
+  EXPECT_EQ(&name.LocalPart(), &name2.LocalPart());
+  EXPECT_TRUE(name == kStaticName);
+
+  // Names built from strings are not interned, but still compare equal.
+  QName name3("a-very:long:namespace", "test");
+  QName name4("a-very:long:namespace:test");
+  EXPECT_FALSE(name3.IsInterned());
+  EXPECT_EQ(count + 1, QName::InternedCount());
+  EXPECT_TRUE(name3 == kStaticName);
+  EXPECT_TRUE(kStaticName == name4);
+  EXPECT_FALSE(name != name3);
+  EXPECT_TRUE(name != QName("a-very:long:namespace", "test2"));
+
+  // Copies share one entry.
+  QName copy(name3);
+  QName copy2;
+  copy2 = copy;
+  EXPECT_EQ(&name3.LocalPart(), &copy.LocalPart());
+  EXPECT_EQ(&name3.LocalPart(), &copy2.LocalPart());
+  EXPECT_TRUE(QName().IsEmpty());
+  EXPECT_EQ(&QName().Namespace(), &QName().Namespace());
+}
+
+TEST(QNameTest, TestCache) {
+  static const StaticQName kStaticName("cached-static", "test");
+  size_t count = QName::InternedCount();
+  buzz::QNameCache cache;
+
+  // Static names resolve to their entry, without being cached again.
+  QName name = cache.Resolve("cached-static", "test");
+  EXPECT_TRUE(name.IsInterned());
+  EXPECT_EQ(&name.LocalPart(), &QName(kStaticName).LocalPart());
+
+  // Other names share one entry per cache, and stay out of the interned
+  // names.
+  QName peer = cache.Resolve("peer", "test");
+  EXPECT_FALSE(peer.IsInterned());
+  EXPECT_EQ(&peer.LocalPart(), &cache.Resolve("peer", "test").LocalPart());
+  EXPECT_TRUE(peer == QName("peer", "test"));
+  EXPECT_TRUE(peer != kStaticName);
+  EXPECT_EQ(count, QName::InternedCount());
+
+  // Past the limit, new names get entries of their own.
+  for (int i = 0; i < 5000; ++i) {
+    std::ostringstream local;
+    local << "filler" << i;
+    cache.Resolve("filler", local.str().c_str());
+  }
+  EXPECT_LT(cache.count(), 5000U);
+  QName last = cache.Resolve("peer", "uncached");
+  EXPECT_NE(&last.LocalPart(), &cache.Resolve("peer", "uncached").LocalPart());
+  EXPECT_TRUE(last == QName("peer", "uncached"));
+  EXPECT_EQ(&peer.LocalPart(), &cache.Resolve("peer", "test").LocalPart());
+  EXPECT_EQ(count, QName::InternedCount());
+}
+
+TEST(QNameTest, TestOutlivesCache) {
+  QName name;
+  {
+    buzz::QNameCache cache;
+    name = cache.Resolve("peer", "test");
+  }
+  EXPECT_EQ("peer", name.Namespace());
+  EXPECT_EQ("test", name.LocalPart());
+}
@@ -0,0 +1,145 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/xmllite/xmlarena.h"
+
+#include "talk/base/common.h"
+
+namespace buzz {
+
+namespace {
+
+// Stored in front of every node. The union keeps the node that follows it
+// aligned for any member type.
+union NodeHeader {
+  XmlArena* arena;
+  double align;
+};
+
+const size_t kAlignment = sizeof(NodeHeader);
+
+size_t AlignSize(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+}  // namespace
+
+XmlArena::XmlArena()
+    : block_size_(kDefaultBlockSize),
+      current_(NULL),
+      remaining_(0),
+      live_objects_(0),
+      bytes_allocated_(0),
+      blocks_allocated_(0) {
+}
+
+XmlArena::XmlArena(size_t block_size)
+    : block_size_(block_size),
+      current_(NULL),
+      remaining_(0),
+      live_objects_(0),
+      bytes_allocated_(0),
+      blocks_allocated_(0) {
+}
+
+XmlArena::~XmlArena() {
+  ASSERT(live_objects_ == 0);
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    delete [] blocks_[i];
+  }
+}
+
+void* XmlArena::Allocate(size_t size) {
+  size = AlignSize(size);
+  if (size > remaining_) {
+    // Requests larger than a block get a block of their own.
+    size_t block_size = talk_base::_max(size, block_size_);
+    char* block = new char[block_size];
+    blocks_.push_back(block);
+    ++blocks_allocated_;
+    current_ = block;
+    remaining_ = block_size;
+  }
+  void* result = current_;
+  current_ += size;
+  remaining_ -= size;
+  bytes_allocated_ += size;
+  return result;
+}
+
+void XmlArena::Reset() {
+  ASSERT(live_objects_ == 0);
+  if (blocks_.empty()) {
+    return;
+  }
+  // Keep the first block, which is large enough for most stanzas.
+  for (size_t i = 1; i < blocks_.size(); ++i) {
+    delete [] blocks_[i];
+  }
+  blocks_.resize(1);
+  current_ = blocks_[0];
+  remaining_ = block_size_;
+  bytes_allocated_ = 0;
+}
+
+void* XmlArenaObject::operator new(size_t size) {
+  NodeHeader* header = static_cast<NodeHeader*>(
+      ::operator new(sizeof(NodeHeader) + size));
+  header->arena = NULL;
+  return header + 1;
+}
+
+void* XmlArenaObject::operator new(size_t size, XmlArena* arena) {
+  if (!arena) {
+    return operator new(size);
+  }
+  NodeHeader* header = static_cast<NodeHeader*>(
+      arena->Allocate(sizeof(NodeHeader) + size));
+  header->arena = arena;
+  ++arena->live_objects_;
+  return header + 1;
+}
+
+void XmlArenaObject::operator delete(void* object) {
+  if (!object) {
+    return;
+  }
+  NodeHeader* header = static_cast<NodeHeader*>(object) - 1;
+  if (header->arena) {
+    // The memory goes back when the arena is reset.
+    --header->arena->live_objects_;
+  } else {
+    ::operator delete(header);
+  }
+}
+
+void XmlArenaObject::operator delete(void* object, XmlArena* arena) {
+  UNUSED(arena);
+  operator delete(object);
+}
+
+}  // namespace buzz
@@ -0,0 +1,92 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_XMLLITE_XMLARENA_H_
+#define TALK_XMLLITE_XMLARENA_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include "talk/base/constructormagic.h"
+
+namespace buzz {
+
+// XmlArena is a bump allocator for the nodes of an XmlElement tree. All the
+// nodes of a parsed stanza are carved from a few large blocks which are
+// released in one shot by Reset, instead of being freed one by one.
+// The nodes are still destroyed with delete, which runs their destructors
+// but leaves the memory to the arena. XmlArena is not thread safe.
+class XmlArena {
+ public:
+  static const size_t kDefaultBlockSize = 8 * 1024;
+
+  XmlArena();
+  explicit XmlArena(size_t block_size);
+  ~XmlArena();
+
+  // Returns size bytes aligned for any node type.
+  void* Allocate(size_t size);
+  // Releases all the memory handed out so far, keeping the first block for
+  // reuse. All the nodes allocated from the arena must have been deleted.
+  void Reset();
+
+  // Number of nodes allocated and not yet deleted.
+  int live_objects() const { return live_objects_; }
+  // Bytes handed out since the last Reset.
+  size_t bytes_allocated() const { return bytes_allocated_; }
+  // Blocks allocated from the heap over the lifetime of the arena.
+  int blocks_allocated() const { return blocks_allocated_; }
+
+ private:
+  friend class XmlArenaObject;
+
+  std::vector<char*> blocks_;
+  size_t block_size_;
+  char* current_;
+  size_t remaining_;
+  int live_objects_;
+  size_t bytes_allocated_;
+  int blocks_allocated_;
+
+  DISALLOW_COPY_AND_ASSIGN(XmlArena);
+};
+
+// Base of the XML node classes which lets them be allocated either from the
+// heap with the usual new, or from an arena with new (arena). Each node is
+// preceded by the arena it came from so that delete does the right thing in
+// both cases.
+class XmlArenaObject {
+ public:
+  static void* operator new(size_t size);
+  static void* operator new(size_t size, XmlArena* arena);
+  static void operator delete(void* object);
+  static void operator delete(void* object, XmlArena* arena);
+};
+
+}  // namespace buzz
+
+#endif  // TALK_XMLLITE_XMLARENA_H_
@@ -0,0 +1,101 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include "talk/base/gunit.h"
+#include "talk/base/scoped_ptr.h"
+#include "talk/xmllite/xmlarena.h"
+#include "talk/xmllite/xmlbuilder.h"
+#include "talk/xmllite/xmlelement.h"
+#include "talk/xmllite/xmlparser.h"
+
+using buzz::QName;
+using buzz::XmlArena;
+using buzz::XmlBuilder;
+using buzz::XmlElement;
+using buzz::XmlParser;
+
+static const char kStanza[] =
+    "<iq xmlns='jabber:client' type='result' id='42'>"
+    "<query xmlns='jabber:iq:roster'>"
+    "<item jid='a@b.c' name='A'>text<group>friends</group></item>"
+    "</query></iq>";
+
+TEST(XmlArenaTest, TestAllocate) {
+  XmlArena arena(256);
+  char* first = static_cast<char*>(arena.Allocate(3));
+  char* second = static_cast<char*>(arena.Allocate(16));
+  EXPECT_EQ(0u, reinterpret_cast<size_t>(second) % sizeof(double));
+  EXPECT_LT(first, second);
+  EXPECT_EQ(1, arena.blocks_allocated());
+
+  // Larger than a block gets its own block.
+  arena.Allocate(1024);
+  EXPECT_EQ(2, arena.blocks_allocated());
+
+  // Reset keeps the first block and hands it out again.
+  arena.Reset();
+  EXPECT_EQ(0u, arena.bytes_allocated());
+  EXPECT_EQ(first, arena.Allocate(8));
+  EXPECT_EQ(2, arena.blocks_allocated());
+}
+
+TEST(XmlArenaTest, TestBuildInArena) {
+  XmlArena arena;
+  XmlBuilder builder;
+  builder.set_arena(&arena);
+  XmlParser::ParseXml(&builder, kStanza);
+  talk_base::scoped_ptr<XmlElement> element(builder.CreateElement());
+  ASSERT_TRUE(element.get() != NULL);
+  talk_base::scoped_ptr<XmlElement> heap_element(XmlElement::ForStr(kStanza));
+
+  // The tree reads the same as one built on the heap.
+  EXPECT_EQ(heap_element->Str(), element->Str());
+  EXPECT_EQ("42", element->Attr(QName("", "id")));
+  EXPECT_EQ("friends",
+            element->FirstElement()->FirstElement()->TextNamed(
+                QName("jabber:iq:roster", "group")));
+  int live_objects = arena.live_objects();
+  EXPECT_LT(0, live_objects);
+  EXPECT_EQ(1, arena.blocks_allocated());
+
+  // Copies go to the heap.
+  talk_base::scoped_ptr<XmlElement> copy(new XmlElement(*element));
+  EXPECT_EQ(live_objects, arena.live_objects());
+
+  // Nodes the element creates later come from the same arena, while the
+  // elements handed to it keep their own allocation.
+  element->AddElement(new XmlElement(QName("", "heap")));
+  element->FindOrAddNamedChild(QName("", "arena"))->SetAttr(
+      QName("", "a"), "b");
+  EXPECT_EQ(live_objects + 2, arena.live_objects());
+
+  element.reset();
+  EXPECT_EQ(0, arena.live_objects());
+  arena.Reset();
+  EXPECT_EQ(heap_element->Str(), copy->Str());
+}
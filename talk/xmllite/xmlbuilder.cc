@@ -38,7 +38,8 @@ namespace buzz {
 XmlBuilder::XmlBuilder() :
   pelCurrent_(NULL),
   pelRoot_(NULL),
-  pvParents_(new std::vector<XmlElement *>()) {
+  pvParents_(new std::vector<XmlElement *>()),
+  arena_(NULL) {
 }
 
 void
@@ -51,11 +52,18 @@ XmlBuilder::Reset() {
 XmlElement *
 XmlBuilder::BuildElement(XmlParseContext * pctx,
                               const char * name, const char ** atts) {
+  return BuildElement(pctx, name, atts, NULL);
+}
+
+XmlElement *
+XmlBuilder::BuildElement(XmlParseContext * pctx,
+                              const char * name, const char ** atts,
+                              XmlArena * arena) {
   QName tagName(pctx->ResolveQName(name, false));
   if (tagName.IsEmpty())
     return NULL;
 
-  XmlElement * pelNew = new XmlElement(tagName);
+  XmlElement * pelNew = XmlElement::CreateInArena(tagName, arena);
 
   if (!*atts)
     return pelNew;
@@ -88,7 +96,7 @@ XmlBuilder::BuildElement(XmlParseContext * pctx,
 void
 XmlBuilder::StartElement(XmlParseContext * pctx,
                               const char * name, const char ** atts) {
-  XmlElement * pelNew = BuildElement(pctx, name, atts);
+  XmlElement * pelNew = BuildElement(pctx, name, atts, arena_);
   if (pelNew == NULL) {
     pctx->RaiseError(XML_ERROR_SYNTAX);
     return;
@@ -41,6 +41,7 @@
 
 namespace buzz {
 
+class XmlArena;
 class XmlElement;
 class XmlParseContext;
 
@@ -51,6 +52,10 @@ public:
 
   static XmlElement * BuildElement(XmlParseContext * pctx,
                                   const char * name, const char ** atts);
+  // Same, but the element and its attributes are allocated from arena.
+  static XmlElement * BuildElement(XmlParseContext * pctx,
+                                  const char * name, const char ** atts,
+                                  XmlArena * arena);
   virtual void StartElement(XmlParseContext * pctx,
                             const char * name, const char ** atts);
   virtual void EndElement(XmlParseContext * pctx, const char * name);
@@ -61,6 +66,11 @@ public:
 
   void Reset();
 
+  // Allocate the elements built from now on from arena, or from the heap if
+  // arena is NULL. The built element must be deleted before the arena is
+  // reset.
+  void set_arena(XmlArena * arena) { arena_ = arena; }
+
   // Take ownership of the built element; second call returns NULL
   XmlElement * CreateElement();
 
@@ -71,6 +81,7 @@ private:
   XmlElement * pelCurrent_;
   talk_base::scoped_ptr<XmlElement> pelRoot_;
   talk_base::scoped_ptr<std::vector<XmlElement*> > pvParents_;
+  XmlArena * arena_;
 };
 
 }
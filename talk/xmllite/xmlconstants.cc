@@ -37,6 +37,6 @@ const char STR_XML[] = "xml";
 const char STR_VERSION[] = "version";
 const char STR_ENCODING[] = "encoding";
 
-const StaticQName QN_XMLNS = { STR_EMPTY, STR_XMLNS };
+const StaticQName QN_XMLNS(STR_EMPTY, STR_XMLNS);
 
 }  // namespace buzz
@@ -33,6 +33,7 @@
 
 #include "talk/base/scoped_ptr.h"
 #include "talk/xmllite/qname.h"
+#include "talk/xmllite/xmlarena.h"
 
 namespace buzz {
 
@@ -41,7 +42,7 @@ class XmlText;
 class XmlElement;
 class XmlAttr;
 
-class XmlChild {
+class XmlChild : public XmlArenaObject {
  public:
   XmlChild* NextChild() { return next_child_; }
   const XmlChild* NextChild() const { return next_child_; }
@@ -105,7 +106,7 @@ class XmlText : public XmlChild {
   std::string text_;
 };
 
-class XmlAttr {
+class XmlAttr : public XmlArenaObject {
  public:
   XmlAttr* NextAttr() const { return next_attr_; }
   const QName& Name() const { return name_; }
@@ -138,6 +139,11 @@ class XmlElement : public XmlChild {
 
   virtual ~XmlElement();
 
+  // Creates an element whose nodes, including the attributes and children
+  // added to it later, are allocated from the arena. The element must be
+  // deleted before the arena is reset. Copies are allocated from the heap.
+  static XmlElement* CreateInArena(const QName& name, XmlArena* arena);
+
   const QName& Name() const { return name_; }
   void SetName(const QName& name) { name_ = name; }
 
@@ -243,6 +249,7 @@ class XmlElement : public XmlChild {
   XmlAttr* last_attr_;
   XmlChild* first_child_;
   XmlChild* last_child_;
+  XmlArena* arena_;  // Where new nodes are allocated, NULL for the heap.
   bool cdata_;
 };
 
@@ -199,6 +199,7 @@ XmlParser::ParseXml(XmlParseHandler *pxph, std::string text) {
 XmlParser::ParseContext::ParseContext(XmlParser *parser) :
     parser_(parser),
     xmlnsstack_(),
+    qnames_(),
     raised_(XML_ERROR_NONE),
     line_number_(0),
     column_number_(0),
@@ -229,17 +230,17 @@ XmlParser::ParseContext::ResolveQName(const char* qname, bool isAttr) {
           xmlnsstack_.NsForPrefix(std::string(qname, c - qname));
       if (!result.second)
         return QName();
-      return QName(result.first, c + 1);
+      return qnames_.Resolve(result.first, c + 1);
     }
   }
   if (isAttr)
-    return QName(STR_EMPTY, qname);
+    return qnames_.Resolve(STR_EMPTY, qname);
 
   std::pair<std::string, bool> result = xmlnsstack_.NsForPrefix(STR_EMPTY);
   if (!result.second)
     return QName();
 
-  return QName(result.first, qname);
+  return qnames_.Resolve(result.first, qname);
 }
 
 void
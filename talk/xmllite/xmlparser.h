@@ -104,6 +104,7 @@ private:
   private:
     const XmlParser * parser_;
     XmlnsStack xmlnsstack_;
+    QNameCache qnames_;
     XML_Error raised_;
     XML_Size line_number_;
     XML_Size column_number_;
@@ -27,10 +27,13 @@
 
 #include "talk/xmllite/xmlprinter.h"
 
-#include <sstream>
+#include <string.h>
+
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include "talk/base/basictypes.h"
 #include "talk/xmllite/xmlconstants.h"
 #include "talk/xmllite/xmlelement.h"
 #include "talk/xmllite/xmlnsstack.h"
@@ -39,14 +42,17 @@ namespace buzz {
 
 class XmlPrinterImpl {
 public:
-  XmlPrinterImpl(std::ostream* pout, XmlnsStack* ns_stack);
+  XmlPrinterImpl(std::string* out, XmlnsStack* ns_stack);
   void PrintElement(const XmlElement* element);
+  void PrintQName(const QName& name, bool is_attr);
   void PrintQuotedValue(const std::string& text);
   void PrintBodyText(const std::string& text);
   void PrintCDATAText(const std::string& text);
 
 private:
-  std::ostream *pout_;
+  void PrintEscaped(const std::string& text, bool quote);
+
+  std::string* out_;
   XmlnsStack* ns_stack_;
 };
 
@@ -57,12 +63,24 @@ void XmlPrinter::PrintXml(std::ostream* pout, const XmlElement* element) {
 
 void XmlPrinter::PrintXml(std::ostream* pout, const XmlElement* element,
                           XmlnsStack* ns_stack) {
-  XmlPrinterImpl printer(pout, ns_stack);
+  std::string out;
+  PrintXml(&out, element, ns_stack);
+  pout->write(out.data(), out.length());
+}
+
+void XmlPrinter::PrintXml(std::string* out, const XmlElement* element) {
+  XmlnsStack ns_stack;
+  PrintXml(out, element, &ns_stack);
+}
+
+void XmlPrinter::PrintXml(std::string* out, const XmlElement* element,
+                          XmlnsStack* ns_stack) {
+  XmlPrinterImpl printer(out, ns_stack);
   printer.PrintElement(element);
 }
 
-XmlPrinterImpl::XmlPrinterImpl(std::ostream* pout, XmlnsStack* ns_stack)
-    : pout_(pout),
+XmlPrinterImpl::XmlPrinterImpl(std::string* out, XmlnsStack* ns_stack)
+    : out_(out),
       ns_stack_(ns_stack) {
 }
 
@@ -98,23 +116,30 @@ void XmlPrinterImpl::PrintElement(const XmlElement* element) {
   }
 
   // print the element name
-  *pout_ << '<' << ns_stack_->FormatQName(element->Name(), false);
+  out_->push_back('<');
+  PrintQName(element->Name(), false);
 
   // and the attributes
   for (attr = element->FirstAttr(); attr; attr = attr->NextAttr()) {
-    *pout_ << ' ' << ns_stack_->FormatQName(attr->Name(), true) << "=\"";
+    out_->push_back(' ');
+    PrintQName(attr->Name(), true);
+    out_->append("=\"", 2);
     PrintQuotedValue(attr->Value());
-    *pout_ << '"';
+    out_->push_back('"');
   }
 
   // and the extra xmlns declarations
   std::vector<std::string>::iterator i(new_ns.begin());
   while (i < new_ns.end()) {
     if (*i == STR_EMPTY) {
-      *pout_ << " xmlns=\"" << *(i + 1) << '"';
+      out_->append(" xmlns=\"", 8);
     } else {
-      *pout_ << " xmlns:" << *i << "=\"" << *(i + 1) << '"';
+      out_->append(" xmlns:", 7);
+      out_->append(*i);
+      out_->append("=\"", 2);
     }
+    out_->append(*(i + 1));
+    out_->push_back('"');
     i += 2;
   }
 
@@ -122,9 +147,9 @@ void XmlPrinterImpl::PrintElement(const XmlElement* element) {
   const XmlChild* child = element->FirstChild();
 
   if (child == NULL)
-    *pout_ << "/>";
+    out_->append("/>", 2);
   else {
-    *pout_ << '>';
+    out_->push_back('>');
     while (child) {
       if (child->IsText()) {
         if (element->IsCDATA()) {
@@ -137,55 +162,94 @@ void XmlPrinterImpl::PrintElement(const XmlElement* element) {
       }
       child = child->NextChild();
     }
-    *pout_ << "</" << ns_stack_->FormatQName(element->Name(), false) << '>';
+    out_->append("</", 2);
+    PrintQName(element->Name(), false);
+    out_->push_back('>');
   }
 
   ns_stack_->PopFrame();
 }
 
-void XmlPrinterImpl::PrintQuotedValue(const std::string& text) {
-  size_t safe = 0;
-  for (;;) {
-    size_t unsafe = text.find_first_of("<>&\"", safe);
-    if (unsafe == std::string::npos)
-      unsafe = text.length();
-    *pout_ << text.substr(safe, unsafe - safe);
-    if (unsafe == text.length())
-      return;
-    switch (text[unsafe]) {
-      case '<': *pout_ << "&lt;"; break;
-      case '>': *pout_ << "&gt;"; break;
-      case '&': *pout_ << "&amp;"; break;
-      case '"': *pout_ << "&quot;"; break;
-    }
-    safe = unsafe + 1;
-    if (safe == text.length())
-      return;
+// Same output as XmlnsStack::FormatQName, without building a temporary.
+void XmlPrinterImpl::PrintQName(const QName& name, bool is_attr) {
+  std::pair<std::string, bool> prefix =
+      ns_stack_->PrefixForNs(name.Namespace(), is_attr);
+  if (!prefix.first.empty()) {
+    out_->append(prefix.first);
+    out_->push_back(':');
   }
+  out_->append(name.LocalPart());
+}
+
+void XmlPrinterImpl::PrintQuotedValue(const std::string& text) {
+  PrintEscaped(text, true);
 }
 
 void XmlPrinterImpl::PrintBodyText(const std::string& text) {
+  PrintEscaped(text, false);
+}
+
+void XmlPrinterImpl::PrintCDATAText(const std::string& text) {
+  out_->append("<![CDATA[", 9);
+  out_->append(text);
+  out_->append("]]>", 3);
+}
+
+// Word-at-a-time test for a byte equal to c in v: xoring turns the matching
+// bytes into zeros, and the classic has-zero-byte trick finds them.
+static const uint64 kOnes = UINT64_C(0x0101010101010101);
+static const uint64 kHighs = UINT64_C(0x8080808080808080);
+
+static inline uint64 ZeroBytes(uint64 v) {
+  return (v - kOnes) & ~v & kHighs;
+}
+
+static inline bool HasEscapable(uint64 v, bool quote) {
+  uint64 found = ZeroBytes(v ^ (kOnes * '<')) |
+                 ZeroBytes(v ^ (kOnes * '>')) |
+                 ZeroBytes(v ^ (kOnes * '&'));
+  if (quote)
+    found |= ZeroBytes(v ^ (kOnes * '"'));
+  return found != 0;
+}
+
+// Returns the offset of the first character from start that needs
+// escaping, or length if there is none. Plain text is skipped eight bytes
+// at a time.
+static size_t FindEscapable(const char* text, size_t start, size_t length,
+                            bool quote) {
+  size_t i = start;
+  for (; i + sizeof(uint64) <= length; i += sizeof(uint64)) {
+    uint64 v;
+    memcpy(&v, text + i, sizeof(v));
+    if (HasEscapable(v, quote))
+      break;
+  }
+  for (; i < length; ++i) {
+    char c = text[i];
+    if (c == '<' || c == '>' || c == '&' || (quote && c == '"'))
+      return i;
+  }
+  return length;
+}
+
+void XmlPrinterImpl::PrintEscaped(const std::string& text, bool quote) {
+  const char* data = text.data();
+  size_t length = text.length();
   size_t safe = 0;
-  for (;;) {
-    size_t unsafe = text.find_first_of("<>&", safe);
-    if (unsafe == std::string::npos)
-      unsafe = text.length();
-    *pout_ << text.substr(safe, unsafe - safe);
-    if (unsafe == text.length())
+  while (safe < length) {
+    size_t unsafe = FindEscapable(data, safe, length, quote);
+    out_->append(data + safe, unsafe - safe);
+    if (unsafe == length)
       return;
-    switch (text[unsafe]) {
-      case '<': *pout_ << "&lt;"; break;
-      case '>': *pout_ << "&gt;"; break;
-      case '&': *pout_ << "&amp;"; break;
+    switch (data[unsafe]) {
+      case '<': out_->append("&lt;", 4); break;
+      case '>': out_->append("&gt;", 4); break;
+      case '&': out_->append("&amp;", 5); break;
+      case '"': out_->append("&quot;", 6); break;
     }
     safe = unsafe + 1;
-    if (safe == text.length())
-      return;
   }
 }
 
-void XmlPrinterImpl::PrintCDATAText(const std::string& text) {
-  *pout_ << "<![CDATA[" << text << "]]>";
-}
-
 }  // namespace buzz
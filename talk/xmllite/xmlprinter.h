@@ -42,6 +42,13 @@ class XmlPrinter {
 
   static void PrintXml(std::ostream* pout, const XmlElement* pelt,
                        XmlnsStack* ns_stack);
+
+  // Append the XML to out. This is the fast path: out can be reused across
+  // calls so that its capacity is only allocated once.
+  static void PrintXml(std::string* out, const XmlElement* pelt);
+
+  static void PrintXml(std::string* out, const XmlElement* pelt,
+                       XmlnsStack* ns_stack);
 };
 
 }  // namespace buzz
@@ -40,6 +40,8 @@ extern const char NS_STREAM[];
 extern const char NS_XSTREAM[];
 extern const char NS_TLS[];
 extern const char NS_SASL[];
+extern const char NS_COMPRESS_FEATURE[];
+extern const char NS_COMPRESS[];
 extern const char NS_BIND[];
 extern const char NS_DIALBACK[];
 extern const char NS_SESSION[];
@@ -49,6 +51,7 @@ extern const char NS_ROSTER[];
 extern const char NS_VCARD[];
 extern const char NS_AVATAR_HASH[];
 extern const char NS_VCARD_UPDATE[];
+extern const char NS_STANZA_PARSER[];
 extern const char STR_CLIENT[];
 extern const char STR_SERVER[];
 extern const char STR_STREAM[];
@@ -103,6 +106,8 @@ extern const char STR_MUC_ROOMCONFIG[];
 extern const StaticQName QN_STREAM_STREAM;
 extern const StaticQName QN_STREAM_FEATURES;
 extern const StaticQName QN_STREAM_ERROR;
+// Added by XmppStanzaParser to stanzas it skipped children of.
+extern const StaticQName QN_SKIPPED_CHILDREN;
 
 extern const StaticQName QN_XSTREAM_BAD_FORMAT;
 extern const StaticQName QN_XSTREAM_BAD_NAMESPACE_PREFIX;
@@ -135,6 +140,13 @@ extern const StaticQName QN_TLS_REQUIRED;
 extern const StaticQName QN_TLS_PROCEED;
 extern const StaticQName QN_TLS_FAILURE;
 
+extern const StaticQName QN_COMPRESS_FEATURE_COMPRESSION;
+extern const StaticQName QN_COMPRESS_FEATURE_METHOD;
+extern const StaticQName QN_COMPRESS_COMPRESS;
+extern const StaticQName QN_COMPRESS_METHOD;
+extern const StaticQName QN_COMPRESS_COMPRESSED;
+extern const StaticQName QN_COMPRESS_FAILURE;
+
 extern const StaticQName QN_SASL_MECHANISMS;
 extern const StaticQName QN_SASL_MECHANISM;
 extern const StaticQName QN_SASL_AUTH;
@@ -91,8 +91,21 @@ class FakeXmppClient : public XmppTaskParentInterface,
     tasks_.push_back(task);
   }
 
+  virtual void AddXmppTask(XmppTask* task,
+                           XmppEngine::HandlerLevel level,
+                           const XmppStanzaFilter& filter) {
+    tasks_.push_back(task);
+  }
+
+  // Tasks see every stanza here, so there is no filter to replace.
+  virtual void SetXmppTaskFilter(XmppTask* task,
+                                 XmppEngine::HandlerLevel level,
+                                 const XmppStanzaFilter& filter) {
+  }
+
   virtual void RemoveXmppTask(XmppTask* task) {
-    std::remove(tasks_.begin(), tasks_.end(), task);
+    tasks_.erase(std::remove(tasks_.begin(), tasks_.end(), task),
+                 tasks_.end());
   }
 
   // As FakeXmppClient
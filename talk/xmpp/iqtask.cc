@@ -43,6 +43,7 @@ IqTask::IqTask(XmppTaskParentInterface* parent,
       stanza_(MakeIq(verb, to_, task_id())) {
   stanza_->AddElement(el);
   set_timeout_seconds(kDefaultIqTimeoutSecs);
+  SetStanzaFilter(XmppStanzaFilter(QN_IQ, task_id()));
 }
 
 int IqTask::ProcessStart() {
@@ -33,8 +33,8 @@ namespace buzz {
 // TODO: Move these to xmpp/constants.cc once it's publicly
 // viewable.
 const char NS_GOOGLE_SETTING[] = "google:setting";
-const StaticQName QN_MEETING_HISTORY = { NS_GOOGLE_SETTING, "meetinghistory" };
-const StaticQName QN_MEETING_ITEM = { NS_GOOGLE_SETTING, "item" };
+const StaticQName QN_MEETING_HISTORY(NS_GOOGLE_SETTING, "meetinghistory");
+const StaticQName QN_MEETING_ITEM(NS_GOOGLE_SETTING, "item");
 
 MucRoomHistoryGetTask::MucRoomHistoryGetTask(XmppTaskParentInterface* parent,
                                              const buzz::Jid& user_jid)
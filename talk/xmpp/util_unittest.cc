@@ -72,6 +72,10 @@ void XmppTestHandler::OnStateChange(int state) {
   }
 }
 
+void XmppTestHandler::OnIqTimeoutChanged() {
+  session_ << "[IQ-TIMER]";
+}
+
 bool XmppTestHandler::HandleStanza(const XmlElement * stanza) {
   stanza_ << stanza->Str();
   return true;
@@ -50,6 +50,7 @@ class XmppTestHandler : public XmppOutputHandler,  public XmppSessionHandler,
 
   // Session handler
   virtual void OnStateChange(int state);
+  virtual void OnIqTimeoutChanged();
 
   // Stanza handler
   virtual bool HandleStanza(const XmlElement* stanza);
@@ -30,6 +30,7 @@
 #include "talk/base/sigslot.h"
 #include "talk/base/scoped_ptr.h"
 #include "talk/base/stringutils.h"
+#include "talk/base/thread.h"
 #include "talk/xmpp/constants.h"
 #include "talk/xmpp/saslplainmechanism.h"
 #include "talk/xmpp/prexmppauth.h"
@@ -37,8 +38,14 @@
 
 namespace buzz {
 
+enum {
+  MSG_FLUSH_OUTPUT,
+  MSG_IQ_TIMEOUT
+};
+
 class XmppClient::Private :
     public sigslot::has_slots<>,
+    public talk_base::MessageHandler,
     public XmppSessionHandler,
     public XmppOutputHandler {
 public:
@@ -51,7 +58,13 @@ public:
     pre_engine_error_(XmppEngine::ERROR_NONE),
     pre_engine_subcode_(0),
     signal_closed_(false),
-    allow_plain_(false) {}
+    allow_plain_(false),
+    thread_(NULL) {}
+
+  virtual ~Private() {
+    if (thread_)
+      thread_->Clear(this);
+  }
 
   // the owner
   XmppClient * const client_;
@@ -70,12 +83,19 @@ public:
   CaptchaChallenge captcha_challenge_;
   bool signal_closed_;
   bool allow_plain_;
+  // The thread that flushes coalesced output and times out iqs, or NULL
+  // if the client has none; then output is not coalesced and iqs never
+  // time out.
+  talk_base::Thread* thread_;
 
   // implementations of interfaces
   void OnStateChange(int state);
+  void OnIqTimeoutChanged();
   void WriteOutput(const char * bytes, size_t len);
   void StartTls(const std::string & domainname);
   void CloseConnection();
+  void OnOutputPending();
+  void OnMessage(talk_base::Message* msg);
 
   // slots for socket signals
   void OnSocketConnected();
@@ -111,6 +131,18 @@ XmppClient::Connect(const XmppClientSettings & settings,
     d_->engine_->SetRequestedResource(settings.resource());
   }
   d_->engine_->SetTls(settings.use_tls());
+  d_->engine_->SetCompression(settings.use_compression());
+  d_->engine_->SetSelectiveParsing(settings.selective_parsing());
+
+  // If asked, stanzas sent during one turn of the message loop go out in
+  // one write.
+  d_->thread_ = talk_base::Thread::Current();
+  d_->engine_->SetOutputCoalescing(settings.coalesce_output() &&
+                                   d_->thread_ != NULL);
+  // Iq timeouts fire from a timer on that same thread.
+  if (d_->thread_) {
+    d_->engine_->SetIqTimeout(settings.iq_timeout());
+  }
 
   // The talk.google.com server returns a certificate with common-name:
   //   CN="gmail.com" for @gmail.com accounts,
@@ -379,6 +411,37 @@ XmppClient::Private::WriteOutput(const char * bytes, size_t len) {
   // TODO: deal with error information
 }
 
+void
+XmppClient::Private::OnIqTimeoutChanged() {
+  if (!thread_)
+    return;
+  // One timer serves all the pending iqs.
+  thread_->Clear(this, MSG_IQ_TIMEOUT);
+  int delay = engine_->GetNextIqTimeout();
+  if (delay >= 0)
+    thread_->PostDelayed(delay, this, MSG_IQ_TIMEOUT);
+}
+
+void
+XmppClient::Private::OnOutputPending() {
+  thread_->Post(this, MSG_FLUSH_OUTPUT);
+}
+
+void
+XmppClient::Private::OnMessage(talk_base::Message* msg) {
+  if (!engine_.get())
+    return;
+  switch (msg->message_id) {
+    case MSG_FLUSH_OUTPUT:
+      engine_->FlushOutput();
+      break;
+    case MSG_IQ_TIMEOUT:
+      engine_->HandleIqTimeouts();
+      OnIqTimeoutChanged();
+      break;
+  }
+}
+
 void
 XmppClient::Private::StartTls(const std::string & domain) {
 #if defined(FEATURE_ENABLE_SSL)
@@ -396,6 +459,18 @@ XmppClient::AddXmppTask(XmppTask * task, XmppEngine::HandlerLevel level) {
   d_->engine_->AddStanzaHandler(task, level);
 }
 
+void
+XmppClient::AddXmppTask(XmppTask * task, XmppEngine::HandlerLevel level,
+                        const XmppStanzaFilter& filter) {
+  d_->engine_->AddStanzaHandler(task, level, filter);
+}
+
+void
+XmppClient::SetXmppTaskFilter(XmppTask * task, XmppEngine::HandlerLevel level,
+                              const XmppStanzaFilter& filter) {
+  d_->engine_->SetStanzaFilter(task, filter);
+}
+
 void
 XmppClient::RemoveXmppTask(XmppTask * task) {
   d_->engine_->RemoveStanzaHandler(task);
@@ -119,6 +119,10 @@ public:
                                            XmppStanzaError code,
                                            const std::string & text);
   virtual void AddXmppTask(XmppTask *, XmppEngine::HandlerLevel);
+  virtual void AddXmppTask(XmppTask *, XmppEngine::HandlerLevel,
+                           const XmppStanzaFilter&);
+  virtual void SetXmppTaskFilter(XmppTask *, XmppEngine::HandlerLevel,
+                                 const XmppStanzaFilter&);
   virtual void RemoveXmppTask(XmppTask *);
 
  private:
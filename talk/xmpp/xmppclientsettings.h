@@ -38,6 +38,10 @@ class XmppUserSettings {
  public:
   XmppUserSettings()
     : use_tls_(buzz::TLS_DISABLED),
+      use_compression_(false),
+      coalesce_output_(false),
+      iq_timeout_(0),
+      selective_parsing_(false),
       allow_plain_(false) {
   }
 
@@ -47,6 +51,12 @@ class XmppUserSettings {
   void set_auth_cookie(const std::string & cookie) { auth_cookie_ = cookie; }
   void set_resource(const std::string & resource) { resource_ = resource; }
   void set_use_tls(const TlsOptions use_tls) { use_tls_ = use_tls; }
+  void set_use_compression(bool f) { use_compression_ = f; }
+  void set_coalesce_output(bool f) { coalesce_output_ = f; }
+  // Milliseconds an iq waits for its response; 0 waits forever.
+  void set_iq_timeout(int timeout_ms) { iq_timeout_ = timeout_ms; }
+  // See XmppEngine::SetSelectiveParsing.
+  void set_selective_parsing(bool f) { selective_parsing_ = f; }
   void set_allow_plain(bool f) { allow_plain_ = f; }
   void set_test_server_domain(const std::string & test_server_domain) {
     test_server_domain_ = test_server_domain;
@@ -61,6 +71,10 @@ class XmppUserSettings {
   const std::string & auth_cookie() const { return auth_cookie_; }
   const std::string & resource() const { return resource_; }
   TlsOptions use_tls() const { return use_tls_; }
+  bool use_compression() const { return use_compression_; }
+  bool coalesce_output() const { return coalesce_output_; }
+  int iq_timeout() const { return iq_timeout_; }
+  bool selective_parsing() const { return selective_parsing_; }
   bool allow_plain() const { return allow_plain_; }
   const std::string & test_server_domain() const { return test_server_domain_; }
   const std::string & token_service() const { return token_service_; }
@@ -72,6 +86,10 @@ class XmppUserSettings {
   std::string auth_cookie_;
   std::string resource_;
   TlsOptions use_tls_;
+  bool use_compression_;
+  bool coalesce_output_;
+  int iq_timeout_;
+  bool selective_parsing_;
   bool allow_plain_;
   std::string test_server_domain_;
   std::string token_service_;
@@ -0,0 +1,171 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "talk/xmpp/xmppcompressor.h"
+
+#include <string.h>
+
+#if HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#include "talk/base/common.h"
+#include "talk/base/logging.h"
+
+namespace buzz {
+
+#if HAVE_ZLIB_H
+
+// Room to (de)compress into per zlib call.
+static const size_t kChunkSize = 4096;
+
+struct XmppCompressor::Streams {
+  z_stream deflate;
+  z_stream inflate;
+};
+
+XmppCompressor::XmppCompressor() {
+}
+
+XmppCompressor::~XmppCompressor() {
+  Stop();
+}
+
+bool XmppCompressor::IsAvailable() {
+  return true;
+}
+
+bool XmppCompressor::Start() {
+  Stop();
+  talk_base::scoped_ptr<Streams> streams(new Streams);
+  memset(streams.get(), 0, sizeof(Streams));
+  if (deflateInit(&streams->deflate, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    LOG(LS_ERROR) << "deflateInit failed";
+    return false;
+  }
+  if (inflateInit(&streams->inflate) != Z_OK) {
+    LOG(LS_ERROR) << "inflateInit failed";
+    deflateEnd(&streams->deflate);
+    return false;
+  }
+  streams_.reset(streams.release());
+  return true;
+}
+
+void XmppCompressor::Stop() {
+  if (streams_.get()) {
+    deflateEnd(&streams_->deflate);
+    inflateEnd(&streams_->inflate);
+    streams_.reset();
+  }
+}
+
+bool XmppCompressor::Compress(const char* bytes, size_t len,
+                              std::string* output) {
+  if (!streams_.get())
+    return false;
+
+  z_stream* stream = &streams_->deflate;
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bytes));
+  stream->avail_in = static_cast<uInt>(len);
+  // Z_SYNC_FLUSH ends the output on a byte boundary, so each write can be
+  // decoded as soon as it arrives.
+  do {
+    size_t start = output->size();
+    output->resize(start + kChunkSize);
+    stream->next_out = reinterpret_cast<Bytef*>(&(*output)[start]);
+    stream->avail_out = kChunkSize;
+    int result = deflate(stream, Z_SYNC_FLUSH);
+    output->resize(start + kChunkSize - stream->avail_out);
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+      LOG(LS_ERROR) << "deflate failed: " << result;
+      return false;
+    }
+  } while (stream->avail_out == 0);
+  return true;
+}
+
+bool XmppCompressor::Decompress(const char* bytes, size_t len,
+                                std::string* output) {
+  if (!streams_.get())
+    return false;
+
+  z_stream* stream = &streams_->inflate;
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bytes));
+  stream->avail_in = static_cast<uInt>(len);
+  do {
+    size_t start = output->size();
+    output->resize(start + kChunkSize);
+    stream->next_out = reinterpret_cast<Bytef*>(&(*output)[start]);
+    stream->avail_out = kChunkSize;
+    int result = inflate(stream, Z_SYNC_FLUSH);
+    output->resize(start + kChunkSize - stream->avail_out);
+    if (result == Z_BUF_ERROR || result == Z_STREAM_END)
+      break;  // Needs more input, or the peer ended the stream.
+    if (result != Z_OK) {
+      LOG(LS_ERROR) << "inflate failed: " << result;
+      return false;
+    }
+  } while (stream->avail_in > 0 || stream->avail_out == 0);
+  return true;
+}
+
+#else  // !HAVE_ZLIB_H
+
+struct XmppCompressor::Streams {
+};
+
+XmppCompressor::XmppCompressor() {
+}
+
+XmppCompressor::~XmppCompressor() {
+}
+
+bool XmppCompressor::IsAvailable() {
+  return false;
+}
+
+bool XmppCompressor::Start() {
+  return false;
+}
+
+void XmppCompressor::Stop() {
+}
+
+bool XmppCompressor::Compress(const char* bytes, size_t len,
+                              std::string* output) {
+  return false;
+}
+
+bool XmppCompressor::Decompress(const char* bytes, size_t len,
+                                std::string* output) {
+  return false;
+}
+
+#endif  // !HAVE_ZLIB_H
+
+}  // namespace buzz
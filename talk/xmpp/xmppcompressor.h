@@ -0,0 +1,73 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_XMPP_XMPPCOMPRESSOR_H_
+#define TALK_XMPP_XMPPCOMPRESSOR_H_
+
+#include <string>
+
+#include "talk/base/constructormagic.h"
+#include "talk/base/scoped_ptr.h"
+
+namespace buzz {
+
+// XmppCompressor holds the zlib streams for XEP-0138 stream compression:
+// one deflate stream for what we send and one inflate stream for what we
+// receive. Both run for the life of the connection, so later stanzas are
+// compressed against the text of earlier ones. Compression is only
+// available when the library is built with zlib (HAVE_ZLIB_H).
+class XmppCompressor {
+ public:
+  XmppCompressor();
+  ~XmppCompressor();
+
+  // True if zlib was compiled in, so compression can be negotiated.
+  static bool IsAvailable();
+
+  // Starts fresh compression and decompression streams. Returns false if
+  // zlib is not available or could not be initialized.
+  bool Start();
+  // Drops both streams.
+  void Stop();
+  bool active() const { return streams_.get() != NULL; }
+
+  // Appends the compressed form of the bytes to output. The stream is
+  // flushed, so the peer can decode everything written so far.
+  bool Compress(const char* bytes, size_t len, std::string* output);
+  // Appends the bytes decompressed from the input to output.
+  bool Decompress(const char* bytes, size_t len, std::string* output);
+
+ private:
+  struct Streams;
+  talk_base::scoped_ptr<Streams> streams_;
+
+  DISALLOW_COPY_AND_ASSIGN(XmppCompressor);
+};
+
+}  // namespace buzz
+
+#endif  // TALK_XMPP_XMPPCOMPRESSOR_H_
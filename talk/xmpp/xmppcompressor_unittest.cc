@@ -0,0 +1,103 @@
+/*
+ * libjingle
+ * Copyright 2012, Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+
+#include "talk/base/gunit.h"
+#include "talk/base/logging.h"
+#include "talk/xmpp/xmppcompressor.h"
+
+using buzz::XmppCompressor;
+
+TEST(XmppCompressorTest, TestRoundTrip) {
+  if (!XmppCompressor::IsAvailable()) {
+    LOG(LS_INFO) << "Built without zlib, skipping";
+    return;
+  }
+
+  XmppCompressor sender;
+  XmppCompressor receiver;
+  EXPECT_FALSE(sender.active());
+  EXPECT_TRUE(sender.Start());
+  EXPECT_TRUE(receiver.Start());
+  EXPECT_TRUE(sender.active());
+
+  // Each compressed write decodes on its own, and repeated text shrinks.
+  std::string presence =
+      "<presence from=\"someone@example.com/resource\">"
+      "<show>away</show><status>Out to lunch</status></presence>";
+  size_t first_size = 0;
+  for (int i = 0; i < 10; ++i) {
+    std::string compressed;
+    EXPECT_TRUE(sender.Compress(presence.data(), presence.length(),
+                                &compressed));
+    EXPECT_LT(0U, compressed.length());
+    if (i == 0)
+      first_size = compressed.length();
+    else
+      EXPECT_GT(first_size, compressed.length());
+
+    std::string plain;
+    EXPECT_TRUE(receiver.Decompress(compressed.data(), compressed.length(),
+                                    &plain));
+    EXPECT_EQ(presence, plain);
+  }
+
+  sender.Stop();
+  EXPECT_FALSE(sender.active());
+  std::string output;
+  EXPECT_FALSE(sender.Compress("x", 1, &output));
+}
+
+TEST(XmppCompressorTest, TestSplitInput) {
+  if (!XmppCompressor::IsAvailable())
+    return;
+
+  XmppCompressor sender;
+  XmppCompressor receiver;
+  EXPECT_TRUE(sender.Start());
+  EXPECT_TRUE(receiver.Start());
+
+  // Larger than one zlib output chunk, and fed back a byte at a time.
+  std::string roster;
+  for (int i = 0; i < 500; ++i)
+    roster += "<item jid=\"friend" + std::string(1, 'a' + i % 26) +
+              "@example.com\" subscription=\"both\"/>";
+  std::string compressed;
+  EXPECT_TRUE(sender.Compress(roster.data(), roster.length(), &compressed));
+  EXPECT_GT(roster.length(), compressed.length());
+
+  std::string plain;
+  for (size_t i = 0; i < compressed.length(); ++i)
+    EXPECT_TRUE(receiver.Decompress(&compressed[i], 1, &plain));
+  EXPECT_EQ(roster, plain);
+
+  // Garbage is an error.
+  XmppCompressor bad;
+  EXPECT_TRUE(bad.Start());
+  EXPECT_FALSE(bad.Decompress("not zlib at all", 15, &plain));
+}
@@ -103,6 +103,11 @@ public:
 
   //! Called when engine wants the connecton closed.
   virtual void CloseConnection() = 0;
+
+  //! Called when output coalescing is on and the engine starts holding
+  //! output.  Arrange for XmppEngine.FlushOutput to be called soon,
+  //! typically once the current message loop turn is over.
+  virtual void OnOutputPending() {}
 };
 
 //! Callback to deliver engine state change notifications
@@ -112,6 +117,11 @@ public:
   virtual ~XmppSessionHandler() {}
   //! Called when engine changes state. Argument is new state.
   virtual void OnStateChange(int state) = 0;
+
+  //! Called when an iq is sent that will time out before every other
+  //! pending iq.  Arrange for XmppEngine.HandleIqTimeouts to be called
+  //! after XmppEngine.GetNextIqTimeout milliseconds.
+  virtual void OnIqTimeoutChanged() {}
 };
 
 //! Callback to deliver stanzas to an Xmpp application module.
@@ -127,6 +137,26 @@ public:
   virtual bool HandleStanza(const XmlElement * stanza) = 0;
 };
 
+//! Describes the stanzas an XmppStanzaHandler cares about.
+//! Pass one to XmppEngine.AddStanzaHandler and the engine finds the
+//! handler through an index instead of offering it every stanza.
+//! Fields left empty match anything.
+struct XmppStanzaFilter {
+  XmppStanzaFilter() {}
+  XmppStanzaFilter(const QName& stanza_name, const std::string& stanza_id)
+      : name(stanza_name), id(stanza_id) {}
+
+  //! True if no field is set, so every stanza matches.
+  bool IsEmpty() const;
+  //! True if the stanza matches every field that is set.
+  bool Matches(const XmlElement * stanza) const;
+
+  QName name;            //!< Name of the stanza, e.g. QN_IQ
+  std::string type;      //!< Value of the 'type' attribute
+  std::string child_ns;  //!< Namespace of the first child element
+  std::string id;        //!< Value of the 'id' attribute
+};
+
 //! Callback to deliver iq responses (results and errors).
 //! Register while sending an iq via XmppEngine.SendIq.
 //! Iq responses are routed to matching XmppIqHandlers in preference
@@ -142,6 +172,28 @@ public:
   virtual void IqResponse(XmppIqCookie cookie, const XmlElement * pelStanza) = 0;
 };
 
+//! Counters for the iqs sent through XmppEngine.SendIq.
+struct XmppIqStats {
+  XmppIqStats() : pending(0), sent(0), answered(0), expired(0) {}
+  int pending;   //!< Sent and still waiting for a response
+  int sent;      //!< Sent since the engine was created
+  int answered;  //!< Matched by a result or error from the server
+  int expired;   //!< Given up on after the iq timeout
+};
+
+//! Counters for the traffic of one XmppEngine connection.
+struct XmppTrafficStats {
+  XmppTrafficStats()
+      : bytes_sent(0), bytes_sent_uncompressed(0), writes(0),
+        bytes_received(0), bytes_received_uncompressed(0), reads(0) {}
+  size_t bytes_sent;                   //!< Bytes given to WriteOutput
+  size_t bytes_sent_uncompressed;      //!< The same bytes before compression
+  int writes;                          //!< Calls to WriteOutput
+  size_t bytes_received;               //!< Bytes given to HandleInput
+  size_t bytes_received_uncompressed;  //!< The same bytes decompressed
+  int reads;                           //!< Calls to HandleInput
+};
+
 //! The XMPP connection engine.
 //! This engine implements the client side of the 'core' XMPP protocol.
 //! To use it, register an XmppOutputHandler to handle socket output
@@ -207,6 +259,11 @@ public:
   //! Sets whether TLS will be used within the connection (default true).
   virtual XmppReturnStatus SetTls(TlsOptions useTls) = 0;
 
+  //! Sets whether to ask for XEP-0138 zlib stream compression (default
+  //! false).  It is negotiated after authentication, when the server
+  //! offers it.  Ignored if the library was built without zlib.
+  virtual XmppReturnStatus SetCompression(bool use_compression) = 0;
+
   //! Sets an alternate domain from which we allows TLS certificates.
   //! This is for use in the case where a we want to allow a proxy to
   //! serve up its own certificate rather than one owned by the underlying
@@ -244,6 +301,32 @@ public:
   //! Returns true if the connection is encrypted (under TLS)
   virtual bool IsEncrypted() = 0;
 
+  //! Returns true if the stream is compressed.
+  virtual bool IsCompressed() = 0;
+
+  //! Sets whether output is held until FlushOutput (default false).
+  //! Without coalescing, output is written as each call into the engine
+  //! returns, so stanzas sent one after the other each cost a socket
+  //! write.  With it, they go out together in one write.
+  virtual void SetOutputCoalescing(bool coalesce) = 0;
+
+  //! Writes any output held back by coalescing.
+  virtual void FlushOutput() = 0;
+
+  //! Sets whether incoming stanzas are built only as far as the handlers
+  //! need (default false).  A child of a stanza other than an iq is then
+  //! built only if some handler without a child namespace filter could get
+  //! the stanza, or one filters on the child's namespace; the rest are skipped
+  //! and counted in the stanza's QN_SKIPPED_CHILDREN attribute.  Since
+  //! skipped children are never seen, the first child a filter looks at is
+  //! the first one that was built.  Turn it on only if handlers that filter
+  //! on a child namespace read nothing else from the stanza.  Iqs, stream
+  //! errors and the login exchange are always built in full.
+  virtual void SetSelectiveParsing(bool selective) = 0;
+
+  //! Byte and write counters for the connection.
+  virtual XmppTrafficStats GetTrafficStats() = 0;
+
   //! The error code.
   //! Consult this after XmppOutputHandler.OnClose().
   virtual Error GetError(int *subcode) = 0;
@@ -276,6 +359,18 @@ public:
   //! return 'true' is the last to get each stanza.
   virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler, HandlerLevel level = HL_PEEK) = 0;
 
+  //! Adds a listener that only sees stanzas matching the filter.
+  //! Handlers still get stanzas in the order they were added, filtered
+  //! or not; the filter only saves calls that would have returned false.
+  virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler,
+                                            HandlerLevel level,
+                                            const XmppStanzaFilter& filter) = 0;
+
+  //! Replaces the filter of a listener.  The listener keeps its place in
+  //! the order handlers get stanzas in.
+  virtual XmppReturnStatus SetStanzaFilter(XmppStanzaHandler* handler,
+                                           const XmppStanzaFilter& filter) = 0;
+
   //! Removes a listener for session events.
   virtual XmppReturnStatus RemoveStanzaHandler(XmppStanzaHandler* handler) = 0;
 
@@ -296,6 +391,22 @@ public:
   virtual XmppReturnStatus RemoveIqHandler(XmppIqCookie cookie,
                                       XmppIqHandler** iq_handler) = 0;
 
+  //! Sets how long an iq sent from now on waits for its response.
+  //! When the time is up its handler gets a remote-server-timeout error
+  //! in place of the response.  Zero, the default, waits forever.
+  virtual void SetIqTimeout(int timeout_ms) = 0;
+
+  //! Milliseconds until the next pending iq times out, or -1 if none will.
+  //! Use this to arm a single timer for all pending iqs; the session
+  //! handler's OnIqTimeoutChanged says when to arm it again.
+  virtual int GetNextIqTimeout() = 0;
+
+  //! Expires the pending iqs whose time is up.
+  //! Call this when the timer armed from GetNextIqTimeout fires.
+  virtual void HandleIqTimeouts() = 0;
+
+  //! Counters of outstanding, answered and expired iqs.
+  virtual XmppIqStats GetIqStats() = 0;
 
   //! Forms and sends an error in response to the given stanza.
   //! Swaps to and from, sets type to "error", and adds error information
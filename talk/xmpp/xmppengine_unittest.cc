@@ -3,9 +3,11 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 #include <iostream>
 #include "talk/base/common.h"
 #include "talk/base/gunit.h"
+#include "talk/base/thread.h"
 #include "talk/xmllite/xmlelement.h"
 #include "talk/xmpp/constants.h"
 #include "talk/xmpp/util_unittest.h"
@@ -19,6 +21,9 @@ using buzz::XmlElement;
 using buzz::XmppEngine;
 using buzz::XmppIqCookie;
 using buzz::XmppIqHandler;
+using buzz::XmppIqStats;
+using buzz::XmppStanzaFilter;
+using buzz::XmppStanzaHandler;
 using buzz::XmppTestHandler;
 using buzz::QN_ID;
 using buzz::QN_IQ;
@@ -45,6 +50,53 @@ class XmppEngineTestIqHandler : public XmppIqHandler {
   std::stringstream ss_;
 };
 
+// XmppEngineTestStanzaHandler
+//    This class logs the stanzas it is offered under its own name, and
+//    optionally takes them or removes another handler when called.
+class XmppEngineTestStanzaHandler : public XmppStanzaHandler {
+ public:
+  XmppEngineTestStanzaHandler(const std::string& name, std::string* log)
+      : name_(name), log_(log), handled_(false), engine_(NULL),
+        victim_(NULL), refilter_(false) {}
+
+  void set_handled(bool handled) { handled_ = handled; }
+  void RemoveOnCall(XmppEngine* engine, XmppStanzaHandler* victim) {
+    engine_ = engine;
+    victim_ = victim;
+    refilter_ = false;
+  }
+  void SetFilterOnCall(XmppEngine* engine, XmppStanzaHandler* victim,
+                       const XmppStanzaFilter& filter) {
+    engine_ = engine;
+    victim_ = victim;
+    refilter_ = true;
+    filter_ = filter;
+  }
+  const std::string& last_stanza() const { return last_stanza_; }
+
+  virtual bool HandleStanza(const XmlElement* stanza) {
+    *log_ += "[" + name_ + " " + stanza->Attr(QN_ID) + "]";
+    last_stanza_ = stanza->Str();
+    if (engine_ && refilter_) {
+      engine_->SetStanzaFilter(victim_, filter_);
+      engine_ = NULL;
+    } else if (engine_) {
+      engine_->RemoveStanzaHandler(victim_);
+    }
+    return handled_;
+  }
+
+ private:
+  std::string name_;
+  std::string* log_;
+  bool handled_;
+  XmppEngine* engine_;
+  XmppStanzaHandler* victim_;
+  bool refilter_;
+  XmppStanzaFilter filter_;
+  std::string last_stanza_;
+};
+
 class XmppEngineTest : public testing::Test {
  public:
   XmppEngine* engine() { return engine_.get(); }
@@ -316,3 +368,322 @@ TEST_F(XmppEngineTest, TestIqCallback) {
   EXPECT_EQ("", handler()->OutputActivity());
   EXPECT_EQ("", handler()->SessionActivity());
 }
+
+// TestIqTimeout()
+//    This tests that pending iqs expire with a timeout error once the
+//    iq timeout passes, and that late responses are not delivered twice.
+TEST_F(XmppEngineTest, TestIqTimeout) {
+  XmppEngineTestIqHandler iq_response;
+  XmppIqCookie cookie;
+
+  RunLogin();
+  EXPECT_EQ(-1, engine()->GetNextIqTimeout());
+
+  // Without a timeout nothing ever expires.
+  XmlElement roster_get(QN_IQ);
+  roster_get.AddAttr(QN_TYPE, "get");
+  roster_get.AddAttr(QN_ID, engine()->NextId());
+  engine()->SendIq(&roster_get, &iq_response, &cookie);
+  handler()->OutputActivity();
+  EXPECT_EQ("", handler()->SessionActivity());
+  EXPECT_EQ(-1, engine()->GetNextIqTimeout());
+  engine()->HandleIqTimeouts();
+  EXPECT_EQ("", iq_response.IqResponseActivity());
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveIqHandler(cookie, NULL));
+
+  engine()->SetIqTimeout(1000);
+  roster_get.SetAttr(QN_ID, engine()->NextId());
+  engine()->SendIq(&roster_get, &iq_response, &cookie);
+  handler()->OutputActivity();
+  // The owner is told to arm its timer.
+  EXPECT_EQ("[IQ-TIMER]", handler()->SessionActivity());
+  int next = engine()->GetNextIqTimeout();
+  EXPECT_GT(next, 0);
+  EXPECT_LE(next, 1000);
+  engine()->HandleIqTimeouts();
+  EXPECT_EQ("", iq_response.IqResponseActivity());
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveIqHandler(cookie, NULL));
+  EXPECT_EQ(-1, engine()->GetNextIqTimeout());
+
+  engine()->SetIqTimeout(1);
+  roster_get.SetAttr(QN_ID, engine()->NextId());
+  engine()->SendIq(&roster_get, &iq_response, &cookie);
+  handler()->OutputActivity();
+  talk_base::Thread::SleepMs(10);
+  EXPECT_EQ(0, engine()->GetNextIqTimeout());
+  engine()->HandleIqTimeouts();
+  EXPECT_EQ("<cli:iq type=\"error\" id=\"4\" xmlns:cli=\"jabber:client\">"
+          "<cli:error code=\"502\" type=\"wait\">"
+          "<remote-server-timeout "
+          "xmlns=\"urn:ietf:params:xml:ns:xmpp-stanzas\"/>"
+          "</cli:error></cli:iq>", iq_response.IqResponseActivity());
+  EXPECT_EQ(-1, engine()->GetNextIqTimeout());
+  EXPECT_EQ(XMPP_RETURN_BADARGUMENT, engine()->RemoveIqHandler(cookie, NULL));
+  EXPECT_EQ("", handler()->OutputActivity());
+
+  // The late response goes to the stanza handlers, not the iq handler.
+  std::string input = "<iq type='result' id='4'/>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("", iq_response.IqResponseActivity());
+  EXPECT_EQ("<cli:iq type=\"result\" id=\"4\" xmlns:cli=\"jabber:client\"/>",
+            handler()->StanzaActivity());
+
+  XmppIqStats stats = engine()->GetIqStats();
+  EXPECT_EQ(0, stats.pending);
+  EXPECT_EQ(3, stats.sent);
+  EXPECT_EQ(0, stats.answered);
+  EXPECT_EQ(1, stats.expired);
+}
+
+// TestManyIqs()
+//    This tests matching responses against many outstanding iqs,
+//    answered in a different order than they were sent.
+TEST_F(XmppEngineTest, TestManyIqs) {
+  XmppEngineTestIqHandler iq_response;
+  const int kIqCount = 1000;
+
+  RunLogin();
+
+  std::vector<std::string> ids;
+  XmlElement roster_get(QN_IQ);
+  roster_get.AddAttr(QN_TYPE, "get");
+  for (int i = 0; i < kIqCount; ++i) {
+    ids.push_back(engine()->NextId());
+    roster_get.SetAttr(QN_ID, ids.back());
+    engine()->SendIq(&roster_get, &iq_response, NULL);
+  }
+  handler()->OutputActivity();
+  EXPECT_EQ(kIqCount, engine()->GetIqStats().pending);
+
+  for (int i = kIqCount - 1; i >= 0; --i) {
+    std::string input = "<iq type='result' id='" + ids[i] + "'/>";
+    engine()->HandleInput(input.c_str(), input.length());
+  }
+  EXPECT_EQ("", handler()->StanzaActivity());
+
+  XmppIqStats stats = engine()->GetIqStats();
+  EXPECT_EQ(0, stats.pending);
+  EXPECT_EQ(kIqCount, stats.sent);
+  EXPECT_EQ(kIqCount, stats.answered);
+  EXPECT_EQ(0, stats.expired);
+}
+
+// TestFilteredHandlers()
+//    This tests that handlers with filters only see matching stanzas, and
+//    that filtered and unfiltered handlers keep their registration order.
+TEST_F(XmppEngineTest, TestFilteredHandlers) {
+  std::string log;
+  XmppEngineTestStanzaHandler by_id("by_id", &log);
+  XmppEngineTestStanzaHandler any("any", &log);
+  XmppEngineTestStanzaHandler by_ns("by_ns", &log);
+  XmppEngineTestStanzaHandler by_type("by_type", &log);
+  XmppEngineTestStanzaHandler peek("peek", &log);
+
+  RunLogin();
+
+  XmppStanzaFilter ns_filter;
+  ns_filter.child_ns = "jabber:iq:roster";
+  XmppStanzaFilter type_filter;
+  type_filter.type = "set";
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->AddStanzaHandler(
+      &by_id, XmppEngine::HL_SINGLE, XmppStanzaFilter(QN_IQ, "7")));
+  engine()->AddStanzaHandler(&any, XmppEngine::HL_SINGLE);
+  engine()->AddStanzaHandler(&by_ns, XmppEngine::HL_SINGLE, ns_filter);
+  engine()->AddStanzaHandler(&by_type, XmppEngine::HL_SINGLE, type_filter);
+  engine()->AddStanzaHandler(&peek, XmppEngine::HL_PEEK,
+                             XmppStanzaFilter(QN_IQ, ""));
+
+  std::string input = "<iq type='set' id='7'>"
+                      "<query xmlns='jabber:iq:roster'/></iq>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[peek 7][by_id 7][any 7][by_ns 7][by_type 7]", log);
+  log.clear();
+
+  input = "<message id='8'/>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[any 8]", log);
+  log.clear();
+
+  // A handler that takes the stanza stops the later ones.
+  by_ns.set_handled(true);
+  input = "<iq type='set' id='9'><query xmlns='jabber:iq:roster'/></iq>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[peek 9][any 9][by_ns 9]", log);
+  log.clear();
+
+  // Removing a handler while the stanza is dispatched keeps it from being
+  // called, even though it was already picked for the stanza.
+  any.RemoveOnCall(engine(), &by_ns);
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[peek 9][any 9][by_type 9]", log);
+  log.clear();
+
+  EXPECT_EQ(XMPP_RETURN_BADARGUMENT, engine()->RemoveStanzaHandler(&by_ns));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&by_id));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&any));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&by_type));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&peek));
+}
+
+// TestUnfilteredHandlerRemoval()
+//    This tests that removing an unfiltered handler during dispatch skips
+//    it without skipping the handler after it.
+TEST_F(XmppEngineTest, TestUnfilteredHandlerRemoval) {
+  std::string log;
+  XmppEngineTestStanzaHandler first("first", &log);
+  XmppEngineTestStanzaHandler second("second", &log);
+  XmppEngineTestStanzaHandler third("third", &log);
+
+  RunLogin();
+
+  engine()->AddStanzaHandler(&first, XmppEngine::HL_SINGLE);
+  engine()->AddStanzaHandler(&second, XmppEngine::HL_SINGLE);
+  engine()->AddStanzaHandler(&third, XmppEngine::HL_SINGLE);
+  first.RemoveOnCall(engine(), &second);
+
+  std::string input = "<message id='1'/>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[first 1][third 1]", log);
+  log.clear();
+
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[first 1][third 1]", log);
+
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&first));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&third));
+}
+
+// TestSetStanzaFilter()
+//    This tests that changing a handler's filter keeps its place in the
+//    order, including while the stanza is being dispatched.
+TEST_F(XmppEngineTest, TestSetStanzaFilter) {
+  std::string log;
+  XmppEngineTestStanzaHandler first("first", &log);
+  XmppEngineTestStanzaHandler second("second", &log);
+  XmppEngineTestStanzaHandler third("third", &log);
+
+  RunLogin();
+
+  XmppStanzaFilter ns_filter;
+  ns_filter.child_ns = "jabber:iq:roster";
+  engine()->AddStanzaHandler(&first, XmppEngine::HL_SINGLE);
+  engine()->AddStanzaHandler(&second, XmppEngine::HL_SINGLE, ns_filter);
+  engine()->AddStanzaHandler(&third, XmppEngine::HL_SINGLE);
+
+  std::string input = "<iq type='set' id='1'>"
+                      "<query xmlns='jabber:iq:roster'/></iq>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[first 1][second 1][third 1]", log);
+  log.clear();
+
+  // Swap which handlers are indexed; the order stays the same.
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->SetStanzaFilter(&first, ns_filter));
+  EXPECT_EQ(XMPP_RETURN_OK,
+            engine()->SetStanzaFilter(&second, XmppStanzaFilter()));
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[first 1][second 1][third 1]", log);
+  log.clear();
+
+  // With only unindexed handlers, a handler that changes its own filter
+  // while it has the stanza is not offered the stanza again, and the ones
+  // after it still are.
+  EXPECT_EQ(XMPP_RETURN_OK,
+            engine()->SetStanzaFilter(&first, XmppStanzaFilter()));
+  XmppStanzaFilter type_filter;
+  type_filter.type = "set";
+  first.SetFilterOnCall(engine(), &first, type_filter);
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[first 1][second 1][third 1]", log);
+  log.clear();
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[first 1][second 1][third 1]", log);
+  log.clear();
+
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&first));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&second));
+  EXPECT_EQ(XMPP_RETURN_BADARGUMENT,
+            engine()->SetStanzaFilter(&second, ns_filter));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&third));
+}
+
+// TestSelectiveParsing()
+//    This tests that with selective parsing on, a stanza is built with only
+//    the children some handler's filter may look at.
+TEST_F(XmppEngineTest, TestSelectiveParsing) {
+  std::string log;
+  XmppEngineTestStanzaHandler caps("caps", &log);
+  XmppEngineTestStanzaHandler any("any", &log);
+
+  RunLogin();
+  // The fixture's handler takes every stanza, which would keep every child.
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(handler()));
+  engine()->SetSelectiveParsing(true);
+
+  XmppStanzaFilter caps_filter;
+  caps_filter.name = buzz::QN_PRESENCE;
+  caps_filter.child_ns = "http://jabber.org/protocol/caps";
+  engine()->AddStanzaHandler(&caps, XmppEngine::HL_SINGLE, caps_filter);
+
+  std::string input = "<presence id='1'><show>away</show>"
+      "<c xmlns='http://jabber.org/protocol/caps' ver='1'/></presence>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[caps 1]", log);
+  log.clear();
+  XmlElement* stanza = XmlElement::ForStr(caps.last_stanza());
+  EXPECT_EQ("1", stanza->Attr(buzz::QN_SKIPPED_CHILDREN));
+  EXPECT_TRUE(stanza->FirstNamed(buzz::QN_SHOW) == NULL);
+  EXPECT_TRUE(stanza->FirstNamed(
+      QName("http://jabber.org/protocol/caps", "c")) != NULL);
+  delete stanza;
+
+  // Iqs are always built in full.
+  input = "<iq type='get' id='2'><query xmlns='jabber:iq:version'/></iq>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("", log);
+  EXPECT_EQ("<iq type=\"error\" id=\"2\">"
+      "<query xmlns=\"jabber:iq:version\"/>"
+      "<error code=\"501\" type=\"cancel\"><feature-not-implemented "
+      "xmlns=\"urn:ietf:params:xml:ns:xmpp-stanzas\"/></error></iq>",
+      handler()->OutputActivity());
+
+  // A handler that may look at any child keeps every child.
+  engine()->AddStanzaHandler(&any, XmppEngine::HL_SINGLE);
+  input = "<presence id='3'>"
+      "<c xmlns='http://jabber.org/protocol/caps' ver='1'/>"
+      "<show>away</show></presence>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("[caps 3][any 3]", log);
+  stanza = XmlElement::ForStr(any.last_stanza());
+  EXPECT_FALSE(stanza->HasAttr(buzz::QN_SKIPPED_CHILDREN));
+  EXPECT_TRUE(stanza->FirstNamed(buzz::QN_SHOW) != NULL);
+  delete stanza;
+
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&caps));
+  EXPECT_EQ(XMPP_RETURN_OK, engine()->RemoveStanzaHandler(&any));
+}
+
+// TestOutputCoalescing()
+//    This tests that stanzas sent while coalescing go out in one write.
+TEST_F(XmppEngineTest, TestOutputCoalescing) {
+  RunLogin();
+  buzz::XmppTrafficStats before = engine()->GetTrafficStats();
+  EXPECT_LT(0, before.writes);
+  EXPECT_EQ(before.bytes_sent, before.bytes_sent_uncompressed);
+
+  engine()->SetOutputCoalescing(true);
+  XmlElement presence(QName("jabber:client", "presence"));
+  for (int i = 0; i < 3; ++i)
+    engine()->SendStanza(&presence);
+  EXPECT_EQ("", handler()->OutputActivity());
+  EXPECT_EQ(before.writes, engine()->GetTrafficStats().writes);
+
+  engine()->FlushOutput();
+  EXPECT_EQ("<presence/><presence/><presence/>", handler()->OutputActivity());
+  buzz::XmppTrafficStats after = engine()->GetTrafficStats();
+  EXPECT_EQ(before.writes + 1, after.writes);
+  EXPECT_EQ(before.bytes_sent + 33, after.bytes_sent);
+
+  // Nothing held, nothing written.
+  engine()->FlushOutput();
+  EXPECT_EQ(after.writes, engine()->GetTrafficStats().writes);
+}
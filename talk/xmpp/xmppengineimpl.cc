@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "talk/base/common.h"
+#include "talk/base/logging.h"
 #include "talk/xmllite/xmlelement.h"
 #include "talk/xmllite/xmlprinter.h"
 #include "talk/xmpp/constants.h"
@@ -44,6 +45,41 @@ XmppEngine* XmppEngine::Create() {
   return new XmppEngineImpl();
 }
 
+bool XmppStanzaFilter::IsEmpty() const {
+  return name.IsEmpty() && type.empty() && child_ns.empty() && id.empty();
+}
+
+bool XmppStanzaFilter::Matches(const XmlElement* stanza) const {
+  if (!name.IsEmpty() && stanza->Name() != name)
+    return false;
+  if (!id.empty() && stanza->Attr(QN_ID) != id)
+    return false;
+  if (!type.empty() && stanza->Attr(QN_TYPE) != type)
+    return false;
+  if (!child_ns.empty()) {
+    const XmlElement* child = stanza->FirstElement();
+    if (!child || child->Name().Namespace() != child_ns)
+      return false;
+  }
+  return true;
+}
+
+// Index keys are tagged with the field they come from.  A filter is filed
+// under its most selective field; a stanza is looked up under all three.
+static const char kIdKey[] = "id:";
+static const char kNamespaceKey[] = "ns:";
+static const char kNameKey[] = "qn:";
+
+static std::string FilterKey(const XmppStanzaFilter& filter) {
+  if (!filter.id.empty())
+    return kIdKey + filter.id;
+  if (!filter.child_ns.empty())
+    return kNamespaceKey + filter.child_ns;
+  if (!filter.name.IsEmpty())
+    return kNameKey + filter.name.Merged();
+  return std::string();
+}
+
 
 XmppEngineImpl::XmppEngineImpl()
     : stanza_parse_handler_(this),
@@ -62,12 +98,16 @@ XmppEngineImpl::XmppEngineImpl()
       raised_reset_(false),
       output_handler_(NULL),
       session_handler_(NULL),
-      iq_entries_(new IqEntryVector()),
+      next_handler_order_(0),
+      dispatch_depth_(0),
+      child_interests_valid_(false),
+      iq_timeout_ms_(0),
       sasl_handler_(NULL),
-      output_(new std::stringstream()) {
-  for (int i = 0; i < HL_COUNT; i+= 1) {
-    stanza_handlers_[i].reset(new StanzaHandlerVector());
-  }
+      coalesce_output_(false),
+      output_pending_(false),
+      use_compression_(false) {
+  // Stanzas are only borrowed by the handlers, so build them in an arena.
+  stanza_parser_.set_use_arena(true);
 
   // Add XMPP namespaces to XML namespaces stack.
   xmlns_stack_.AddXmlns("stream", "http://etherx.jabber.org/streams");
@@ -76,6 +116,13 @@ XmppEngineImpl::XmppEngineImpl()
 
 XmppEngineImpl::~XmppEngineImpl() {
   DeleteIqCookies();
+  for (StanzaHandlerMap::iterator it = stanza_handlers_.begin();
+       it != stanza_handlers_.end(); ++it) {
+    delete it->second;
+  }
+  for (size_t i = 0; i < removed_handlers_.size(); ++i) {
+    delete removed_handlers_[i];
+  }
 }
 
 XmppReturnStatus XmppEngineImpl::SetOutputHandler(
@@ -105,9 +152,29 @@ XmppReturnStatus XmppEngineImpl::HandleInput(
 
   EnterExit ee(this);
 
+  traffic_stats_.reads += 1;
+  traffic_stats_.bytes_received += len;
+
+  // Swap the scratch buffer out while it is in use, as for output_.
+  std::string input;
+  if (compressor_.active()) {
+    input.swap(decompressed_input_);
+    input.clear();
+    if (!compressor_.Decompress(bytes, len, &input)) {
+      SignalError(ERROR_XML, 0);
+      return XMPP_RETURN_OK;
+    }
+    bytes = input.data();
+    len = input.length();
+  }
+  traffic_stats_.bytes_received_uncompressed += len;
+
   // TODO: The return value of the xml parser is not checked.
   stanza_parser_.Parse(bytes, len, false);
 
+  if (decompressed_input_.empty())
+    input.swap(decompressed_input_);
+
   return XMPP_RETURN_OK;
 }
 
@@ -132,6 +199,13 @@ XmppReturnStatus XmppEngineImpl::SetTls(TlsOptions use_tls) {
   return XMPP_RETURN_OK;
 }
 
+XmppReturnStatus XmppEngineImpl::SetCompression(bool use_compression) {
+  if (state_ != STATE_START)
+    return XMPP_RETURN_BADSTATE;
+  use_compression_ = use_compression && XmppCompressor::IsAvailable();
+  return XMPP_RETURN_OK;
+}
+
 XmppReturnStatus XmppEngineImpl::SetTlsServer(
     const std::string& tls_server_hostname,
     const std::string& tls_server_domain) {
@@ -186,36 +260,102 @@ const std::string& XmppEngineImpl::GetRequestedResource() {
 XmppReturnStatus XmppEngineImpl::AddStanzaHandler(
     XmppStanzaHandler* stanza_handler,
     XmppEngine::HandlerLevel level) {
+  return AddStanzaHandler(stanza_handler, level, XmppStanzaFilter());
+}
+
+XmppReturnStatus XmppEngineImpl::AddStanzaHandler(
+    XmppStanzaHandler* stanza_handler,
+    XmppEngine::HandlerLevel level,
+    const XmppStanzaFilter& filter) {
   if (state_ == STATE_CLOSED)
     return XMPP_RETURN_BADSTATE;
 
-  stanza_handlers_[level]->push_back(stanza_handler);
+  StanzaHandlerEntry* entry = new StanzaHandlerEntry;
+  entry->handler = stanza_handler;
+  entry->filter = filter;
+  entry->level = level;
+  entry->order = next_handler_order_++;
+  entry->removed = false;
+  LinkHandlerEntry(entry);
+  stanza_handlers_.insert(std::make_pair(stanza_handler, entry));
 
   return XMPP_RETURN_OK;
 }
 
-XmppReturnStatus XmppEngineImpl::RemoveStanzaHandler(
-    XmppStanzaHandler* stanza_handler) {
-  bool found = false;
-
-  for (int level = 0; level < HL_COUNT; level += 1) {
-    StanzaHandlerVector::iterator new_end =
-      std::remove(stanza_handlers_[level]->begin(),
-      stanza_handlers_[level]->end(),
-      stanza_handler);
+XmppReturnStatus XmppEngineImpl::SetStanzaFilter(
+    XmppStanzaHandler* stanza_handler,
+    const XmppStanzaFilter& filter) {
+  std::pair<StanzaHandlerMap::iterator, StanzaHandlerMap::iterator> range =
+      stanza_handlers_.equal_range(stanza_handler);
+  if (range.first == range.second)
+    return XMPP_RETURN_BADARGUMENT;
 
-    if (new_end != stanza_handlers_[level]->end()) {
-      stanza_handlers_[level]->erase(new_end, stanza_handlers_[level]->end());
-      found = true;
-    }
+  // A stanza being dispatched may hold on to the old entry, so the handler
+  // gets a new entry with the same level and order.
+  for (StanzaHandlerMap::iterator it = range.first;
+       it != range.second; ++it) {
+    StanzaHandlerEntry* entry = new StanzaHandlerEntry(*it->second);
+    UnlinkHandlerEntry(it->second);
+    entry->filter = filter;
+    LinkHandlerEntry(entry);
+    it->second = entry;
   }
 
-  if (!found)
+  return XMPP_RETURN_OK;
+}
+
+XmppReturnStatus XmppEngineImpl::RemoveStanzaHandler(
+    XmppStanzaHandler* stanza_handler) {
+  std::pair<StanzaHandlerMap::iterator, StanzaHandlerMap::iterator> range =
+      stanza_handlers_.equal_range(stanza_handler);
+  if (range.first == range.second)
     return XMPP_RETURN_BADARGUMENT;
 
+  for (StanzaHandlerMap::iterator it = range.first;
+       it != range.second; ++it) {
+    UnlinkHandlerEntry(it->second);
+  }
+  stanza_handlers_.erase(range.first, range.second);
+
   return XMPP_RETURN_OK;
 }
 
+// Files the entry under its filter's key, or among the unindexed handlers,
+// which are kept in order.
+void XmppEngineImpl::LinkHandlerEntry(StanzaHandlerEntry* entry) {
+  child_interests_valid_ = false;
+  std::string key = FilterKey(entry->filter);
+  entry->indexed = !key.empty();
+  if (entry->indexed) {
+    entry->index_pos =
+        indexed_handlers_[entry->level].insert(std::make_pair(key, entry));
+  } else {
+    StanzaHandlerVector& handlers = unindexed_handlers_[entry->level];
+    handlers.insert(std::upper_bound(handlers.begin(), handlers.end(),
+                                     entry, HandlerOrderLess),
+                    entry);
+  }
+}
+
+// Takes the entry out of dispatch and frees it.  A stanza being dispatched
+// may still hold on to the entry, so while one is, unindexed entries stay in
+// place and all are freed later.
+void XmppEngineImpl::UnlinkHandlerEntry(StanzaHandlerEntry* entry) {
+  child_interests_valid_ = false;
+  entry->removed = true;
+  if (entry->indexed) {
+    indexed_handlers_[entry->level].erase(entry->index_pos);
+  } else if (dispatch_depth_ == 0) {
+    StanzaHandlerVector& handlers = unindexed_handlers_[entry->level];
+    handlers.erase(std::find(handlers.begin(), handlers.end(), entry));
+  }
+  if (dispatch_depth_ > 0) {
+    removed_handlers_.push_back(entry);
+  } else {
+    delete entry;
+  }
+}
+
 XmppReturnStatus XmppEngineImpl::Connect() {
   if (state_ != STATE_START)
     return XMPP_RETURN_BADSTATE;
@@ -256,7 +396,7 @@ XmppReturnStatus XmppEngineImpl::SendRaw(const std::string& text) {
 
   EnterExit ee(this);
 
-  (*output_) << text;
+  output_.append(text);
 
   return XMPP_RETURN_OK;
 }
@@ -271,7 +411,7 @@ XmppReturnStatus XmppEngineImpl::Disconnect() {
   if (state_ != STATE_CLOSED) {
     EnterExit ee(this);
     if (state_ == STATE_OPEN)
-      *output_ << "</stream:stream>";
+      output_.append("</stream:stream>");
     state_ = STATE_CLOSED;
   }
 
@@ -309,18 +449,26 @@ void XmppEngineImpl::IncomingStanza(const XmlElement* stanza) {
   } else if (HandleIqResponse(stanza)) {
     // iq is handled by above call
   } else {
+    // Where to look in the handler indexes, worked out by the first level
+    // that has an index.
+    std::vector<std::string> keys;
+
+    dispatch_depth_ += 1;
+
     // give every "peek" handler a shot at all stanzas
-    for (size_t i = 0; i < stanza_handlers_[HL_PEEK]->size(); i += 1) {
-      (*stanza_handlers_[HL_PEEK])[i]->HandleStanza(stanza);
-    }
+    DispatchStanza(HL_PEEK, stanza, &keys);
 
     // give other handlers a shot in precedence order, stopping after handled
-    for (int level = HL_SINGLE; level <= HL_ALL; level += 1) {
-      for (size_t i = 0; i < stanza_handlers_[level]->size(); i += 1) {
-        if ((*stanza_handlers_[level])[i]->HandleStanza(stanza))
-          return;
-      }
-    }
+    bool handled = false;
+    for (int level = HL_SINGLE; level <= HL_ALL && !handled; level += 1)
+      handled = DispatchStanza(level, stanza, &keys);
+
+    dispatch_depth_ -= 1;
+    if (dispatch_depth_ == 0 && !removed_handlers_.empty())
+      FreeRemovedHandlers();
+
+    if (handled)
+      return;
 
     // If nobody wants to handle a stanza then send back an error.
     // Only do this for IQ stanzas as messages should probably just be dropped
@@ -333,6 +481,147 @@ void XmppEngineImpl::IncomingStanza(const XmlElement* stanza) {
   }
 }
 
+// Tells the stanza parser, in selective mode, whether a handler may look at
+// a child of a stanza.  Filters on the stanza id or type are ignored, which
+// only builds more than needed.
+bool XmppEngineImpl::WantsStanzaChild(const XmlElement* stanza,
+                                      const QName& child) {
+  // The login exchange, iq responses and error replies to unhandled iqs
+  // use the whole stanza, whoever handles it.
+  if (login_task_.get() || stanza->Name() == QN_IQ ||
+      stanza->Name() == QN_STREAM_ERROR)
+    return true;
+
+  if (!child_interests_valid_)
+    UpdateChildInterests();
+  // Handlers without a stanza name are filed under the empty QName.
+  const QName names[] = { stanza->Name(), QName() };
+  for (int i = 0; i < ARRAY_SIZE(names); ++i) {
+    ChildInterestMap::const_iterator it = child_interests_.find(names[i]);
+    if (it != child_interests_.end() &&
+        (it->second.all || it->second.namespaces.count(child.Namespace())))
+      return true;
+  }
+  return false;
+}
+
+void XmppEngineImpl::UpdateChildInterests() {
+  child_interests_.clear();
+  for (StanzaHandlerMap::const_iterator it = stanza_handlers_.begin();
+       it != stanza_handlers_.end(); ++it) {
+    if (it->second->removed)
+      continue;
+    const XmppStanzaFilter& filter = it->second->filter;
+    ChildInterest& interest = child_interests_[filter.name];
+    if (filter.child_ns.empty()) {
+      interest.all = true;
+    } else {
+      interest.namespaces.insert(filter.child_ns);
+    }
+  }
+  child_interests_valid_ = true;
+}
+
+bool XmppEngineImpl::HandlerOrderLess(const StanzaHandlerEntry* a,
+                                      const StanzaHandlerEntry* b) {
+  return a->order < b->order;
+}
+
+// Offers the stanza to the handlers at one level, in the order they were
+// added.  Peek handlers all get it; at other levels the first handler to
+// take it stops the walk.  Returns true if a handler took it.  Handlers
+// added meanwhile are not offered this stanza.
+bool XmppEngineImpl::DispatchStanza(int level, const XmlElement* stanza,
+                                    std::vector<std::string>* keys) {
+  const StanzaHandlerVector& unindexed = unindexed_handlers_[level];
+  const StanzaHandlerIndex& index = indexed_handlers_[level];
+  if (index.empty()) {
+    // Entries removed meanwhile stay in the vector until the dispatch
+    // unwinds, so the walk needs no copy.  An entry whose filter changed
+    // meanwhile comes back with its old order, so the walk resumes after
+    // the last order it offered the stanza to.
+    int next_order = next_handler_order_;
+    int last_order = -1;
+    for (size_t i = 0; i < unindexed.size(); ++i) {
+      const StanzaHandlerEntry* entry = unindexed[i];
+      if (entry->order >= next_order)
+        break;
+      if (entry->order <= last_order || entry->removed ||
+          !entry->filter.Matches(stanza))
+        continue;
+      last_order = entry->order;
+      if (entry->handler->HandleStanza(stanza) && level != HL_PEEK)
+        return true;
+      if (i >= unindexed.size() || unindexed[i] != entry) {
+        i = std::upper_bound(unindexed.begin(), unindexed.end(), entry,
+                             HandlerOrderLess) - unindexed.begin() - 1;
+      }
+    }
+    return false;
+  }
+
+  if (keys->empty()) {
+    if (stanza->HasAttr(QN_ID))
+      keys->push_back(kIdKey + stanza->Attr(QN_ID));
+    const XmlElement* child = stanza->FirstElement();
+    if (child)
+      keys->push_back(kNamespaceKey + child->Name().Namespace());
+    keys->push_back(kNameKey + stanza->Name().Merged());
+  }
+
+  // Collect the candidates first, so handlers can add and remove
+  // handlers while the stanza is being delivered.  Each key, and the
+  // unindexed handlers, mostly yield candidates in the order they were
+  // added, so they only need sorting when that order was broken.
+  StanzaHandlerVector candidates;
+  for (size_t i = 0; i < keys->size(); ++i) {
+    std::pair<StanzaHandlerIndex::const_iterator,
+              StanzaHandlerIndex::const_iterator> range =
+        index.equal_range((*keys)[i]);
+    for (StanzaHandlerIndex::const_iterator it = range.first;
+         it != range.second; ++it) {
+      if (it->second->filter.Matches(stanza))
+        candidates.push_back(it->second);
+    }
+  }
+  for (size_t i = 0; i < unindexed.size(); ++i) {
+    if (!unindexed[i]->removed && unindexed[i]->filter.Matches(stanza))
+      candidates.push_back(unindexed[i]);
+  }
+  for (size_t i = 1; i < candidates.size(); ++i) {
+    if (HandlerOrderLess(candidates[i], candidates[i - 1])) {
+      std::sort(candidates.begin(), candidates.end(), HandlerOrderLess);
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (candidates[i]->removed)
+      continue;
+    if (candidates[i]->handler->HandleStanza(stanza) && level != HL_PEEK)
+      return true;
+  }
+  return false;
+}
+
+// Drops the entries removed during a dispatch from the unindexed handlers,
+// and frees them.
+void XmppEngineImpl::FreeRemovedHandlers() {
+  for (int level = HL_PEEK; level <= HL_ALL; level += 1) {
+    StanzaHandlerVector& handlers = unindexed_handlers_[level];
+    handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+                                  IsHandlerRemoved),
+                   handlers.end());
+  }
+  for (size_t i = 0; i < removed_handlers_.size(); ++i)
+    delete removed_handlers_[i];
+  removed_handlers_.clear();
+}
+
+bool XmppEngineImpl::IsHandlerRemoved(const StanzaHandlerEntry* entry) {
+  return entry->removed;
+}
+
 void XmppEngineImpl::IncomingEnd(bool isError) {
   if (HasError() || raised_reset_)
     return;
@@ -353,11 +642,13 @@ void XmppEngineImpl::InternalSendStart(const std::string& to) {
   // send stream-beginning
   // note, we put a \r\n at tne end fo the first line to cause non-XMPP
   // line-oriented servers (e.g., Apache) to reveal themselves more quickly.
-  *output_ << "<stream:stream to=\"" << hostname << "\" "
-           << "xml:lang=\"" << lang << "\" "
-           << "version=\"1.0\" "
-           << "xmlns:stream=\"http://etherx.jabber.org/streams\" "
-           << "xmlns=\"jabber:client\">\r\n";
+  output_.append("<stream:stream to=\"");
+  output_.append(hostname);
+  output_.append("\" xml:lang=\"");
+  output_.append(lang);
+  output_.append("\" version=\"1.0\" "
+                 "xmlns:stream=\"http://etherx.jabber.org/streams\" "
+                 "xmlns=\"jabber:client\">\r\n");
 }
 
 void XmppEngineImpl::InternalSendStanza(const XmlElement* element) {
@@ -366,7 +657,7 @@ void XmppEngineImpl::InternalSendStanza(const XmlElement* element) {
   // (by flipping from/to on a message?) the server will close the stream.
   ASSERT(!element->HasAttr(QN_FROM));
 
-  XmlPrinter::PrintXml(output_.get(), element, &xmlns_stack_);
+  XmlPrinter::PrintXml(&output_, element, &xmlns_stack_);
 }
 
 std::string XmppEngineImpl::ChooseBestSaslMechanism(
@@ -416,6 +707,59 @@ void XmppEngineImpl::StartTls(const std::string& domain) {
   }
 }
 
+bool XmppEngineImpl::StartCompression() {
+  // Whatever is queued was sent before the switch and goes out as is.
+  WriteBufferedOutput();
+  return compressor_.Start();
+}
+
+void XmppEngineImpl::FlushOutput() {
+  if (!output_pending_)
+    return;
+
+  // Closes the connection if the output fails to compress.
+  EnterExit ee(this);
+  WriteBufferedOutput();
+}
+
+void XmppEngineImpl::WriteBufferedOutput() {
+  output_pending_ = false;
+  if (!output_handler_ || output_.empty())
+    return;
+
+  // Swap the pending bytes out in case writing them sends more, and swap
+  // the emptied buffer back to reuse its capacity.
+  std::string output;
+  output.swap(output_);
+  traffic_stats_.bytes_sent_uncompressed += output.length();
+
+  std::string compressed;
+  if (compressor_.active()) {
+    compressed.swap(compressed_output_);
+    compressed.clear();
+    if (!compressor_.Compress(output.data(), output.length(), &compressed)) {
+      // The stream cannot go on without the output; the caller closes it.
+      LOG(LS_ERROR) << "Output failed to compress";
+      compressed.clear();
+      SignalError(ERROR_XML, 0);
+    }
+  }
+  const std::string& data = compressor_.active() ? compressed : output;
+
+  if (!data.empty()) {
+    traffic_stats_.bytes_sent += data.length();
+    traffic_stats_.writes += 1;
+    output_handler_->WriteOutput(data.data(), data.length());
+  }
+
+  if (output_.empty()) {
+    output.clear();
+    output.swap(output_);
+  }
+  if (compressed_output_.empty())
+    compressed.swap(compressed_output_);
+}
+
 XmppEngineImpl::EnterExit::EnterExit(XmppEngineImpl* engine)
     : engine_(engine),
   state_(engine->state_),
@@ -433,10 +777,16 @@ XmppEngineImpl::EnterExit::~EnterExit()  {
  bool flushing = closing || (engine->engine_entered_ == 0);
 
  if (engine->output_handler_ && flushing) {
-   std::string output = engine->output_->str();
-   if (output.length() > 0)
-     engine->output_handler_->WriteOutput(output.c_str(), output.length());
-   engine->output_->str("");
+   if (closing || !engine->coalesce_output_) {
+     engine->WriteBufferedOutput();
+     // Writing closes the stream if the output fails to compress.
+     closing = (engine->state_ != state_ &&
+                engine->state_ == STATE_CLOSED);
+   } else if (!engine->output_.empty() && !engine->output_pending_) {
+     // Hold the output until the owner calls FlushOutput.
+     engine->output_pending_ = true;
+     engine->output_handler_->OnOutputPending();
+   }
 
    if (closing) {
      engine->output_handler_->CloseConnection();
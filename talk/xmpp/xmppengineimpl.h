@@ -28,8 +28,12 @@
 #ifndef TALK_XMPP_XMPPENGINEIMPL_H_
 #define TALK_XMPP_XMPPENGINEIMPL_H_
 
+#include <list>
+#include <map>
+#include <set>
 #include <sstream>
 #include <vector>
+#include "talk/xmpp/xmppcompressor.h"
 #include "talk/xmpp/xmppengine.h"
 #include "talk/xmpp/xmppstanzaparser.h"
 
@@ -79,6 +83,9 @@ class XmppEngineImpl : public XmppEngine {
   //! Sets whether TLS will be used within the connection (default true).
   virtual XmppReturnStatus SetTls(TlsOptions use_tls);
 
+  //! Sets whether to ask for zlib stream compression after authentication.
+  virtual XmppReturnStatus SetCompression(bool use_compression);
+
   //! Sets an alternate domain from which we allows TLS certificates.
   //! This is for use in the case where a we want to allow a proxy to
   //! serve up its own certificate rather than one owned by the underlying
@@ -118,6 +125,25 @@ class XmppEngineImpl : public XmppEngine {
   //! Returns true if the connection is encrypted (under TLS)
   virtual bool IsEncrypted() { return encrypted_; }
 
+  //! Returns true if the stream is compressed.
+  virtual bool IsCompressed() { return compressor_.active(); }
+
+  //! Sets whether output is held until FlushOutput.
+  virtual void SetOutputCoalescing(bool coalesce) {
+    coalesce_output_ = coalesce;
+  }
+
+  //! Writes any output held back by coalescing.
+  virtual void FlushOutput();
+
+  //! Sets whether stanzas are built only as far as the handlers need.
+  virtual void SetSelectiveParsing(bool selective) {
+    stanza_parser_.set_selective(selective);
+  }
+
+  //! Byte and write counters for the connection.
+  virtual XmppTrafficStats GetTrafficStats() { return traffic_stats_; }
+
   //! The error code.
   //! Consult this after XmppOutputHandler.OnClose().
   virtual Error GetError(int *subcode) {
@@ -146,6 +172,15 @@ class XmppEngineImpl : public XmppEngine {
   virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler,
                                             XmppEngine::HandlerLevel level);
 
+  //! Adds a listener that only sees stanzas matching the filter.
+  virtual XmppReturnStatus AddStanzaHandler(XmppStanzaHandler* handler,
+                                            XmppEngine::HandlerLevel level,
+                                            const XmppStanzaFilter& filter);
+
+  //! Replaces the filter of a listener, keeping its place in the order.
+  virtual XmppReturnStatus SetStanzaFilter(XmppStanzaHandler* handler,
+                                           const XmppStanzaFilter& filter);
+
   //! Removes a listener for session events.
   virtual XmppReturnStatus RemoveStanzaHandler(XmppStanzaHandler* handler);
 
@@ -166,6 +201,18 @@ class XmppEngineImpl : public XmppEngine {
   virtual XmppReturnStatus RemoveIqHandler(XmppIqCookie cookie,
                                       XmppIqHandler** iq_handler);
 
+  //! Sets how long an iq sent from now on waits for its response.
+  virtual void SetIqTimeout(int timeout_ms);
+
+  //! Milliseconds until the next pending iq times out, or -1 if none will.
+  virtual int GetNextIqTimeout();
+
+  //! Expires the pending iqs whose time is up.
+  virtual void HandleIqTimeouts();
+
+  //! Counters of outstanding, answered and expired iqs.
+  virtual XmppIqStats GetIqStats();
+
   //! Forms and sends an error in response to the given stanza.
   //! Swaps to and from, sets type to "error", and adds error information
   //! based on the passed code.  Text is optional and may be STR_EMPTY.
@@ -188,6 +235,9 @@ class XmppEngineImpl : public XmppEngine {
   friend class XmppIqEntry;
 
   void IncomingStanza(const XmlElement *stanza);
+  bool WantsStanzaChild(const XmlElement* stanza, const QName& child);
+  bool DispatchStanza(int level, const XmlElement* stanza,
+                      std::vector<std::string>* keys);
   void IncomingStart(const XmlElement *stanza);
   void IncomingEnd(bool isError);
 
@@ -202,7 +252,11 @@ class XmppEngineImpl : public XmppEngine {
   bool HasError();
   void DeleteIqCookies();
   bool HandleIqResponse(const XmlElement* element);
+  void ExpireIq(XmppIqEntry* iq_entry);
+  void UnlinkIqEntry(XmppIqEntry* iq_entry);
   void StartTls(const std::string& domain);
+  bool StartCompression();
+  void WriteBufferedOutput();
   void RaiseReset() { raised_reset_ = true; }
 
   class StanzaParseHandler : public XmppStanzaParseHandler {
@@ -222,6 +276,9 @@ class XmppEngineImpl : public XmppEngine {
     virtual void XmlError() {
       outer_->IncomingEnd(true);
     }
+    virtual bool WantsChild(const XmlElement* stanza, const QName& child) {
+      return outer_->WantsStanzaChild(stanza, child);
+    }
 
    private:
     XmppEngineImpl* const outer_;
@@ -268,15 +325,79 @@ class XmppEngineImpl : public XmppEngine {
 
   XmlnsStack xmlns_stack_;
 
-  typedef std::vector<XmppStanzaHandler*> StanzaHandlerVector;
-  talk_base::scoped_ptr<StanzaHandlerVector> stanza_handlers_[HL_COUNT];
-
-  typedef std::vector<XmppIqEntry*> IqEntryVector;
-  talk_base::scoped_ptr<IqEntryVector> iq_entries_;
+  // A registered stanza handler.  Handlers whose filter names an id, a
+  // child namespace or a stanza name sit in the index under that key;
+  // the rest are offered every stanza, as before.  Entries removed while
+  // a stanza is being dispatched are marked, and freed once the dispatch
+  // unwinds.
+  struct StanzaHandlerEntry;
+  typedef std::vector<StanzaHandlerEntry*> StanzaHandlerVector;
+  typedef std::multimap<std::string, StanzaHandlerEntry*> StanzaHandlerIndex;
+  struct StanzaHandlerEntry {
+    XmppStanzaHandler* handler;
+    XmppStanzaFilter filter;
+    int level;
+    int order;
+    bool indexed;
+    bool removed;
+    StanzaHandlerIndex::iterator index_pos;
+  };
+  typedef std::multimap<XmppStanzaHandler*, StanzaHandlerEntry*>
+      StanzaHandlerMap;
+  static bool HandlerOrderLess(const StanzaHandlerEntry* a,
+                               const StanzaHandlerEntry* b);
+  static bool IsHandlerRemoved(const StanzaHandlerEntry* entry);
+  void LinkHandlerEntry(StanzaHandlerEntry* entry);
+  void UnlinkHandlerEntry(StanzaHandlerEntry* entry);
+  void FreeRemovedHandlers();
+  StanzaHandlerMap stanza_handlers_;
+  StanzaHandlerVector unindexed_handlers_[HL_COUNT];
+  StanzaHandlerIndex indexed_handlers_[HL_COUNT];
+  StanzaHandlerVector removed_handlers_;
+  int next_handler_order_;
+  int dispatch_depth_;
+
+  // For selective parsing, the children that the handlers may look at, by
+  // stanza name; handlers that take any stanza are under the empty name.
+  // Rebuilt from the filters after handlers change.
+  struct ChildInterest {
+    ChildInterest() : all(false) {}
+    bool all;  // Some handler takes the stanza whatever its children.
+    std::set<std::string> namespaces;
+  };
+  typedef std::map<QName, ChildInterest> ChildInterestMap;
+  void UpdateChildInterests();
+  ChildInterestMap child_interests_;
+  bool child_interests_valid_;
+
+  // Pending iqs are indexed by id, so a response is matched without
+  // walking every outstanding request.  The set validates cookies handed
+  // back to RemoveIqHandler, and the list holds the iqs that can time out,
+  // earliest deadline first.
+  typedef std::multimap<std::string, XmppIqEntry*> IqEntryMap;
+  typedef std::set<XmppIqEntry*> IqEntrySet;
+  typedef std::list<XmppIqEntry*> IqEntryList;
+  IqEntryMap iq_entries_;
+  IqEntrySet iq_cookies_;
+  IqEntryList iq_deadlines_;
+  int iq_timeout_ms_;
+  XmppIqStats iq_stats_;
 
   talk_base::scoped_ptr<SaslHandler> sasl_handler_;
 
-  talk_base::scoped_ptr<std::stringstream> output_;
+  // Bytes waiting to be written. The buffer keeps its capacity across
+  // flushes, so steady traffic does not reallocate it.
+  std::string output_;
+  bool coalesce_output_;
+  bool output_pending_;
+
+  // Stream compression, and scratch buffers reused the same way as output_.
+  bool use_compression_;
+  XmppCompressor compressor_;
+  std::string compressed_output_;
+  std::string decompressed_input_;
+
+  XmppTrafficStats traffic_stats_;
 };
 
 }  // namespace buzz
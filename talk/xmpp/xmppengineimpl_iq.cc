@@ -28,6 +28,7 @@
 #include <vector>
 #include <algorithm>
 #include "talk/base/common.h"
+#include "talk/base/timeutils.h"
 #include "talk/xmpp/xmppengineimpl.h"
 #include "talk/xmpp/constants.h"
 
@@ -39,7 +40,9 @@ class XmppIqEntry {
     id_(id),
     to_(to),
     engine_(pxce),
-    iq_handler_(iq_handler) {
+    iq_handler_(iq_handler),
+    deadline_(0),
+    has_deadline_(false) {
   }
 
 private:
@@ -49,6 +52,10 @@ private:
   const std::string to_;
   XmppEngine * const engine_;
   XmppIqHandler * const iq_handler_;
+  uint32 deadline_;
+  bool has_deadline_;
+  XmppEngineImpl::IqEntryMap::iterator by_id_;
+  XmppEngineImpl::IqEntryList::iterator by_deadline_;
 };
 
 
@@ -73,7 +80,29 @@ XmppEngineImpl::SendIq(const XmlElement * element, XmppIqHandler * iq_handler,
   XmppIqEntry * iq_entry = new XmppIqEntry(id,
                                               element->Attr(QN_TO),
                                               this, iq_handler);
-  iq_entries_->push_back(iq_entry);
+  iq_entry->by_id_ = iq_entries_.insert(std::make_pair(id, iq_entry));
+  iq_cookies_.insert(iq_entry);
+
+  if (iq_timeout_ms_ > 0) {
+    // Deadlines almost always arrive in order, so the walk back from the
+    // end stops at once unless the timeout was shortened meanwhile.
+    iq_entry->deadline_ = talk_base::TimeAfter(iq_timeout_ms_);
+    iq_entry->has_deadline_ = true;
+    IqEntryList::iterator pos = iq_deadlines_.end();
+    while (pos != iq_deadlines_.begin()) {
+      IqEntryList::iterator prev = pos;
+      --prev;
+      if (!talk_base::TimeIsLater(iq_entry->deadline_, (*prev)->deadline_))
+        break;
+      pos = prev;
+    }
+    iq_entry->by_deadline_ = iq_deadlines_.insert(pos, iq_entry);
+    if (iq_entry->by_deadline_ == iq_deadlines_.begin() && session_handler_)
+      session_handler_->OnIqTimeoutChanged();
+  }
+
+  iq_stats_.pending += 1;
+  iq_stats_.sent += 1;
   SendStanza(element);
 
   if (cookie)
@@ -86,18 +115,13 @@ XmppEngineImpl::SendIq(const XmlElement * element, XmppIqHandler * iq_handler,
 XmppReturnStatus
 XmppEngineImpl::RemoveIqHandler(XmppIqCookie cookie,
     XmppIqHandler ** iq_handler) {
-
-  std::vector<XmppIqEntry*, std::allocator<XmppIqEntry*> >::iterator pos;
-
-  pos = std::find(iq_entries_->begin(),
-                  iq_entries_->end(),
-                  reinterpret_cast<XmppIqEntry*>(cookie));
-
-  if (pos == iq_entries_->end())
+  IqEntrySet::iterator pos =
+      iq_cookies_.find(reinterpret_cast<XmppIqEntry*>(cookie));
+  if (pos == iq_cookies_.end())
     return XMPP_RETURN_BADARGUMENT;
 
   XmppIqEntry* entry = *pos;
-  iq_entries_->erase(pos);
+  UnlinkIqEntry(entry);
   if (iq_handler)
     *iq_handler = entry->iq_handler_;
   delete entry;
@@ -105,14 +129,56 @@ XmppEngineImpl::RemoveIqHandler(XmppIqCookie cookie,
   return XMPP_RETURN_OK;
 }
 
+void
+XmppEngineImpl::UnlinkIqEntry(XmppIqEntry* iq_entry) {
+  iq_entries_.erase(iq_entry->by_id_);
+  iq_cookies_.erase(iq_entry);
+  if (iq_entry->has_deadline_)
+    iq_deadlines_.erase(iq_entry->by_deadline_);
+  iq_stats_.pending -= 1;
+}
+
 void
 XmppEngineImpl::DeleteIqCookies() {
-  for (size_t i = 0; i < iq_entries_->size(); i += 1) {
-    XmppIqEntry * iq_entry_ = (*iq_entries_)[i];
-    (*iq_entries_)[i] = NULL;
-    delete iq_entry_;
+  for (IqEntryMap::iterator it = iq_entries_.begin();
+       it != iq_entries_.end(); ++it) {
+    delete it->second;
   }
-  iq_entries_->clear();
+  iq_entries_.clear();
+  iq_cookies_.clear();
+  iq_deadlines_.clear();
+  iq_stats_.pending = 0;
+}
+
+void
+XmppEngineImpl::SetIqTimeout(int timeout_ms) {
+  iq_timeout_ms_ = talk_base::_max(timeout_ms, 0);
+}
+
+int
+XmppEngineImpl::GetNextIqTimeout() {
+  if (iq_deadlines_.empty())
+    return -1;
+  return talk_base::_max(
+      talk_base::TimeUntil(iq_deadlines_.front()->deadline_), 0);
+}
+
+void
+XmppEngineImpl::HandleIqTimeouts() {
+  EnterExit ee(this);
+
+  uint32 now = talk_base::Time();
+  while (!iq_deadlines_.empty()) {
+    XmppIqEntry* iq_entry = iq_deadlines_.front();
+    if (talk_base::TimeIsLater(now, iq_entry->deadline_))
+      break;
+    ExpireIq(iq_entry);
+  }
+}
+
+XmppIqStats
+XmppEngineImpl::GetIqStats() {
+  return iq_stats_;
 }
 
 static void
@@ -246,25 +312,46 @@ XmppEngineImpl::SendStanzaError(const XmlElement * element_original,
 }
 
 
+// Answers a pending iq on the server's behalf with a timeout error, so
+// its handler hears back exactly once whichever way the iq ends.
+void
+XmppEngineImpl::ExpireIq(XmppIqEntry* iq_entry) {
+  UnlinkIqEntry(iq_entry);
+  iq_stats_.expired += 1;
+
+  XmlElement error_element(QN_IQ);
+  error_element.AddAttr(QN_TYPE, "error");
+  error_element.AddAttr(QN_ID, iq_entry->id_);
+  if (!iq_entry->to_.empty())
+    error_element.AddAttr(QN_FROM, iq_entry->to_);
+  AddErrorCode(&error_element, XSE_SERVER_TIMEOUT);
+
+  iq_entry->iq_handler_->IqResponse(iq_entry, &error_element);
+  delete iq_entry;
+}
+
+
 bool
 XmppEngineImpl::HandleIqResponse(const XmlElement * element) {
-  if (iq_entries_->empty())
+  if (iq_entries_.empty())
     return false;
   if (element->Name() != QN_IQ)
     return false;
-  std::string type = element->Attr(QN_TYPE);
+  const std::string& type = element->Attr(QN_TYPE);
   if (type != "result" && type != "error")
     return false;
   if (!element->HasAttr(QN_ID))
     return false;
-  std::string id = element->Attr(QN_ID);
-  std::string from = element->Attr(QN_FROM);
-
-  for (std::vector<XmppIqEntry *>::iterator it = iq_entries_->begin();
-       it != iq_entries_->end(); it += 1) {
-    XmppIqEntry * iq_entry = *it;
-    if (iq_entry->id_ == id && iq_entry->to_ == from) {
-      iq_entries_->erase(it);
+  const std::string& id = element->Attr(QN_ID);
+  const std::string& from = element->Attr(QN_FROM);
+
+  std::pair<IqEntryMap::iterator, IqEntryMap::iterator> range =
+      iq_entries_.equal_range(id);
+  for (IqEntryMap::iterator it = range.first; it != range.second; ++it) {
+    XmppIqEntry * iq_entry = it->second;
+    if (iq_entry->to_ == from) {
+      UnlinkIqEntry(iq_entry);
+      iq_stats_.answered += 1;
       iq_entry->iq_handler_->IqResponse(iq_entry, element);
       delete iq_entry;
       return true;
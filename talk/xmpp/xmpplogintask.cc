@@ -52,6 +52,8 @@ const ConstantLabel XmppLoginTask::LOGINTASK_STATES[] = {
   KLABEL(LOGINSTATE_BIND_INIT),
   KLABEL(LOGINSTATE_TLS_REQUESTED),
   KLABEL(LOGINSTATE_SASL_RUNNING),
+  KLABEL(LOGINSTATE_COMPRESS_INIT),
+  KLABEL(LOGINSTATE_COMPRESS_REQUESTED),
   KLABEL(LOGINSTATE_BIND_REQUESTED),
   KLABEL(LOGINSTATE_SESSION_REQUESTED),
   KLABEL(LOGINSTATE_DONE),
@@ -157,6 +159,12 @@ XmppLoginTask::Advance() {
           continue;
         }
 
+        // Compression comes after TLS and authentication (XEP-0138).
+        if (CanCompress()) {
+          state_ = LOGINSTATE_COMPRESS_INIT;
+          continue;
+        }
+
         state_ = LOGINSTATE_BIND_INIT;
         continue;
       }
@@ -264,6 +272,35 @@ XmppLoginTask::Advance() {
         continue;
       }
 
+      case LOGINSTATE_COMPRESS_INIT: {
+        XmlElement el(QN_COMPRESS_COMPRESS, true);
+        el.AddElement(new XmlElement(QN_COMPRESS_METHOD));
+        el.AddText("zlib", 1);
+        pctx_->InternalSendStanza(&el);
+        state_ = LOGINSTATE_COMPRESS_REQUESTED;
+        continue;
+      }
+
+      case LOGINSTATE_COMPRESS_REQUESTED: {
+        if (NULL == (element = NextStanza()))
+          return true;
+
+        if (element->Name() == QN_COMPRESS_FAILURE) {
+          // Not fatal: the stream just stays uncompressed.
+          pctx_->use_compression_ = false;
+          state_ = LOGINSTATE_BIND_INIT;
+          continue;
+        }
+
+        if (element->Name() != QN_COMPRESS_COMPRESSED ||
+            !pctx_->StartCompression())
+          return Failure(XmppEngine::ERROR_XML);
+
+        // Both sides restart the stream, compressed from here on.
+        state_ = LOGINSTATE_INIT;
+        continue;
+      }
+
       case LOGINSTATE_BIND_INIT: {
         const XmlElement * pelBindFeature = GetFeature(QN_BIND_BIND);
         const XmlElement * pelSessionFeature = GetFeature(QN_SESSION_SESSION);
@@ -372,6 +409,26 @@ XmppLoginTask::GetFeature(const QName & name) {
   return pelFeatures_->FirstNamed(name);
 }
 
+bool
+XmppLoginTask::CanCompress() {
+  if (!pctx_->use_compression_ || pctx_->IsCompressed())
+    return false;
+
+  const XmlElement * pelCompression =
+      GetFeature(QN_COMPRESS_FEATURE_COMPRESSION);
+  if (!pelCompression)
+    return false;
+
+  for (const XmlElement * pelMethod =
+       pelCompression->FirstNamed(QN_COMPRESS_FEATURE_METHOD);
+       pelMethod;
+       pelMethod = pelMethod->NextNamed(QN_COMPRESS_FEATURE_METHOD)) {
+    if (pelMethod->BodyText() == "zlib")
+      return true;
+  }
+  return false;
+}
+
 bool
 XmppLoginTask::Failure(XmppEngine::Error reason) {
   state_ = LOGINSTATE_DONE;
@@ -67,6 +67,8 @@ private:
     LOGINSTATE_BIND_INIT,
     LOGINSTATE_TLS_REQUESTED,
     LOGINSTATE_SASL_RUNNING,
+    LOGINSTATE_COMPRESS_INIT,
+    LOGINSTATE_COMPRESS_REQUESTED,
     LOGINSTATE_BIND_REQUESTED,
     LOGINSTATE_SESSION_REQUESTED,
     LOGINSTATE_DONE,
@@ -77,6 +79,7 @@ private:
   bool HandleStartStream(const XmlElement * element);
   bool HandleFeatures(const XmlElement * element);
   const XmlElement * GetFeature(const QName & name);
+  bool CanCompress();
   bool Failure(XmppEngine::Error reason);
   void FlushQueuedStanzas();
 
@@ -12,11 +12,13 @@
 #include "talk/xmpp/constants.h"
 #include "talk/xmpp/saslplainmechanism.h"
 #include "talk/xmpp/plainsaslhandler.h"
+#include "talk/xmpp/xmppcompressor.h"
 #include "talk/xmpp/xmppengine.h"
 
 using buzz::Jid;
 using buzz::QName;
 using buzz::XmlElement;
+using buzz::XmppCompressor;
 using buzz::XmppEngine;
 using buzz::XmppTestHandler;
 
@@ -612,3 +614,88 @@ TEST_F(XmppLoginTaskTest, TestStreamError) {
   }
 }
 
+
+TEST_F(XmppLoginTaskTest, TestCompressionRefused) {
+  engine()->SetCompression(true);
+  RunPartialLogin(XLTT_STAGE_CONNECT, XLTT_STAGE_AUTHENTICATED_START);
+
+  std::string input = "<stream:features>"
+          "<compression xmlns='http://jabber.org/features/compress'>"
+            "<method>zlib</method>"
+          "</compression>"
+          "<bind xmlns='urn:ietf:params:xml:ns:xmpp-bind'/>"
+          "<session xmlns='urn:ietf:params:xml:ns:xmpp-session'/>"
+        "</stream:features>";
+  engine()->HandleInput(input.c_str(), input.length());
+  if (!XmppCompressor::IsAvailable()) {
+    EXPECT_FALSE(engine()->IsCompressed());
+    return;
+  }
+  EXPECT_EQ("<compress xmlns=\"http://jabber.org/protocol/compress\">"
+      "<method>zlib</method></compress>", handler()->OutputActivity());
+
+  // A refusal leaves the stream uncompressed and login carries on.
+  input = "<failure xmlns='http://jabber.org/protocol/compress'>"
+          "<setup-failed/></failure>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("<iq type=\"set\" id=\"0\">"
+      "<bind xmlns=\"urn:ietf:params:xml:ns:xmpp-bind\"/></iq>",
+      handler()->OutputActivity());
+  EXPECT_EQ("", handler()->SessionActivity());
+  EXPECT_FALSE(engine()->IsCompressed());
+}
+
+TEST_F(XmppLoginTaskTest, TestCompression) {
+  if (!XmppCompressor::IsAvailable())
+    return;
+
+  engine()->SetCompression(true);
+  RunPartialLogin(XLTT_STAGE_CONNECT, XLTT_STAGE_AUTHENTICATED_START);
+
+  std::string input = "<stream:features>"
+          "<compression xmlns='http://jabber.org/features/compress'>"
+            "<method>lzw</method><method>zlib</method>"
+          "</compression>"
+          "<bind xmlns='urn:ietf:params:xml:ns:xmpp-bind'/>"
+          "<session xmlns='urn:ietf:params:xml:ns:xmpp-session'/>"
+        "</stream:features>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_EQ("<compress xmlns=\"http://jabber.org/protocol/compress\">"
+      "<method>zlib</method></compress>", handler()->OutputActivity());
+
+  // Play the server's side of the compressed stream.
+  XmppCompressor server;
+  EXPECT_TRUE(server.Start());
+
+  input = "<compressed xmlns='http://jabber.org/protocol/compress'/>";
+  engine()->HandleInput(input.c_str(), input.length());
+  EXPECT_TRUE(engine()->IsCompressed());
+  std::string output = handler()->OutputActivity();
+  std::string plain;
+  EXPECT_TRUE(server.Decompress(output.data(), output.length(), &plain));
+  EXPECT_EQ("<stream:stream to=\"my-server\" xml:lang=\"*\" "
+      "version=\"1.0\" xmlns:stream=\"http://etherx.jabber.org/streams\" "
+      "xmlns=\"jabber:client\">\r\n", plain);
+
+  input = "<stream:stream id=\"89abcdef\" version=\"1.0\" "
+          "xmlns:stream=\"http://etherx.jabber.org/streams\" "
+          "xmlns=\"jabber:client\">"
+          "<stream:features>"
+            "<bind xmlns='urn:ietf:params:xml:ns:xmpp-bind'/>"
+            "<session xmlns='urn:ietf:params:xml:ns:xmpp-session'/>"
+          "</stream:features>";
+  std::string compressed;
+  EXPECT_TRUE(server.Compress(input.data(), input.length(), &compressed));
+  engine()->HandleInput(compressed.data(), compressed.length());
+  output = handler()->OutputActivity();
+  plain.clear();
+  EXPECT_TRUE(server.Decompress(output.data(), output.length(), &plain));
+  EXPECT_EQ("<iq type=\"set\" id=\"0\">"
+      "<bind xmlns=\"urn:ietf:params:xml:ns:xmpp-bind\"/></iq>", plain);
+  EXPECT_EQ("", handler()->SessionActivity());
+
+  buzz::XmppTrafficStats stats = engine()->GetTrafficStats();
+  EXPECT_LT(stats.bytes_received, stats.bytes_received_uncompressed);
+  EXPECT_EQ(input.length() + stats.bytes_received - compressed.length(),
+            stats.bytes_received_uncompressed);
+}
@@ -29,6 +29,7 @@
 
 #include "talk/xmllite/xmlelement.h"
 #include "talk/base/common.h"
+#include "talk/base/stringencode.h"
 #include "talk/xmpp/constants.h"
 #ifdef EXPAT_RELATIVE_PATH
 #include "expat.h"
@@ -43,6 +44,11 @@ XmppStanzaParser::XmppStanzaParser(XmppStanzaParseHandler *psph) :
   innerHandler_(this),
   parser_(&innerHandler_),
   depth_(0),
+  selective_(false),
+  skip_depth_(0),
+  skipped_children_(0),
+  skipped_elements_(0),
+  use_arena_(false),
   builder_() {
 }
 
@@ -50,30 +56,62 @@ void
 XmppStanzaParser::Reset() {
   parser_.Reset();
   depth_ = 0;
+  skip_depth_ = 0;
+  skipped_children_ = 0;
   builder_.Reset();
 }
 
+void
+XmppStanzaParser::set_use_arena(bool use_arena) {
+  use_arena_ = use_arena;
+  builder_.set_arena(use_arena ? &arena_ : NULL);
+}
+
 void
 XmppStanzaParser::IncomingStartElement(
     XmlParseContext * pctx, const char * name, const char ** atts) {
   if (depth_++ == 0) {
-    XmlElement * pelStream = XmlBuilder::BuildElement(pctx, name, atts);
+    XmlElement * pelStream = XmlBuilder::BuildElement(
+        pctx, name, atts, use_arena_ ? &arena_ : NULL);
     if (pelStream == NULL) {
       pctx->RaiseError(XML_ERROR_SYNTAX);
       return;
     }
     psph_->StartStream(pelStream);
     delete pelStream;
+    arena_.Reset();
     return;
   }
 
+  if (skip_depth_) {
+    ++skip_depth_;
+    ++skipped_elements_;
+    return;
+  }
+
+  if (selective_ && depth_ == 3) {
+    // A direct child of the stanza: only resolve its name, and skip it
+    // unless the handler wants it.
+    QName child_name(pctx->ResolveQName(name, false));
+    if (child_name.IsEmpty()) {
+      pctx->RaiseError(XML_ERROR_SYNTAX);
+      return;
+    }
+    if (!psph_->WantsChild(builder_.BuiltElement(), child_name)) {
+      skip_depth_ = 1;
+      ++skipped_children_;
+      ++skipped_elements_;
+      return;
+    }
+  }
+
   builder_.StartElement(pctx, name, atts);
 }
 
 void
 XmppStanzaParser::IncomingCharacterData(
     XmlParseContext * pctx, const char * text, int len) {
-  if (depth_ > 1) {
+  if (depth_ > 1 && !skip_depth_) {
     builder_.CharacterData(pctx, text, len);
   }
 }
@@ -86,12 +124,23 @@ XmppStanzaParser::IncomingEndElement(
     return;
   }
 
+  if (skip_depth_) {
+    --skip_depth_;
+    return;
+  }
+
   builder_.EndElement(pctx, name);
 
   if (depth_ == 1) {
     XmlElement *element = builder_.CreateElement();
+    if (skipped_children_) {
+      element->AddAttr(QN_SKIPPED_CHILDREN,
+                       talk_base::ToString(skipped_children_));
+      skipped_children_ = 0;
+    }
     psph_->Stanza(element);
     delete element;
+    arena_.Reset();
   }
 }
 
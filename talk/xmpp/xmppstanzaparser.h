@@ -28,6 +28,8 @@
 #ifndef _xmppstanzaparser_h_
 #define _xmppstanzaparser_h_
 
+#include "talk/xmllite/qname.h"
+#include "talk/xmllite/xmlarena.h"
 #include "talk/xmllite/xmlparser.h"
 #include "talk/xmllite/xmlbuilder.h"
 
@@ -43,6 +45,11 @@ public:
   virtual void Stanza(const XmlElement * pelStanza) = 0;
   virtual void EndStream() = 0;
   virtual void XmlError() = 0;
+  // In selective mode, asked for each direct child of a stanza whether to
+  // build it. The stanza has its attributes and the children built so far.
+  virtual bool WantsChild(const XmlElement * pelStanza, const QName & child) {
+    return true;
+  }
 };
 
 class XmppStanzaParser {
@@ -52,6 +59,21 @@ public:
     { return parser_.Parse(data, len, isFinal); }
   void Reset();
 
+  // When enabled, each stanza is built in an arena which is released in one
+  // shot once the handler returns. The handler must copy any part of the
+  // stanza it wants to keep, as it already has to.
+  void set_use_arena(bool use_arena);
+  const XmlArena & arena() const { return arena_; }
+
+  // In selective mode, a direct child of a stanza is built only if the
+  // handler's WantsChild says so. Other children and everything below them
+  // are skipped without building any element, text or attribute. A stanza
+  // that lost children carries QN_SKIPPED_CHILDREN with how many it lost.
+  void set_selective(bool selective) { selective_ = selective; }
+  bool selective() const { return selective_; }
+  // Number of elements skipped in selective mode, descendants included.
+  int skipped_elements() const { return skipped_elements_; }
+
 private:
   class ParseHandler : public XmlParseHandler {
   public:
@@ -87,6 +109,15 @@ private:
   ParseHandler innerHandler_;
   XmlParser parser_;
   int depth_;
+  bool selective_;
+  // Depth inside the child being skipped, 0 when not skipping.
+  int skip_depth_;
+  // Direct children of the current stanza that were skipped.
+  int skipped_children_;
+  int skipped_elements_;
+  // Declared before builder_ so that it outlives the element being built.
+  XmlArena arena_;
+  bool use_arena_;
   XmlBuilder builder_;
 
  };
@@ -4,9 +4,11 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <set>
 #include "talk/base/common.h"
 #include "talk/base/gunit.h"
 #include "talk/xmllite/xmlelement.h"
+#include "talk/xmpp/constants.h"
 #include "talk/xmpp/xmppstanzaparser.h"
 
 using buzz::QName;
@@ -43,6 +45,18 @@ class XmppStanzaParserTestHandler : public XmppStanzaParseHandler {
   std::stringstream ss_;
 };
 
+// Builds only the children whose namespace it was told to want.
+class SelectiveTestHandler : public XmppStanzaParserTestHandler {
+ public:
+  virtual bool WantsChild(const XmlElement * element, const QName & child) {
+    return wanted_.count(child.Namespace()) != 0;
+  }
+  void Want(const std::string & ns) { wanted_.insert(ns); }
+
+ private:
+  std::set<std::string> wanted_;
+};
+
 
 TEST(XmppStanzaParserTest, TestTrivial) {
   XmppStanzaParserTestHandler handler;
@@ -109,6 +123,86 @@ TEST(XmppStanzaParserTest, TestFragmentedStanzas) {
   EXPECT_EQ("END", handler.StrClear());
 }
 
+TEST(XmppStanzaParserTest, TestArena) {
+  XmppStanzaParserTestHandler handler;
+  XmppStanzaParser parser(&handler);
+  parser.set_use_arena(true);
+  std::string fragment;
+
+  fragment = "<stream:stream id='abc' xmlns='j:c' xmlns:stream='str'>";
+  parser.Parse(fragment.c_str(), fragment.length(), false);
+  EXPECT_EQ("START<stream:stream id=\"abc\" xmlns=\"j:c\" "
+      "xmlns:stream=\"str\"/>", handler.StrClear());
+
+  for (int i = 0; i < 100; ++i) {
+    fragment = "<message type='foo'><body>hel";
+    parser.Parse(fragment.c_str(), fragment.length(), false);
+    EXPECT_EQ("", handler.StrClear());
+    EXPECT_LT(0, parser.arena().live_objects());
+
+    fragment = "lo</body></message>";
+    parser.Parse(fragment.c_str(), fragment.length(), false);
+    EXPECT_EQ("STANZA<c:message type=\"foo\" xmlns:c=\"j:c\">"
+        "<c:body>hello</c:body></c:message>", handler.StrClear());
+    EXPECT_EQ(0, parser.arena().live_objects());
+    EXPECT_EQ(0u, parser.arena().bytes_allocated());
+  }
+  // The same block was reused for every stanza.
+  EXPECT_EQ(1, parser.arena().blocks_allocated());
+
+  parser.Reset();
+  EXPECT_EQ(0, parser.arena().live_objects());
+}
+
+TEST(XmppStanzaParserTest, TestSelective) {
+  SelectiveTestHandler handler;
+  XmppStanzaParser parser(&handler);
+  parser.set_selective(true);
+  handler.Want("roster");
+  std::string fragment;
+
+  fragment = "<stream:stream xmlns='j:c' xmlns:stream='str'>";
+  parser.Parse(fragment.c_str(), fragment.length(), false);
+  handler.StrClear();
+
+  // Only the wanted child is built; the stanza counts the others.
+  fragment = "<iq type='result' id='1'>"
+      "<vCard xmlns='vcard-temp'><PHOTO><BINVAL>AAAA</BINVAL></PHOTO></vCard>"
+      "<query xmlns='roster'><item jid='a@b'/></query></iq>";
+  parser.Parse(fragment.c_str(), fragment.length(), false);
+  XmlElement* stanza = XmlElement::ForStr(
+      handler.StrClear().substr(strlen("STANZA")));
+  EXPECT_EQ("1", stanza->Attr(buzz::QN_SKIPPED_CHILDREN));
+  EXPECT_TRUE(stanza->FirstNamed(QName("vcard-temp", "vCard")) == NULL);
+  EXPECT_TRUE(stanza->FirstNamed(QName("roster", "query")) != NULL);
+  EXPECT_TRUE(stanza->FirstNamed(QName("roster", "query"))
+      ->FirstNamed(QName("roster", "item")) != NULL);
+  EXPECT_EQ("1", stanza->Attr(QName("", "id")));
+  EXPECT_EQ(3, parser.skipped_elements());
+  delete stanza;
+
+  // A stanza that lost nothing is not marked.
+  fragment = "<message><x xmlns='roster'/></message>";
+  parser.Parse(fragment.c_str(), fragment.length(), false);
+  EXPECT_EQ("STANZA<c:message xmlns:c=\"j:c\"><x xmlns=\"roster\"/>"
+      "</c:message>", handler.StrClear());
+
+  // Text under a skipped child is dropped with it.
+  fragment = "<message><body>hi</body></message>";
+  parser.Parse(fragment.c_str(), fragment.length(), false);
+  stanza = XmlElement::ForStr(handler.StrClear().substr(strlen("STANZA")));
+  EXPECT_EQ("1", stanza->Attr(buzz::QN_SKIPPED_CHILDREN));
+  EXPECT_TRUE(stanza->FirstElement() == NULL);
+  EXPECT_EQ(4, parser.skipped_elements());
+  delete stanza;
+
+  parser.set_selective(false);
+  parser.Parse(fragment.c_str(), fragment.length(), false);
+  EXPECT_EQ("STANZA<c:message xmlns:c=\"j:c\"><c:body>hi</c:body>"
+      "</c:message>", handler.StrClear());
+  EXPECT_EQ(4, parser.skipped_elements());
+}
+
 TEST(XmppStanzaParserTest, TestReset) {
   XmppStanzaParserTestHandler handler;
   XmppStanzaParser parser(&handler);
@@ -40,7 +40,7 @@ XmppClientInterface::~XmppClientInterface() {
 
 XmppTask::XmppTask(XmppTaskParentInterface* parent,
                    XmppEngine::HandlerLevel level)
-    : XmppTaskBase(parent), stopped_(false) {
+    : XmppTaskBase(parent), stopped_(false), level_(level) {
 #ifdef _DEBUG
   debug_force_timeout_ = false;
 #endif
@@ -54,6 +54,12 @@ XmppTask::~XmppTask() {
   StopImpl();
 }
 
+void XmppTask::SetStanzaFilter(const XmppStanzaFilter& filter) {
+  if (stopped_)
+    return;
+  GetClient()->SetXmppTaskFilter(this, level_, filter);
+}
+
 void XmppTask::StopImpl() {
   while (NextStanza() != NULL) {}
   if (!stopped_) {
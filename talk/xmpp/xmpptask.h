@@ -81,6 +81,19 @@ class XmppClientInterface {
                                            XmppStanzaError error_code,
                                            const std::string& message) = 0;
   virtual void AddXmppTask(XmppTask* task, XmppEngine::HandlerLevel level) = 0;
+  // The filter only saves calls to the task, so by default it is ignored.
+  virtual void AddXmppTask(XmppTask* task, XmppEngine::HandlerLevel level,
+                           const XmppStanzaFilter& filter) {
+    AddXmppTask(task, level);
+  }
+  // Replaces the filter of a task added at |level|.  By default the task is
+  // added again, which moves it after the other tasks at its level.
+  virtual void SetXmppTaskFilter(XmppTask* task,
+                                 XmppEngine::HandlerLevel level,
+                                 const XmppStanzaFilter& filter) {
+    RemoveXmppTask(task);
+    AddXmppTask(task, level, filter);
+  }
   virtual void RemoveXmppTask(XmppTask* task) = 0;
   sigslot::signal0<> SignalDisconnected;
 
@@ -152,6 +165,11 @@ class XmppTask : public XmppTaskBase,
   virtual void Stop();
   virtual void OnDisconnect();
 
+  // Narrows the stanzas offered to HandleStanza, so the engine can skip
+  // this task for everything else.  HandleStanza still has to check the
+  // stanza; the filter is only a hint.
+  void SetStanzaFilter(const XmppStanzaFilter& filter);
+
   virtual void QueueStanza(const XmlElement* stanza);
   const XmlElement* NextStanza();
 
@@ -175,6 +193,7 @@ private:
   void StopImpl();
 
   bool stopped_;
+  XmppEngine::HandlerLevel level_;
   std::deque<XmlElement*> stanza_queue_;
   talk_base::scoped_ptr<XmlElement> next_stanza_;
   std::string id_;